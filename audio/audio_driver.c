@@ -34,6 +34,9 @@
 
 #include "audio_driver.h"
 #include "audio_thread_wrapper.h"
+#ifdef HAVE_THREADS
+#include "audio_pipeline.h"
+#endif
 #include "../gfx/video_driver.h"
 #include "../record/record_driver.h"
 #include "../frontend/frontend_driver.h"
@@ -182,7 +185,6 @@ static float *audio_driver_input_data                    = NULL;
 static float *audio_driver_output_samples_buf            = NULL;
 
 static double audio_source_ratio_original                = 0.0f;
-static double audio_source_ratio_current                 = 0.0f;
 
 static struct retro_audio_callback audio_callback        = {0};
 
@@ -197,6 +199,39 @@ static void *audio_driver_context_audio_data             = NULL;
 static bool audio_suspended                              = false;
 static bool audio_is_threaded                            = false;
 
+#ifdef HAVE_THREADS
+/* Samples are handed from the core thread to the audio pipeline
+ * thread, which runs DSP, resampling and mixing and writes them
+ * to the driver. */
+static audio_pipeline_t *audio_driver_pipeline           = NULL;
+static int16_t *audio_driver_pipeline_conv_buf           = NULL;
+static bool audio_driver_pipeline_blocking               = true;
+
+#define audio_driver_pipeline_lock()   audio_pipeline_lock(audio_driver_pipeline)
+#define audio_driver_pipeline_unlock() audio_pipeline_unlock(audio_driver_pipeline)
+#else
+#define audio_driver_pipeline_lock()   ((void)0)
+#define audio_driver_pipeline_unlock() ((void)0)
+#endif
+
+/* What the processing chain needs of the state that the core
+ * and menu threads change. It is taken when the samples are
+ * flushed and handed over with them when they go through the
+ * pipeline, so the pipeline thread never reads that state. */
+typedef struct audio_driver_process_params
+{
+   /* Resampling ratio, slow motion included */
+   double ratio;
+   float rate_control_delta;
+   float volume_gain;
+   float mixer_gain;
+   bool mixer_override;
+} audio_driver_process_params_t;
+
+static bool audio_driver_process(const int16_t *data, size_t samples,
+      const void *data_params);
+static void audio_driver_mixer_play_stream_internal(unsigned i, unsigned type);
+
 static void audio_mixer_play_stop_sequential_cb(
       audio_mixer_sound_t *sound, unsigned reason);
 static void audio_mixer_play_stop_cb(
@@ -363,6 +398,16 @@ static bool audio_driver_deinit_internal(void)
 {
    settings_t *settings = config_get_ptr();
 
+#ifdef HAVE_THREADS
+   if (audio_driver_pipeline)
+      audio_pipeline_free(audio_driver_pipeline);
+   audio_driver_pipeline = NULL;
+
+   if (audio_driver_pipeline_conv_buf)
+      free(audio_driver_pipeline_conv_buf);
+   audio_driver_pipeline_conv_buf = NULL;
+#endif
+
    if (current_audio && current_audio->free)
    {
       if (audio_driver_context_audio_data)
@@ -519,7 +564,7 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
       audio_driver_input = settings->uints.audio_out_rate;
    }
 
-   audio_source_ratio_original   = audio_source_ratio_current =
+   audio_source_ratio_original   =
       (double)settings->uints.audio_out_rate / audio_driver_input;
 
    if (!retro_resampler_realloc(
@@ -580,6 +625,35 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
 
    audio_driver_mixer_init(settings->uints.audio_out_rate);
 
+#ifdef HAVE_THREADS
+   if (     !audio_cb_inited
+         && audio_driver_active
+         && settings->bools.audio_pipeline)
+   {
+      /* The driver already buffers audio_latency worth of output,
+       * so the ring only has to cover one video frame of input,
+       * or anything in it adds to the latency. */
+      float refresh_rate  = settings->floats.video_refresh_rate;
+      size_t ring_samples = (size_t)(audio_driver_input
+            / (refresh_rate > 0.0f ? refresh_rate : 60.0f)) * 2;
+
+      if (ring_samples < AUDIO_CHUNK_SIZE_BLOCKING * 2)
+         ring_samples = AUDIO_CHUNK_SIZE_BLOCKING * 2;
+
+      audio_driver_pipeline_conv_buf = (int16_t*)malloc(outsamples_max
+            * sizeof(int16_t));
+
+      if (audio_driver_pipeline_conv_buf)
+         audio_driver_pipeline = audio_pipeline_new(ring_samples,
+               AUDIO_CHUNK_SIZE_BLOCKING,
+               sizeof(audio_driver_process_params_t),
+               audio_driver_process);
+
+      if (!audio_driver_pipeline)
+         RARCH_WARN("[Audio]: Failed to start audio pipeline, processing audio on the main thread.\n");
+   }
+#endif
+
    /* Threaded driver is initially stopped. */
    if (
          audio_driver_active
@@ -600,9 +674,17 @@ void audio_driver_set_nonblocking_state(bool enable)
          audio_driver_active
          && audio_driver_context_audio_data
       )
+   {
+      audio_driver_pipeline_lock();
       current_audio->set_nonblock_state(
             audio_driver_context_audio_data,
             settings->bools.audio_sync ? enable : true);
+      audio_driver_pipeline_unlock();
+   }
+
+#ifdef HAVE_THREADS
+   audio_driver_pipeline_blocking = settings->bools.audio_sync && !enable;
+#endif
 
    audio_driver_chunk_size = enable ?
       audio_driver_chunk_nonblock_size :
@@ -610,43 +692,40 @@ void audio_driver_set_nonblocking_state(bool enable)
 }
 
 /**
- * audio_driver_flush:
+ * audio_driver_process:
  * @data                 : pointer to audio buffer.
- * @right                : amount of samples to write.
+ * @samples              : amount of samples to write.
+ * @data_params          : audio_driver_process_params_t taken
+ *                         when the samples were flushed.
+ *
+ * Performs DSP processing (if enabled), resampling and
+ * mixing, then writes the samples to the audio driver.
+ * Called on the audio pipeline thread if there is one.
  *
- * Writes audio samples to audio driver. Will first
- * perform DSP processing (if enabled) and resampling.
+ * Returns: false if the audio driver failed to write.
  **/
-static void audio_driver_flush(const int16_t *data, size_t samples)
+static bool audio_driver_process(const int16_t *data, size_t samples,
+      const void *data_params)
 {
    struct resampler_data src_data;
-   bool is_perfcnt_enable            = false;
-   bool is_paused                    = false;
-   bool is_idle                      = false;
-   bool is_slowmotion                = false;
+   const audio_driver_process_params_t *params =
+      (const audio_driver_process_params_t*)data_params;
    bool is_active                    = false;
    const void *output_data           = NULL;
    unsigned output_frames            = 0;
-   float audio_volume_gain           = !audio_driver_mute_enable ?
-      audio_driver_volume_gain : 0.0f;
+   int16_t *conv_buf                 = audio_driver_output_samples_conv_buf;
 
    src_data.data_out                 = NULL;
    src_data.output_frames            = 0;
 
-   if (recording_data)
-      recording_push_audio(data, samples);
-
-   runloop_get_status(&is_paused, &is_idle, &is_slowmotion,
-         &is_perfcnt_enable);
-
-   if (            is_paused                ||
-		   !audio_driver_active     ||
-		   !audio_driver_input_data ||
-		   !audio_driver_output_samples_buf)
-      return;
+#ifdef HAVE_THREADS
+   /* The core thread keeps filling the other one. */
+   if (audio_driver_pipeline)
+      conv_buf                       = audio_driver_pipeline_conv_buf;
+#endif
 
    convert_s16_to_float(audio_driver_input_data, data, samples,
-         audio_volume_gain);
+         params->volume_gain);
 
    src_data.data_in                  = audio_driver_input_data;
    src_data.input_frames             = samples >> 1;
@@ -673,23 +752,23 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
    }
 
    src_data.data_out = audio_driver_output_samples_buf;
+   src_data.ratio    = params->ratio;
 
    if (audio_driver_control)
    {
       /* Readjust the audio input rate. */
       int      half_size   = (int)(audio_driver_buffer_size / 2);
-      int      avail       =
-         (int)current_audio->write_avail(audio_driver_context_audio_data);
+      int      avail       = (int)current_audio->write_avail(
+            audio_driver_context_audio_data);
       int      delta_mid   = avail - half_size;
       double   direction   = (double)delta_mid / half_size;
-      double   adjust      = 1.0 + audio_driver_rate_control_delta * direction;
+      double   adjust      = 1.0 + params->rate_control_delta * direction;
       unsigned write_idx   = audio_driver_free_samples_count++ &
          (AUDIO_BUFFER_FREE_SAMPLES_COUNT - 1);
 
       audio_driver_free_samples_buf
          [write_idx]               = avail;
-      audio_source_ratio_current   =
-         audio_source_ratio_original * adjust;
+      src_data.ratio              *= adjust;
 
 #if 0
       if (verbosity_is_enabled())
@@ -697,33 +776,20 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
          RARCH_LOG_OUTPUT("[Audio]: Audio buffer is %u%% full\n",
                (unsigned)(100 - (avail * 100) / audio_driver_buffer_size));
          RARCH_LOG_OUTPUT("[Audio]: New rate: %lf, Orig rate: %lf\n",
-               audio_source_ratio_current,
-               audio_source_ratio_original);
+               src_data.ratio,
+               params->ratio);
       }
 #endif
    }
 
-   src_data.ratio           = audio_source_ratio_current;
-
-   if (is_slowmotion)
-   {
-      settings_t *settings  = config_get_ptr();
-      src_data.ratio       *= settings->floats.slowmotion_ratio;
-   }
-
    audio_driver_resampler->process(audio_driver_resampler_data, &src_data);
 
    is_active = audio_mixer_active;
 
    if (is_active)
-   {
-      bool override     = audio_driver_mixer_mute_enable ? true :
-         (audio_driver_mixer_volume_gain != 1.0f) ? true : false;
-      float mixer_gain  = !audio_driver_mixer_mute_enable ?
-         audio_driver_mixer_volume_gain : 0.0f;
       audio_mixer_mix(audio_driver_output_samples_buf,
-            src_data.output_frames, mixer_gain, override);
-   }
+            src_data.output_frames, params->mixer_gain,
+            params->mixer_override);
 
    output_data        = audio_driver_output_samples_buf;
    output_frames      = (unsigned)src_data.output_frames;
@@ -732,15 +798,77 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
       output_frames  *= sizeof(float);
    else
    {
-      convert_float_to_s16(audio_driver_output_samples_conv_buf,
+      convert_float_to_s16(conv_buf,
             (const float*)output_data, output_frames * 2);
 
-      output_data     = audio_driver_output_samples_conv_buf;
+      output_data     = conv_buf;
       output_frames  *= sizeof(int16_t);
    }
 
-   if (current_audio->write(audio_driver_context_audio_data,
-            output_data, output_frames * 2) < 0)
+   return current_audio->write(audio_driver_context_audio_data,
+         output_data, output_frames * 2) >= 0;
+}
+
+/**
+ * audio_driver_flush:
+ * @data                 : pointer to audio buffer.
+ * @samples              : amount of samples to write.
+ *
+ * Writes audio samples to audio driver, or hands them
+ * to the audio pipeline thread.
+ **/
+static void audio_driver_flush(const int16_t *data, size_t samples)
+{
+   audio_driver_process_params_t params;
+   bool is_perfcnt_enable            = false;
+   bool is_paused                    = false;
+   bool is_idle                      = false;
+   bool is_slowmotion                = false;
+
+   if (recording_data)
+      recording_push_audio(data, samples);
+
+   runloop_get_status(&is_paused, &is_idle, &is_slowmotion,
+         &is_perfcnt_enable);
+
+   if (            is_paused                ||
+		   !audio_driver_active     ||
+		   !audio_driver_input_data ||
+		   !audio_driver_output_samples_buf)
+      return;
+
+   params.ratio              = audio_source_ratio_original;
+   params.rate_control_delta = audio_driver_rate_control_delta;
+   params.volume_gain        = !audio_driver_mute_enable ?
+      audio_driver_volume_gain : 0.0f;
+   params.mixer_gain         = !audio_driver_mixer_mute_enable ?
+      audio_driver_mixer_volume_gain : 0.0f;
+   params.mixer_override     = audio_driver_mixer_mute_enable ||
+      audio_driver_mixer_volume_gain != 1.0f;
+
+   if (is_slowmotion)
+   {
+      settings_t *settings   = config_get_ptr();
+      params.ratio          *= settings->floats.slowmotion_ratio;
+   }
+
+#ifdef HAVE_THREADS
+   if (audio_driver_pipeline)
+   {
+      /* The driver failed to write on the pipeline thread */
+      if (audio_pipeline_write_failed(audio_driver_pipeline))
+      {
+         audio_driver_active = false;
+         return;
+      }
+
+      audio_pipeline_push(audio_driver_pipeline, data, samples,
+            &params, audio_driver_pipeline_blocking);
+      return;
+   }
+#endif
+
+   if (!audio_driver_process(data, samples, &params))
       audio_driver_active = false;
 }
 
@@ -853,13 +981,16 @@ size_t audio_driver_sample_batch_rewind(const int16_t *data, size_t frames)
 
 void audio_driver_dsp_filter_free(void)
 {
+   audio_driver_pipeline_lock();
    if (audio_driver_dsp)
       retro_dsp_filter_free(audio_driver_dsp);
    audio_driver_dsp = NULL;
+   audio_driver_pipeline_unlock();
 }
 
 void audio_driver_dsp_filter_init(const char *device)
 {
+   retro_dsp_filter_t *dsp       = NULL;
    struct string_list *plugs     = NULL;
 #if defined(HAVE_DYLIB) && !defined(HAVE_FILTERS_BUILTIN)
    char *basedir   = (char*)calloc(PATH_MAX_LENGTH, sizeof(*basedir));
@@ -874,11 +1005,15 @@ void audio_driver_dsp_filter_init(const char *device)
    if (!plugs)
       goto error;
 #endif
-   audio_driver_dsp = retro_dsp_filter_new(
+   dsp = retro_dsp_filter_new(
          device, plugs, audio_driver_input);
-   if (!audio_driver_dsp)
+   if (!dsp)
       goto error;
 
+   audio_driver_pipeline_lock();
+   audio_driver_dsp = dsp;
+   audio_driver_pipeline_unlock();
+
 #if defined(HAVE_DYLIB) && !defined(HAVE_FILTERS_BUILTIN)
    free(basedir);
    free(ext_name);
@@ -891,7 +1026,7 @@ error:
    free(basedir);
    free(ext_name);
 #endif
-   if (!audio_driver_dsp)
+   if (!dsp)
       RARCH_ERR("[DSP]: Failed to initialize DSP filter \"%s\".\n", device);
 }
 
@@ -1170,7 +1305,12 @@ static void audio_mixer_play_stop_sequential_cb(
             {
                if (audio_mixer_streams[i].state == AUDIO_STREAM_STATE_STOPPED)
                {
-                  audio_driver_mixer_play_stream_sequential(i);
+                  /* Runs inside audio_mixer_mix, with the
+                   * pipeline already locked. */
+                  audio_mixer_streams[i].stop_cb =
+                     audio_mixer_play_stop_sequential_cb;
+                  audio_driver_mixer_play_stream_internal(i,
+                        AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL);
                   break;
                }
             }
@@ -1265,6 +1405,10 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
       return false;
    }
 
+   /* The pipeline thread mixes the voices and its stop
+    * callbacks write to the stream slots. */
+   audio_driver_pipeline_lock();
+
    switch (params->state)
    {
       case AUDIO_STREAM_STATE_PLAYING_LOOPED:
@@ -1294,6 +1438,8 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
    audio_mixer_streams[free_slot].volume  = params->volume;
    audio_mixer_streams[free_slot].stop_cb = stop_cb;
 
+   audio_driver_pipeline_unlock();
+
    return true;
 }
 
@@ -1438,32 +1584,42 @@ end:
 
 void audio_driver_mixer_play_stream(unsigned i)
 {
+   audio_driver_pipeline_lock();
    audio_mixer_streams[i].stop_cb = audio_mixer_play_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING);
+   audio_driver_pipeline_unlock();
 }
 
 void audio_driver_mixer_play_menu_sound_looped(unsigned i)
 {
+   audio_driver_pipeline_lock();
    audio_mixer_streams[i].stop_cb = audio_mixer_menu_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING_LOOPED);
+   audio_driver_pipeline_unlock();
 }
 
 void audio_driver_mixer_play_menu_sound(unsigned i)
 {
+   audio_driver_pipeline_lock();
    audio_mixer_streams[i].stop_cb = audio_mixer_menu_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING);
+   audio_driver_pipeline_unlock();
 }
 
 void audio_driver_mixer_play_stream_looped(unsigned i)
 {
+   audio_driver_pipeline_lock();
    audio_mixer_streams[i].stop_cb = audio_mixer_play_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING_LOOPED);
+   audio_driver_pipeline_unlock();
 }
 
 void audio_driver_mixer_play_stream_sequential(unsigned i)
 {
+   audio_driver_pipeline_lock();
    audio_mixer_streams[i].stop_cb = audio_mixer_play_stop_sequential_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL);
+   audio_driver_pipeline_unlock();
 }
 
 float audio_driver_mixer_get_stream_volume(unsigned i)
@@ -1481,21 +1637,23 @@ void audio_driver_mixer_set_stream_volume(unsigned i, float vol)
    if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return;
 
+   audio_driver_pipeline_lock();
+
    audio_mixer_streams[i].volume  = vol;
 
    voice                          = audio_mixer_streams[i].voice;
 
    if (voice)
       audio_mixer_voice_set_volume(voice, db_to_gain(vol));
+
+   audio_driver_pipeline_unlock();
 }
 
-void audio_driver_mixer_stop_stream(unsigned i)
+/* Callers hold the pipeline lock */
+static void audio_driver_mixer_stop_stream_internal(unsigned i)
 {
    bool set_state              = false;
 
-   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
-      return;
-
    switch (audio_mixer_streams[i].state)
    {
       case AUDIO_STREAM_STATE_PLAYING:
@@ -1519,19 +1677,27 @@ void audio_driver_mixer_stop_stream(unsigned i)
    }
 }
 
-void audio_driver_mixer_remove_stream(unsigned i)
+void audio_driver_mixer_stop_stream(unsigned i)
 {
-   bool destroy                = false;
-
    if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return;
 
+   audio_driver_pipeline_lock();
+   audio_driver_mixer_stop_stream_internal(i);
+   audio_driver_pipeline_unlock();
+}
+
+/* Callers hold the pipeline lock */
+static void audio_driver_mixer_remove_stream_internal(unsigned i)
+{
+   bool destroy                = false;
+
    switch (audio_mixer_streams[i].state)
    {
       case AUDIO_STREAM_STATE_PLAYING:
       case AUDIO_STREAM_STATE_PLAYING_LOOPED:
       case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
-         audio_driver_mixer_stop_stream(i);
+         audio_driver_mixer_stop_stream_internal(i);
          destroy = true;
          break;
       case AUDIO_STREAM_STATE_STOPPED:
@@ -1559,19 +1725,33 @@ void audio_driver_mixer_remove_stream(unsigned i)
    }
 }
 
+void audio_driver_mixer_remove_stream(unsigned i)
+{
+   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
+      return;
+
+   audio_driver_pipeline_lock();
+   audio_driver_mixer_remove_stream_internal(i);
+   audio_driver_pipeline_unlock();
+}
+
 static void audio_driver_mixer_deinit(void)
 {
    unsigned i;
 
+   audio_driver_pipeline_lock();
+
    audio_mixer_active = false;
 
    for (i = 0; i < AUDIO_MIXER_MAX_SYSTEM_STREAMS; i++)
    {
-      audio_driver_mixer_stop_stream(i);
-      audio_driver_mixer_remove_stream(i);
+      audio_driver_mixer_stop_stream_internal(i);
+      audio_driver_mixer_remove_stream_internal(i);
    }
 
    audio_mixer_done();
+
+   audio_driver_pipeline_unlock();
 }
 
 bool audio_driver_deinit(void)
@@ -1621,7 +1801,6 @@ void audio_driver_monitor_set_rate(void)
       audio_driver_input;
 
    audio_source_ratio_original = new_src_ratio;
-   audio_source_ratio_current  = new_src_ratio;
 }
 
 bool audio_driver_callback(void)
@@ -1665,10 +1844,17 @@ static INLINE bool audio_driver_alive(void)
 
 bool audio_driver_start(bool is_shutdown)
 {
+   bool ret;
+
    if (!current_audio || !current_audio->start
          || !audio_driver_context_audio_data)
       goto error;
-   if (!current_audio->start(audio_driver_context_audio_data, is_shutdown))
+
+   audio_driver_pipeline_lock();
+   ret = current_audio->start(audio_driver_context_audio_data, is_shutdown);
+   audio_driver_pipeline_unlock();
+
+   if (!ret)
       goto error;
 
    return true;
@@ -1682,12 +1868,19 @@ error:
 
 bool audio_driver_stop(void)
 {
+   bool ret;
+
    if (!current_audio || !current_audio->stop
          || !audio_driver_context_audio_data)
       return false;
    if (!audio_driver_alive())
       return false;
-   return current_audio->stop(audio_driver_context_audio_data);
+
+   audio_driver_pipeline_lock();
+   ret = current_audio->stop(audio_driver_context_audio_data);
+   audio_driver_pipeline_unlock();
+
+   return ret;
 }
 
 void audio_driver_unset_callback(void)
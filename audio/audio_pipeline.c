@@ -0,0 +1,341 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rthreads/rthreads.h>
+
+#include "audio_pipeline.h"
+#include "../verbosity.h"
+
+/* Priority hint for the audio thread, only honoured
+ * where the user may create real-time threads. */
+#define AUDIO_PIPELINE_THREAD_PRIORITY 90
+
+/* How long a blocking push waits for room before dropping
+ * samples, so a stalled audio driver can't hang the core. */
+#define AUDIO_PIPELINE_PUSH_TIMEOUT_USEC 100000
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+#define AUDIO_PIPELINE_ATOMIC_LOAD(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define AUDIO_PIPELINE_ATOMIC_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#endif
+
+struct audio_pipeline
+{
+   audio_pipeline_process_t process;
+
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond_data;
+   scond_t *cond_space;
+   /* Held by the audio thread while it processes samples */
+   slock_t *process_lock;
+#ifndef AUDIO_PIPELINE_ATOMIC_LOAD
+   slock_t *index_lock;
+#endif
+
+   int16_t *ring;
+   int16_t *chunk;
+   size_t capacity;
+   size_t chunk_size;
+
+   /* Last pushed parameters, and the audio thread's copy
+    * of them, taken under lock */
+   void *params;
+   void *chunk_params;
+   size_t params_size;
+
+   /* Only ever increase, the producer owns write_pos
+    * and the audio thread read_pos. */
+   size_t write_pos;
+   size_t read_pos;
+
+   unsigned dropped;
+   bool failed; /* use lock when touching it */
+   bool alive;
+};
+
+static size_t audio_pipeline_load(audio_pipeline_t *pipe, size_t *pos)
+{
+#ifdef AUDIO_PIPELINE_ATOMIC_LOAD
+   (void)pipe;
+   return AUDIO_PIPELINE_ATOMIC_LOAD(pos);
+#else
+   size_t val;
+   slock_lock(pipe->index_lock);
+   val = *pos;
+   slock_unlock(pipe->index_lock);
+   return val;
+#endif
+}
+
+static void audio_pipeline_store(audio_pipeline_t *pipe,
+      size_t *pos, size_t val)
+{
+#ifdef AUDIO_PIPELINE_ATOMIC_STORE
+   (void)pipe;
+   AUDIO_PIPELINE_ATOMIC_STORE(pos, val);
+#else
+   slock_lock(pipe->index_lock);
+   *pos = val;
+   slock_unlock(pipe->index_lock);
+#endif
+}
+
+static void audio_pipeline_loop(void *data)
+{
+   audio_pipeline_t *pipe = (audio_pipeline_t*)data;
+
+   for (;;)
+   {
+      size_t i, avail, offset;
+      size_t read_pos = pipe->read_pos;
+
+      bool failed;
+
+      slock_lock(pipe->lock);
+      while (pipe->alive && (avail =
+               audio_pipeline_load(pipe, &pipe->write_pos) - read_pos) < 2)
+         scond_wait(pipe->cond_data, pipe->lock);
+
+      if (!pipe->alive)
+      {
+         slock_unlock(pipe->lock);
+         break;
+      }
+      memcpy(pipe->chunk_params, pipe->params, pipe->params_size);
+      failed = pipe->failed;
+      slock_unlock(pipe->lock);
+
+      /* Whole stereo frames only. */
+      if (avail > pipe->chunk_size)
+         avail = pipe->chunk_size;
+      avail &= ~(size_t)1;
+
+      offset = read_pos & (pipe->capacity - 1);
+      i      = pipe->capacity - offset;
+      if (i > avail)
+         i = avail;
+
+      memcpy(pipe->chunk, pipe->ring + offset, i * sizeof(int16_t));
+      if (i < avail)
+         memcpy(pipe->chunk + i, pipe->ring, (avail - i) * sizeof(int16_t));
+
+      audio_pipeline_store(pipe, &pipe->read_pos, read_pos + avail);
+
+      slock_lock(pipe->lock);
+      scond_signal(pipe->cond_space);
+      slock_unlock(pipe->lock);
+
+      if (failed)
+         continue;
+
+      slock_lock(pipe->process_lock);
+      failed = !pipe->process(pipe->chunk, avail, pipe->chunk_params);
+      slock_unlock(pipe->process_lock);
+
+      if (failed)
+      {
+         slock_lock(pipe->lock);
+         pipe->failed = true;
+         slock_unlock(pipe->lock);
+      }
+   }
+}
+
+audio_pipeline_t *audio_pipeline_new(size_t capacity, size_t chunk_size,
+      size_t params_size, audio_pipeline_process_t process)
+{
+   size_t size            = 2;
+   audio_pipeline_t *pipe = (audio_pipeline_t*)calloc(1, sizeof(*pipe));
+
+   if (!pipe)
+      return NULL;
+
+   while (size < capacity)
+      size <<= 1;
+
+   pipe->process          = process;
+   pipe->capacity         = size;
+   pipe->chunk_size       = chunk_size;
+   pipe->ring             = (int16_t*)calloc(size, sizeof(int16_t));
+   pipe->chunk            = (int16_t*)calloc(chunk_size, sizeof(int16_t));
+   pipe->params_size      = params_size;
+   pipe->params           = calloc(1, params_size ? params_size : 1);
+   pipe->chunk_params     = calloc(1, params_size ? params_size : 1);
+   pipe->lock             = slock_new();
+   pipe->process_lock     = slock_new();
+   pipe->cond_data        = scond_new();
+   pipe->cond_space       = scond_new();
+#ifndef AUDIO_PIPELINE_ATOMIC_LOAD
+   pipe->index_lock       = slock_new();
+#endif
+   pipe->alive            = true;
+
+   if (     !pipe->ring
+         || !pipe->chunk
+         || !pipe->params
+         || !pipe->chunk_params
+         || !pipe->lock
+         || !pipe->process_lock
+         || !pipe->cond_data
+         || !pipe->cond_space
+#ifndef AUDIO_PIPELINE_ATOMIC_LOAD
+         || !pipe->index_lock
+#endif
+      )
+      goto error;
+
+   pipe->thread = sthread_create_with_priority(audio_pipeline_loop, pipe,
+         AUDIO_PIPELINE_THREAD_PRIORITY);
+
+   if (!pipe->thread)
+      goto error;
+
+   RARCH_LOG("[Audio Pipeline]: Started audio thread, ring of %u samples.\n",
+         (unsigned)size);
+
+   return pipe;
+
+error:
+   audio_pipeline_free(pipe);
+   return NULL;
+}
+
+void audio_pipeline_free(audio_pipeline_t *pipe)
+{
+   if (!pipe)
+      return;
+
+   if (pipe->thread)
+   {
+      slock_lock(pipe->lock);
+      pipe->alive = false;
+      scond_signal(pipe->cond_data);
+      slock_unlock(pipe->lock);
+
+      sthread_join(pipe->thread);
+
+      RARCH_LOG("[Audio Pipeline]: Samples dropped: %u.\n", pipe->dropped);
+   }
+
+   if (pipe->lock)
+      slock_free(pipe->lock);
+   if (pipe->process_lock)
+      slock_free(pipe->process_lock);
+   if (pipe->cond_data)
+      scond_free(pipe->cond_data);
+   if (pipe->cond_space)
+      scond_free(pipe->cond_space);
+#ifndef AUDIO_PIPELINE_ATOMIC_LOAD
+   if (pipe->index_lock)
+      slock_free(pipe->index_lock);
+#endif
+   free(pipe->ring);
+   free(pipe->chunk);
+   free(pipe->params);
+   free(pipe->chunk_params);
+   free(pipe);
+}
+
+size_t audio_pipeline_push(audio_pipeline_t *pipe,
+      const int16_t *data, size_t samples, const void *params,
+      bool blocking)
+{
+   size_t pushed    = 0;
+   size_t write_pos = pipe->write_pos;
+
+   slock_lock(pipe->lock);
+   memcpy(pipe->params, params, pipe->params_size);
+   slock_unlock(pipe->lock);
+
+   while (pushed < samples)
+   {
+      size_t offset, n, i;
+      size_t space = pipe->capacity -
+         (write_pos - audio_pipeline_load(pipe, &pipe->read_pos));
+
+      if (space < 2)
+      {
+         if (!blocking)
+            break;
+
+         slock_lock(pipe->lock);
+         while ((space = pipe->capacity - (write_pos
+                     - audio_pipeline_load(pipe, &pipe->read_pos))) < 2)
+         {
+            if (!scond_wait_timeout(pipe->cond_space, pipe->lock,
+                     AUDIO_PIPELINE_PUSH_TIMEOUT_USEC))
+               break;
+         }
+         slock_unlock(pipe->lock);
+
+         if (space < 2)
+            break;
+      }
+
+      n = samples - pushed;
+      if (n > space)
+         n = space & ~(size_t)1;
+
+      offset = write_pos & (pipe->capacity - 1);
+      i      = pipe->capacity - offset;
+      if (i > n)
+         i = n;
+
+      memcpy(pipe->ring + offset, data + pushed, i * sizeof(int16_t));
+      if (i < n)
+         memcpy(pipe->ring, data + pushed + i, (n - i) * sizeof(int16_t));
+
+      write_pos += n;
+      pushed    += n;
+      audio_pipeline_store(pipe, &pipe->write_pos, write_pos);
+
+      slock_lock(pipe->lock);
+      scond_signal(pipe->cond_data);
+      slock_unlock(pipe->lock);
+   }
+
+   pipe->dropped += (unsigned)(samples - pushed);
+
+   return pushed;
+}
+
+bool audio_pipeline_write_failed(audio_pipeline_t *pipe)
+{
+   bool failed;
+
+   slock_lock(pipe->lock);
+   failed       = pipe->failed;
+   pipe->failed = false;
+   slock_unlock(pipe->lock);
+
+   return failed;
+}
+
+void audio_pipeline_lock(audio_pipeline_t *pipe)
+{
+   if (pipe)
+      slock_lock(pipe->process_lock);
+}
+
+void audio_pipeline_unlock(audio_pipeline_t *pipe)
+{
+   if (pipe)
+      slock_unlock(pipe->process_lock);
+}
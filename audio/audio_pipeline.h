@@ -0,0 +1,91 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RARCH_AUDIO_PIPELINE_H__
+#define RARCH_AUDIO_PIPELINE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+typedef struct audio_pipeline audio_pipeline_t;
+
+/* Called on the audio thread with interleaved stereo s16 samples
+ * and the parameters last pushed with them. Returns false if the
+ * samples couldn't be written out. */
+typedef bool (*audio_pipeline_process_t)(const int16_t *data,
+      size_t samples, const void *params);
+
+/**
+ * audio_pipeline_new:
+ * @capacity                  : ring size in samples, rounded up
+ *                              to a power of two
+ * @chunk_size                : maximum amount of samples handed to
+ *                              @process at once
+ * @params_size               : size of the parameters pushed along
+ *                              with the samples
+ * @process                   : processing callback
+ *
+ * Starts an audio thread that takes the samples pushed with
+ * audio_pipeline_push out of a single-producer/single-consumer
+ * ring and hands them to @process. The thread is run with
+ * real-time priority where the system permits it.
+ *
+ * Returns: pipeline handle if successful, otherwise NULL.
+ **/
+audio_pipeline_t *audio_pipeline_new(size_t capacity, size_t chunk_size,
+      size_t params_size, audio_pipeline_process_t process);
+
+void audio_pipeline_free(audio_pipeline_t *pipe);
+
+/**
+ * audio_pipeline_push:
+ * @pipe                      : pipeline handle
+ * @data                      : interleaved stereo s16 samples
+ * @samples                   : amount of samples
+ * @params                    : parameters for @process, applied
+ *                              from the next chunk the audio
+ *                              thread takes on
+ * @blocking                  : wait for room in the ring instead
+ *                              of dropping samples
+ *
+ * Pushes samples from the core thread. The ring itself is
+ * lock-free, a lock is only taken to hand over @params, to
+ * wake up the audio thread and, if @blocking is set, to wait
+ * for room in the ring.
+ *
+ * Returns: amount of samples pushed.
+ **/
+size_t audio_pipeline_push(audio_pipeline_t *pipe,
+      const int16_t *data, size_t samples, const void *params,
+      bool blocking);
+
+/* Returns true if @process failed since the last call. The
+ * samples are dropped from then on, until this is called. */
+bool audio_pipeline_write_failed(audio_pipeline_t *pipe);
+
+/* Keeps the audio thread from processing samples, so that
+ * the state used by the process callback can be changed. */
+void audio_pipeline_lock(audio_pipeline_t *pipe);
+void audio_pipeline_unlock(audio_pipeline_t *pipe);
+
+RETRO_END_DECLS
+
+#endif
@@ -0,0 +1,118 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2019 - Brad Parker
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <memmap.h>
+#endif
+
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+
+#include "cache_file.h"
+
+bool cache_file_load(cache_file_t *file, const char *path)
+{
+#ifdef HAVE_MMAP
+   struct stat buf;
+   int fd = open(path, O_RDONLY);
+
+   if (fd < 0)
+      return false;
+
+   if (fstat(fd, &buf) == 0 && buf.st_size > 0)
+   {
+      void *data = mmap(NULL, (size_t)buf.st_size,
+            PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (data != MAP_FAILED)
+      {
+         file->data   = data;
+         file->len    = (size_t)buf.st_size;
+         file->mapped = true;
+      }
+   }
+
+   close(fd);
+#else
+   void *data  = NULL;
+   int64_t len = 0;
+
+   if (filestream_read_file(path, &data, &len) && data)
+   {
+      if (len > 0)
+      {
+         file->data = data;
+         file->len  = (size_t)len;
+      }
+      else
+         free(data);
+   }
+#endif
+
+   return file->data != NULL;
+}
+
+void cache_file_unload(cache_file_t *file)
+{
+   if (file->data)
+   {
+#ifdef HAVE_MMAP
+      if (file->mapped)
+         munmap(file->data, file->len);
+      else
+#endif
+         free(file->data);
+   }
+
+   file->data   = NULL;
+   file->len    = 0;
+   file->mapped = false;
+}
+
+bool cache_file_write(const char *path, const void *data, size_t len)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+   if (!filestream_write_file(tmp_path, data, (int64_t)len))
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   filestream_delete(path);
+
+   if (filestream_rename(tmp_path, path) != 0)
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   return true;
+}
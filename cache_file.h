@@ -0,0 +1,75 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2019 - Brad Parker
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CACHE_FILE_H_
+#define CACHE_FILE_H_
+
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Files the frontend derives from other files to skip work on
+ * the next start, such as the core info cache or the database
+ * index. They are written in the native byte order and used
+ * as is, a file written on another machine must fail the
+ * magic check of its owner and get rebuilt. */
+typedef struct cache_file
+{
+   void *data;
+   size_t len;
+   bool mapped;
+} cache_file_t;
+
+/**
+ * cache_file_load:
+ * @file                 : Cache file, zeroed.
+ * @path                 : Path of the file.
+ *
+ * Maps @path read-only where memory mapping is available,
+ * otherwise reads it into a buffer.
+ *
+ * Returns: true if the file is loaded and not empty.
+ **/
+bool cache_file_load(cache_file_t *file, const char *path);
+
+/**
+ * cache_file_unload:
+ * @file                 : Cache file.
+ *
+ * Releases what cache_file_load() loaded and zeroes @file.
+ **/
+void cache_file_unload(cache_file_t *file);
+
+/**
+ * cache_file_write:
+ * @path                 : Path of the file.
+ * @data                 : Content of the file.
+ * @len                  : Size of @data.
+ *
+ * Writes to "@path.tmp" first and renames it over @path, so
+ * that nobody reads half a file and that a mapping of the
+ * previous one stays valid.
+ *
+ * Returns: true on success.
+ **/
+bool cache_file_write(const char *path, const void *data, size_t len);
+
+RETRO_END_DECLS
+
+#endif
@@ -2073,7 +2073,25 @@ TODO: Add a setting for these tweaks */
                if (!netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_ENABLED, NULL))
 #endif
                {
-                  state_manager_event_init((unsigned)settings->sizes.rewind_buffer_size);
+                  char spill_path[PATH_MAX_LENGTH];
+                  const char *savestate_dir = dir_get(RARCH_DIR_SAVESTATE);
+
+                  spill_path[0] = '\0';
+
+                  if (settings->bools.rewind_disk_spill &&
+                        !string_is_empty(savestate_dir))
+                  {
+                     fill_pathname_join(spill_path, savestate_dir,
+                           path_basename(path_get(RARCH_PATH_BASENAME)),
+                           sizeof(spill_path));
+                     strlcat(spill_path, ".rewind", sizeof(spill_path));
+                  }
+
+                  state_manager_event_init((unsigned)settings->sizes.rewind_buffer_size,
+                        settings->arrays.rewind_engine,
+                        settings->uints.rewind_keyframe_interval,
+                        (size_t)settings->uints.rewind_keyframe_buffer_size * 1000000,
+                        spill_path);
                }
             }
          }
@@ -2317,18 +2335,29 @@ TODO: Add a setting for these tweaks */
       case CMD_EVENT_CORE_INFO_INIT:
          {
             char ext_name[255];
+            char dir_cache[PATH_MAX_LENGTH];
             settings_t *settings      = config_get_ptr();
 
             ext_name[0]               = '\0';
+            dir_cache[0]              = '\0';
 
             command_event(CMD_EVENT_CORE_INFO_DEINIT, NULL);
 
             if (!frontend_driver_get_core_extension(ext_name, sizeof(ext_name)))
                return false;
 
+            /* Next to the config file without a cache directory */
+            if (!string_is_empty(settings->paths.directory_cache))
+               strlcpy(dir_cache, settings->paths.directory_cache,
+                     sizeof(dir_cache));
+            else if (!path_is_empty(RARCH_PATH_CONFIG))
+               fill_pathname_basedir(dir_cache,
+                     path_get(RARCH_PATH_CONFIG), sizeof(dir_cache));
+
             if (!string_is_empty(settings->paths.directory_libretro))
                core_info_init_list(settings->paths.path_libretro_info,
                      settings->paths.directory_libretro,
+                     dir_cache,
                      ext_name,
                      settings->bools.show_hidden_files
                      );
@@ -151,6 +151,17 @@ static const bool load_dummy_on_core_shutdown = false;
 static const bool load_dummy_on_core_shutdown = true;
 #endif
 static const bool check_firmware_before_loading = false;
+/* Map content files into memory instead of reading them
+ * into a heap buffer when the core wants the data itself. */
+static const bool content_load_mmap = true;
+
+/* Decompressed hunks kept by each CHD image read during a
+ * content scan. */
+static const unsigned scan_chd_cache_hunks = 8;
+
+/* Hunks decompressed ahead by a background thread while a
+ * content scan reads a CHD image sequentially, 0 disables it. */
+static const unsigned scan_chd_prefetch_hunks = 0;
 /* Forcibly disable composition.
  * Only valid on Windows Vista/7/8 for now. */
 static const bool disable_composition = false;
@@ -495,6 +506,10 @@ static const bool gpu_screenshot = true;
 /* Watch shader files for changes and auto-apply as necessary. */
 static const bool video_shader_watch_files = false;
 
+/* Keep up to this many megabytes of compiled slang shaders on disk,
+ * so that presets load faster the next time. 0 disables the cache. */
+static const unsigned video_shader_cache_size = 32;
+
 /* Screenshots named automatically. */
 static const bool auto_screenshot_filename = true;
 
@@ -570,6 +585,10 @@ static const int out_latency = 64;
 /* Will sync audio. (recommended) */
 static const bool audio_sync = true;
 
+/* Process audio (DSP, resampling, mixing) and write it to the
+ * driver on a dedicated thread instead of the main thread. */
+static const bool audio_pipeline = false;
+
 /* Audio rate control. */
 #if !defined(RARCH_CONSOLE)
 static const bool rate_control = true;
@@ -632,6 +651,23 @@ static const unsigned rewind_buffer_size_step = 10; /* 10MB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Rewind engine. "legacy" delta-compresses the whole savestate on the
+ * main thread, "blocked" splits it into hashed blocks and compresses the
+ * changed ones on worker threads. */
+static const char *rewind_engine = "legacy";
+
+/* Frames between two full-state keyframes kept beyond the rewind
+ * buffer, 0 disables them. Once the rewind buffer is exhausted,
+ * rewinding continues one keyframe at a time. */
+static const unsigned rewind_keyframe_interval = 0;
+
+/* RAM budget for compressed keyframes, in MB. */
+static const unsigned rewind_keyframe_buffer_size = 128;
+
+/* Write keyframes that no longer fit in RAM to a file in the
+ * savestate directory instead of discarding them. */
+static const bool rewind_disk_spill = false;
+
 /* Pause gameplay when gameplay loses focus. */
 #ifdef EMSCRIPTEN
 static const bool pause_nonactive = false;
@@ -676,6 +712,12 @@ static const int netplay_check_frames = 600;
 
 static const bool netplay_use_mitm_server = false;
 
+/* Also send netplay input over UDP, with this many frames of
+ * redundancy per datagram, if the peer supports it */
+static const bool netplay_udp_input = false;
+
+static const unsigned netplay_udp_input_frames = 4;
+
 static const char *netplay_mitm_server = "nyc";
 
 #ifdef HAVE_NETWORKING
@@ -718,6 +760,11 @@ static const unsigned run_ahead_frames = 1;
 /* When using the Run Ahead feature, use a secondary instance of the core. */
 static const bool run_ahead_secondary_instance = true;
 
+/* When using the Run Ahead feature without a secondary instance, keep
+ * the states of the frames run ahead and skip loading a state back as
+ * long as the input matches the prediction. */
+static const bool run_ahead_skip_reload = false;
+
 /* Hide warning messages when using the Run Ahead feature. */
 static const bool run_ahead_hide_warnings = false;
 
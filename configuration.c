@@ -1186,6 +1186,7 @@ static struct config_array_setting *populate_settings_array(settings_t *settings
    SETTING_ARRAY("midi_output",              settings->arrays.midi_output, true, midi_output, true);
    SETTING_ARRAY("youtube_stream_key",       settings->arrays.youtube_stream_key, true, NULL, true);
    SETTING_ARRAY("discord_app_id",           settings->arrays.discord_app_id, true, default_discord_app_id, true);
+   SETTING_ARRAY("rewind_engine",            settings->arrays.rewind_engine, true, rewind_engine, true);
    *size = count;
 
    return tmp;
@@ -1215,6 +1216,7 @@ static struct config_path_setting *populate_settings_path(settings_t *settings,
    SETTING_PATH("netplay_ip_address",       settings->paths.netplay_server, false, NULL, true);
    SETTING_PATH("netplay_password",           settings->paths.netplay_password, false, NULL, true);
    SETTING_PATH("netplay_spectate_password",  settings->paths.netplay_spectate_password, false, NULL, true);
+   SETTING_PATH("netplay_record_directory",   settings->paths.directory_netplay_record, false, NULL, true);
 #endif
    SETTING_PATH("libretro_directory",
          settings->paths.directory_libretro, false, NULL, false);
@@ -1350,6 +1352,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("netplay_stateless_mode",        &settings->bools.netplay_stateless_mode, true, netplay_stateless_mode, false);
    SETTING_OVERRIDE(RARCH_OVERRIDE_SETTING_NETPLAY_STATELESS_MODE);
    SETTING_BOOL("netplay_use_mitm_server",       &settings->bools.netplay_use_mitm_server, true, netplay_use_mitm_server, false);
+   SETTING_BOOL("netplay_udp_input",             &settings->bools.netplay_udp_input, true, netplay_udp_input, false);
    SETTING_BOOL("netplay_request_device_p1",     &settings->bools.netplay_request_devices[0], true, false, false);
    SETTING_BOOL("netplay_request_device_p2",     &settings->bools.netplay_request_devices[1], true, false, false);
    SETTING_BOOL("netplay_request_device_p3",     &settings->bools.netplay_request_devices[2], true, false, false);
@@ -1371,6 +1374,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("input_descriptor_hide_unbound", &settings->bools.input_descriptor_hide_unbound, true, input_descriptor_hide_unbound, false);
    SETTING_BOOL("load_dummy_on_core_shutdown",   &settings->bools.load_dummy_on_core_shutdown, true, load_dummy_on_core_shutdown, false);
    SETTING_BOOL("check_firmware_before_loading", &settings->bools.check_firmware_before_loading, true, check_firmware_before_loading, false);
+   SETTING_BOOL("content_load_mmap",             &settings->bools.content_load_mmap, true, content_load_mmap, false);
    SETTING_BOOL("builtin_mediaplayer_enable",    &settings->bools.multimedia_builtin_mediaplayer_enable, false, false /* TODO */, false);
    SETTING_BOOL("builtin_imageviewer_enable",    &settings->bools.multimedia_builtin_imageviewer_enable, true, true, false);
    SETTING_BOOL("fps_show",                      &settings->bools.video_fps_show, true, fps_show, false);
@@ -1380,13 +1384,16 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("ui_menubar_enable",             &settings->bools.ui_menubar_enable, true, true, false);
    SETTING_BOOL("suspend_screensaver_enable",    &settings->bools.ui_suspend_screensaver_enable, true, true, false);
    SETTING_BOOL("rewind_enable",                 &settings->bools.rewind_enable, true, rewind_enable, false);
+   SETTING_BOOL("rewind_disk_spill",             &settings->bools.rewind_disk_spill, true, rewind_disk_spill, false);
    SETTING_BOOL("vrr_runloop_enable",            &settings->bools.vrr_runloop_enable, true, vrr_runloop_enable, false);
    SETTING_BOOL("apply_cheats_after_toggle",     &settings->bools.apply_cheats_after_toggle, true, apply_cheats_after_toggle, false);
    SETTING_BOOL("apply_cheats_after_load",       &settings->bools.apply_cheats_after_load, true, apply_cheats_after_load, false);
    SETTING_BOOL("run_ahead_enabled",             &settings->bools.run_ahead_enabled, true, false, false);
    SETTING_BOOL("run_ahead_secondary_instance",  &settings->bools.run_ahead_secondary_instance, true, false, false);
+   SETTING_BOOL("run_ahead_skip_reload",         &settings->bools.run_ahead_skip_reload, true, run_ahead_skip_reload, false);
    SETTING_BOOL("run_ahead_hide_warnings",       &settings->bools.run_ahead_hide_warnings, true, false, false);
    SETTING_BOOL("audio_sync",                    &settings->bools.audio_sync, true, audio_sync, false);
+   SETTING_BOOL("audio_pipeline",                &settings->bools.audio_pipeline, true, audio_pipeline, false);
    SETTING_BOOL("video_shader_enable",           &settings->bools.video_shader_enable, true, shader_enable, false);
    SETTING_BOOL("video_shader_watch_files",      &settings->bools.video_shader_watch_files, true, video_shader_watch_files, false);
 
@@ -1687,6 +1694,10 @@ static struct config_uint_setting *populate_settings_uint(settings_t *settings,
 #endif
    SETTING_UINT("rewind_granularity",           &settings->uints.rewind_granularity, true, rewind_granularity, false);
    SETTING_UINT("rewind_buffer_size_step",      &settings->uints.rewind_buffer_size_step, true, rewind_buffer_size_step, false);
+   SETTING_UINT("rewind_keyframe_interval",     &settings->uints.rewind_keyframe_interval, true, rewind_keyframe_interval, false);
+   SETTING_UINT("rewind_keyframe_buffer_size",  &settings->uints.rewind_keyframe_buffer_size, true, rewind_keyframe_buffer_size, false);
+   SETTING_UINT("scan_chd_cache_hunks",         &settings->uints.scan_chd_cache_hunks, true, scan_chd_cache_hunks, false);
+   SETTING_UINT("scan_chd_prefetch_hunks",      &settings->uints.scan_chd_prefetch_hunks, true, scan_chd_prefetch_hunks, false);
    SETTING_UINT("autosave_interval",            &settings->uints.autosave_interval,  true, autosave_interval, false);
    SETTING_UINT("libretro_log_level",           &settings->uints.libretro_log_level, true, libretro_log_level, false);
    SETTING_UINT("keyboard_gamepad_mapping_type",&settings->uints.input_keyboard_gamepad_mapping_type, true, 1, false);
@@ -1695,6 +1706,7 @@ static struct config_uint_setting *populate_settings_uint(settings_t *settings,
    SETTING_UINT("video_fullscreen_x",           &settings->uints.video_fullscreen_x,  true, fullscreen_x, false);
    SETTING_UINT("video_fullscreen_y",           &settings->uints.video_fullscreen_y,  true, fullscreen_y, false);
    SETTING_UINT("video_window_opacity",         &settings->uints.video_window_opacity, true, window_opacity, false);
+   SETTING_UINT("video_shader_cache_size",      &settings->uints.video_shader_cache_size, true, video_shader_cache_size, false);
 #ifdef HAVE_COMMAND
    SETTING_UINT("network_cmd_port",             &settings->uints.network_cmd_port,    true, network_cmd_port, false);
 #endif
@@ -1766,6 +1778,7 @@ static struct config_uint_setting *populate_settings_uint(settings_t *settings,
    SETTING_UINT("netplay_input_latency_frames_range",&settings->uints.netplay_input_latency_frames_range, true, 0, false);
    SETTING_UINT("netplay_share_digital",        &settings->uints.netplay_share_digital, true, netplay_share_digital, false);
    SETTING_UINT("netplay_share_analog",         &settings->uints.netplay_share_analog,  true, netplay_share_analog, false);
+   SETTING_UINT("netplay_udp_input_frames",     &settings->uints.netplay_udp_input_frames, true, netplay_udp_input_frames, false);
 #endif
 #ifdef HAVE_LANGEXTRA
    SETTING_UINT("user_language",                msg_hash_get_uint(MSG_HASH_USER_LANGUAGE), true, def_user_language, false);
@@ -2312,6 +2325,9 @@ void config_set_defaults(void)
    if (midi_output)
       strlcpy(settings->arrays.midi_output,
             midi_output, sizeof(settings->arrays.midi_output));
+   if (rewind_engine)
+      strlcpy(settings->arrays.rewind_engine,
+            rewind_engine, sizeof(settings->arrays.rewind_engine));
 
    /* Avoid reloading config on every content load */
    if (default_block_config_read)
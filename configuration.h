@@ -115,6 +115,7 @@ typedef struct settings
       bool audio_enable_menu_notice;
       bool audio_enable_menu_bgm;
       bool audio_sync;
+      bool audio_pipeline;
       bool audio_rate_control;
       bool audio_wasapi_exclusive_mode;
       bool audio_wasapi_float_format;
@@ -219,6 +220,7 @@ typedef struct settings
       bool netplay_stateless_mode;
       bool netplay_nat_traversal;
       bool netplay_use_mitm_server;
+      bool netplay_udp_input;
       bool netplay_request_devices[MAX_USERS];
 
       /* Network */
@@ -268,11 +270,13 @@ typedef struct settings
       bool playlist_entry_remove;
       bool playlist_entry_rename;
       bool rewind_enable;
+      bool rewind_disk_spill;
       bool vrr_runloop_enable;
       bool apply_cheats_after_toggle;
       bool apply_cheats_after_load;
       bool run_ahead_enabled;
       bool run_ahead_secondary_instance;
+      bool run_ahead_skip_reload;
       bool run_ahead_hide_warnings;
       bool pause_nonactive;
       bool block_sram_overwrite;
@@ -287,6 +291,7 @@ typedef struct settings
       bool network_remote_enable_user[MAX_USERS];
       bool load_dummy_on_core_shutdown;
       bool check_firmware_before_loading;
+      bool content_load_mmap;
 
       bool game_specific_options;
       bool auto_overrides_enable;
@@ -401,17 +406,23 @@ typedef struct settings
       unsigned netplay_input_latency_frames_range;
       unsigned netplay_share_digital;
       unsigned netplay_share_analog;
+      unsigned netplay_udp_input_frames;
       unsigned bundle_assets_extract_version_current;
       unsigned bundle_assets_extract_last_version;
       unsigned content_history_size;
       unsigned libretro_log_level;
       unsigned rewind_granularity;
       unsigned rewind_buffer_size_step;
+      unsigned rewind_keyframe_interval;
+      unsigned rewind_keyframe_buffer_size;
+      unsigned scan_chd_cache_hunks;
+      unsigned scan_chd_prefetch_hunks;
       unsigned autosave_interval;
       unsigned network_cmd_port;
       unsigned network_remote_base_port;
       unsigned keymapper_port;
       unsigned video_window_opacity;
+      unsigned video_shader_cache_size;
       unsigned crt_switch_resolution;
       unsigned crt_switch_resolution_super;
       unsigned video_monitor_index;
@@ -523,6 +534,7 @@ typedef struct settings
       char input_driver[32];
       char input_joypad_driver[32];
       char midi_driver[32];
+      char rewind_engine[32];
 
       char input_keyboard_layout[64];
 
@@ -604,6 +616,7 @@ typedef struct settings
       char directory_thumbnails[PATH_MAX_LENGTH];
       char directory_menu_config[PATH_MAX_LENGTH];
       char directory_menu_content[PATH_MAX_LENGTH];
+      char directory_netplay_record[PATH_MAX_LENGTH];
       char streaming_title[PATH_MAX_LENGTH];
 
       char log_dir[PATH_MAX_LENGTH];
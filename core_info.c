@@ -15,6 +15,13 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <retro_miscellaneous.h>
 #include <compat/strl.h>
 #include <string/stdstring.h>
 #include <file/config_file.h>
@@ -23,12 +30,9 @@
 #include <file/archive_file.h>
 #include <streams/file_stream.h>
 
-#ifdef HAVE_CONFIG_H
-#include "config.h"
-#endif
-
 #include "verbosity.h"
 
+#include "cache_file.h"
 #include "core_info.h"
 #include "file_path_special.h"
 
@@ -81,60 +85,230 @@ static void core_info_list_resolve_all_extensions(
 #endif
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+#define CORE_INFO_CACHE_MAGIC   0x49435243 /* "CRCI" */
+#define CORE_INFO_CACHE_VERSION 1
+#define CORE_INFO_CACHE_NONE    0xFFFFFFFF
+
+#define CORE_INFO_CACHE_NO_GAME                (1 << 0)
+#define CORE_INFO_CACHE_MATCH_ARCHIVE_MEMBER   (1 << 1)
+
+/* String fields read from the .info files, along with
+ * the lists they are split into */
+static const struct core_info_field
+{
+   const char *key;
+   size_t offset;
+   size_t list_offset;
+} core_info_fields[] = {
+   { "display_name",         offsetof(core_info_t, display_name),         0 },
+   { "display_version",      offsetof(core_info_t, display_version),      0 },
+   { "corename",             offsetof(core_info_t, core_name),            0 },
+   { "systemname",           offsetof(core_info_t, systemname),           0 },
+   { "systemid",             offsetof(core_info_t, system_id),            0 },
+   { "manufacturer",         offsetof(core_info_t, system_manufacturer),  0 },
+   { "supported_extensions", offsetof(core_info_t, supported_extensions),
+      offsetof(core_info_t, supported_extensions_list) },
+   { "authors",              offsetof(core_info_t, authors),
+      offsetof(core_info_t, authors_list) },
+   { "permissions",          offsetof(core_info_t, permissions),
+      offsetof(core_info_t, permissions_list) },
+   { "license",              offsetof(core_info_t, licenses),
+      offsetof(core_info_t, licenses_list) },
+   { "categories",           offsetof(core_info_t, categories),
+      offsetof(core_info_t, categories_list) },
+   { "database",             offsetof(core_info_t, databases),
+      offsetof(core_info_t, databases_list) },
+   { "notes",                offsetof(core_info_t, notes),
+      offsetof(core_info_t, note_list) },
+};
+
+#define CORE_INFO_FIELD_COUNT ARRAY_SIZE(core_info_fields)
+
+/* A cache file, see cache_file.h. Strings are referenced by
+ * their offset in the string section at the end. */
+typedef struct core_info_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t entry_count;
+   uint32_t firmware_count;
+   uint32_t strings_size;
+   uint32_t reserved;
+} core_info_cache_header_t;
+
+typedef struct core_info_cache_entry
+{
+   uint64_t size;
+   int64_t mtime;
+   uint32_t path;
+   uint32_t hash;
+   uint32_t fields[CORE_INFO_FIELD_COUNT];
+   uint32_t firmware_count;
+   uint32_t firmware;
+   uint32_t flags;
+} core_info_cache_entry_t;
+
+typedef struct core_info_cache_firmware
+{
+   uint32_t path;
+   uint32_t desc;
+   uint32_t optional;
+} core_info_cache_firmware_t;
+
+typedef struct core_info_cache
+{
+   cache_file_t file;
+   const core_info_cache_header_t *header;
+   const core_info_cache_entry_t *entries;
+   const core_info_cache_firmware_t *firmware;
+   const char *strings;
+} core_info_cache_t;
+
+/* .info file found for each core of the list */
+typedef struct core_info_path
+{
+   char *path;
+   uint64_t size;
+   int64_t mtime;
+} core_info_path_t;
+
+typedef struct core_info_cache_strings
+{
+   char *data;
+   size_t size;
+   size_t capacity;
+} core_info_cache_strings_t;
+
+static uint32_t core_info_hash(const char *s)
+{
+   uint32_t hash = 5381;
+
+   while (*s)
+      hash = (hash << 5) + hash + (uint8_t)*s++;
+
+   return hash;
+}
+
+static bool core_info_stat(const char *path, uint64_t *size, int64_t *mtime)
+{
+   int64_t len = 0;
+
+   if (!path_get_size_mtime(path, &len, mtime))
+      return false;
+
+   *size = (uint64_t)len;
+
+   return true;
+}
+
+static void core_info_set_field(core_info_t *info,
+      const struct core_info_field *field, const char *value)
+{
+   char *copy = strdup(value);
+
+   *(char**)((uint8_t*)info + field->offset) = copy;
+
+   if (copy && field->list_offset)
+      *(struct string_list**)((uint8_t*)info + field->list_offset) =
+         string_split(copy, "|");
+}
+
+static void core_info_parse_config(core_info_t *info, config_file_t *conf)
 {
    size_t i;
    unsigned c;
+   unsigned count = 0;
+   bool tmp_bool  = false;
+   char *tmp      = NULL;
 
-   for (i = 0; i < core_info_list->count; i++)
+   for (i = 0; i < CORE_INFO_FIELD_COUNT; i++)
    {
-      unsigned count                  = 0;
-      core_info_firmware_t *firmware  = NULL;
-      core_info_t *info               = (core_info_t*)&core_info_list->list[i];
-      config_file_t *config           = (config_file_t*)info->config_data;
+      if (config_get_string(conf, core_info_fields[i].key, &tmp)
+            && !string_is_empty(tmp))
+         core_info_set_field(info, &core_info_fields[i], tmp);
 
-      if (!config || !config_get_uint(config, "firmware_count", &count))
-         continue;
+      free(tmp);
+      tmp = NULL;
+   }
 
-      firmware = (core_info_firmware_t*)calloc(count, sizeof(*firmware));
+   if (config_get_bool(conf, "supports_no_game", &tmp_bool))
+      info->supports_no_game = tmp_bool;
 
-      if (!firmware)
-         continue;
+   if (config_get_bool(conf, "database_match_archive_member", &tmp_bool))
+      info->database_match_archive_member = tmp_bool;
 
-      info->firmware = firmware;
+   if (!config_get_uint(conf, "firmware_count", &count))
+      return;
 
-      for (c = 0; c < count; c++)
-      {
-         char path_key[64];
-         char desc_key[64];
-         char opt_key[64];
-         bool tmp_bool     = false;
-         char *tmp         = NULL;
-         path_key[0]       = desc_key[0] = opt_key[0] = '\0';
-
-         snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
-         snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
-         snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
-
-         if (config_get_string(config, path_key, &tmp) && !string_is_empty(tmp))
-         {
-            info->firmware[c].path = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(config, desc_key, &tmp) && !string_is_empty(tmp))
-         {
-            info->firmware[c].desc = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (tmp)
-            free(tmp);
-         tmp = NULL;
-         if (config_get_bool(config, opt_key , &tmp_bool))
-            info->firmware[c].optional = tmp_bool;
-      }
+   info->firmware_count = count;
+
+   if (!(info->firmware = (core_info_firmware_t*)
+            calloc(count, sizeof(*info->firmware))))
+   {
+      info->firmware_count = 0;
+      return;
+   }
+
+   for (c = 0; c < count; c++)
+   {
+      char path_key[64];
+      char desc_key[64];
+      char opt_key[64];
+
+      snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
+      snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
+      snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
+
+      if (config_get_string(conf, path_key, &tmp) && !string_is_empty(tmp))
+         info->firmware[c].path = strdup(tmp);
+      free(tmp);
+      tmp = NULL;
+
+      if (config_get_string(conf, desc_key, &tmp) && !string_is_empty(tmp))
+         info->firmware[c].desc = strdup(tmp);
+      free(tmp);
+      tmp = NULL;
+
+      if (config_get_bool(conf, opt_key, &tmp_bool))
+         info->firmware[c].optional = tmp_bool;
+   }
+}
+
+static void core_info_parse_cache(core_info_t *info,
+      const core_info_cache_t *cache, const core_info_cache_entry_t *entry)
+{
+   size_t i;
+   uint32_t c;
+
+   for (i = 0; i < CORE_INFO_FIELD_COUNT; i++)
+      if (entry->fields[i] != CORE_INFO_CACHE_NONE)
+         core_info_set_field(info, &core_info_fields[i],
+               cache->strings + entry->fields[i]);
+
+   info->supports_no_game              =
+      (entry->flags & CORE_INFO_CACHE_NO_GAME) != 0;
+   info->database_match_archive_member =
+      (entry->flags & CORE_INFO_CACHE_MATCH_ARCHIVE_MEMBER) != 0;
+
+   if (!entry->firmware_count)
+      return;
+
+   if (!(info->firmware = (core_info_firmware_t*)
+            calloc(entry->firmware_count, sizeof(*info->firmware))))
+      return;
+
+   info->firmware_count = entry->firmware_count;
+
+   for (c = 0; c < entry->firmware_count; c++)
+   {
+      const core_info_cache_firmware_t *firmware =
+         &cache->firmware[entry->firmware + c];
+
+      if (firmware->path != CORE_INFO_CACHE_NONE)
+         info->firmware[c].path = strdup(cache->strings + firmware->path);
+      if (firmware->desc != CORE_INFO_CACHE_NONE)
+         info->firmware[c].desc = strdup(cache->strings + firmware->desc);
+      info->firmware[c].optional = firmware->optional != 0;
    }
 }
 
@@ -170,7 +344,6 @@ static void core_info_list_free(core_info_list_t *core_info_list)
       string_list_free(info->licenses_list);
       string_list_free(info->categories_list);
       string_list_free(info->databases_list);
-      config_file_free((config_file_t*)info->config_data);
 
       for (j = 0; j < info->firmware_count; j++)
       {
@@ -185,25 +358,289 @@ static void core_info_list_free(core_info_list_t *core_info_list)
    free(core_info_list);
 }
 
-static config_file_t *core_info_list_iterate(
+static bool core_info_cache_parse(core_info_cache_t *cache)
+{
+   uint32_t i, j;
+   uint64_t len                           = cache->file.len;
+   const uint8_t *data                    = (const uint8_t*)cache->file.data;
+   const core_info_cache_header_t *header = (const core_info_cache_header_t*)data;
+
+   if (     len < sizeof(*header)
+         || header->magic   != CORE_INFO_CACHE_MAGIC
+         || header->version != CORE_INFO_CACHE_VERSION)
+      return false;
+
+   len -= sizeof(*header);
+
+   if (     header->entry_count    > len / sizeof(core_info_cache_entry_t)
+         || header->firmware_count > len / sizeof(core_info_cache_firmware_t))
+      return false;
+
+   if (len != (uint64_t)header->entry_count * sizeof(core_info_cache_entry_t)
+         + (uint64_t)header->firmware_count * sizeof(core_info_cache_firmware_t)
+         + header->strings_size)
+      return false;
+
+   cache->header   = header;
+   cache->entries  = (const core_info_cache_entry_t*)(header + 1);
+   cache->firmware = (const core_info_cache_firmware_t*)
+      (cache->entries + header->entry_count);
+   cache->strings  = (const char*)(cache->firmware + header->firmware_count);
+
+   if (header->strings_size == 0
+         || cache->strings[header->strings_size - 1] != '\0')
+      return false;
+
+   for (i = 0; i < header->entry_count; i++)
+   {
+      const core_info_cache_entry_t *entry = &cache->entries[i];
+
+      if (     entry->path >= header->strings_size
+            || entry->firmware > header->firmware_count
+            || entry->firmware_count > header->firmware_count - entry->firmware)
+         return false;
+
+      for (j = 0; j < CORE_INFO_FIELD_COUNT; j++)
+         if (     entry->fields[j] != CORE_INFO_CACHE_NONE
+               && entry->fields[j] >= header->strings_size)
+            return false;
+   }
+
+   for (i = 0; i < header->firmware_count; i++)
+   {
+      const core_info_cache_firmware_t *firmware = &cache->firmware[i];
+
+      if (     (firmware->path != CORE_INFO_CACHE_NONE
+               && firmware->path >= header->strings_size)
+            || (firmware->desc != CORE_INFO_CACHE_NONE
+               && firmware->desc >= header->strings_size))
+         return false;
+   }
+
+   return true;
+}
+
+static void core_info_cache_unload(core_info_cache_t *cache)
+{
+   cache_file_unload(&cache->file);
+   memset(cache, 0, sizeof(*cache));
+}
+
+static bool core_info_cache_load(core_info_cache_t *cache, const char *path)
+{
+   if (!cache_file_load(&cache->file, path))
+      return false;
+
+   if (!core_info_cache_parse(cache))
+   {
+      RARCH_WARN("[Core Info]: Ignoring invalid cache \"%s\".\n", path);
+      core_info_cache_unload(cache);
+      return false;
+   }
+
+   return true;
+}
+
+/* Returns: index of the cache entry of @path if it is
+ * still current, otherwise -1. */
+static int core_info_cache_find(const core_info_cache_t *cache,
+      const core_info_path_t *info_path, size_t hint)
+{
+   uint32_t i;
+   uint32_t hash;
+
+   if (!cache->header)
+      return -1;
+
+   hash = core_info_hash(info_path->path);
+
+   /* The cores are listed in the same order most of the time */
+   for (i = 0; i < cache->header->entry_count; i++)
+   {
+      uint32_t idx                         = (uint32_t)
+         ((hint + i) % cache->header->entry_count);
+      const core_info_cache_entry_t *entry = &cache->entries[idx];
+
+      if (     entry->hash == hash
+            && string_is_equal(cache->strings + entry->path, info_path->path))
+      {
+         if (     entry->size  == info_path->size
+               && entry->mtime == info_path->mtime)
+            return (int)idx;
+         return -1;
+      }
+   }
+
+   return -1;
+}
+
+static uint32_t core_info_cache_push_string(core_info_cache_strings_t *strings,
+      const char *s)
+{
+   size_t len;
+   uint32_t offset;
+
+   if (!s)
+      return CORE_INFO_CACHE_NONE;
+
+   len = strlen(s) + 1;
+
+   if (strings->size + len > strings->capacity)
+   {
+      size_t capacity = strings->capacity ? strings->capacity * 2 : 16384;
+      char *data      = NULL;
+
+      while (capacity < strings->size + len)
+         capacity *= 2;
+
+      if (!(data = (char*)realloc(strings->data, capacity)))
+         return CORE_INFO_CACHE_NONE;
+
+      strings->data     = data;
+      strings->capacity = capacity;
+   }
+
+   offset         = (uint32_t)strings->size;
+   memcpy(strings->data + strings->size, s, len);
+   strings->size += len;
+
+   return offset;
+}
+
+/* Writes the info of every core with a .info file. */
+static void core_info_cache_write(const char *path,
+      const core_info_list_t *core_info_list,
+      const core_info_path_t *info_paths)
+{
+   size_t i, j;
+   core_info_cache_header_t header;
+   core_info_cache_strings_t strings      = {0};
+   core_info_cache_entry_t *entries       = NULL;
+   core_info_cache_firmware_t *firmware   = NULL;
+   uint8_t *data                          = NULL;
+   size_t entry_count                     = 0;
+   size_t firmware_count                  = 0;
+   size_t len                             = 0;
+
+   for (i = 0; i < core_info_list->count; i++)
+      firmware_count += core_info_list->list[i].firmware_count;
+
+   entries  = (core_info_cache_entry_t*)calloc(
+         core_info_list->count + 1, sizeof(*entries));
+   firmware = (core_info_cache_firmware_t*)calloc(
+         firmware_count + 1, sizeof(*firmware));
+
+   if (!entries || !firmware)
+      goto end;
+
+   firmware_count = 0;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      const core_info_t *info         = &core_info_list->list[i];
+      core_info_cache_entry_t *entry  = &entries[entry_count];
+      uint32_t hash;
+
+      if (!info->has_info)
+         continue;
+
+      /* Cores sharing a .info file only need one entry */
+      hash = core_info_hash(info_paths[i].path);
+      for (j = 0; j < entry_count; j++)
+         if (     entries[j].hash == hash
+               && string_is_equal(strings.data + entries[j].path,
+                  info_paths[i].path))
+            break;
+      if (j < entry_count)
+         continue;
+
+      entry->size  = info_paths[i].size;
+      entry->mtime = info_paths[i].mtime;
+      entry->path  = core_info_cache_push_string(&strings, info_paths[i].path);
+      entry->hash  = hash;
+
+      if (entry->path == CORE_INFO_CACHE_NONE)
+         goto end;
+
+      for (j = 0; j < CORE_INFO_FIELD_COUNT; j++)
+         entry->fields[j] = core_info_cache_push_string(&strings,
+               *(const char**)((const uint8_t*)info
+                  + core_info_fields[j].offset));
+
+      if (info->supports_no_game)
+         entry->flags |= CORE_INFO_CACHE_NO_GAME;
+      if (info->database_match_archive_member)
+         entry->flags |= CORE_INFO_CACHE_MATCH_ARCHIVE_MEMBER;
+
+      entry->firmware       = (uint32_t)firmware_count;
+      entry->firmware_count = info->firmware ? (uint32_t)info->firmware_count : 0;
+
+      for (j = 0; j < entry->firmware_count; j++)
+      {
+         firmware[firmware_count].path     = core_info_cache_push_string(
+               &strings, info->firmware[j].path);
+         firmware[firmware_count].desc     = core_info_cache_push_string(
+               &strings, info->firmware[j].desc);
+         firmware[firmware_count].optional = info->firmware[j].optional;
+         firmware_count++;
+      }
+
+      entry_count++;
+   }
+
+   if (!strings.size)
+      goto end;
+
+   header.magic          = CORE_INFO_CACHE_MAGIC;
+   header.version        = CORE_INFO_CACHE_VERSION;
+   header.entry_count    = (uint32_t)entry_count;
+   header.firmware_count = (uint32_t)firmware_count;
+   header.strings_size   = (uint32_t)strings.size;
+   header.reserved       = 0;
+
+   len = sizeof(header) + entry_count * sizeof(*entries)
+      + firmware_count * sizeof(*firmware) + strings.size;
+
+   if (!(data = (uint8_t*)malloc(len)))
+      goto end;
+
+   {
+      uint8_t *pos = data;
+
+      memcpy(pos, &header, sizeof(header));
+      pos += sizeof(header);
+      memcpy(pos, entries, entry_count * sizeof(*entries));
+      pos += entry_count * sizeof(*entries);
+      memcpy(pos, firmware, firmware_count * sizeof(*firmware));
+      pos += firmware_count * sizeof(*firmware);
+      memcpy(pos, strings.data, strings.size);
+   }
+
+   if (!cache_file_write(path, data, len))
+      RARCH_WARN("[Core Info]: Failed to write cache \"%s\".\n", path);
+
+end:
+   free(data);
+   free(entries);
+   free(firmware);
+   free(strings.data);
+}
+
+static bool core_info_list_iterate(core_info_path_t *info_path,
       const char *current_path,
       const char *path_basedir)
 {
-   size_t info_path_base_size = PATH_MAX_LENGTH * sizeof(char);
-   char *info_path_base       = NULL;
-   char *info_path            = NULL;
-   config_file_t *conf        = NULL;
+   char info_path_base[PATH_MAX_LENGTH];
+   char path[PATH_MAX_LENGTH];
 
    if (!current_path)
-      return NULL;
-
-   info_path_base             = (char*)malloc(info_path_base_size);
+      return false;
 
    info_path_base[0] = '\0';
 
    fill_pathname_base_noext(info_path_base,
          current_path,
-         info_path_base_size);
+         sizeof(info_path_base));
 
 #if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP) && !defined(_3DS) && !defined(VITA) && !defined(PS2) && !defined(HW_WUP))
    {
@@ -215,30 +652,37 @@ static config_file_t *core_info_list_iterate(
 
    strlcat(info_path_base,
          file_path_str(FILE_PATH_CORE_INFO_EXTENSION),
-         info_path_base_size);
+         sizeof(info_path_base));
 
-   info_path = (char*)malloc(info_path_base_size);
-   fill_pathname_join(info_path,
+   fill_pathname_join(path,
          path_basedir,
-         info_path_base, info_path_base_size);
-   free(info_path_base);
-   info_path_base = NULL;
+         info_path_base, sizeof(path));
+
+   if (!core_info_stat(path, &info_path->size, &info_path->mtime))
+      return false;
 
-   if (path_is_valid(info_path))
-      conf = config_file_new(info_path);
-   free(info_path);
+   info_path->path = strdup(path);
 
-   return conf;
+   return info_path->path != NULL;
 }
 
 static core_info_list_t *core_info_list_new(const char *path,
       const char *libretro_info_dir,
+      const char *dir_cache,
       const char *exts,
       bool dir_show_hidden_files)
 {
    size_t i;
+   char cache_path[PATH_MAX_LENGTH];
+   char cache_name[64];
+   core_info_cache_t cache          = {0};
    core_info_t *core_info           = NULL;
    core_info_list_t *core_info_list = NULL;
+   core_info_path_t *info_paths     = NULL;
+   bool *cache_used                 = NULL;
+   unsigned hits                    = 0;
+   unsigned misses                  = 0;
+   bool cache_current               = true;
    const char       *path_basedir   = libretro_info_dir;
    struct string_list *contents     = string_list_new();
    bool                          ok = dir_list_append(contents, path, exts,
@@ -271,9 +715,13 @@ static core_info_list_t *core_info_list_new(const char *path,
       return NULL;
    }
 
-   core_info = (core_info_t*)calloc(contents->size, sizeof(*core_info));
-   if (!core_info)
+   core_info  = (core_info_t*)calloc(contents->size, sizeof(*core_info));
+   info_paths = (core_info_path_t*)calloc(contents->size + 1,
+         sizeof(*info_paths));
+   if (!core_info || !info_paths)
    {
+      free(core_info);
+      free(info_paths);
       core_info_list_free(core_info_list);
       string_list_free(contents);
       return NULL;
@@ -282,160 +730,57 @@ static core_info_list_t *core_info_list_new(const char *path,
    core_info_list->list  = core_info;
    core_info_list->count = contents->size;
 
-   for (i = 0; i < contents->size; i++)
-   {
-      const char *path      = contents->elems[i].data;
-      config_file_t *conf   = core_info_list_iterate(path,
-            path_basedir);
-
-      if (conf)
-      {
-         char *tmp           = NULL;
-
-         if (config_get_string(conf, "display_name", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].display_name = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(conf, "display_version", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].display_version = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(conf, "corename", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].core_name = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "systemname", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].systemname = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "systemid", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].system_id = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "manufacturer", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].system_manufacturer = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         {
-            unsigned count      = 0;
-            config_get_uint(conf, "firmware_count", &count);
-            core_info[i].firmware_count = count;
-         }
+   /* Cached info is only used as long as the size and
+    * the modification time of the .info file match. The
+    * .info directory is often read-only, so the cache goes
+    * to the cache directory, one file per .info directory. */
+   cache_path[0] = '\0';
 
-         if (config_get_string(conf, "supported_extensions", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].supported_extensions      = strdup(tmp);
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "authors", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].authors      = strdup(tmp);
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "permissions", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].permissions      = strdup(tmp);
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
+   if (!string_is_empty(dir_cache))
+   {
+      snprintf(cache_name, sizeof(cache_name), "%08x_%s",
+            (unsigned)core_info_hash(path_basedir),
+            file_path_str(FILE_PATH_CORE_INFO_CACHE));
+      fill_pathname_join(cache_path, dir_cache,
+            cache_name, sizeof(cache_path));
+   }
 
-            free(tmp);
-            tmp = NULL;
-         }
+   if (     !string_is_empty(cache_path)
+         && path_is_valid(cache_path)
+         && core_info_cache_load(&cache, cache_path))
+      cache_used = (bool*)calloc(cache.header->entry_count + 1,
+            sizeof(*cache_used));
 
-         if (config_get_string(conf, "license", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].licenses      = strdup(tmp);
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
+   for (i = 0; i < contents->size; i++)
+   {
+      const char *path    = contents->elems[i].data;
 
-            free(tmp);
-            tmp = NULL;
-         }
+      if (core_info_list_iterate(&info_paths[i], path, path_basedir))
+      {
+         int entry = cache_used
+            ? core_info_cache_find(&cache, &info_paths[i], i) : -1;
 
-         if (config_get_string(conf, "categories", &tmp)
-               && !string_is_empty(tmp))
+         if (entry >= 0)
          {
-            core_info[i].categories      = strdup(tmp);
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
-
-            free(tmp);
-            tmp = NULL;
+            core_info_parse_cache(&core_info[i], &cache,
+                  &cache.entries[entry]);
+            core_info[i].has_info = true;
+            cache_used[entry]     = true;
+            hits++;
          }
-
-         if (config_get_string(conf, "database", &tmp)
-               && !string_is_empty(tmp))
+         else
          {
-            core_info[i].databases      = strdup(tmp);
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
+            config_file_t *conf = config_file_new(info_paths[i].path);
 
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "notes", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].notes     = strdup(tmp);
-            core_info[i].note_list = string_split(core_info[i].notes, "|");
+            if (conf)
+            {
+               core_info_parse_config(&core_info[i], conf);
+               core_info[i].has_info = true;
+               config_file_free(conf);
+            }
 
-            free(tmp);
-            tmp = NULL;
+            misses++;
          }
-
-         if (tmp)
-            free(tmp);
-         tmp    = NULL;
-
-         {
-            bool tmp_bool       = false;
-            if (config_get_bool(conf, "supports_no_game",
-                     &tmp_bool))
-               core_info[i].supports_no_game = tmp_bool;
-
-            if (config_get_bool(conf, "database_match_archive_member",
-                     &tmp_bool))
-               core_info[i].database_match_archive_member = tmp_bool;
-         }
-
-         core_info[i].config_data = conf;
       }
 
       if (!string_is_empty(path))
@@ -446,12 +791,35 @@ static core_info_list_t *core_info_list_new(const char *path,
             strdup(path_basename(core_info[i].path));
    }
 
-   if (core_info_list)
+   core_info_list_resolve_all_extensions(core_info_list);
+
+   if (misses)
+      cache_current = false;
+   else if (cache.header)
+   {
+      /* Drop the entries of the removed .info files */
+      for (i = 0; i < cache.header->entry_count; i++)
+         if (!cache_used[i])
+            cache_current = false;
+   }
+
+   RARCH_LOG("[Core Info]: Cache: %u hits, %u misses.\n", hits, misses);
+
+   core_info_cache_unload(&cache);
+
+   if (!cache_current && !string_is_empty(cache_path))
    {
-      core_info_list_resolve_all_extensions(core_info_list);
-      core_info_list_resolve_all_firmware(core_info_list);
+      if (!path_is_directory(dir_cache) && !path_mkdir(dir_cache))
+         RARCH_WARN("[Core Info]: Failed to create cache directory \"%s\".\n",
+               dir_cache);
+      else
+         core_info_cache_write(cache_path, core_info_list, info_paths);
    }
 
+   for (i = 0; i < contents->size; i++)
+      free(info_paths[i].path);
+   free(info_paths);
+   free(cache_used);
    string_list_free(contents);
    return core_info_list;
 }
@@ -624,10 +992,11 @@ void core_info_deinit_list(void)
 }
 
 bool core_info_init_list(const char *path_info, const char *dir_cores,
-      const char *exts, bool dir_show_hidden_files)
+      const char *dir_cache, const char *exts, bool dir_show_hidden_files)
 {
    if (!(core_info_curr_list = core_info_list_new(dir_cores,
                !string_is_empty(path_info) ? path_info : dir_cores,
+               dir_cache,
                exts,
                dir_show_hidden_files)))
       return false;
@@ -760,6 +1129,7 @@ void core_info_get_name(const char *path, char *s, size_t len,
 
    for (i = 0; i < contents->size; i++)
    {
+      core_info_path_t info_path;
       config_file_t *conf             = NULL;
       char *new_core_name             = NULL;
       const char *current_path        = contents->elems[i].data;
@@ -767,8 +1137,12 @@ void core_info_get_name(const char *path, char *s, size_t len,
       if (!string_is_equal(path_basename(current_path), core_path_basename))
          continue;
 
-      conf = core_info_list_iterate(contents->elems[i].data,
-               path_basedir);
+      if (!core_info_list_iterate(&info_path, contents->elems[i].data,
+               path_basedir))
+         continue;
+
+      conf = config_file_new(info_path.path);
+      free(info_path.path);
 
       if (!conf)
          continue;
@@ -798,9 +1172,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
 
    for (i = 0; i < core_info_list->count; i++)
    {
-      config_file_t *conf = (config_file_t*)
-         core_info_list->list[i].config_data;
-      num += !!conf;
+      num += core_info_list->list[i].has_info;
    }
 
    return num;
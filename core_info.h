@@ -39,9 +39,10 @@ typedef struct
 {
    bool supports_no_game;
    bool database_match_archive_member;
+   /* A .info file was found for the core */
+   bool has_info;
    size_t firmware_count;
    char *path;
-   void *config_data;
    char *display_name;
    char *display_version;
    char *core_name;
@@ -114,8 +115,10 @@ bool core_info_get_current_core(core_info_t **core);
 
 void core_info_deinit_list(void);
 
+/* The parsed .info files are cached in @dir_cache,
+ * if it is set. */
 bool core_info_init_list(const char *path_info, const char *dir_cores,
-      const char *exts, bool show_hidden_files);
+      const char *dir_cache, const char *exts, bool show_hidden_files);
 
 bool core_info_get_list(core_info_list_t **core);
 
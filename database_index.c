@@ -0,0 +1,596 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2019 - Brad Parker
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <retro_endianness.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <string/stdstring.h>
+#include <streams/file_stream.h>
+#include <features/features_cpu.h>
+
+#include "libretro-db/libretrodb.h"
+
+#include "cache_file.h"
+#include "database_index.h"
+#include "verbosity.h"
+
+#define DATABASE_INDEX_MAGIC      0x58444452 /* "RDDX" */
+#define DATABASE_INDEX_VERSION    1
+
+/* A cache file, see cache_file.h. All the sections are
+ * multiples of 8 bytes, except for the strings at the end. */
+typedef struct database_index_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t db_count;
+   uint32_t strings_size;
+   uint64_t crc_count;
+   uint64_t serial_count;
+} database_index_header_t;
+
+typedef struct database_index_db
+{
+   uint64_t size;
+   int64_t mtime;
+   uint32_t path;
+   uint32_t hash;
+} database_index_db_t;
+
+struct database_index
+{
+   cache_file_t file;
+   const database_index_header_t *header;
+   const database_index_db_t *dbs;
+   const database_index_entry_t *crcs;
+   const database_index_entry_t *serials;
+   const char *strings;
+};
+
+typedef struct database_index_entries
+{
+   database_index_entry_t *data;
+   size_t count;
+   size_t capacity;
+} database_index_entries_t;
+
+static uint32_t database_index_hash(const char *s, size_t len)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < len; i++)
+      hash = (hash << 5) + hash + (uint8_t)s[i];
+
+   return hash;
+}
+
+static bool database_index_stat(const char *path,
+      uint64_t *size, int64_t *mtime)
+{
+   int64_t len = 0;
+
+   if (!path_get_size_mtime(path, &len, mtime))
+      return false;
+
+   *size = (uint64_t)len;
+
+   return true;
+}
+
+static bool database_index_parse(database_index_t *index)
+{
+   uint32_t i;
+   uint64_t len                           = index->file.len;
+   const uint8_t *data                    = (const uint8_t*)index->file.data;
+   const database_index_header_t *header  = (const database_index_header_t*)data;
+
+   if (     len < sizeof(*header)
+         || header->magic   != DATABASE_INDEX_MAGIC
+         || header->version != DATABASE_INDEX_VERSION)
+      return false;
+
+   len -= sizeof(*header);
+
+   if (     header->db_count     > len / sizeof(database_index_db_t)
+         || header->crc_count    > len / sizeof(database_index_entry_t)
+         || header->serial_count > len / sizeof(database_index_entry_t))
+      return false;
+
+   if (len != header->db_count * sizeof(database_index_db_t)
+         + (header->crc_count + header->serial_count)
+         * sizeof(database_index_entry_t) + header->strings_size)
+      return false;
+
+   index->header  = header;
+   index->dbs     = (const database_index_db_t*)(header + 1);
+   index->crcs    = (const database_index_entry_t*)
+      (index->dbs + header->db_count);
+   index->serials = index->crcs + header->crc_count;
+   index->strings = (const char*)(index->serials + header->serial_count);
+
+   if (header->strings_size == 0
+         || index->strings[header->strings_size - 1] != '\0')
+      return false;
+
+   for (i = 0; i < header->db_count; i++)
+      if (index->dbs[i].path >= header->strings_size)
+         return false;
+
+   return true;
+}
+
+static void database_index_unload(database_index_t *index)
+{
+   cache_file_unload(&index->file);
+}
+
+static bool database_index_load(database_index_t *index, const char *path)
+{
+   if (!cache_file_load(&index->file, path))
+      return false;
+
+   if (!database_index_parse(index))
+   {
+      RARCH_WARN("[Database Index]: Ignoring invalid index \"%s\".\n", path);
+      database_index_unload(index);
+      return false;
+   }
+
+   return true;
+}
+
+static bool database_index_is_current(database_index_t *index,
+      const struct string_list *list,
+      const uint64_t *sizes, const int64_t *mtimes)
+{
+   size_t i;
+
+   if (!index->header || index->header->db_count != list->size)
+      return false;
+
+   for (i = 0; i < list->size; i++)
+   {
+      int db = database_index_get_db(index, list->elems[i].data);
+
+      if (     db < 0
+            || index->dbs[db].size  != sizes[i]
+            || index->dbs[db].mtime != mtimes[i])
+         return false;
+   }
+
+   return true;
+}
+
+static bool database_index_push(database_index_entries_t *entries,
+      uint32_t key, uint32_t db, uint64_t offset)
+{
+   database_index_entry_t *entry = NULL;
+
+   if (entries->count == entries->capacity)
+   {
+      size_t capacity                = entries->capacity
+         ? entries->capacity * 2 : 1024;
+      database_index_entry_t *data   = (database_index_entry_t*)
+         realloc(entries->data, capacity * sizeof(*data));
+
+      if (!data)
+         return false;
+
+      entries->data     = data;
+      entries->capacity = capacity;
+   }
+
+   entry         = &entries->data[entries->count++];
+   entry->key    = key;
+   entry->db     = db;
+   entry->offset = offset;
+
+   return true;
+}
+
+/* Adds the CRC32 and the serial of every item of
+ * the database at @path. */
+static bool database_index_scan(const char *path, uint32_t db,
+      database_index_entries_t *crcs, database_index_entries_t *serials)
+{
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_value crc_key;
+   struct rmsgpack_dom_value serial_key;
+   bool ret                 = true;
+   libretrodb_t *rdb        = libretrodb_new();
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   if (!rdb || !cur || libretrodb_open(path, rdb) != 0)
+   {
+      ret = false;
+      goto end;
+   }
+
+   if (libretrodb_cursor_open(rdb, cur, NULL) != 0)
+   {
+      libretrodb_close(rdb);
+      ret = false;
+      goto end;
+   }
+
+   crc_key.type               = RDT_STRING;
+   crc_key.val.string.len     = STRLEN_CONST("crc");
+   crc_key.val.string.buff    = (char*)"crc";
+   serial_key.type            = RDT_STRING;
+   serial_key.val.string.len  = STRLEN_CONST("serial");
+   serial_key.val.string.buff = (char*)"serial";
+
+   for (;;)
+   {
+      struct rmsgpack_dom_value *value = NULL;
+      uint64_t offset                  = libretrodb_cursor_tell(cur);
+
+      if (libretrodb_cursor_read_item(cur, &item) != 0)
+         break;
+
+      if (item.type == RDT_MAP)
+      {
+         value = rmsgpack_dom_value_map_value(&item, &crc_key);
+
+         if (     value
+               && value->type == RDT_BINARY
+               && value->val.binary.len == sizeof(uint32_t))
+         {
+            uint32_t crc;
+            memcpy(&crc, value->val.binary.buff, sizeof(crc));
+            ret = database_index_push(crcs,
+                  swap_if_little32(crc), db, offset);
+         }
+
+         value = rmsgpack_dom_value_map_value(&item, &serial_key);
+
+         if (     ret
+               && value
+               && (value->type == RDT_STRING || value->type == RDT_BINARY)
+               && value->val.string.len > 0)
+            ret = database_index_push(serials,
+                  database_index_hash(value->val.string.buff,
+                     value->val.string.len), db, offset);
+      }
+
+      rmsgpack_dom_value_free(&item);
+
+      if (!ret)
+         break;
+   }
+
+   libretrodb_cursor_close(cur);
+   libretrodb_close(rdb);
+
+end:
+   if (rdb)
+      libretrodb_free(rdb);
+   if (cur)
+      libretrodb_cursor_free(cur);
+
+   return ret;
+}
+
+static int database_index_entry_compare(const void *a, const void *b)
+{
+   const database_index_entry_t *left  = (const database_index_entry_t*)a;
+   const database_index_entry_t *right = (const database_index_entry_t*)b;
+
+   if (left->key != right->key)
+      return left->key < right->key ? -1 : 1;
+   if (left->db != right->db)
+      return left->db < right->db ? -1 : 1;
+   if (left->offset != right->offset)
+      return left->offset < right->offset ? -1 : 1;
+   return 0;
+}
+
+/* Keeps the entries of the databases that didn't change
+ * since @old was written, renumbered after @remap. */
+static bool database_index_copy(database_index_entries_t *entries,
+      const database_index_entry_t *old, uint64_t count,
+      const int *remap)
+{
+   uint64_t i;
+
+   for (i = 0; i < count; i++)
+   {
+      if (remap[old[i].db] < 0)
+         continue;
+      if (!database_index_push(entries, old[i].key,
+               (uint32_t)remap[old[i].db], old[i].offset))
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * database_index_build:
+ * @index               : Index handle, holding the previous
+ *                        index if there was a valid one.
+ * @list                : Databases.
+ *
+ * Replaces the index with a new one for @list, reusing the
+ * entries of the unchanged databases.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool database_index_build(database_index_t *index,
+      const struct string_list *list,
+      const uint64_t *sizes, const int64_t *mtimes)
+{
+   size_t i;
+   database_index_header_t header;
+   database_index_entries_t crcs    = {0};
+   database_index_entries_t serials = {0};
+   database_index_db_t *dbs         = NULL;
+   int *remap                       = NULL;
+   uint8_t *data                    = NULL;
+   size_t strings_size              = 0;
+   size_t len                       = 0;
+   size_t indexed                   = 0;
+   bool ret                         = false;
+
+   if (!(dbs = (database_index_db_t*)calloc(list->size, sizeof(*dbs))))
+      goto end;
+
+   if (index->header)
+   {
+      if (!(remap = (int*)malloc(index->header->db_count * sizeof(int))))
+         goto end;
+      for (i = 0; i < index->header->db_count; i++)
+         remap[i] = -1;
+   }
+
+   for (i = 0; i < list->size; i++)
+   {
+      const char *path = list->elems[i].data;
+      int old          = index->header
+         ? database_index_get_db(index, path) : -1;
+
+      dbs[i].size      = sizes[i];
+      dbs[i].mtime     = mtimes[i];
+      dbs[i].path      = (uint32_t)strings_size;
+      dbs[i].hash      = database_index_hash(path, strlen(path));
+      strings_size    += strlen(path) + 1;
+
+      if (     old >= 0
+            && index->dbs[old].size  == sizes[i]
+            && index->dbs[old].mtime == mtimes[i])
+         remap[old] = (int)i;
+      else
+      {
+         if (!database_index_scan(path, (uint32_t)i, &crcs, &serials))
+            RARCH_WARN("[Database Index]: Failed to index \"%s\".\n", path);
+         indexed++;
+      }
+   }
+
+   if (remap && (  !database_index_copy(&crcs, index->crcs,
+               index->header->crc_count, remap)
+            || !database_index_copy(&serials, index->serials,
+               index->header->serial_count, remap)))
+      goto end;
+
+   if (crcs.count)
+      qsort(crcs.data, crcs.count, sizeof(*crcs.data),
+            database_index_entry_compare);
+   if (serials.count)
+      qsort(serials.data, serials.count, sizeof(*serials.data),
+            database_index_entry_compare);
+
+   header.magic        = DATABASE_INDEX_MAGIC;
+   header.version      = DATABASE_INDEX_VERSION;
+   header.db_count     = (uint32_t)list->size;
+   header.strings_size = (uint32_t)strings_size;
+   header.crc_count    = crcs.count;
+   header.serial_count = serials.count;
+
+   len = sizeof(header) + list->size * sizeof(*dbs)
+      + (crcs.count + serials.count) * sizeof(database_index_entry_t)
+      + strings_size;
+
+   if (!(data = (uint8_t*)malloc(len)))
+      goto end;
+
+   {
+      uint8_t *pos = data;
+
+      memcpy(pos, &header, sizeof(header));
+      pos += sizeof(header);
+      memcpy(pos, dbs, list->size * sizeof(*dbs));
+      pos += list->size * sizeof(*dbs);
+      if (crcs.count)
+         memcpy(pos, crcs.data, crcs.count * sizeof(*crcs.data));
+      pos += crcs.count * sizeof(*crcs.data);
+      if (serials.count)
+         memcpy(pos, serials.data, serials.count * sizeof(*serials.data));
+      pos += serials.count * sizeof(*serials.data);
+
+      for (i = 0; i < list->size; i++)
+      {
+         size_t path_len = strlen(list->elems[i].data) + 1;
+         memcpy(pos, list->elems[i].data, path_len);
+         pos += path_len;
+      }
+   }
+
+   RARCH_LOG("[Database Index]: Indexed " STRING_REP_USIZE " of "
+         STRING_REP_USIZE " databases, " STRING_REP_USIZE " CRC32 and "
+         STRING_REP_USIZE " serial entries.\n",
+         indexed, (size_t)list->size, crcs.count, serials.count);
+
+   database_index_unload(index);
+   index->file.data = data;
+   index->file.len  = len;
+   ret         = database_index_parse(index);
+
+end:
+   free(dbs);
+   free(remap);
+   free(crcs.data);
+   free(serials.data);
+   return ret;
+}
+
+database_index_t *database_index_init(const char *index_path,
+      const char *rdb_dir, bool show_hidden_files)
+{
+   size_t i;
+   database_index_t *index  = NULL;
+   struct string_list *list = NULL;
+   uint64_t *sizes          = NULL;
+   int64_t *mtimes          = NULL;
+   retro_time_t start       = cpu_features_get_time_usec();
+
+   if (string_is_empty(rdb_dir))
+      return NULL;
+
+   list = dir_list_new(rdb_dir, "rdb", false,
+         show_hidden_files, false, false);
+
+   if (!list || list->size == 0)
+      goto error;
+
+   sizes  = (uint64_t*)calloc(list->size, sizeof(*sizes));
+   mtimes = (int64_t*)calloc(list->size, sizeof(*mtimes));
+   index  = (database_index_t*)calloc(1, sizeof(*index));
+
+   if (!sizes || !mtimes || !index)
+      goto error;
+
+   for (i = 0; i < list->size; i++)
+      database_index_stat(list->elems[i].data, &sizes[i], &mtimes[i]);
+
+   if (!string_is_empty(index_path) && path_is_valid(index_path))
+      database_index_load(index, index_path);
+
+   if (!database_index_is_current(index, list, sizes, mtimes))
+   {
+      if (!database_index_build(index, list, sizes, mtimes))
+         goto error;
+
+      if (     !string_is_empty(index_path)
+            && !cache_file_write(index_path,
+               index->file.data, index->file.len))
+         RARCH_WARN("[Database Index]: Failed to write \"%s\".\n",
+               index_path);
+
+      RARCH_LOG("[Database Index]: Built in %.1f seconds.\n",
+            (cpu_features_get_time_usec() - start) / 1000000.0);
+   }
+
+   free(sizes);
+   free(mtimes);
+   dir_list_free(list);
+
+   return index;
+
+error:
+   free(sizes);
+   free(mtimes);
+   if (list)
+      dir_list_free(list);
+   database_index_free(index);
+   return NULL;
+}
+
+void database_index_free(database_index_t *index)
+{
+   if (!index)
+      return;
+
+   database_index_unload(index);
+   free(index);
+}
+
+int database_index_get_db(database_index_t *index, const char *rdb_path)
+{
+   uint32_t i;
+   uint32_t hash;
+
+   if (!index->header || !rdb_path)
+      return -1;
+
+   hash = database_index_hash(rdb_path, strlen(rdb_path));
+
+   for (i = 0; i < index->header->db_count; i++)
+   {
+      if (     index->dbs[i].hash == hash
+            && string_is_equal(index->strings + index->dbs[i].path, rdb_path))
+         return (int)i;
+   }
+
+   return -1;
+}
+
+static const database_index_entry_t *database_index_find(
+      const database_index_entry_t *entries, uint64_t count,
+      uint32_t key, size_t *found)
+{
+   size_t n    = 0;
+   uint64_t lo = 0;
+   uint64_t hi = count;
+
+   while (lo < hi)
+   {
+      uint64_t mid = lo + (hi - lo) / 2;
+
+      if (entries[mid].key < key)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   while (lo + n < count && entries[lo + n].key == key)
+      n++;
+
+   *found = n;
+
+   return n ? &entries[lo] : NULL;
+}
+
+const database_index_entry_t *database_index_find_crc(
+      database_index_t *index, uint32_t crc, size_t *count)
+{
+   *count = 0;
+   if (!index->header)
+      return NULL;
+   return database_index_find(index->crcs,
+         index->header->crc_count, crc, count);
+}
+
+const database_index_entry_t *database_index_find_serial(
+      database_index_t *index, const char *serial, size_t *count)
+{
+   *count = 0;
+   if (!index->header || string_is_empty(serial))
+      return NULL;
+   return database_index_find(index->serials,
+         index->header->serial_count,
+         database_index_hash(serial, strlen(serial)), count);
+}
@@ -0,0 +1,83 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2019 - Brad Parker
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_INDEX_H_
+#define DATABASE_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Combined CRC32 and serial lookup index over all the
+ * databases of a directory. The index maps each key to the
+ * database and the offset of the item it was found in, so
+ * the items can be read with database_info_list_new_offsets
+ * instead of running a query over every database. */
+typedef struct database_index database_index_t;
+
+typedef struct database_index_entry
+{
+   uint32_t key;
+   uint32_t db;
+   uint64_t offset;
+} database_index_entry_t;
+
+/**
+ * database_index_init:
+ * @index_path          : Path of the index file, NULL to
+ *                        keep the index in memory only.
+ * @rdb_dir             : Directory of the databases.
+ * @show_hidden_files   : Include hidden databases.
+ *
+ * Loads the index from @index_path. The databases that
+ * were added or changed since it was written are indexed
+ * again, in which case the index file is rewritten.
+ *
+ * Returns: the index, or NULL if there are no databases.
+ **/
+database_index_t *database_index_init(const char *index_path,
+      const char *rdb_dir, bool show_hidden_files);
+
+void database_index_free(database_index_t *index);
+
+/* Returns: id of the database at @rdb_path, or -1 if
+ * it isn't part of the index. */
+int database_index_get_db(database_index_t *index, const char *rdb_path);
+
+/**
+ * database_index_find_crc:
+ * @index               : Index handle.
+ * @crc                 : CRC32 to look up.
+ * @count               : Amount of entries found.
+ *
+ * Returns: the entries of @crc, sorted by database and
+ * offset, or NULL if there are none.
+ **/
+const database_index_entry_t *database_index_find_crc(
+      database_index_t *index, uint32_t crc, size_t *count);
+
+/* Same as database_index_find_crc. Serials are indexed
+ * by hash, so the items still have to be compared. */
+const database_index_entry_t *database_index_find_serial(
+      database_index_t *index, const char *serial, size_t *count);
+
+RETRO_END_DECLS
+
+#endif
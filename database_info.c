@@ -26,6 +26,7 @@
 #include <string/stdstring.h>
 
 #include "libretro-db/libretrodb.h"
+#include "libretro-db/rmsgpack.h"
 
 #include "core_info.h"
 #include "database_info.h"
@@ -148,12 +149,154 @@ char *bin_to_hex_alloc(const uint8_t *data, size_t len)
    return ret;
 }
 
-static int database_cursor_iterate(libretrodb_cursor_t *cur,
+/* Copies a string value, the value isn't NUL terminated
+ * when it's read straight from the database. */
+static char *database_info_strdup(const struct rmsgpack_view *val)
+{
+   char *s = NULL;
+
+   if (     (val->type != RDT_STRING && val->type != RDT_BINARY)
+         || val->val.string.len == 0
+         || val->val.string.buff[0] == '\0')
+      return NULL;
+
+   if (!(s = (char*)malloc(val->val.string.len + 1)))
+      return NULL;
+
+   memcpy(s, val->val.string.buff, val->val.string.len);
+   s[val->val.string.len] = '\0';
+   return s;
+}
+
+#define DATABASE_INFO_KEY_IS(str) \
+   (key_len == STRLEN_CONST(str) && !memcmp(key, str, key_len))
+
+static void database_info_set_field(database_info_t *db_info,
+      const char *key, size_t key_len, const struct rmsgpack_view *val)
+{
+   if (DATABASE_INFO_KEY_IS("publisher"))
+      db_info->publisher            = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("developer"))
+   {
+      char *developer               = database_info_strdup(val);
+
+      if (developer)
+      {
+         db_info->developer         = string_split(developer, "|");
+         free(developer);
+      }
+   }
+   else if (DATABASE_INFO_KEY_IS("serial"))
+      db_info->serial               = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("rom_name"))
+      db_info->rom_name             = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("name"))
+      db_info->name                 = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("description"))
+      db_info->description          = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("genre"))
+      db_info->genre                = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("origin"))
+      db_info->origin               = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("franchise"))
+      db_info->franchise            = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("bbfc_rating"))
+      db_info->bbfc_rating          = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("esrb_rating"))
+      db_info->esrb_rating          = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("elspa_rating"))
+      db_info->elspa_rating         = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("cero_rating"))
+      db_info->cero_rating          = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("pegi_rating"))
+      db_info->pegi_rating          = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("enhancement_hw"))
+      db_info->enhancement_hw       = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("edge_review"))
+      db_info->edge_magazine_review = database_info_strdup(val);
+   else if (DATABASE_INFO_KEY_IS("edge_rating"))
+      db_info->edge_magazine_rating    = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("edge_issue"))
+      db_info->edge_magazine_issue     = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("famitsu_rating"))
+      db_info->famitsu_magazine_rating = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("tgdb_rating"))
+      db_info->tgdb_rating             = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("users"))
+      db_info->max_users               = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("releasemonth"))
+      db_info->releasemonth            = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("releaseyear"))
+      db_info->releaseyear             = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("rumble"))
+      db_info->rumble_supported        = (int)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("coop"))
+      db_info->coop_supported          = (int)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("analog"))
+      db_info->analog_supported        = (int)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("size"))
+      db_info->size                    = (unsigned)val->val.uint_;
+   else if (DATABASE_INFO_KEY_IS("crc"))
+   {
+      uint32_t crc32 = 0;
+
+      if (val->type == RDT_BINARY && val->val.binary.len >= sizeof(crc32))
+         memcpy(&crc32, val->val.binary.buff, sizeof(crc32));
+      db_info->crc32 = swap_if_little32(crc32);
+   }
+   else if (DATABASE_INFO_KEY_IS("sha1"))
+      db_info->sha1 = bin_to_hex_alloc(
+            (const uint8_t*)val->val.binary.buff, val->val.binary.len);
+   else if (DATABASE_INFO_KEY_IS("md5"))
+      db_info->md5 = bin_to_hex_alloc(
+            (const uint8_t*)val->val.binary.buff, val->val.binary.len);
+   else
+   {
+      RARCH_LOG("Unknown key: %.*s\n", (int)key_len, key);
+   }
+}
+
+#undef DATABASE_INFO_KEY_IS
+
+static void database_info_view_from_dom(const struct rmsgpack_dom_value *dom,
+      struct rmsgpack_view *view)
+{
+   view->type = dom->type;
+
+   switch (dom->type)
+   {
+      case RDT_STRING:
+      case RDT_BINARY:
+         view->val.string.len  = dom->val.string.len;
+         view->val.string.buff = dom->val.string.buff;
+         break;
+      case RDT_MAP:
+         view->val.len         = dom->val.map.len;
+         break;
+      case RDT_ARRAY:
+         view->val.len         = dom->val.array.len;
+         break;
+      case RDT_BOOL:
+         view->val.uint_       = 0;
+         view->val.bool_       = dom->val.bool_;
+         break;
+      case RDT_UINT:
+      case RDT_INT:
+         view->val.uint_       = dom->val.uint_;
+         break;
+      case RDT_NULL:
+         view->val.uint_       = 0;
+         break;
+   }
+}
+
+/* Reads the item through the DOM, used if the database
+ * couldn't be mapped. */
+static int database_cursor_iterate_dom(libretrodb_cursor_t *cur,
       database_info_t *db_info)
 {
    unsigned i;
    struct rmsgpack_dom_value item;
-   const char* str                = NULL;
 
    if (libretrodb_cursor_read_item(cur, &item) != 0)
       return -1;
@@ -170,134 +313,81 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
 
    for (i = 0; i < item.val.map.len; i++)
    {
+      struct rmsgpack_view val;
       struct rmsgpack_dom_value *key = &item.val.map.items[i].key;
-      struct rmsgpack_dom_value *val = &item.val.map.items[i].value;
-      const char *val_string         = NULL;
 
-      if (!key || !val)
+      if (key->type != RDT_STRING)
          continue;
 
-      val_string                     = val->val.string.buff;
-      str                            = key->val.string.buff;
+      database_info_view_from_dom(&item.val.map.items[i].value, &val);
+      database_info_set_field(db_info,
+            key->val.string.buff, key->val.string.len, &val);
+   }
 
-      if (string_is_equal(str, "publisher"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->publisher = strdup(val_string);
-      }
-      else if (string_is_equal(str, "developer"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->developer = string_split(val_string, "|");
-      }
-      else if (string_is_equal(str, "serial"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->serial = strdup(val_string);
-      }
-      else if (string_is_equal(str, "rom_name"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->rom_name = strdup(val_string);
-      }
-      else if (string_is_equal(str, "name"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->name = strdup(val_string);
-      }
-      else if (string_is_equal(str, "description"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->description = strdup(val_string);
-      }
-      else if (string_is_equal(str, "genre"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->genre = strdup(val_string);
-      }
-      else if (string_is_equal(str, "origin"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->origin = strdup(val_string);
-      }
-      else if (string_is_equal(str, "franchise"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->franchise = strdup(val_string);
-      }
-      else if (string_is_equal(str, "bbfc_rating"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->bbfc_rating = strdup(val_string);
-      }
-      else if (string_is_equal(str, "esrb_rating"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->esrb_rating = strdup(val_string);
-      }
-      else if (string_is_equal(str, "elspa_rating"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->elspa_rating = strdup(val_string);
-      }
-      else if (string_is_equal(str, "cero_rating"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->cero_rating          = strdup(val_string);
-      }
-      else if (string_is_equal(str, "pegi_rating"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->pegi_rating          = strdup(val_string);
-      }
-      else if (string_is_equal(str, "enhancement_hw"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->enhancement_hw       = strdup(val_string);
-      }
-      else if (string_is_equal(str, "edge_review"))
-      {
-         if (!string_is_empty(val_string))
-            db_info->edge_magazine_review = strdup(val_string);
-      }
-      else if (string_is_equal(str, "edge_rating"))
-         db_info->edge_magazine_rating    = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "edge_issue"))
-         db_info->edge_magazine_issue     = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "famitsu_rating"))
-         db_info->famitsu_magazine_rating = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "tgdb_rating"))
-         db_info->tgdb_rating             = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "users"))
-         db_info->max_users               = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "releasemonth"))
-         db_info->releasemonth            = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "releaseyear"))
-         db_info->releaseyear             = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "rumble"))
-         db_info->rumble_supported        = (int)val->val.uint_;
-      else if (string_is_equal(str, "coop"))
-         db_info->coop_supported          = (int)val->val.uint_;
-      else if (string_is_equal(str, "analog"))
-         db_info->analog_supported        = (int)val->val.uint_;
-      else if (string_is_equal(str, "size"))
-         db_info->size                    = (unsigned)val->val.uint_;
-      else if (string_is_equal(str, "crc"))
-         db_info->crc32 = swap_if_little32(
-               *(uint32_t*)val->val.binary.buff);
-      else if (string_is_equal(str, "sha1"))
-         db_info->sha1 = bin_to_hex_alloc(
-               (uint8_t*)val->val.binary.buff, val->val.binary.len);
-      else if (string_is_equal(str, "md5"))
-         db_info->md5 = bin_to_hex_alloc(
-               (uint8_t*)val->val.binary.buff, val->val.binary.len);
-      else
+   rmsgpack_dom_value_free(&item);
+
+   return 0;
+}
+
+static int database_cursor_iterate(libretrodb_cursor_t *cur,
+      database_info_t *db_info)
+{
+   uint32_t i;
+   size_t len          = 0;
+   const uint8_t *data = NULL;
+   const uint8_t *pos  = NULL;
+   const uint8_t *end  = NULL;
+   struct rmsgpack_view item;
+   int rv              = libretrodb_cursor_read_item_buf(cur, &data, &len);
+
+   if (rv == 1)
+      return database_cursor_iterate_dom(cur, db_info);
+
+   if (rv != 0)
+      return -1;
+
+   /* The item stays in the mapped database, only the
+    * fields that are kept get copied */
+   pos = data;
+   end = data + len;
+
+   if (rmsgpack_read_view(&pos, end, &item) < 0)
+      return -1;
+
+   if (item.type != RDT_MAP)
+      return 1;
+
+   db_info->analog_supported       = -1;
+   db_info->rumble_supported       = -1;
+   db_info->coop_supported         = -1;
+
+   for (i = 0; i < item.val.len; i++)
+   {
+      struct rmsgpack_view key, val;
+      const uint8_t *val_pos = NULL;
+
+      if (rmsgpack_read_view(&pos, end, &key) < 0)
+         return -1;
+
+      val_pos = pos;
+
+      if (rmsgpack_read_view(&pos, end, &val) < 0)
+         return -1;
+
+      if (val.type == RDT_MAP || val.type == RDT_ARRAY)
       {
-         RARCH_LOG("Unknown key: %s\n", str);
+         pos = val_pos;
+         if (rmsgpack_skip_view(&pos, end) < 0)
+            return -1;
+         continue;
       }
-   }
 
-   rmsgpack_dom_value_free(&item);
+      if (key.type != RDT_STRING)
+         continue;
+
+      database_info_set_field(db_info,
+            key.val.string.buff, key.val.string.len, &val);
+   }
 
    return 0;
 }
@@ -439,6 +529,48 @@ void database_info_free(database_info_handle_t *db)
    string_list_free(db->list);
 }
 
+static void database_info_free_entry(database_info_t *info)
+{
+   if (info->name)
+      free(info->name);
+   if (info->rom_name)
+      free(info->rom_name);
+   if (info->serial)
+      free(info->serial);
+   if (info->genre)
+      free(info->genre);
+   if (info->description)
+      free(info->description);
+   if (info->publisher)
+      free(info->publisher);
+   if (info->developer)
+      string_list_free(info->developer);
+   info->developer = NULL;
+   if (info->origin)
+      free(info->origin);
+   if (info->franchise)
+      free(info->franchise);
+   if (info->edge_magazine_review)
+      free(info->edge_magazine_review);
+
+   if (info->cero_rating)
+      free(info->cero_rating);
+   if (info->pegi_rating)
+      free(info->pegi_rating);
+   if (info->enhancement_hw)
+      free(info->enhancement_hw);
+   if (info->elspa_rating)
+      free(info->elspa_rating);
+   if (info->esrb_rating)
+      free(info->esrb_rating);
+   if (info->bbfc_rating)
+      free(info->bbfc_rating);
+   if (info->sha1)
+      free(info->sha1);
+   if (info->md5)
+      free(info->md5);
+}
+
 database_info_list_t *database_info_list_new(
       const char *rdb_path, const char *query)
 {
@@ -477,36 +609,7 @@ database_info_list_t *database_info_list_new(
 
          if (!new_ptr)
          {
-            if (db_info.bbfc_rating)
-               free(db_info.bbfc_rating);
-            if (db_info.cero_rating)
-               free(db_info.cero_rating);
-            if (db_info.description)
-               free(db_info.description);
-            if (db_info.edge_magazine_review)
-               free(db_info.edge_magazine_review);
-            if (db_info.elspa_rating)
-               free(db_info.elspa_rating);
-            if (db_info.enhancement_hw)
-               free(db_info.enhancement_hw);
-            if (db_info.esrb_rating)
-               free(db_info.esrb_rating);
-            if (db_info.franchise)
-               free(db_info.franchise);
-            if (db_info.genre)
-               free(db_info.genre);
-            if (db_info.name)
-               free(db_info.name);
-            if (db_info.origin)
-               free(db_info.origin);
-            if (db_info.pegi_rating)
-               free(db_info.pegi_rating);
-            if (db_info.publisher)
-               free(db_info.publisher);
-            if (db_info.rom_name)
-               free(db_info.rom_name);
-            if (db_info.serial)
-               free(db_info.serial);
+            database_info_free_entry(&db_info);
             database_info_list_free(database_info_list);
             free(database_info);
             free(database_info_list);
@@ -538,6 +641,63 @@ end:
    return database_info_list;
 }
 
+/**
+ * database_info_list_new_offsets:
+ * @rdb_path            : Path of the database.
+ * @offsets             : Item offsets, see libretrodb_cursor_tell.
+ * @count               : Amount of @offsets.
+ *
+ * Reads the items at @offsets without running a query over
+ * the whole database, the list is empty if @count is 0.
+ *
+ * Returns: the list, or NULL on failure.
+ **/
+database_info_list_t *database_info_list_new_offsets(
+      const char *rdb_path, const uint64_t *offsets, size_t count)
+{
+   size_t i;
+   libretrodb_t *db                         = NULL;
+   libretrodb_cursor_t *cur                 = NULL;
+   database_info_list_t *database_info_list = (database_info_list_t*)
+      calloc(1, sizeof(*database_info_list));
+
+   if (!database_info_list || count == 0)
+      return database_info_list;
+
+   database_info_list->list = (database_info_t*)
+      calloc(count, sizeof(database_info_t));
+   db                       = libretrodb_new();
+   cur                      = libretrodb_cursor_new();
+
+   if (!database_info_list->list || !db || !cur
+         || database_cursor_open(db, cur, rdb_path, NULL) != 0)
+      goto error;
+
+   for (i = 0; i < count; i++)
+   {
+      if (libretrodb_cursor_seek(cur, offsets[i]) != 0)
+         break;
+      if (database_cursor_iterate(cur,
+               &database_info_list->list[database_info_list->count]) == 0)
+         database_info_list->count++;
+   }
+
+   database_cursor_close(db, cur);
+   libretrodb_free(db);
+   libretrodb_cursor_free(cur);
+
+   return database_info_list;
+
+error:
+   if (db)
+      libretrodb_free(db);
+   if (cur)
+      libretrodb_cursor_free(cur);
+   free(database_info_list->list);
+   free(database_info_list);
+   return NULL;
+}
+
 void database_info_list_free(database_info_list_t *database_info_list)
 {
    size_t i;
@@ -546,48 +706,7 @@ void database_info_list_free(database_info_list_t *database_info_list)
       return;
 
    for (i = 0; i < database_info_list->count; i++)
-   {
-      database_info_t *info = &database_info_list->list[i];
-
-      if (info->name)
-         free(info->name);
-      if (info->rom_name)
-         free(info->rom_name);
-      if (info->serial)
-         free(info->serial);
-      if (info->genre)
-         free(info->genre);
-      if (info->description)
-         free(info->description);
-      if (info->publisher)
-         free(info->publisher);
-      if (info->developer)
-         string_list_free(info->developer);
-      info->developer = NULL;
-      if (info->origin)
-         free(info->origin);
-      if (info->franchise)
-         free(info->franchise);
-      if (info->edge_magazine_review)
-         free(info->edge_magazine_review);
-
-      if (info->cero_rating)
-         free(info->cero_rating);
-      if (info->pegi_rating)
-         free(info->pegi_rating);
-      if (info->enhancement_hw)
-         free(info->enhancement_hw);
-      if (info->elspa_rating)
-         free(info->elspa_rating);
-      if (info->esrb_rating)
-         free(info->esrb_rating);
-      if (info->bbfc_rating)
-         free(info->bbfc_rating);
-      if (info->sha1)
-         free(info->sha1);
-      if (info->md5)
-         free(info->md5);
-   }
+      database_info_free_entry(&database_info_list->list[i]);
 
    free(database_info_list->list);
 }
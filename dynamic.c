@@ -531,9 +531,13 @@ bool init_libretro_sym_custom(enum rarch_core_type type, struct retro_core_t *cu
             {
                /* for a secondary core, we already have a
                 * primary library loaded, so we can skip
-                * some checks and just load the library */
+                * some checks and just load the library,
+                * unless the caller has loaded it already */
                retro_assert(lib_path != NULL && lib_handle_p != NULL);
-               lib_handle_local = dylib_load(lib_path);
+               lib_handle_local = *lib_handle_p;
+
+               if (!lib_handle_local)
+                  lib_handle_local = dylib_load(lib_path);
 
                if (!lib_handle_local)
                   return false;
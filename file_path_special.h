@@ -34,6 +34,9 @@ enum file_path_enum
    FILE_PATH_DETECT,
    FILE_PATH_NUL,
    FILE_PATH_LUTRO_PLAYLIST,
+   FILE_PATH_CONTENT_SCAN_CACHE,
+   FILE_PATH_CONTENT_DATABASE_INDEX,
+   FILE_PATH_CORE_INFO_CACHE,
    FILE_PATH_LOG_WARN,
    FILE_PATH_LOG_ERROR,
    FILE_PATH_LOG_INFO,
@@ -41,6 +41,15 @@ const char *file_path_str(enum file_path_enum enum_idx)
       case FILE_PATH_LUTRO_PLAYLIST:
          str = "Lutro.lpl";
          break;
+      case FILE_PATH_CONTENT_SCAN_CACHE:
+         str = "content_scan.cache";
+         break;
+      case FILE_PATH_CONTENT_DATABASE_INDEX:
+         str = "content_database.index";
+         break;
+      case FILE_PATH_CORE_INFO_CACHE:
+         str = "core_info.cache";
+         break;
       case FILE_PATH_NUL:
          str = "nul";
          break;
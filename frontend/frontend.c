@@ -23,6 +23,7 @@
 #endif
 
 #include <retro_timers.h>
+#include <file/archive_file.h>
 
 #ifdef HAVE_MENU
 #include "../menu/menu_driver.h"
@@ -85,6 +86,8 @@ void main_exit(void *args)
 
    rarch_ctl(RARCH_CTL_DESTROY, NULL);
 
+   file_archive_deinit();
+
    ui_companion_driver_deinit();
 
    frontend_driver_shutdown(false);
@@ -124,6 +127,8 @@ int rarch_main(int argc, char *argv[], void *data)
    }
 #endif
 
+   file_archive_init();
+
    rarch_ctl(RARCH_CTL_PREINIT, NULL);
    frontend_driver_init_first(args);
    rarch_ctl(RARCH_CTL_INIT, NULL);
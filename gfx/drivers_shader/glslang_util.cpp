@@ -14,6 +14,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <string>
 #include <sstream>
@@ -30,8 +31,10 @@
 #endif
 
 #include "glslang_util.h"
+#include "slang_cache.h"
 #if defined(HAVE_GLSLANG)
 #include <glslang.hpp>
+#include <glslang/Include/revision.h>
 #endif
 #include "../../verbosity.h"
 
@@ -391,11 +394,70 @@ bool glslang_parse_meta(const vector<string> &lines, glslang_meta *meta)
 }
 
 #if defined(HAVE_GLSLANG)
+static void glslang_hash_source(hash_stream_t *hash, const string &source)
+{
+   uint32_t size = (uint32_t)source.size();
+
+   hash_stream_update(hash, &size, sizeof(size));
+   hash_stream_update(hash, source.data(), source.size());
+}
+
+/* The SPIR-V of a pass is cached as the word counts of both stages,
+ * then the vertex words, then the fragment words. */
+static bool glslang_load_cached_spirv(const slang_cache_key_t *key,
+      glslang_output *output)
+{
+   uint32_t counts[2];
+   void *data  = NULL;
+   size_t size = 0;
+   bool ret    = false;
+
+   if (!slang_cache_load(key, &data, &size))
+      return false;
+
+   if (size >= sizeof(counts))
+   {
+      const uint32_t *words;
+
+      memcpy(counts, data, sizeof(counts));
+      words = (const uint32_t*)data + 2;
+
+      if ((uint64_t)counts[0] + counts[1] + 2 == size / sizeof(uint32_t)
+            && size % sizeof(uint32_t) == 0)
+      {
+         output->vertex.assign(words, words + counts[0]);
+         output->fragment.assign(words + counts[0],
+               words + counts[0] + counts[1]);
+         ret = true;
+      }
+   }
+
+   free(data);
+   return ret;
+}
+
+static void glslang_store_cached_spirv(const slang_cache_key_t *key,
+      const glslang_output *output)
+{
+   vector<uint32_t> words;
+
+   words.reserve(2 + output->vertex.size() + output->fragment.size());
+   words.push_back((uint32_t)output->vertex.size());
+   words.push_back((uint32_t)output->fragment.size());
+   words.insert(words.end(), output->vertex.begin(), output->vertex.end());
+   words.insert(words.end(), output->fragment.begin(), output->fragment.end());
+
+   slang_cache_store(key, words.data(), words.size() * sizeof(uint32_t));
+}
+
 bool glslang_compile_shader(const char *shader_path, glslang_output *output)
 {
    vector<string> lines;
-
-   RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
+   string vertex_source;
+   string fragment_source;
+   hash_stream_t hash;
+   slang_cache_key_t key;
+   bool cached;
 
    if (!glslang_read_shader_file(shader_path, &lines, true))
       return false;
@@ -403,20 +465,48 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
    if (!glslang_parse_meta(lines, &output->meta))
       return false;
 
-   if (    !glslang::compile_spirv(build_stage_source(lines, "vertex"),
+   vertex_source   = build_stage_source(lines, "vertex");
+   fragment_source = build_stage_source(lines, "fragment");
+
+   /* The sources already have every #include expanded, so they and the
+    * compiler that turns them into SPIR-V are all the output depends on */
+   cached = slang_cache_key_init(&key, &hash, SLANG_CACHE_SPIRV);
+   if (cached)
+   {
+      uint32_t patch_level = GLSLANG_PATCH_LEVEL;
+
+      hash_stream_update(&hash, &patch_level, sizeof(patch_level));
+      glslang_hash_source(&hash, vertex_source);
+      glslang_hash_source(&hash, fragment_source);
+      slang_cache_key_final(&hash, &key);
+
+      if (glslang_load_cached_spirv(&key, output))
+      {
+         RARCH_LOG("[slang]: Loaded shader \"%s\" from the cache.\n",
+               shader_path);
+         return true;
+      }
+   }
+
+   RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
+
+   if (    !glslang::compile_spirv(vertex_source,
             glslang::StageVertex, &output->vertex))
    {
       RARCH_ERR("Failed to compile vertex shader stage.\n");
       return false;
    }
 
-   if (    !glslang::compile_spirv(build_stage_source(lines, "fragment"),
+   if (    !glslang::compile_spirv(fragment_source,
             glslang::StageFragment, &output->fragment))
    {
       RARCH_ERR("Failed to compile fragment shader stage.\n");
       return false;
    }
 
+   if (cached)
+      glslang_store_cached_spirv(&key, output);
+
    return true;
 }
 #else
@@ -0,0 +1,287 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2019 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#if defined(_WIN32)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "slang_cache.h"
+
+#include "../../cache_file.h"
+#include "../../configuration.h"
+#include "../../paths.h"
+#include "../../verbosity.h"
+
+using namespace std;
+
+#define SLANG_CACHE_MAGIC   0x48434c53 /* "SLCH" */
+
+/* Bump whenever what goes into keys or entries changes */
+#define SLANG_CACHE_VERSION 1
+
+/* Entries are cache files, see cache_file.h */
+struct slang_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t size;
+   uint32_t crc;
+};
+
+struct slang_cache_file
+{
+   string path;
+   uint64_t size;
+   int64_t mtime;
+};
+
+static const char *slang_cache_extensions[] = {
+   "spv",
+   "refl"
+};
+
+static bool slang_cache_dir(char *s, size_t len)
+{
+   char base[PATH_MAX_LENGTH];
+   settings_t *settings = config_get_ptr();
+
+   if (!settings || !settings->uints.video_shader_cache_size)
+      return false;
+
+   base[0] = '\0';
+
+   if (!string_is_empty(settings->paths.directory_cache))
+      strlcpy(base, settings->paths.directory_cache, sizeof(base));
+   else if (!path_is_empty(RARCH_PATH_CONFIG))
+      fill_pathname_basedir(base, path_get(RARCH_PATH_CONFIG), sizeof(base));
+   else
+      return false;
+
+   fill_pathname_join(s, base, "slang", len);
+   return true;
+}
+
+static bool slang_cache_path(const slang_cache_key_t *key,
+      char *s, size_t len)
+{
+   char dir[PATH_MAX_LENGTH];
+   char name[64];
+
+   dir[0] = '\0';
+
+   if (!slang_cache_dir(dir, sizeof(dir)))
+      return false;
+
+   snprintf(name, sizeof(name), "%s.%s", key->name,
+         slang_cache_extensions[key->type]);
+   fill_pathname_join(s, dir, name, len);
+   return true;
+}
+
+bool slang_cache_key_init(slang_cache_key_t *key, hash_stream_t *hash,
+      enum slang_cache_type type)
+{
+   uint32_t header[2];
+   settings_t *settings = config_get_ptr();
+
+   if (!settings || !settings->uints.video_shader_cache_size)
+      return false;
+
+   key->type    = type;
+   key->name[0] = '\0';
+
+   header[0]    = SLANG_CACHE_VERSION;
+   header[1]    = type;
+
+   hash_stream_init(hash, HASH_STREAM_SHA1);
+   hash_stream_update(hash, header, sizeof(header));
+   return true;
+}
+
+void slang_cache_key_final(hash_stream_t *hash, slang_cache_key_t *key)
+{
+   uint8_t digest[HASH_STREAM_DIGEST_MAX];
+   size_t len = hash_stream_final(hash, digest);
+
+   hash_stream_digest_to_string(digest, len, key->name, sizeof(key->name));
+}
+
+bool slang_cache_load(const slang_cache_key_t *key, void **data, size_t *size)
+{
+   char path[PATH_MAX_LENGTH];
+   struct slang_cache_header header;
+   cache_file_t file;
+   const uint8_t *payload;
+   void *buf   = NULL;
+
+   path[0] = '\0';
+   memset(&file, 0, sizeof(file));
+
+   if (!slang_cache_path(key, path, sizeof(path)))
+      return false;
+
+   if (!path_is_valid(path) || !cache_file_load(&file, path))
+   {
+      RARCH_LOG("[slang]: Cache miss for %s.\n", key->name);
+      return false;
+   }
+
+   if (file.len < sizeof(header))
+      goto corrupt;
+
+   memcpy(&header, file.data, sizeof(header));
+   payload = (const uint8_t*)file.data + sizeof(header);
+   if (     header.magic   != SLANG_CACHE_MAGIC
+         || header.version != SLANG_CACHE_VERSION
+         || header.size    != file.len - sizeof(header)
+         || header.crc     != hash_crc32(0, payload, header.size))
+      goto corrupt;
+
+   /* The callers own what they get */
+   if (!(buf = malloc(header.size ? header.size : 1)))
+   {
+      cache_file_unload(&file);
+      return false;
+   }
+   memcpy(buf, payload, header.size);
+   cache_file_unload(&file);
+
+   /* Keep it from being evicted as the least recently used */
+   utime(path, NULL);
+
+   *data = buf;
+   *size = header.size;
+
+   RARCH_LOG("[slang]: Cache hit for %s.\n", key->name);
+   return true;
+
+corrupt:
+   RARCH_WARN("[slang]: Discarding invalid cache entry %s.\n", key->name);
+   cache_file_unload(&file);
+   filestream_delete(path);
+   return false;
+}
+
+static bool slang_cache_file_older(const slang_cache_file &a,
+      const slang_cache_file &b)
+{
+   return a.mtime < b.mtime;
+}
+
+/* Delete the least recently used entries until the cache fits */
+static void slang_cache_evict(const char *dir, const char *keep,
+      uint64_t max_size)
+{
+   vector<slang_cache_file> files;
+   uint64_t total      = 0;
+   unsigned evicted    = 0;
+   size_t i;
+   struct string_list *list = dir_list_new(dir, "spv|refl",
+         false, false, false, false);
+
+   if (!list)
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      int64_t size = 0;
+      slang_cache_file file;
+
+      if (!path_get_size_mtime(list->elems[i].data, &size, &file.mtime))
+         continue;
+
+      file.path  = list->elems[i].data;
+      file.size  = (uint64_t)size;
+      total     += file.size;
+      files.push_back(file);
+   }
+
+   string_list_free(list);
+
+   if (total <= max_size)
+      return;
+
+   sort(files.begin(), files.end(), slang_cache_file_older);
+
+   for (i = 0; i < files.size() && total > max_size; i++)
+   {
+      if (string_is_equal(files[i].path.c_str(), keep))
+         continue;
+      if (filestream_delete(files[i].path.c_str()) == 0)
+      {
+         total -= files[i].size;
+         evicted++;
+      }
+   }
+
+   RARCH_LOG("[slang]: Evicted %u cache entries, %u KB left.\n",
+         evicted, (unsigned)(total / 1024));
+}
+
+void slang_cache_store(const slang_cache_key_t *key,
+      const void *data, size_t size)
+{
+   char dir[PATH_MAX_LENGTH];
+   char path[PATH_MAX_LENGTH];
+   struct slang_cache_header header;
+   vector<uint8_t> buf(sizeof(header) + size);
+   settings_t *settings = config_get_ptr();
+
+   dir[0] = path[0] = '\0';
+
+   if (!slang_cache_dir(dir, sizeof(dir)) ||
+         !slang_cache_path(key, path, sizeof(path)))
+      return;
+
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+   {
+      RARCH_WARN("[slang]: Failed to create cache directory \"%s\".\n", dir);
+      return;
+   }
+
+   header.magic   = SLANG_CACHE_MAGIC;
+   header.version = SLANG_CACHE_VERSION;
+   header.size    = (uint32_t)size;
+   header.crc     = hash_crc32(0, data, size);
+   memcpy(buf.data(), &header, sizeof(header));
+   memcpy(buf.data() + sizeof(header), data, size);
+
+   if (!cache_file_write(path, buf.data(), buf.size()))
+   {
+      RARCH_WARN("[slang]: Failed to write cache entry \"%s\".\n", path);
+      return;
+   }
+
+   slang_cache_evict(dir, path,
+         (uint64_t)settings->uints.video_shader_cache_size * 1024 * 1024);
+}
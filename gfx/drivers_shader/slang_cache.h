@@ -0,0 +1,82 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2019 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLANG_CACHE_H
+#define SLANG_CACHE_H
+
+#include <stddef.h>
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <hash/hash_stream.h>
+
+RETRO_BEGIN_DECLS
+
+/* On-disk cache of what slang presets are turned into, so that loading a
+ * preset doesn't have to run glslang and SPIRV-Cross over every pass again.
+ *
+ * Entries are files in the "slang" folder of the cache directory (or of the
+ * config directory if none is set), named by the SHA1 of everything their
+ * contents depend on. Whoever produces an entry builds that key, and encodes
+ * the entry. Once the entries add up to more than video_shader_cache_size
+ * megabytes, the least recently used are deleted. */
+
+enum slang_cache_type
+{
+   /* SPIR-V of both stages of a pass, see glslang_util.cpp */
+   SLANG_CACHE_SPIRV = 0,
+
+   /* Reflection of a pass's SPIR-V, see slang_reflection.cpp */
+   SLANG_CACHE_REFLECTION
+};
+
+typedef struct slang_cache_key
+{
+   enum slang_cache_type type;
+   char name[2 * HASH_STREAM_DIGEST_MAX + 1];
+} slang_cache_key_t;
+
+/**
+ * slang_cache_key_init:
+ * @key               : Key to start.
+ * @hash              : Hash to start.
+ * @type              : Type of the entry.
+ *
+ * Starts the key of an entry. The caller then feeds @hash with
+ * everything the entry depends on, and passes it to
+ * slang_cache_key_final.
+ *
+ * Returns: false if the cache is disabled.
+ **/
+bool slang_cache_key_init(slang_cache_key_t *key, hash_stream_t *hash,
+      enum slang_cache_type type);
+
+void slang_cache_key_final(hash_stream_t *hash, slang_cache_key_t *key);
+
+/**
+ * slang_cache_load:
+ * @key               : Key of the entry.
+ * @data              : Contents of the entry, to be freed by the caller.
+ * @size              : Size of @data.
+ *
+ * Returns: true on a hit.
+ **/
+bool slang_cache_load(const slang_cache_key_t *key, void **data, size_t *size);
+
+void slang_cache_store(const slang_cache_key_t *key,
+      const void *data, size_t size);
+
+RETRO_END_DECLS
+
+#endif
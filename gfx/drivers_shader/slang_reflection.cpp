@@ -16,9 +16,12 @@
 #include "spirv_cross.hpp"
 #include "slang_reflection.h"
 #include "slang_reflection.hpp"
+#include "slang_cache.h"
 #include <vector>
 #include <algorithm>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "../../verbosity.h"
 
 using namespace std;
@@ -734,10 +737,225 @@ bool slang_reflect(
    return true;
 }
 
+template <typename M>
+static void slang_hash_semantic_map(hash_stream_t *hash, const M *map)
+{
+   vector<string> names;
+   uint32_t count = map ? (uint32_t)map->size() : 0xffffffffu;
+
+   hash_stream_update(hash, &count, sizeof(count));
+   if (!map)
+      return;
+
+   /* Iteration order of an unordered_map isn't stable, so go by name */
+   for (auto &entry : *map)
+      names.push_back(entry.first);
+   sort(begin(names), end(names));
+
+   for (auto &name : names)
+   {
+      const auto &entry = map->find(name)->second;
+      uint32_t fields[3];
+
+      fields[0] = (uint32_t)name.size();
+      fields[1] = (uint32_t)entry.semantic;
+      fields[2] = entry.index;
+      hash_stream_update(hash, fields, sizeof(fields));
+      hash_stream_update(hash, name.data(), name.size());
+   }
+}
+
+/* Reflection doesn't only depend on the SPIR-V, but also on the semantic
+ * names of the preset and which pass this is */
+static void slang_reflection_cache_key(hash_stream_t *hash,
+      const vector<uint32_t> &vertex, const vector<uint32_t> &fragment,
+      const slang_reflection *reflection, slang_cache_key_t *key)
+{
+   uint32_t sizes[3];
+
+   sizes[0] = (uint32_t)vertex.size();
+   sizes[1] = (uint32_t)fragment.size();
+   sizes[2] = reflection->pass_number;
+   hash_stream_update(hash, sizes, sizeof(sizes));
+   hash_stream_update(hash, vertex.data(), vertex.size() * sizeof(uint32_t));
+   hash_stream_update(hash, fragment.data(),
+         fragment.size() * sizeof(uint32_t));
+
+   slang_hash_semantic_map(hash, reflection->texture_semantic_map);
+   slang_hash_semantic_map(hash, reflection->texture_semantic_uniform_map);
+   slang_hash_semantic_map(hash, reflection->semantic_map);
+
+   slang_cache_key_final(hash, key);
+}
+
+enum
+{
+   SLANG_META_UNIFORM       = 1 << 0,
+   SLANG_META_PUSH_CONSTANT = 1 << 1,
+   SLANG_META_TEXTURE       = 1 << 2
+};
+
+static void slang_write_semantic_meta(vector<uint32_t> &out,
+      const slang_semantic_meta &meta)
+{
+   out.push_back((uint32_t)meta.ubo_offset);
+   out.push_back((uint32_t)meta.push_constant_offset);
+   out.push_back(meta.num_components);
+   out.push_back((meta.uniform ? SLANG_META_UNIFORM : 0)
+         | (meta.push_constant ? SLANG_META_PUSH_CONSTANT : 0));
+}
+
+/* The cached reflection is a list of words: the buffer layout, then
+ * every texture semantic array, the base semantics and the parameters. */
+static void slang_write_reflection(vector<uint32_t> &out,
+      const slang_reflection *reflection)
+{
+   unsigned i;
+
+   out.push_back((uint32_t)reflection->ubo_size);
+   out.push_back((uint32_t)reflection->push_constant_size);
+   out.push_back(reflection->ubo_binding);
+   out.push_back(reflection->ubo_stage_mask);
+   out.push_back(reflection->push_constant_stage_mask);
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      out.push_back((uint32_t)reflection->semantic_textures[i].size());
+      for (auto &meta : reflection->semantic_textures[i])
+      {
+         out.push_back((uint32_t)meta.ubo_offset);
+         out.push_back((uint32_t)meta.push_constant_offset);
+         out.push_back(meta.binding);
+         out.push_back(meta.stage_mask);
+         out.push_back((meta.uniform ? SLANG_META_UNIFORM : 0)
+               | (meta.push_constant ? SLANG_META_PUSH_CONSTANT : 0)
+               | (meta.texture ? SLANG_META_TEXTURE : 0));
+      }
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      slang_write_semantic_meta(out, reflection->semantics[i]);
+
+   out.push_back((uint32_t)reflection->semantic_float_parameters.size());
+   for (auto &meta : reflection->semantic_float_parameters)
+      slang_write_semantic_meta(out, meta);
+}
+
+static bool slang_read_semantic_meta(const uint32_t *in, size_t size,
+      size_t *pos, slang_semantic_meta &meta)
+{
+   if (size - *pos < 4)
+      return false;
+
+   meta.ubo_offset           = in[*pos];
+   meta.push_constant_offset = in[*pos + 1];
+   meta.num_components       = in[*pos + 2];
+   meta.uniform              = !!(in[*pos + 3] & SLANG_META_UNIFORM);
+   meta.push_constant        = !!(in[*pos + 3] & SLANG_META_PUSH_CONSTANT);
+   *pos                     += 4;
+   return true;
+}
+
+static bool slang_read_reflection(const uint32_t *in, size_t size,
+      slang_reflection *reflection)
+{
+   unsigned i;
+   uint32_t count;
+   size_t pos = 5;
+
+   if (size < pos)
+      return false;
+
+   reflection->ubo_size                 = in[0];
+   reflection->push_constant_size       = in[1];
+   reflection->ubo_binding              = in[2];
+   reflection->ubo_stage_mask           = in[3];
+   reflection->push_constant_stage_mask = in[4];
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      if (pos >= size)
+         return false;
+      count = in[pos++];
+      if ((size - pos) / 5 < count)
+         return false;
+
+      reflection->semantic_textures[i].clear();
+      reflection->semantic_textures[i].resize(count);
+      for (auto &meta : reflection->semantic_textures[i])
+      {
+         meta.ubo_offset           = in[pos];
+         meta.push_constant_offset = in[pos + 1];
+         meta.binding              = in[pos + 2];
+         meta.stage_mask           = in[pos + 3];
+         meta.uniform              = !!(in[pos + 4] & SLANG_META_UNIFORM);
+         meta.push_constant        = !!(in[pos + 4] & SLANG_META_PUSH_CONSTANT);
+         meta.texture              = !!(in[pos + 4] & SLANG_META_TEXTURE);
+         pos                      += 5;
+      }
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      if (!slang_read_semantic_meta(in, size, &pos, reflection->semantics[i]))
+         return false;
+
+   if (pos >= size)
+      return false;
+   count = in[pos++];
+   if ((size - pos) / 4 < count)
+      return false;
+
+   reflection->semantic_float_parameters.clear();
+   reflection->semantic_float_parameters.resize(count);
+   for (auto &meta : reflection->semantic_float_parameters)
+      slang_read_semantic_meta(in, size, &pos, meta);
+
+   return pos == size;
+}
+
+/* Back to what slang_reflect expects to start from, keeping the inputs */
+static void slang_reflection_clear(slang_reflection *reflection)
+{
+   slang_reflection clean;
+
+   clean.texture_semantic_map         = reflection->texture_semantic_map;
+   clean.texture_semantic_uniform_map =
+      reflection->texture_semantic_uniform_map;
+   clean.semantic_map                 = reflection->semantic_map;
+   clean.pass_number                  = reflection->pass_number;
+   *reflection                        = clean;
+}
+
 bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
       const std::vector<uint32_t> &fragment,
       slang_reflection *reflection)
 {
+   hash_stream_t hash;
+   slang_cache_key_t key;
+   bool cached = slang_cache_key_init(&key, &hash, SLANG_CACHE_REFLECTION);
+
+   if (cached)
+   {
+      void *data  = NULL;
+      size_t size = 0;
+
+      slang_reflection_cache_key(&hash, vertex, fragment, reflection, &key);
+
+      if (slang_cache_load(&key, &data, &size))
+      {
+         bool ret = size % sizeof(uint32_t) == 0 &&
+            slang_read_reflection((const uint32_t*)data,
+                  size / sizeof(uint32_t), reflection);
+
+         free(data);
+         if (ret)
+            return true;
+
+         RARCH_WARN("[slang]: Cached reflection is invalid, reflecting again.\n");
+         slang_reflection_clear(reflection);
+      }
+   }
+
    try
    {
       Compiler vertex_compiler(vertex);
@@ -756,6 +974,13 @@ bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
          return false;
       }
 
+      if (cached)
+      {
+         vector<uint32_t> words;
+         slang_write_reflection(words, reflection);
+         slang_cache_store(&key, words.data(), words.size() * sizeof(uint32_t));
+      }
+
       return true;
    }
    catch (const std::exception &e)
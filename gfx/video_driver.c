@@ -2481,6 +2481,32 @@ void video_driver_frame(const void *data, unsigned width,
             av_info->timing.fps,
             av_info->timing.sample_rate);
 
+#ifdef HAVE_THREADS
+      if (video_driver_is_threaded_internal())
+      {
+         video_thread_stats_t thread_stats;
+
+         if (video_thread_get_stats(&thread_stats))
+         {
+            size_t len = strlen(video_info.stat_text);
+
+            snprintf(video_info.stat_text + len,
+                  sizeof(video_info.stat_text) - len,
+                  "Threaded Video:\n -Frames pushed: %u\n -Frames dropped: %u\n -Frames not copied: %u\n"
+                  " -Latency: <2 ms: %u, <4 ms: %u, <8 ms: %u, <16 ms: %u, <32 ms: %u, more: %u\n",
+                  thread_stats.hit_count,
+                  thread_stats.miss_count,
+                  thread_stats.zero_copy_count,
+                  thread_stats.latency[0],
+                  thread_stats.latency[1],
+                  thread_stats.latency[2],
+                  thread_stats.latency[3],
+                  thread_stats.latency[4],
+                  thread_stats.latency[5]);
+         }
+      }
+#endif
+
       /* TODO/FIXME - add OSD chat text here */
 #if 0
       snprintf(video_info.chat_text, sizeof(video_info.chat_text),
@@ -29,6 +29,23 @@
 #include "../retroarch.h"
 #include "../verbosity.h"
 
+/* Frames are handed to the video thread through three slots. The
+ * core thread owns the write slot, the video thread the read slot,
+ * and the third one is exchanged atomically between them together
+ * with a flag telling whether it holds a frame not rendered yet. */
+#define VIDEO_THREAD_SLOTS       3
+#define VIDEO_THREAD_SLOT_MASK   0x3
+#define VIDEO_THREAD_SLOT_FRESH  0x4
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+#define VIDEO_THREAD_ATOMIC_XCHG(ptr, val) __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+#define VIDEO_THREAD_ATOMIC_LOAD(ptr)      __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER) && !defined(_XBOX)
+#include <windows.h>
+#define VIDEO_THREAD_ATOMIC_XCHG(ptr, val) InterlockedExchange((volatile LONG*)(ptr), (val))
+#define VIDEO_THREAD_ATOMIC_LOAD(ptr)      InterlockedCompareExchange((volatile LONG*)(ptr), 0, 0)
+#endif
+
 enum thread_cmd
 {
    CMD_VIDEO_NONE = 0,
@@ -144,6 +161,20 @@ struct thread_packet
    } data;
 };
 
+struct thread_frame_slot
+{
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   uint64_t count;
+   retro_time_t time; /* When it was handed to the video thread. */
+   bool statistics_show;
+   struct font_params osd_stat_params;
+   char stat_text[sizeof(((video_frame_info_t*)0)->stat_text)];
+   char msg[255];
+};
+
 struct thread_video
 {
    slock_t *lock;
@@ -187,6 +218,8 @@ struct thread_video
    retro_time_t last_time;
    unsigned hit_count;
    unsigned miss_count;
+   unsigned zero_copy_count;
+   unsigned latency[VIDEO_THREAD_LATENCY_BUCKETS];
 
    float *alpha_mod;
    unsigned alpha_mods;
@@ -204,14 +237,17 @@ struct thread_video
    struct
    {
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      bool updated;
+#ifndef VIDEO_THREAD_ATOMIC_XCHG
+      slock_t *swap_lock;
+#endif
+      struct thread_frame_slot slots[VIDEO_THREAD_SLOTS];
+      size_t size;
+      unsigned write;
+      unsigned read;
+      unsigned last;
+      int state;
+      bool rendering;
       bool within_thread;
-      uint64_t count;
-      char msg[255];
    } frame;
 
    video_driver_t video_thread;
@@ -554,6 +590,48 @@ static bool video_thread_handle_packet(
    return false;
 }
 
+/* Exchanges the shared slot, returns the previous state. */
+static int video_thread_frame_swap(thread_video_t *thr, int state)
+{
+#ifdef VIDEO_THREAD_ATOMIC_XCHG
+   return (int)VIDEO_THREAD_ATOMIC_XCHG(&thr->frame.state, state);
+#else
+   int prev;
+   slock_lock(thr->frame.swap_lock);
+   prev             = thr->frame.state;
+   thr->frame.state = state;
+   slock_unlock(thr->frame.swap_lock);
+   return prev;
+#endif
+}
+
+static bool video_thread_frame_pending(thread_video_t *thr)
+{
+#ifdef VIDEO_THREAD_ATOMIC_LOAD
+   return (VIDEO_THREAD_ATOMIC_LOAD(&thr->frame.state)
+         & VIDEO_THREAD_SLOT_FRESH) != 0;
+#else
+   bool pending;
+   slock_lock(thr->frame.swap_lock);
+   pending = (thr->frame.state & VIDEO_THREAD_SLOT_FRESH) != 0;
+   slock_unlock(thr->frame.swap_lock);
+   return pending;
+#endif
+}
+
+static void video_thread_latency_add(thread_video_t *thr,
+      retro_time_t latency)
+{
+   unsigned i;
+   retro_time_t bound = 2000;
+
+   for (i = 0; i < VIDEO_THREAD_LATENCY_BUCKETS - 1; i++, bound *= 2)
+      if (latency < bound)
+         break;
+
+   thr->latency[i]++;
+}
+
 static void video_thread_loop(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
@@ -564,10 +642,18 @@ static void video_thread_loop(void *data)
       bool updated = false;
 
       slock_lock(thr->lock);
-      while (thr->send_cmd == CMD_VIDEO_NONE && !thr->frame.updated)
+      while (thr->send_cmd == CMD_VIDEO_NONE &&
+            !video_thread_frame_pending(thr))
          scond_wait(thr->cond_thread, thr->lock);
-      if (thr->frame.updated)
-         updated = true;
+      if (video_thread_frame_pending(thr))
+      {
+         thr->frame.read      = video_thread_frame_swap(thr,
+               thr->frame.read) & VIDEO_THREAD_SLOT_MASK;
+         thr->frame.rendering = true;
+         updated              = true;
+         /* The core thread might wait for the slot to be free. */
+         scond_signal(thr->cond_cmd);
+      }
 
       /* To avoid race condition where send_cmd is updated
        * right after the switch is checked. */
@@ -581,10 +667,13 @@ static void video_thread_loop(void *data)
       if (updated)
       {
          struct video_viewport vp;
+         const struct thread_frame_slot *slot =
+            &thr->frame.slots[thr->frame.read];
          bool                 ret = false;
          bool               alive = false;
          bool               focus = false;
          bool        has_windowed = true;
+         retro_time_t     latency = 0;
 
          vp.x                     = 0;
          vp.y                     = 0;
@@ -602,15 +691,26 @@ static void video_thread_loop(void *data)
             video_frame_info_t video_info;
             video_driver_build_info(&video_info);
 
+            video_info.statistics_show = slot->statistics_show;
+            if (slot->statistics_show)
+            {
+               memcpy(&video_info.osd_stat_params, &slot->osd_stat_params,
+                     sizeof(video_info.osd_stat_params));
+               strlcpy(video_info.stat_text, slot->stat_text,
+                     sizeof(video_info.stat_text));
+            }
+
             ret = thr->driver->frame(thr->driver_data,
-                  thr->frame.buffer, thr->frame.width, thr->frame.height,
-                  thr->frame.count,
-                  thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL,
+                  slot->buffer, slot->width, slot->height,
+                  slot->count,
+                  slot->pitch, *slot->msg ? slot->msg : NULL,
                   &video_info);
          }
 
          slock_unlock(thr->frame.lock);
 
+         latency = cpu_features_get_time_usec() - slot->time;
+
          if (thr->driver && thr->driver->alive)
             alive = ret && thr->driver->alive(thr->driver_data);
 
@@ -624,11 +724,12 @@ static void video_thread_loop(void *data)
             thr->driver->viewport_info(thr->driver_data, &vp);
 
          slock_lock(thr->lock);
-         thr->alive         = alive;
-         thr->focus         = focus;
-         thr->has_windowed  = has_windowed;
-         thr->frame.updated = false;
-         thr->vp            = vp;
+         thr->alive           = alive;
+         thr->focus           = focus;
+         thr->has_windowed    = has_windowed;
+         thr->frame.rendering = false;
+         thr->vp              = vp;
+         video_thread_latency_add(thr, latency);
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -696,6 +797,8 @@ static bool video_thread_frame(void *data, const void *frame_,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
    unsigned copy_stride;
+   int prev;
+   struct thread_frame_slot *slot      = NULL;
    const uint8_t *src                  = NULL;
    uint8_t *dst                        = NULL;
    thread_video_t *thr                 = (thread_video_t*)data;
@@ -715,20 +818,65 @@ static bool video_thread_frame(void *data, const void *frame_,
    copy_stride = width * (thr->info.rgb32
          ? sizeof(uint32_t) : sizeof(uint16_t));
 
-   src = (const uint8_t*)frame_;
-   dst = thr->frame.buffer;
+   slot = &thr->frame.slots[thr->frame.write];
+   src  = (const uint8_t*)frame_;
+   dst  = slot->buffer;
 
-   slock_lock(thr->lock);
+   /* A duped frame shows the last one again. */
+   if (!src)
+   {
+      src   = thr->frame.slots[thr->frame.last].buffer;
+      pitch = thr->frame.slots[thr->frame.last].pitch;
+   }
+
+   if (src == dst)
+   {
+      /* The core rendered into the buffer from
+       * GET_CURRENT_SOFTWARE_FRAMEBUFFER, nothing to copy. */
+      if (pitch != copy_stride)
+      {
+         unsigned h;
+         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+            memmove(dst, src, copy_stride);
+      }
+      thr->zero_copy_count++;
+   }
+   else
+   {
+      unsigned h;
+      for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+         memcpy(dst, src, copy_stride);
+   }
+
+   slot->width           = width;
+   slot->height          = height;
+   slot->count           = frame_count;
+   slot->pitch           = copy_stride;
+   slot->statistics_show = video_info->statistics_show;
 
-   if (!thr->nonblock)
+   if (video_info->statistics_show)
    {
+      memcpy(&slot->osd_stat_params, &video_info->osd_stat_params,
+            sizeof(slot->osd_stat_params));
+      strlcpy(slot->stat_text, video_info->stat_text,
+            sizeof(slot->stat_text));
+   }
 
+   if (msg)
+      strlcpy(slot->msg, msg, sizeof(slot->msg));
+   else
+      *slot->msg = '\0';
+
+   if (!thr->nonblock && video_thread_frame_pending(thr))
+   {
       retro_time_t target_frame_time = (retro_time_t)
          roundf(1000000 / video_info->refresh_rate);
       retro_time_t target = thr->last_time + target_frame_time;
 
-      /* Ideally, use absolute time, but that is only a good idea on POSIX. */
-      while (thr->frame.updated)
+      /* Give the thread until the frame would be due to pick up
+       * the previous one before replacing it. */
+      slock_lock(thr->lock);
+      while (video_thread_frame_pending(thr))
       {
          retro_time_t current = cpu_features_get_time_usec();
          retro_time_t delta   = target - current;
@@ -739,43 +887,32 @@ static bool video_thread_frame(void *data, const void *frame_,
          if (!scond_wait_timeout(thr->cond_cmd, thr->lock, delta))
             break;
       }
+      slock_unlock(thr->lock);
    }
 
-   /* Drop frame if updated flag is still set, as thread is
-    * still working on last frame. */
-   if (!thr->frame.updated)
-   {
-      if (src)
-      {
-         unsigned h;
-         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
-
-      thr->frame.updated = true;
-      thr->frame.width  = width;
-      thr->frame.height = height;
-      thr->frame.count  = frame_count;
-      thr->frame.pitch  = copy_stride;
+   slot->time       = cpu_features_get_time_usec();
+   thr->frame.last  = thr->frame.write;
+   prev             = video_thread_frame_swap(thr,
+         thr->frame.write | VIDEO_THREAD_SLOT_FRESH);
+   thr->frame.write = prev & VIDEO_THREAD_SLOT_MASK;
 
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
+   /* The thread was still busy and did not render
+    * the frame that got replaced. */
+   if (prev & VIDEO_THREAD_SLOT_FRESH)
+      thr->miss_count++;
+   else
+      thr->hit_count++;
 
-      scond_signal(thr->cond_thread);
+   slock_lock(thr->lock);
+   scond_signal(thr->cond_thread);
 
 #if defined(HAVE_MENU)
-      if (thr->texture.enable)
-      {
-         while (thr->frame.updated)
-            scond_wait(thr->cond_cmd, thr->lock);
-      }
-#endif
-      thr->hit_count++;
+   if (thr->texture.enable)
+   {
+      while (video_thread_frame_pending(thr) || thr->frame.rendering)
+         scond_wait(thr->cond_cmd, thr->lock);
    }
-   else
-      thr->miss_count++;
+#endif
 
    slock_unlock(thr->lock);
 
@@ -794,12 +931,16 @@ static bool video_thread_init(thread_video_t *thr,
       const video_info_t info,
       const input_driver_t **input, void **input_data)
 {
+   unsigned i;
    size_t max_size;
    thread_packet_t pkt = {CMD_INIT};
 
    thr->lock                 = slock_new();
    thr->alpha_lock           = slock_new();
    thr->frame.lock           = slock_new();
+#ifndef VIDEO_THREAD_ATOMIC_XCHG
+   thr->frame.swap_lock      = slock_new();
+#endif
    thr->cond_cmd             = scond_new();
    thr->cond_thread          = scond_new();
    thr->input                = input;
@@ -813,12 +954,22 @@ static bool video_thread_init(thread_video_t *thr,
    max_size                  = info.input_scale * RARCH_SCALE_BASE;
    max_size                 *= max_size;
    max_size                 *= info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
-   thr->frame.buffer         = (uint8_t*)malloc(max_size);
+   thr->frame.size           = max_size;
 
-   if (!thr->frame.buffer)
-      return false;
+   for (i = 0; i < VIDEO_THREAD_SLOTS; i++)
+   {
+      thr->frame.slots[i].buffer = (uint8_t*)malloc(max_size);
+
+      if (!thr->frame.slots[i].buffer)
+         return false;
+
+      memset(thr->frame.slots[i].buffer, 0x80, max_size);
+   }
 
-   memset(thr->frame.buffer, 0x80, max_size);
+   thr->frame.write          = 0;
+   thr->frame.last           = 0;
+   thr->frame.state          = 1;
+   thr->frame.read           = 2;
 
    thr->last_time            = cpu_features_get_time_usec();
    thr->thread               = sthread_create(video_thread_loop, thr);
@@ -915,6 +1066,7 @@ static bool video_thread_read_viewport(void *data, uint8_t *buffer, bool is_idle
 
 static void video_thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
    thread_packet_t pkt = { CMD_FREE };
 
@@ -928,8 +1080,12 @@ static void video_thread_free(void *data)
 #if defined(HAVE_MENU)
    free(thr->texture.frame);
 #endif
-   free(thr->frame.buffer);
+   for (i = 0; i < VIDEO_THREAD_SLOTS; i++)
+      free(thr->frame.slots[i].buffer);
    slock_free(thr->frame.lock);
+#ifndef VIDEO_THREAD_ATOMIC_XCHG
+   slock_free(thr->frame.swap_lock);
+#endif
    slock_free(thr->lock);
    scond_free(thr->cond_cmd);
    scond_free(thr->cond_thread);
@@ -937,8 +1093,8 @@ static void video_thread_free(void *data)
    free(thr->alpha_mod);
    slock_free(thr->alpha_lock);
 
-   RARCH_LOG("Threaded video stats: Frames pushed: %u, Frames dropped: %u.\n",
-         thr->hit_count, thr->miss_count);
+   RARCH_LOG("Threaded video stats: Frames pushed: %u, Frames dropped: %u, Frames not copied: %u.\n",
+         thr->hit_count, thr->miss_count, thr->zero_copy_count);
 
    free(thr);
 }
@@ -1239,6 +1395,41 @@ static uint32_t thread_get_flags(void *data)
    return thr->poke->get_flags(thr->driver_data);
 }
 
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   unsigned bpp;
+   thread_video_t *thr = (thread_video_t*)data;
+
+   if (!thr || thr->frame.within_thread)
+      return false;
+
+   /* 0RGB1555 frames are converted before they get here. */
+   switch (video_driver_get_pixel_format())
+   {
+      case RETRO_PIXEL_FORMAT_XRGB8888:
+      case RETRO_PIXEL_FORMAT_RGB565:
+         break;
+      default:
+         return false;
+   }
+
+   bpp = thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
+
+   if ((size_t)framebuffer->width * framebuffer->height * bpp
+         > thr->frame.size)
+      return false;
+
+   /* Hand out the write slot, the frame is then
+    * passed on to the video thread without a copy. */
+   framebuffer->data   = thr->frame.slots[thr->frame.write].buffer;
+   framebuffer->pitch  = framebuffer->width * bpp;
+   framebuffer->format = video_driver_get_pixel_format();
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+
+   return true;
+}
+
 static const video_poke_interface_t thread_poke = {
    thread_get_flags,
    thread_load_texture,
@@ -1261,7 +1452,7 @@ static const video_poke_interface_t thread_poke = {
    NULL,
 
    thread_get_current_shader,
-   NULL,                      /* get_current_software_framebuffer */
+   thread_get_current_software_framebuffer,
    NULL                       /* get_hw_render_interface */
 };
 
@@ -1398,6 +1589,26 @@ void *video_thread_get_ptr(const video_driver_t **drv)
    return thr->driver_data;
 }
 
+bool video_thread_get_stats(video_thread_stats_t *stats)
+{
+   unsigned i;
+   thread_video_t *thr = (thread_video_t*)video_driver_get_ptr(true);
+
+   if (!thr || !stats)
+      return false;
+
+   stats->hit_count       = thr->hit_count;
+   stats->miss_count      = thr->miss_count;
+   stats->zero_copy_count = thr->zero_copy_count;
+
+   slock_lock(thr->lock);
+   for (i = 0; i < VIDEO_THREAD_LATENCY_BUCKETS; i++)
+      stats->latency[i] = thr->latency[i];
+   slock_unlock(thr->lock);
+
+   return true;
+}
+
 const char *video_thread_get_ident(void)
 {
    const thread_video_t *thr = (const thread_video_t*)
@@ -38,6 +38,21 @@ typedef struct thread_packet thread_packet_t;
 
 typedef struct thread_video thread_video_t;
 
+/* Buckets of the frame latency histogram, each one twice as
+ * long as the previous one, starting with 0-2 ms. The last
+ * bucket holds everything above. */
+#define VIDEO_THREAD_LATENCY_BUCKETS 6
+
+typedef struct video_thread_stats
+{
+   unsigned hit_count;
+   unsigned miss_count;
+   unsigned zero_copy_count;
+   /* Time from handing a frame to the video thread
+    * until it has been rendered */
+   unsigned latency[VIDEO_THREAD_LATENCY_BUCKETS];
+} video_thread_stats_t;
+
 /**
  * video_init_thread:
  * @out_driver                : Output video driver
@@ -73,6 +88,17 @@ void *video_thread_get_ptr(const video_driver_t **drv);
 
 const char *video_thread_get_ident(void);
 
+/**
+ * video_thread_get_stats:
+ * @stats                     : Output statistics.
+ *
+ * Gets the frame handoff statistics of the threaded
+ * video wrapper.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool video_thread_get_stats(video_thread_stats_t *stats);
+
 bool video_thread_font_init(
       const void **font_driver,
       void **font_handle,
@@ -193,6 +193,7 @@ CHEATS
 ============================================================ */
 #include "../managers/cheat_manager.c"
 #include "../libretro-common/hash/rhash.c"
+#include "../libretro-common/hash/hash_stream.c"
 
 /*============================================================
 UI COMMON CONTEXT
@@ -1021,6 +1022,7 @@ FRONTEND
 #endif
 #include "../frontend/drivers/platform_null.c"
 
+#include "../cache_file.c"
 #include "../core_info.c"
 
 /*============================================================
@@ -1143,6 +1145,7 @@ THREAD
 #include "../libretro-common/rthreads/rsemaphore.c"
 #include "../gfx/video_thread_wrapper.c"
 #include "../audio/audio_thread_wrapper.c"
+#include "../audio/audio_pipeline.c"
 #endif
 
 /* needed for both playlists and netplay lobbies */
@@ -1161,6 +1164,9 @@ NETPLAY
 #include "../network/netplay/netplay_sync.c"
 #include "../network/netplay/netplay_discovery.c"
 #include "../network/netplay/netplay_buf.c"
+#include "../network/netplay/netplay_udp.c"
+#include "../network/netplay/netplay_state.c"
+#include "../network/netplay/netplay_record.c"
 #include "../network/netplay/netplay_room_parse.c"
 #include "../libretro-common/net/net_compat.c"
 #include "../libretro-common/net/net_socket.c"
@@ -1464,6 +1470,7 @@ XML
 #include "../libretro-db/rmsgpack_dom.c"
 #include "../libretro-db/query.c"
 #include "../database_info.c"
+#include "../database_index.c"
 #endif
 
 #if defined(HAVE_BUILTINMINIUPNPC)
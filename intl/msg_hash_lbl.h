@@ -63,6 +63,8 @@ MSG_HASH(MENU_ENUM_LABEL_AUDIO_SETTINGS,
       "audio_settings")
 MSG_HASH(MENU_ENUM_LABEL_AUDIO_SYNC,
       "audio_sync")
+MSG_HASH(MENU_ENUM_LABEL_AUDIO_PIPELINE,
+      "audio_pipeline")
 MSG_HASH(MENU_ENUM_LABEL_AUDIO_VOLUME,
       "audio_volume")
 MSG_HASH(MENU_ENUM_LABEL_AUDIO_WASAPI_EXCLUSIVE_MODE,
@@ -1082,6 +1084,8 @@ MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,
       "run_ahead_enabled")
 MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE,
       "run_ahead_secondary_instance")
+MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_SKIP_RELOAD,
+      "run_ahead_skip_reload")
 MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS,
       "run_ahead_hide_warnings")
 MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,
@@ -353,6 +353,10 @@ MSG_HASH(
     MENU_ENUM_LABEL_VALUE_AUDIO_SYNC,
     "Synchronization"
     )
+MSG_HASH(
+    MENU_ENUM_LABEL_VALUE_AUDIO_PIPELINE,
+    "Threaded Processing"
+    )
 MSG_HASH(
     MENU_ENUM_LABEL_VALUE_AUDIO_VOLUME,
     "Volume Gain (dB)"
@@ -2602,6 +2606,10 @@ MSG_HASH(
     MENU_ENUM_LABEL_VALUE_RUN_AHEAD_SECONDARY_INSTANCE,
     "RunAhead Use Second Instance"
     )
+MSG_HASH(
+    MENU_ENUM_LABEL_VALUE_RUN_AHEAD_SKIP_RELOAD,
+    "RunAhead Skip Reload On Predicted Input"
+    )
 MSG_HASH(
     MENU_ENUM_LABEL_VALUE_RUN_AHEAD_HIDE_WARNINGS,
     "RunAhead Hide Warnings"
@@ -5048,6 +5056,10 @@ MSG_HASH(
     MENU_ENUM_SUBLABEL_AUDIO_SYNC,
     "Synchronize audio. Recommended."
     )
+MSG_HASH(
+    MENU_ENUM_SUBLABEL_AUDIO_PIPELINE,
+    "Process audio and write it to the driver on a separate thread. Takes effect after the audio driver is reinitialized."
+    )
 MSG_HASH(
     MENU_ENUM_SUBLABEL_INPUT_BUTTON_AXIS_THRESHOLD,
     "How far an axis must be tilted to result in a button press."
@@ -5497,6 +5509,10 @@ MSG_HASH(
     MENU_ENUM_SUBLABEL_RUN_AHEAD_SECONDARY_INSTANCE,
     "Use a second instance of the RetroArch core to run ahead. Prevents audio problems due to loading state."
     )
+MSG_HASH(
+    MENU_ENUM_SUBLABEL_RUN_AHEAD_SKIP_RELOAD,
+    "Keep the states of the frames run ahead and only load a state back when the input differs from the prediction. Not used with a second instance."
+    )
 MSG_HASH(
     MENU_ENUM_SUBLABEL_RUN_AHEAD_HIDE_WARNINGS,
     "Hides the warning message that appears when using RunAhead and the core does not support savestates."
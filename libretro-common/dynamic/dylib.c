@@ -20,6 +20,11 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+/* dlmopen() and LM_ID_NEWLM are GNU extensions */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <string.h>
 #include <stdio.h>
 #include <dynamic/dylib.h>
@@ -125,6 +130,26 @@ dylib_t dylib_load(const char *path)
    return lib;
 }
 
+/**
+ * dylib_load_isolated:
+ * @path                         : Path to libretro core library.
+ *
+ * Loads the library into a new link-map namespace, so that it
+ * gets its own copy of its global state even if the same file
+ * has already been loaded with dylib_load.
+ *
+ * Returns: library handle on success, otherwise NULL. Always
+ * fails on platforms without dlmopen().
+ **/
+dylib_t dylib_load_isolated(const char *path)
+{
+#if !defined(_WIN32) && defined(LM_ID_NEWLM)
+   return dlmopen(LM_ID_NEWLM, path, RTLD_LAZY | RTLD_LOCAL);
+#else
+   return NULL;
+#endif
+}
+
 char *dylib_error(void)
 {
 #ifdef _WIN32
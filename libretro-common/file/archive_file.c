@@ -575,6 +575,81 @@ end:
    return ret;
 }
 
+static int file_archive_extract_all_cb(const char *name,
+      const char *valid_exts, const uint8_t *cdata,
+      unsigned cmode, uint32_t csize, uint32_t size,
+      uint32_t checksum, struct archive_extract_userdata *userdata)
+{
+   char path[PATH_MAX_LENGTH];
+   size_t name_len = strlen(name);
+   char last_char  = name_len ? name[name_len - 1] : '/';
+
+   path[0] = '\0';
+
+   fill_pathname_join(path, userdata->extraction_directory,
+         name, sizeof(path));
+
+   /* Directories only need to exist */
+   if (last_char == '/' || last_char == '\\')
+   {
+      if (!path_mkdir(path))
+         goto error;
+      return 1;
+   }
+
+   path_basedir_wrapper(path);
+
+   if (!path_mkdir(path))
+      goto error;
+
+   fill_pathname_join(path, userdata->extraction_directory,
+         name, sizeof(path));
+
+   if (!file_archive_perform_mode(path, valid_exts, cdata, cmode,
+            csize, size, checksum, userdata))
+      goto error;
+
+   return 1;
+
+error:
+   /* Stopping the walk isn't an error for it */
+   userdata->found_file = false;
+   return 0;
+}
+
+/**
+ * file_archive_extract_all:
+ * @path                        : filename path of archive.
+ * @target_dir                  : directory to extract the files to.
+ * @threads                     : threads decoding the archive, 1 to
+ *                                decode on the calling thread only.
+ *
+ * Extract every file from archive, keeping the directories
+ * inside it. Solid 7z archives decode their blocks in parallel.
+ *
+ * Returns : true (1) on success, otherwise false (0).
+ **/
+bool file_archive_extract_all(const char *path, const char *target_dir,
+      unsigned threads)
+{
+   struct archive_extract_userdata userdata  = {{0}};
+   const struct file_archive_file_backend *backend =
+      file_archive_get_file_backend(path);
+
+   if (!backend || string_is_empty(target_dir))
+      return false;
+
+   if (backend->archive_extract_all)
+      return backend->archive_extract_all(path, target_dir,
+            threads ? threads : 1);
+
+   userdata.extraction_directory = target_dir;
+   userdata.found_file           = true;
+
+   return file_archive_walk(path, NULL,
+         file_archive_extract_all_cb, &userdata) && userdata.found_file;
+}
+
 /**
  * file_archive_get_file_list:
  * @path                        : filename path of archive
@@ -784,6 +859,58 @@ const struct file_archive_file_backend *file_archive_get_7z_file_backend(void)
 #endif
 }
 
+void file_archive_init(void)
+{
+#ifdef HAVE_ZLIB
+   if (zlib_backend.cache_init)
+      zlib_backend.cache_init();
+#endif
+#ifdef HAVE_7ZIP
+   if (sevenzip_backend.cache_init)
+      sevenzip_backend.cache_init();
+#endif
+}
+
+void file_archive_cache_flush(void)
+{
+#ifdef HAVE_ZLIB
+   if (zlib_backend.cache_flush)
+      zlib_backend.cache_flush();
+#endif
+#ifdef HAVE_7ZIP
+   if (sevenzip_backend.cache_flush)
+      sevenzip_backend.cache_flush();
+#endif
+}
+
+void file_archive_cache_hold(void)
+{
+#ifdef HAVE_7ZIP
+   if (sevenzip_backend.cache_hold)
+      sevenzip_backend.cache_hold(true);
+#endif
+}
+
+void file_archive_cache_release(void)
+{
+#ifdef HAVE_7ZIP
+   if (sevenzip_backend.cache_hold)
+      sevenzip_backend.cache_hold(false);
+#endif
+}
+
+void file_archive_deinit(void)
+{
+#ifdef HAVE_ZLIB
+   if (zlib_backend.cache_deinit)
+      zlib_backend.cache_deinit();
+#endif
+#ifdef HAVE_7ZIP
+   if (sevenzip_backend.cache_deinit)
+      sevenzip_backend.cache_deinit();
+#endif
+}
+
 const struct file_archive_file_backend* file_archive_get_file_backend(const char *path)
 {
    char newpath[PATH_MAX_LENGTH];
@@ -832,6 +959,9 @@ uint32_t file_archive_get_file_crc32(const char *path)
    const char *archive_path                        = NULL;
    bool contains_compressed = path_contains_compressed_file(path);
 
+   const struct file_archive_file_backend *backend =
+      file_archive_get_file_backend(path);
+
    if (contains_compressed)
    {
       archive_path = path_get_archive_delim(path);
@@ -841,6 +971,24 @@ uint32_t file_archive_get_file_crc32(const char *path)
          archive_path += 1;
    }
 
+   /* Backends with an index answer without walking the archive */
+   if (backend && backend->compressed_file_crc32)
+   {
+      uint32_t crc = 0;
+      char archive_file[PATH_MAX_LENGTH];
+
+      strlcpy(archive_file, path, sizeof(archive_file));
+
+      if (archive_path)
+         archive_file[archive_path - 1 - path] = '\0';
+
+      if (backend->compressed_file_crc32(archive_file,
+               string_is_empty(archive_path) ? NULL : archive_path, &crc))
+         return crc;
+
+      return 0;
+   }
+
    state.type          = ARCHIVE_TRANSFER_INIT;
    state.archive_size  = 0;
    state.handle        = NULL;
@@ -21,13 +21,14 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <boolean.h>
 #include <file/archive_file.h>
 #include <streams/file_stream.h>
 #include <retro_miscellaneous.h>
 #include <encodings/utf.h>
-#include <encodings/crc32.h>
+#include <hash/hash_stream.h>
 #include <string/stdstring.h>
 #include <lists/string_list.h>
 #include <file/file_path.h>
@@ -36,8 +37,24 @@
 #include <7zip/7zCrc.h>
 #include <7zip/7zFile.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #define SEVENZIP_MAGIC "7z\xBC\xAF\x27\x1C"
 #define SEVENZIP_MAGIC_LEN 6
+/* Magic, version and start header */
+#define SEVENZIP_SIGNATURE_LEN 32
+
+/* Archives kept open between reads */
+#define SEVENZIP_CACHE_ARCHIVES 2
+
+/* Decoded solid blocks up to this size are kept for the next
+ * read, until file_archive_cache_flush(). Larger ones are only
+ * kept under file_archive_cache_hold(). */
+#ifndef SEVENZIP_CACHE_BLOCK_MAX
+#define SEVENZIP_CACHE_BLOCK_MAX (16 * 1024 * 1024)
+#endif
 
 /* Assume W-functions do not work below Win2K and Xbox platforms */
 #if defined(_WIN32_WINNT) && _WIN32_WINNT < 0x0500 || defined(_XBOX)
@@ -119,6 +136,379 @@ static void sevenzip_stream_free(void *data)
    File_Close(&sevenzip_context->archiveStream.file);
 }
 
+static bool sevenzip_open_file(CSzFile *file, const char *path)
+{
+#if defined(_WIN32) && defined(USE_WINDOWS_FILE) && !defined(LEGACY_WIN32)
+   if (!string_is_empty(path))
+   {
+      wchar_t *pathW = utf8_to_utf16_string_alloc(path);
+
+      if (pathW)
+      {
+         /* Could not open 7zip archive? */
+         if (InFile_OpenW(file, pathW))
+         {
+            free(pathW);
+            return false;
+         }
+
+         free(pathW);
+      }
+   }
+#else
+   /* Could not open 7zip archive? */
+   if (InFile_Open(file, path))
+      return false;
+#endif
+
+   return true;
+}
+
+/* A parsed archive with the names of its files, and the solid
+ * block decoded last. The file itself is only open while the
+ * archive is in use, so it can still be replaced or deleted. */
+typedef struct sevenzip_archive
+{
+   char *path;
+   int64_t size;
+   uint8_t signature[SEVENZIP_SIGNATURE_LEN];
+   CFileInStream archiveStream;
+   CLookToRead lookStream;
+   ISzAlloc allocImp;
+   ISzAlloc allocTempImp;
+   CSzArEx db;
+   bool db_opened;
+   bool file_opened;
+   /* UTF-8, NULL for unconvertible names */
+   char **names;
+   uint32_t block_index;
+   uint8_t *output;
+   size_t output_size;
+} sevenzip_archive_t;
+
+/* Most recently used first */
+static sevenzip_archive_t *sevenzip_cache[SEVENZIP_CACHE_ARCHIVES];
+/* Outstanding file_archive_cache_hold() calls */
+static unsigned sevenzip_cache_holds = 0;
+#ifdef HAVE_THREADS
+static slock_t *sevenzip_cache_lock = NULL;
+#endif
+
+/* Reads what tells a rewritten archive apart, the next
+ * header offset, size and CRC are in the start header. */
+static bool sevenzip_archive_stat(const char *path, int64_t *size,
+      uint8_t *signature)
+{
+   RFILE *file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   bool ret    = false;
+
+   if (!file)
+      return false;
+
+   *size = filestream_get_size(file);
+
+   if (filestream_read(file, signature, SEVENZIP_SIGNATURE_LEN)
+         == SEVENZIP_SIGNATURE_LEN)
+      ret = !memcmp(signature, SEVENZIP_MAGIC, SEVENZIP_MAGIC_LEN);
+
+   filestream_close(file);
+
+   return ret;
+}
+
+static void sevenzip_archive_free(sevenzip_archive_t *archive)
+{
+   uint32_t i;
+
+   if (!archive)
+      return;
+
+   if (archive->names)
+   {
+      for (i = 0; i < archive->db.db.NumFiles; i++)
+         free(archive->names[i]);
+      free(archive->names);
+   }
+
+   if (archive->output)
+      IAlloc_Free(&archive->allocImp, archive->output);
+
+   if (archive->db_opened)
+      SzArEx_Free(&archive->db, &archive->allocImp);
+   if (archive->file_opened)
+      File_Close(&archive->archiveStream.file);
+
+   free(archive->path);
+   free(archive);
+}
+
+static bool sevenzip_archive_open_file(sevenzip_archive_t *archive)
+{
+   if (archive->file_opened)
+      return true;
+
+   if (!sevenzip_open_file(&archive->archiveStream.file, archive->path))
+      return false;
+
+   FileInStream_CreateVTable(&archive->archiveStream);
+   LookToRead_CreateVTable(&archive->lookStream, false);
+   archive->lookStream.realStream = &archive->archiveStream.s;
+   LookToRead_Init(&archive->lookStream);
+   archive->file_opened           = true;
+
+   return true;
+}
+
+static void sevenzip_archive_close_file(sevenzip_archive_t *archive)
+{
+   if (!archive->file_opened)
+      return;
+
+   File_Close(&archive->archiveStream.file);
+   archive->file_opened = false;
+}
+
+static sevenzip_archive_t *sevenzip_archive_open(const char *path)
+{
+   uint32_t i;
+   uint16_t *temp              = NULL;
+   size_t temp_size            = 0;
+   sevenzip_archive_t *archive = (sevenzip_archive_t*)
+      calloc(1, sizeof(*archive));
+
+   if (!archive)
+      return NULL;
+
+   /* These are the allocation routines - currently using
+    * the non-standard 7zip choices. */
+   archive->allocImp.Alloc     = sevenzip_stream_alloc_impl;
+   archive->allocImp.Free      = sevenzip_stream_free_impl;
+   archive->allocTempImp.Alloc = sevenzip_stream_alloc_tmp_impl;
+   archive->allocTempImp.Free  = sevenzip_stream_free_impl;
+   archive->block_index        = 0xFFFFFFFF;
+
+   if (!(archive->path = strdup(path))
+         || !sevenzip_archive_stat(path, &archive->size, archive->signature)
+         || !sevenzip_archive_open_file(archive))
+      goto error;
+
+   CrcGenerateTable();
+   SzArEx_Init(&archive->db);
+   archive->db_opened = true;
+
+   if (SzArEx_Open(&archive->db, &archive->lookStream.s,
+            &archive->allocImp, &archive->allocTempImp) != SZ_OK)
+      goto error;
+
+   archive->names     = (char**)calloc(archive->db.db.NumFiles + 1,
+         sizeof(*archive->names));
+
+   if (!archive->names)
+      goto error;
+
+   for (i = 0; i < archive->db.db.NumFiles; i++)
+   {
+      char infile[PATH_MAX_LENGTH];
+      size_t len = SzArEx_GetFileNameUtf16(&archive->db, i, NULL);
+
+      if (len >= PATH_MAX_LENGTH)
+         continue;
+
+      if (len > temp_size)
+      {
+         free(temp);
+         temp_size = len;
+         temp      = (uint16_t*)malloc(temp_size * sizeof(temp[0]));
+
+         if (!temp)
+            goto error;
+      }
+
+      SzArEx_GetFileNameUtf16(&archive->db, i, temp);
+      infile[0] = '\0';
+
+      if (utf16_to_char_string(temp, infile, sizeof(infile)))
+         archive->names[i] = strdup(infile);
+   }
+
+   free(temp);
+
+   return archive;
+
+error:
+   free(temp);
+   sevenzip_archive_free(archive);
+   return NULL;
+}
+
+static void sevenzip_cache_lock_acquire(void)
+{
+#ifdef HAVE_THREADS
+   if (sevenzip_cache_lock)
+      slock_lock(sevenzip_cache_lock);
+#endif
+}
+
+static void sevenzip_cache_unlock(void)
+{
+#ifdef HAVE_THREADS
+   if (sevenzip_cache_lock)
+      slock_unlock(sevenzip_cache_lock);
+#endif
+}
+
+/* Same as the zip index, the lock is created by
+ * file_archive_init() */
+static void sevenzip_cache_init(void)
+{
+#ifdef HAVE_THREADS
+   if (!sevenzip_cache_lock)
+      sevenzip_cache_lock = slock_new();
+#endif
+}
+
+static void sevenzip_cache_flush(void)
+{
+   unsigned i;
+
+   sevenzip_cache_lock_acquire();
+
+   for (i = 0; i < SEVENZIP_CACHE_ARCHIVES; i++)
+   {
+      sevenzip_archive_free(sevenzip_cache[i]);
+      sevenzip_cache[i] = NULL;
+   }
+
+   sevenzip_cache_unlock();
+}
+
+/* Frees the decoded block of @archive if it is over the size cap
+ * and no hold keeps it */
+static void sevenzip_archive_trim(sevenzip_archive_t *archive)
+{
+   if (     sevenzip_cache_holds
+         || !archive->output
+         || archive->output_size <= SEVENZIP_CACHE_BLOCK_MAX)
+      return;
+
+   IAlloc_Free(&archive->allocImp, archive->output);
+   archive->output      = NULL;
+   archive->output_size = 0;
+   archive->block_index = 0xFFFFFFFF;
+}
+
+static void sevenzip_cache_hold(bool hold)
+{
+   unsigned i;
+
+   sevenzip_cache_lock_acquire();
+
+   if (hold)
+      sevenzip_cache_holds++;
+   else if (sevenzip_cache_holds && !--sevenzip_cache_holds)
+   {
+      for (i = 0; i < SEVENZIP_CACHE_ARCHIVES && sevenzip_cache[i]; i++)
+         sevenzip_archive_trim(sevenzip_cache[i]);
+   }
+
+   sevenzip_cache_unlock();
+}
+
+static void sevenzip_cache_deinit(void)
+{
+   sevenzip_cache_flush();
+
+#ifdef HAVE_THREADS
+   if (sevenzip_cache_lock)
+      slock_free(sevenzip_cache_lock);
+   sevenzip_cache_lock = NULL;
+#endif
+}
+
+static void sevenzip_cache_release(sevenzip_archive_t *archive)
+{
+   sevenzip_archive_close_file(archive);
+   sevenzip_cache_unlock();
+}
+
+/* Returns the archive at @path with its file open and the cache
+ * locked, parsing it again if the cached one is missing or was
+ * rewritten. To be released with sevenzip_cache_release(). */
+static sevenzip_archive_t *sevenzip_cache_acquire(const char *path)
+{
+   unsigned i;
+   int64_t size;
+   uint8_t signature[SEVENZIP_SIGNATURE_LEN];
+   sevenzip_archive_t *archive = NULL;
+
+   if (!sevenzip_archive_stat(path, &size, signature))
+      return NULL;
+
+   sevenzip_cache_lock_acquire();
+
+   for (i = 0; i < SEVENZIP_CACHE_ARCHIVES && sevenzip_cache[i]; i++)
+   {
+      if (string_is_equal(sevenzip_cache[i]->path, path))
+         break;
+   }
+
+   if (i < SEVENZIP_CACHE_ARCHIVES && sevenzip_cache[i])
+   {
+      archive = sevenzip_cache[i];
+
+      if (     archive->size != size
+            || memcmp(archive->signature, signature, sizeof(signature)))
+      {
+         sevenzip_archive_free(archive);
+         archive = NULL;
+      }
+   }
+   else if (i == SEVENZIP_CACHE_ARCHIVES)
+   {
+      i--;
+      sevenzip_archive_free(sevenzip_cache[i]);
+   }
+
+   memmove(&sevenzip_cache[1], &sevenzip_cache[0],
+         i * sizeof(*sevenzip_cache));
+   sevenzip_cache[0] = NULL;
+
+   if (archive && !sevenzip_archive_open_file(archive))
+   {
+      sevenzip_archive_free(archive);
+      archive = NULL;
+   }
+
+   if (!archive && !(archive = sevenzip_archive_open(path)))
+   {
+      memmove(&sevenzip_cache[0], &sevenzip_cache[1],
+            (SEVENZIP_CACHE_ARCHIVES - 1) * sizeof(*sevenzip_cache));
+      sevenzip_cache[SEVENZIP_CACHE_ARCHIVES - 1] = NULL;
+      sevenzip_cache_unlock();
+      return NULL;
+   }
+
+   sevenzip_cache[0] = archive;
+
+   return archive;
+}
+
+static uint32_t sevenzip_archive_find(const sevenzip_archive_t *archive,
+      const char *needle)
+{
+   uint32_t i;
+
+   for (i = 0; i < archive->db.db.NumFiles; i++)
+   {
+      if (     !archive->db.db.Files[i].IsDir
+            && string_is_equal(archive->names[i], needle))
+         return i;
+   }
+
+   return 0xFFFFFFFF;
+}
+
 /* Extract the relative path (needle) from a 7z archive
  * (path) and allocate a buf for it to write it in.
  * If optional_outfile is set, extract to that instead
@@ -129,178 +519,288 @@ static int sevenzip_file_read(
       const char *needle, void **buf,
       const char *optional_outfile)
 {
-   CFileInStream archiveStream;
-   CLookToRead lookStream;
+   uint32_t i;
+   size_t offset                = 0;
+   size_t outSizeProcessed      = 0;
+   long outsize                 = -1;
+   sevenzip_archive_t *archive  = sevenzip_cache_acquire(path);
+
+   if (!archive)
+      return -1;
+
+   i = sevenzip_archive_find(archive, needle);
+
+   /* C LZMA SDK does not support chunked extraction - see here:
+    * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
+    *
+    * The whole solid block is decoded, and kept for the
+    * files which follow it in the block. */
+   if (i != 0xFFFFFFFF && SzArEx_Extract(&archive->db,
+            &archive->lookStream.s, i, &archive->block_index,
+            &archive->output, &archive->output_size, &offset,
+            &outSizeProcessed, &archive->allocImp,
+            &archive->allocTempImp) == SZ_OK)
+   {
+      const void *ptr = (const void*)(archive->output + offset);
+
+      outsize = outSizeProcessed;
+
+      if (optional_outfile != NULL)
+      {
+         if (!filestream_write_file(optional_outfile, ptr, outsize))
+            outsize = -1;
+      }
+      else
+      {
+         /*We could either use the 7Zip allocated buffer,
+          * or create our own and use it.
+          * We would however need to realloc anyways, because RetroArch
+          * expects a \0 at the end, therefore we allocate new,
+          * copy and free the old one. */
+         if ((*buf = malloc(outsize + 1)))
+         {
+            ((char*)(*buf))[outsize] = '\0';
+            if (outsize > 0)
+               memcpy(*buf, ptr, outsize);
+         }
+         else
+            outsize = -1;
+      }
+   }
+
+   sevenzip_archive_trim(archive);
+
+   sevenzip_cache_release(archive);
+
+   return (int)outsize;
+}
+
+static bool sevenzip_file_crc32(const char *path, const char *needle,
+      uint32_t *crc)
+{
+   uint32_t i                  = 0;
+   sevenzip_archive_t *archive = sevenzip_cache_acquire(path);
+
+   if (!archive)
+      return false;
+
+   /* Without a needle, the first file is used */
+   if (needle)
+      i = sevenzip_archive_find(archive, needle);
+   else if (archive->db.db.NumFiles == 0)
+      i = 0xFFFFFFFF;
+
+   if (i != 0xFFFFFFFF)
+      *crc = archive->db.db.Files[i].IsDir ? 0 : archive->db.db.Files[i].Crc;
+
+   sevenzip_cache_release(archive);
+
+   return i != 0xFFFFFFFF;
+}
+
+typedef struct sevenzip_extract
+{
+   const sevenzip_archive_t *archive;
+   const char *target_dir;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+   uint32_t next_folder;
+   bool failed;
+} sevenzip_extract_t;
+
+static bool sevenzip_extract_file(const char *target_dir,
+      const char *name, const void *data, size_t size)
+{
+   char path[PATH_MAX_LENGTH];
+   char path_dir[PATH_MAX_LENGTH];
+
+   fill_pathname_join(path, target_dir, name, sizeof(path));
+   fill_pathname_basedir(path_dir, path, sizeof(path_dir));
+
+   return path_mkdir(path_dir)
+      && filestream_write_file(path, data, (int64_t)size);
+}
+
+/* Decodes the folders, as 7z calls solid blocks, which no
+ * other thread took yet, and writes out their files. */
+static void sevenzip_extract_folders(sevenzip_extract_t *extract,
+      ILookInStream *stream)
+{
    ISzAlloc allocImp;
    ISzAlloc allocTempImp;
-   CSzArEx db;
-   uint8_t *output      = 0;
-   long outsize         = -1;
+   const CSzArEx *db    = &extract->archive->db;
+   uint32_t block_index = 0xFFFFFFFF;
+   uint8_t *output      = NULL;
+   size_t output_size   = 0;
 
-   /*These are the allocation routines.
-    * Currently using the non-standard 7zip choices. */
    allocImp.Alloc       = sevenzip_stream_alloc_impl;
    allocImp.Free        = sevenzip_stream_free_impl;
    allocTempImp.Alloc   = sevenzip_stream_alloc_tmp_impl;
    allocTempImp.Free    = sevenzip_stream_free_impl;
 
-#if defined(_WIN32) && defined(USE_WINDOWS_FILE) && !defined(LEGACY_WIN32)
-   if (!string_is_empty(path))
+   for (;;)
    {
-      wchar_t *pathW = utf8_to_utf16_string_alloc(path);
+      uint32_t i, folder;
+      bool failed = false;
 
-      if (pathW)
+#ifdef HAVE_THREADS
+      if (extract->lock)
+         slock_lock(extract->lock);
+#endif
+      folder = extract->next_folder++;
+      failed = extract->failed;
+#ifdef HAVE_THREADS
+      if (extract->lock)
+         slock_unlock(extract->lock);
+#endif
+
+      if (failed || folder >= db->db.NumFolders)
+         break;
+
+      for (i = db->FolderStartFileIndex[folder];
+            i < db->db.NumFiles && !failed; i++)
       {
-         /* Could not open 7zip archive? */
-         if (InFile_OpenW(&archiveStream.file, pathW))
-         {
-            free(pathW);
-            return -1;
-         }
+         size_t offset           = 0;
+         size_t outSizeProcessed = 0;
+         uint32_t file_folder    = db->FileIndexToFolderIndexMap[i];
 
-         free(pathW);
+         if (file_folder == 0xFFFFFFFF)
+            continue;
+         if (file_folder != folder)
+            break;
+         if (db->db.Files[i].IsDir || !extract->archive->names[i])
+            continue;
+
+         failed = SzArEx_Extract(db, stream, i, &block_index, &output,
+               &output_size, &offset, &outSizeProcessed,
+               &allocImp, &allocTempImp) != SZ_OK
+            || !sevenzip_extract_file(extract->target_dir,
+                  extract->archive->names[i], output + offset,
+                  outSizeProcessed);
       }
-   }
-#else
-   /* Could not open 7zip archive? */
-   if (InFile_Open(&archiveStream.file, path))
-      return -1;
+
+      if (failed)
+      {
+#ifdef HAVE_THREADS
+         if (extract->lock)
+            slock_lock(extract->lock);
+#endif
+         extract->failed = true;
+#ifdef HAVE_THREADS
+         if (extract->lock)
+            slock_unlock(extract->lock);
 #endif
+      }
+   }
+
+   IAlloc_Free(&allocImp, output);
+}
+
+#ifdef HAVE_THREADS
+static void sevenzip_extract_thread(void *data)
+{
+   CFileInStream archiveStream;
+   CLookToRead lookStream;
+   sevenzip_extract_t *extract = (sevenzip_extract_t*)data;
+
+   /* Each thread reads through a file of its own */
+   if (!sevenzip_open_file(&archiveStream.file, extract->archive->path))
+   {
+      slock_lock(extract->lock);
+      extract->failed = true;
+      slock_unlock(extract->lock);
+      return;
+   }
 
    FileInStream_CreateVTable(&archiveStream);
    LookToRead_CreateVTable(&lookStream, false);
    lookStream.realStream = &archiveStream.s;
    LookToRead_Init(&lookStream);
-   CrcGenerateTable();
 
-   db.db.PackSizes               = NULL;
-   db.db.PackCRCsDefined         = NULL;
-   db.db.PackCRCs                = NULL;
-   db.db.Folders                 = NULL;
-   db.db.Files                   = NULL;
-   db.db.NumPackStreams          = 0;
-   db.db.NumFolders              = 0;
-   db.db.NumFiles                = 0;
-   db.startPosAfterHeader        = 0;
-   db.dataPos                    = 0;
-   db.FolderStartPackStreamIndex = NULL;
-   db.PackStreamStartPositions   = NULL;
-   db.FolderStartFileIndex       = NULL;
-   db.FileIndexToFolderIndexMap  = NULL;
-   db.FileNameOffsets            = NULL;
-   db.FileNames.data             = NULL;
-   db.FileNames.size             = 0;
-
-   SzArEx_Init(&db);
-
-   if (SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp) == SZ_OK)
-   {
-      uint32_t i;
-      bool file_found      = false;
-      uint16_t *temp       = NULL;
-      size_t temp_size     = 0;
-      uint32_t block_index = 0xFFFFFFFF;
-      SRes res             = SZ_OK;
-
-      for (i = 0; i < db.db.NumFiles; i++)
-      {
-         size_t len;
-         char infile[PATH_MAX_LENGTH];
-         size_t offset                = 0;
-         size_t outSizeProcessed      = 0;
-         const CSzFileItem    *f      = db.db.Files + i;
+   sevenzip_extract_folders(extract, &lookStream.s);
 
-         /* We skip over everything which is not a directory.
-          * FIXME: Why continue then if f->IsDir is true?*/
-         if (f->IsDir)
-            continue;
+   File_Close(&archiveStream.file);
+}
+#endif
 
-         len = SzArEx_GetFileNameUtf16(&db, i, NULL);
+static bool sevenzip_extract_all(const char *path, const char *target_dir,
+      unsigned threads)
+{
+   uint32_t i;
+   sevenzip_extract_t extract;
+#ifdef HAVE_THREADS
+   sthread_t **workers         = NULL;
+#endif
+   sevenzip_archive_t *archive = sevenzip_archive_open(path);
 
-         if (len > temp_size)
-         {
-            if (temp)
-               free(temp);
-            temp_size = len;
-            temp = (uint16_t *)malloc(temp_size * sizeof(temp[0]));
-
-            if (temp == 0)
-            {
-               res = SZ_ERROR_MEM;
-               break;
-            }
-         }
+   if (!archive)
+      return false;
 
-         SzArEx_GetFileNameUtf16(&db, i, temp);
-         res       = SZ_ERROR_FAIL;
-         infile[0] = '\0';
+   extract.archive     = archive;
+   extract.target_dir  = target_dir;
+   extract.next_folder = 0;
+   extract.failed      = false;
 
-         if (temp)
-            res = utf16_to_char_string(temp, infile, sizeof(infile))
-               ? SZ_OK : SZ_ERROR_FAIL;
+   /* Directories and empty files have no folder */
+   for (i = 0; i < archive->db.db.NumFiles && !extract.failed; i++)
+   {
+      if (     archive->db.FileIndexToFolderIndexMap[i] != 0xFFFFFFFF
+            || !archive->names[i])
+         continue;
 
-         if (string_is_equal(infile, needle))
-         {
-            size_t output_size   = 0;
-
-            /* C LZMA SDK does not support chunked extraction - see here:
-             * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
-             * */
-            file_found = true;
-            res = SzArEx_Extract(&db, &lookStream.s, i, &block_index,
-                  &output, &output_size, &offset, &outSizeProcessed,
-                  &allocImp, &allocTempImp);
-
-            if (res != SZ_OK)
-               break; /* This goes to the error section. */
-
-            outsize = outSizeProcessed;
-
-            if (optional_outfile != NULL)
-            {
-               const void *ptr = (const void*)(output + offset);
-
-               if (!filestream_write_file(optional_outfile, ptr, outsize))
-               {
-                  res        = SZ_OK;
-                  file_found = true;
-                  outsize    = -1;
-               }
-            }
-            else
-            {
-               /*We could either use the 7Zip allocated buffer,
-                * or create our own and use it.
-                * We would however need to realloc anyways, because RetroArch
-                * expects a \0 at the end, therefore we allocate new,
-                * copy and free the old one. */
-               *buf = malloc(outsize + 1);
-               ((char*)(*buf))[outsize] = '\0';
-               memcpy(*buf,output + offset,outsize);
-            }
-            break;
-         }
+      if (archive->db.db.Files[i].IsDir)
+      {
+         char path_dir[PATH_MAX_LENGTH];
+
+         fill_pathname_join(path_dir, target_dir, archive->names[i],
+               sizeof(path_dir));
+         extract.failed = !path_mkdir(path_dir);
       }
+      else
+         extract.failed = !sevenzip_extract_file(target_dir,
+               archive->names[i], "", 0);
+   }
 
-      if (temp)
-         free(temp);
-      IAlloc_Free(&allocImp, output);
+#ifdef HAVE_THREADS
+   extract.lock = NULL;
 
-      if (!(file_found && res == SZ_OK))
+   if (threads > archive->db.db.NumFolders)
+      threads = archive->db.db.NumFolders;
+
+   if (threads > 1)
+   {
+      extract.lock = slock_new();
+      workers      = (sthread_t**)calloc(threads - 1, sizeof(*workers));
+
+      if (extract.lock && workers)
       {
-         /* Error handling
-          *
-          * Failed to open compressed file inside 7zip archive.
-          */
+         for (i = 0; i < threads - 1; i++)
+            workers[i] = sthread_create(sevenzip_extract_thread, &extract);
+      }
+   }
+#endif
 
-         outsize    = -1;
+   /* The calling thread takes its share too */
+   sevenzip_extract_folders(&extract, &archive->lookStream.s);
+
+#ifdef HAVE_THREADS
+   if (workers)
+   {
+      for (i = 0; i < threads - 1; i++)
+      {
+         if (workers[i])
+            sthread_join(workers[i]);
       }
+      free(workers);
    }
+   if (extract.lock)
+      slock_free(extract.lock);
+#endif
 
-   SzArEx_Free(&db, &allocImp);
-   File_Close(&archiveStream.file);
+   sevenzip_archive_free(archive);
 
-   return (int)outsize;
+   return !extract.failed;
 }
 
 static bool sevenzip_stream_decompress_data_to_file_init(
@@ -357,28 +857,8 @@ static int sevenzip_parse_file_init(file_archive_transfer_t *state,
 
    state->stream = sevenzip_context;
 
-#if defined(_WIN32) && defined(USE_WINDOWS_FILE) && !defined(LEGACY_WIN32)
-   if (!string_is_empty(file))
-   {
-      wchar_t *fileW = utf8_to_utf16_string_alloc(file);
-
-      if (fileW)
-      {
-         /* could not open 7zip archive? */
-         if (InFile_OpenW(&sevenzip_context->archiveStream.file, fileW))
-         {
-            free(fileW);
-            goto error;
-         }
-
-         free(fileW);
-      }
-   }
-#else
-   /* could not open 7zip archive? */
-   if (InFile_Open(&sevenzip_context->archiveStream.file, file))
+   if (!sevenzip_open_file(&sevenzip_context->archiveStream.file, file))
       goto error;
-#endif
 
    FileInStream_CreateVTable(&sevenzip_context->archiveStream);
    LookToRead_CreateVTable(&sevenzip_context->lookStream, false);
@@ -500,7 +980,7 @@ static int sevenzip_parse_file_iterate_step(file_archive_transfer_t *state,
 static uint32_t sevenzip_stream_crc32_calculate(uint32_t crc,
       const uint8_t *data, size_t length)
 {
-   return encoding_crc32(crc, data, length);
+   return hash_crc32(crc, data, length);
 }
 
 const struct file_archive_file_backend sevenzip_backend = {
@@ -510,6 +990,12 @@ const struct file_archive_file_backend sevenzip_backend = {
    sevenzip_stream_decompress_data_to_file_iterate,
    sevenzip_stream_crc32_calculate,
    sevenzip_file_read,
+   sevenzip_file_crc32,
+   sevenzip_extract_all,
+   sevenzip_cache_init,
+   sevenzip_cache_flush,
+   sevenzip_cache_deinit,
+   sevenzip_cache_hold,
    sevenzip_parse_file_init,
    sevenzip_parse_file_iterate_step,
    "7z"
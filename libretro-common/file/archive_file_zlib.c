@@ -28,7 +28,12 @@
 #include <streams/trans_stream.h>
 #include <retro_inline.h>
 #include <retro_miscellaneous.h>
-#include <encodings/crc32.h>
+#include <hash/hash_stream.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 /* Only for MAX_WBITS */
 #include <compat/zlib.h>
@@ -41,6 +46,16 @@
 #define END_OF_CENTRAL_DIR_SIGNATURE 0x06054b50
 #endif
 
+#ifndef LOCAL_FILE_HEADER_SIGNATURE
+#define LOCAL_FILE_HEADER_SIGNATURE 0x04034b50
+#endif
+
+/* Archives whose central directory is kept parsed */
+#define ZIP_INDEX_CACHE_SIZE 4
+
+/* Compressed data is read and inflated this much at a time */
+#define ZIP_CHUNK_SIZE 0x10000
+
 static INLINE uint32_t read_le(const uint8_t *data, unsigned size)
 {
    unsigned i;
@@ -122,169 +137,599 @@ static int zlib_stream_decompress_data_to_file_iterate(void *stream)
 static uint32_t zlib_stream_crc32_calculate(uint32_t crc,
       const uint8_t *data, size_t length)
 {
-   return encoding_crc32(crc, data, length);
+   return hash_crc32(crc, data, length);
 }
 
-static bool zip_file_decompressed_handle(
-      file_archive_file_handle_t *handle,
-      const uint8_t *cdata, uint32_t csize,
-      uint32_t size, uint32_t crc32)
+/* Parsed central directory of an archive, so a member can be
+ * found without walking all the entries before it. */
+typedef struct zip_index_entry
 {
-   int ret   = 0;
+   const char *name;
+   uint32_t hash;
+   /* Offset of the local file header */
+   uint32_t offset;
+   uint32_t csize;
+   uint32_t size;
+   uint32_t crc32;
+   unsigned cmode;
+} zip_index_entry_t;
 
-   handle->backend = &zlib_backend;
+typedef struct zip_index
+{
+   char *path;
+   int64_t archive_size;
+   /* End of central directory record the index was built from */
+   uint8_t footer[22];
+   zip_index_entry_t *entries;
+   uint32_t count;
+   /* Entry index + 1 by name hash, 0 for an empty bucket */
+   uint32_t *buckets;
+   uint32_t buckets_mask;
+   char *names;
+} zip_index_t;
+
+/* Most recently used first */
+static zip_index_t *zip_index_cache[ZIP_INDEX_CACHE_SIZE];
+#ifdef HAVE_THREADS
+static slock_t *zip_index_cache_lock = NULL;
+#endif
 
-   if (!handle->backend->stream_decompress_data_to_file_init(
-            handle, cdata, csize, size))
-      return false;
+static uint32_t zip_index_hash(const char *name)
+{
+   uint32_t hash = 5381;
+
+   while (*name)
+      hash = (hash << 5) + hash + (uint8_t)*name++;
 
-   do
+   return hash;
+}
+
+static void zip_index_free(zip_index_t *index)
+{
+   if (!index)
+      return;
+
+   free(index->path);
+   free(index->entries);
+   free(index->buckets);
+   free(index->names);
+   free(index);
+}
+
+static const zip_index_entry_t *zip_index_find(const zip_index_t *index,
+      const char *name)
+{
+   uint32_t hash = zip_index_hash(name);
+   uint32_t i    = hash & index->buckets_mask;
+
+   while (index->buckets[i])
    {
-      ret = handle->backend->stream_decompress_data_to_file_iterate(
-            handle->stream);
-   }while(ret == 0);
+      const zip_index_entry_t *entry = &index->entries[index->buckets[i] - 1];
 
-#if 0
-   handle->real_checksum = handle->backend->stream_crc_calculate(0,
-         handle->data, size);
+      if (entry->hash == hash && string_is_equal(entry->name, name))
+         return entry;
+
+      i = (i + 1) & index->buckets_mask;
+   }
+
+   return NULL;
+}
+
+/* Reads the end of central directory record into @footer.
+ * @hint is where a cached index expects it to be, otherwise
+ * most archives have no comment, so only the last kilobyte
+ * is read first. */
+static bool zip_index_read_footer(RFILE *file, int64_t archive_size,
+      int64_t hint, uint8_t *footer)
+{
+   unsigned pass;
+   uint8_t *tail = NULL;
+   bool found    = false;
 
-   if (handle->real_checksum != crc32)
+   for (pass = hint ? 0 : 1; pass < 3 && !found; pass++)
+   {
+      int64_t len = pass == 0 ? hint : pass == 1 ? 1024 : 22 + 0xFFFF;
+      uint8_t *cur;
+
+      if (len > archive_size)
+         len = archive_size;
+      if (len < 22 || (pass == 2 && len <= 1024))
+         break;
+
+      free(tail);
+      tail = (uint8_t*)malloc((size_t)len);
+
+      if (!tail
+            || filestream_seek(file, archive_size - len,
+               RETRO_VFS_SEEK_POSITION_START) != 0
+            || filestream_read(file, tail, len) != len)
+         break;
+
+      for (cur = tail + len - 22; cur >= tail; cur--)
+      {
+         if (read_le(cur, 4) == END_OF_CENTRAL_DIR_SIGNATURE
+               && cur + 22 + read_le(cur + 20, 2) == tail + len)
+         {
+            memcpy(footer, cur, 22);
+            found = true;
+            break;
+         }
+      }
+   }
+
+   free(tail);
+
+   return found;
+}
+
+static zip_index_t *zip_index_parse(RFILE *file, const char *path,
+      int64_t archive_size, const uint8_t *footer)
+{
+   uint32_t i, capacity, buckets;
+   uint8_t *directory  = NULL;
+   const uint8_t *cur  = NULL;
+   const uint8_t *end  = NULL;
+   char *names         = NULL;
+   uint32_t dir_size   = read_le(footer + 12, 4);
+   uint32_t dir_offset = read_le(footer + 16, 4);
+   zip_index_t *index  = (zip_index_t*)calloc(1, sizeof(*index));
+
+   if (!index || (int64_t)dir_offset + dir_size > archive_size)
       goto error;
-#endif
 
-   if (handle->stream)
-      free(handle->stream);
+   /* Every entry takes at least 46 bytes, which is more than
+    * its name and terminator take in the names block. */
+   capacity         = dir_size / 46;
+   buckets          = 16;
+   while (buckets < capacity * 2)
+      buckets     <<= 1;
+
+   index->path         = strdup(path);
+   index->archive_size = archive_size;
+   index->entries      = (zip_index_entry_t*)malloc(
+         (capacity ? capacity : 1) * sizeof(*index->entries));
+   index->buckets      = (uint32_t*)calloc(buckets, sizeof(*index->buckets));
+   index->buckets_mask = buckets - 1;
+   index->names        = (char*)malloc(dir_size + 1);
+   directory           = (uint8_t*)malloc(dir_size + 1);
+   memcpy(index->footer, footer, sizeof(index->footer));
+
+   if (!index->path || !index->entries || !index->buckets
+         || !index->names || !directory)
+      goto error;
+
+   if (filestream_seek(file, dir_offset, RETRO_VFS_SEEK_POSITION_START) != 0
+         || filestream_read(file, directory, dir_size) != dir_size)
+      goto error;
+
+   cur   = directory;
+   end   = directory + dir_size;
+   names = index->names;
+
+   while (cur + 46 <= end && index->count < capacity
+         && read_le(cur, 4) == CENTRAL_FILE_HEADER_SIGNATURE)
+   {
+      zip_index_entry_t *entry = &index->entries[index->count];
+      uint32_t namelength      = read_le(cur + 28, 2);
+      uint32_t extralength     = read_le(cur + 30, 2);
+      uint32_t commentlength   = read_le(cur + 32, 2);
+
+      if (cur + 46 + namelength > end || namelength >= PATH_MAX_LENGTH)
+         break;
+
+      memcpy(names, cur + 46, namelength);
+      names[namelength] = '\0';
+
+      entry->name    = names;
+      entry->hash    = zip_index_hash(names);
+      entry->cmode   = read_le(cur + 10, 2);
+      entry->crc32   = read_le(cur + 16, 4);
+      entry->csize   = read_le(cur + 20, 4);
+      entry->size    = read_le(cur + 24, 4);
+      entry->offset  = read_le(cur + 42, 4);
+
+      /* Keep the first of duplicate names, like a walk would */
+      if (!zip_index_find(index, names))
+      {
+         i = entry->hash & index->buckets_mask;
+         while (index->buckets[i])
+            i = (i + 1) & index->buckets_mask;
+         index->buckets[i] = index->count + 1;
+      }
+
+      names += namelength + 1;
+      cur   += 46 + namelength + extralength + commentlength;
+      index->count++;
+   }
+
+   free(directory);
+
+   return index;
 
-   return true;
-#if 0
 error:
-   if (handle->stream)
-      free(handle->stream);
-   if (handle->data)
-      free(handle->data);
+   free(directory);
+   zip_index_free(index);
+   return NULL;
+}
 
-   handle->stream = NULL;
-   handle->data   = NULL;
-   return false;
+static void zip_index_unlock(void)
+{
+#ifdef HAVE_THREADS
+   if (zip_index_cache_lock)
+      slock_unlock(zip_index_cache_lock);
 #endif
 }
 
-/* Extract the relative path (needle) from a
- * ZIP archive (path) and allocate a buffer for it to write it in.
- *
- * optional_outfile if not NULL will be used to extract the file to.
- * buf will be 0 then.
- */
+/* The lock is created by file_archive_init(), before any
+ * archive is read. Without it, archives are only read from
+ * one thread. */
+static void zip_index_cache_init(void)
+{
+#ifdef HAVE_THREADS
+   if (!zip_index_cache_lock)
+      zip_index_cache_lock = slock_new();
+#endif
+}
 
-static int zip_file_decompressed(
-      const char *name, const char *valid_exts,
-      const uint8_t *cdata, unsigned cmode,
-      uint32_t csize, uint32_t size,
-      uint32_t crc32, struct archive_extract_userdata *userdata)
+static void zip_index_lock(void)
 {
-   char last_char = name[strlen(name) - 1];
-   /* Ignore directories. */
-   if (last_char == '/' || last_char == '\\')
-      return 1;
+#ifdef HAVE_THREADS
+   if (zip_index_cache_lock)
+      slock_lock(zip_index_cache_lock);
+#endif
+}
+
+static void zip_index_cache_flush(void)
+{
+   unsigned i;
+
+   zip_index_lock();
 
-   if (strstr(name, userdata->decomp_state.needle))
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
    {
-      bool goto_error = false;
-      file_archive_file_handle_t handle = {0};
+      zip_index_free(zip_index_cache[i]);
+      zip_index_cache[i] = NULL;
+   }
+
+   zip_index_unlock();
+}
+
+static void zip_index_cache_deinit(void)
+{
+   zip_index_cache_flush();
+
+#ifdef HAVE_THREADS
+   if (zip_index_cache_lock)
+      slock_free(zip_index_cache_lock);
+   zip_index_cache_lock = NULL;
+#endif
+}
+
+
+/* Returns the index of the archive at @path with the cache
+ * locked, parsing it if the cached one is missing or stale.
+ * @file is left open for reading the members. */
+static const zip_index_t *zip_index_acquire(const char *path, RFILE **file)
+{
+   unsigned i;
+   uint8_t footer[22];
+   int64_t archive_size;
+   int64_t hint       = 0;
+   zip_index_t *index = NULL;
+
+   *file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
-      userdata->decomp_state.found = true;
+   if (!*file)
+      return NULL;
 
-      if (zip_file_decompressed_handle(&handle,
-               cdata, csize, size, crc32))
+   archive_size = filestream_get_size(*file);
+
+   zip_index_lock();
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE && zip_index_cache[i]; i++)
+   {
+      if (string_is_equal(zip_index_cache[i]->path, path))
       {
-         if (userdata->decomp_state.opt_file != 0)
-         {
-            /* Called in case core has need_fullpath enabled. */
-            char *buf       = (char*)malloc(size);
+         hint = 22 + read_le(zip_index_cache[i]->footer + 20, 2);
+         break;
+      }
+   }
+   zip_index_unlock();
 
-            if (buf)
-            {
-               memcpy(buf, handle.data, size);
+   if (!zip_index_read_footer(*file, archive_size, hint, footer))
+      goto error;
 
-               if (!filestream_write_file(userdata->decomp_state.opt_file, buf, size))
-                  goto_error = true;
-            }
+   zip_index_lock();
 
-            free(buf);
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE && zip_index_cache[i]; i++)
+   {
+      zip_index_t *cached = zip_index_cache[i];
 
-            userdata->decomp_state.size = 0;
-         }
-         else
-         {
-            /* Called in case core has need_fullpath disabled.
-             * Will copy decompressed content directly into
-             * RetroArch's ROM buffer. */
-            *userdata->decomp_state.buf = malloc(size);
-            memcpy(*userdata->decomp_state.buf, handle.data, size);
+      if (     cached->archive_size == archive_size
+            && !memcmp(cached->footer, footer, sizeof(footer))
+            && string_is_equal(cached->path, path))
+      {
+         memmove(&zip_index_cache[1], &zip_index_cache[0],
+               i * sizeof(*zip_index_cache));
+         zip_index_cache[0] = cached;
+         return cached;
+      }
+   }
 
-            userdata->decomp_state.size = size;
-         }
+   zip_index_unlock();
+
+   if (!(index = zip_index_parse(*file, path, archive_size, footer)))
+      goto error;
+
+   zip_index_lock();
+
+   /* Drops the least recently used index, and a stale copy
+    * of this one if there is one */
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE && zip_index_cache[i]; i++)
+   {
+      if (string_is_equal(zip_index_cache[i]->path, path))
+         break;
+   }
+   if (i == ZIP_INDEX_CACHE_SIZE)
+      i--;
+
+   zip_index_free(zip_index_cache[i]);
+   memmove(&zip_index_cache[1], &zip_index_cache[0],
+         i * sizeof(*zip_index_cache));
+   zip_index_cache[0] = index;
+
+   return index;
+
+error:
+   filestream_close(*file);
+   *file = NULL;
+   return NULL;
+}
+
+static bool zip_file_is_directory(const char *name)
+{
+   size_t len = strlen(name);
+
+   return len == 0 || name[len - 1] == '/' || name[len - 1] == '\\';
+}
+
+/* Moves @file to the data of the member whose local file
+ * header is at @offset. */
+static bool zip_file_seek_data(RFILE *file, uint32_t offset)
+{
+   uint8_t header[30];
+
+   if (filestream_seek(file, offset, RETRO_VFS_SEEK_POSITION_START) != 0
+         || filestream_read(file, header, sizeof(header)) != sizeof(header)
+         || read_le(header, 4) != LOCAL_FILE_HEADER_SIGNATURE)
+      return false;
+
+   return filestream_seek(file, offset + 30 + read_le(header + 26, 2)
+         + read_le(header + 28, 2), RETRO_VFS_SEEK_POSITION_START) == 0;
+}
+
+/* Inflates or copies the member, read from the current position
+ * of @file, either into @out which must hold one byte more than
+ * the member, or to @outfile a chunk at a time. */
+static bool zip_file_extract(RFILE *file, const zip_index_entry_t *entry,
+      uint8_t *out, RFILE *outfile)
+{
+   uint32_t left    = entry->csize;
+   uint32_t written = 0;
+   uint32_t avail   = 0;
+   uint8_t *in      = NULL;
+   uint8_t *chunk   = NULL;
+   void *stream     = NULL;
+   bool ret         = false;
+
+   if (entry->cmode == ARCHIVE_MODE_UNCOMPRESSED && out)
+      return entry->csize == entry->size
+         && filestream_read(file, out, entry->size) == entry->size;
+
+   in    = (uint8_t*)malloc(ZIP_CHUNK_SIZE);
+   chunk = outfile ? (uint8_t*)malloc(ZIP_CHUNK_SIZE) : NULL;
+
+   if (!in || (outfile && !chunk))
+      goto end;
+
+   if (entry->cmode == ARCHIVE_MODE_UNCOMPRESSED)
+   {
+      if (entry->csize != entry->size)
+         goto end;
+
+      while (left > 0)
+      {
+         uint32_t len = left < ZIP_CHUNK_SIZE ? left : ZIP_CHUNK_SIZE;
+
+         if (     filestream_read(file, in, len) != len
+               || filestream_write(outfile, in, len) != len)
+            goto end;
+
+         left -= len;
+      }
+
+      ret = true;
+      goto end;
+   }
+
+   if (entry->cmode != ARCHIVE_MODE_COMPRESSED)
+      goto end;
+
+   if (!(stream = zlib_inflate_backend.stream_new()))
+      goto end;
+
+   if (zlib_inflate_backend.define)
+      zlib_inflate_backend.define(stream, "window_bits", (uint32_t)-MAX_WBITS);
+
+   if (out)
+      zlib_inflate_backend.set_out(stream, out, entry->size + 1);
+   else
+      zlib_inflate_backend.set_out(stream, chunk, ZIP_CHUNK_SIZE);
+
+   for (;;)
+   {
+      bool zstatus;
+      uint32_t rd = 0;
+      uint32_t wn = 0;
+      enum trans_stream_error terror = TRANS_STREAM_ERROR_NONE;
+
+      if (avail == 0 && left > 0)
+      {
+         avail = left < ZIP_CHUNK_SIZE ? left : ZIP_CHUNK_SIZE;
+
+         if (filestream_read(file, in, avail) != avail)
+            goto end;
+
+         left -= avail;
+         zlib_inflate_backend.set_in(stream, in, avail);
+      }
+
+      zstatus  = zlib_inflate_backend.trans(stream, false, &rd, &wn, &terror);
+      avail   -= rd;
+      written += wn;
+
+      if (written > entry->size)
+         goto end;
+
+      if (outfile && wn > 0)
+      {
+         if (filestream_write(outfile, chunk, wn) != wn)
+            goto end;
+         zlib_inflate_backend.set_out(stream, chunk, ZIP_CHUNK_SIZE);
       }
 
-      if (handle.data)
-         free(handle.data);
+      if (!zstatus && terror != TRANS_STREAM_ERROR_BUFFER_FULL)
+         goto end;
 
-      if (goto_error)
-         return 0;
+      if (zstatus && terror == TRANS_STREAM_ERROR_NONE)
+         break;
    }
 
-   return 1;
+   ret = written == entry->size;
+
+end:
+   if (stream)
+      zlib_inflate_backend.stream_free(stream);
+   free(chunk);
+   free(in);
+
+   return ret;
 }
 
+/* Extract the relative path (needle) from a
+ * ZIP archive (path) and allocate a buffer for it to write it in.
+ *
+ * optional_outfile if not NULL will be used to extract the file to.
+ * buf will be 0 then.
+ */
 static int zip_file_read(
       const char *path,
       const char *needle, void **buf,
       const char *optional_outfile)
 {
-   file_archive_transfer_t zlib;
-   struct archive_extract_userdata userdata = {{0}};
-   bool returnerr                           = true;
-   int ret                                  = 0;
-
-   zlib.type                                = ARCHIVE_TRANSFER_INIT;
-   zlib.archive_size                        = 0;
-   zlib.start_delta                         = 0;
-   zlib.handle                              = NULL;
-   zlib.stream                              = NULL;
-   zlib.footer                              = NULL;
-   zlib.directory                           = NULL;
-   zlib.data                                = NULL;
-   zlib.backend                             = NULL;
-
-   userdata.decomp_state.needle             = NULL;
-   userdata.decomp_state.opt_file           = NULL;
-   userdata.decomp_state.found              = false;
-   userdata.decomp_state.buf                = buf;
+   uint32_t i;
+   zip_index_entry_t entry;
+   RFILE *file                    = NULL;
+   RFILE *outfile                 = NULL;
+   uint8_t *data                  = NULL;
+   const zip_index_entry_t *found = NULL;
+   const zip_index_t *index       = zip_index_acquire(path, &file);
+
+   if (!index)
+      return -1;
 
    if (needle)
-      userdata.decomp_state.needle          = strdup(needle);
+   {
+      found = zip_index_find(index, needle);
+
+      /* Fall back to the first member containing the needle */
+      for (i = 0; (!found || zip_file_is_directory(found->name))
+            && i < index->count; i++)
+      {
+         found = NULL;
+         if (strstr(index->entries[i].name, needle))
+            found = &index->entries[i];
+      }
+
+      if (found && zip_file_is_directory(found->name))
+         found = NULL;
+   }
+
+   if (found)
+      entry = *found;
+
+   zip_index_unlock();
+
+   if (!found || !zip_file_seek_data(file, entry.offset))
+      goto error;
+
    if (optional_outfile)
-      userdata.decomp_state.opt_file        = strdup(optional_outfile);
+   {
+      /* Called in case core has need_fullpath enabled. */
+      if (!(outfile = filestream_open(optional_outfile,
+                  RETRO_VFS_FILE_ACCESS_WRITE,
+                  RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+         goto error;
+
+      if (!zip_file_extract(file, &entry, NULL, outfile))
+         goto error;
+
+      filestream_close(outfile);
+      filestream_close(file);
+
+      return 0;
+   }
+
+   /* Called in case core has need_fullpath disabled.
+    * Will inflate directly into RetroArch's ROM buffer. */
+   if (!(data = (uint8_t*)malloc(entry.size + 1)))
+      goto error;
+
+   if (!zip_file_extract(file, &entry, data, NULL))
+      goto error;
+
+   data[entry.size] = '\0';
+   *buf             = data;
 
-   do
+   filestream_close(file);
+
+   return (int)entry.size;
+
+error:
+   free(data);
+   if (outfile)
    {
-      ret = file_archive_parse_file_iterate(&zlib, &returnerr, path,
-            "", zip_file_decompressed, &userdata);
-      if (!returnerr)
-         break;
-   }while(ret == 0 && !userdata.decomp_state.found);
+      filestream_close(outfile);
+      filestream_delete(optional_outfile);
+   }
+   filestream_close(file);
 
-   file_archive_parse_file_iterate_stop(&zlib);
+   return -1;
+}
 
-   if (userdata.decomp_state.opt_file)
-      free(userdata.decomp_state.opt_file);
-   if (userdata.decomp_state.needle)
-      free(userdata.decomp_state.needle);
+static bool zip_file_crc32(const char *path, const char *needle,
+      uint32_t *crc)
+{
+   RFILE *file                    = NULL;
+   const zip_index_entry_t *found = NULL;
+   const zip_index_t *index       = zip_index_acquire(path, &file);
 
-   if (!userdata.decomp_state.found)
-      return -1;
+   if (!index)
+      return false;
+
+   /* Without a needle, the first member is used */
+   if (needle)
+      found = zip_index_find(index, needle);
+   else if (index->count > 0)
+      found = &index->entries[0];
+
+   if (found)
+      *crc = found->crc32;
+
+   zip_index_unlock();
+   filestream_close(file);
 
-   return (int)userdata.decomp_state.size;
+   return found != NULL;
 }
 
 static int zip_parse_file_init(file_archive_transfer_t *state,
@@ -387,6 +832,12 @@ const struct file_archive_file_backend zlib_backend = {
    zlib_stream_decompress_data_to_file_iterate,
    zlib_stream_crc32_calculate,
    zip_file_read,
+   zip_file_crc32,
+   NULL,
+   zip_index_cache_init,
+   zip_index_cache_flush,
+   zip_index_cache_deinit,
+   NULL,
    zip_parse_file_init,
    zip_parse_file_iterate_step,
    "zlib"
@@ -51,6 +51,10 @@
 
 #define MAX_INCLUDE_DEPTH 16
 
+#define CONFIG_ARENA_BLOCK_MIN  (2 * 1024)
+#define CONFIG_ARENA_BLOCK_MAX  (64 * 1024)
+#define CONFIG_MAP_BUCKETS_MIN  32
+
 struct config_entry_list
 {
    /* If we got this from an #include,
@@ -60,6 +64,19 @@ struct config_entry_list
    char *key;
    char *value;
    struct config_entry_list *next;
+   /* Next entry of the same bucket in the key map */
+   struct config_entry_list *map_next;
+   uint32_t hash;
+};
+
+/* Keys and values are never freed one by one, they are
+ * released all at once with the config file. */
+struct config_arena_block
+{
+   struct config_arena_block *next;
+   size_t used;
+   size_t size;
+   char data[1];
 };
 
 struct config_include_list
@@ -71,6 +88,244 @@ struct config_include_list
 static config_file_t *config_file_new_internal(
       const char *path, unsigned depth, config_file_cb_t *cb);
 
+static char *config_strndup(config_file_t *conf, const char *str, size_t len)
+{
+   char *copy                       = NULL;
+   struct config_arena_block *block = conf->arena;
+
+   if (!block || block->size - block->used < len + 1)
+   {
+      size_t size = block ? block->size * 2 : CONFIG_ARENA_BLOCK_MIN;
+
+      if (size > CONFIG_ARENA_BLOCK_MAX)
+         size = CONFIG_ARENA_BLOCK_MAX;
+      if (size < len + 1)
+         size = len + 1;
+
+      block = (struct config_arena_block*)malloc(sizeof(*block) + size);
+
+      if (!block)
+         return NULL;
+
+      block->used = 0;
+      block->size = size;
+
+      /* An oversized string gets a block of its own, keep
+       * filling the current one afterwards */
+      if (conf->arena && size == len + 1)
+      {
+         block->next       = conf->arena->next;
+         conf->arena->next = block;
+      }
+      else
+      {
+         block->next       = conf->arena;
+         conf->arena       = block;
+      }
+   }
+
+   copy         = block->data + block->used;
+   memcpy(copy, str, len);
+   copy[len]    = '\0';
+   block->used += len + 1;
+
+   return copy;
+}
+
+/* Hands the strings of @src over to @conf. */
+static void config_arena_move(config_file_t *conf, config_file_t *src)
+{
+   struct config_arena_block *tail = src->arena;
+
+   if (!tail)
+      return;
+
+   if (!conf->arena)
+      conf->arena = src->arena;
+   else
+   {
+      while (tail->next)
+         tail = tail->next;
+
+      tail->next        = conf->arena->next;
+      conf->arena->next = src->arena;
+   }
+
+   src->arena = NULL;
+}
+
+static uint32_t config_hash(const char *key)
+{
+   uint32_t hash = 5381;
+
+   while (*key)
+      hash = (hash << 5) + hash + (uint8_t)*key++;
+
+   return hash;
+}
+
+static struct config_entry_list *config_map_find(const config_file_t *conf,
+      const char *key, uint32_t hash)
+{
+   struct config_entry_list *entry = NULL;
+
+   if (!conf->map)
+      return NULL;
+
+   for (entry = conf->map[hash & (conf->map_size - 1)];
+         entry; entry = entry->map_next)
+      if (entry->hash == hash && string_is_equal(key, entry->key))
+         return entry;
+
+   return NULL;
+}
+
+static void config_map_remove(config_file_t *conf,
+      struct config_entry_list *entry);
+
+/* The key map only holds the first entry of each key, later
+ * entries with the same key are left out. An entry of the file
+ * itself hides the ones from an #include, wherever the #include
+ * line is. */
+static void config_map_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   struct config_entry_list *found   = NULL;
+   struct config_entry_list **bucket = NULL;
+
+   if (!entry->key)
+      return;
+
+   if ((found = config_map_find(conf, entry->key, entry->hash)))
+   {
+      if (!found->readonly || entry->readonly)
+         return;
+      config_map_remove(conf, found);
+   }
+
+   if (conf->map_count >= conf->map_size)
+   {
+      size_t i;
+      size_t size = conf->map_size
+         ? conf->map_size * 2 : CONFIG_MAP_BUCKETS_MIN;
+      struct config_entry_list **map = (struct config_entry_list**)
+         calloc(size, sizeof(*map));
+
+      if (map)
+      {
+         for (i = 0; i < conf->map_size; i++)
+         {
+            struct config_entry_list *node = conf->map[i];
+
+            while (node)
+            {
+               struct config_entry_list *next = node->map_next;
+               node->map_next               = map[node->hash & (size - 1)];
+               map[node->hash & (size - 1)] = node;
+               node                         = next;
+            }
+         }
+
+         free(conf->map);
+         conf->map      = map;
+         conf->map_size = size;
+      }
+      else if (!conf->map)
+         return;
+   }
+
+   bucket          = &conf->map[entry->hash & (conf->map_size - 1)];
+   entry->map_next = *bucket;
+   *bucket         = entry;
+   conf->map_count++;
+}
+
+static void config_map_remove(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   struct config_entry_list **node = NULL;
+
+   if (!conf->map)
+      return;
+
+   for (node = &conf->map[entry->hash & (conf->map_size - 1)];
+         *node; node = &(*node)->map_next)
+   {
+      if (*node == entry)
+      {
+         *node           = entry->map_next;
+         entry->map_next = NULL;
+         conf->map_count--;
+         return;
+      }
+   }
+}
+
+/* Used after entries were inserted anywhere but at the end */
+static void config_map_rebuild(config_file_t *conf)
+{
+   struct config_entry_list *entry = NULL;
+
+   if (conf->map)
+      memset(conf->map, 0, conf->map_size * sizeof(*conf->map));
+   conf->map_count = 0;
+   conf->tail      = NULL;
+
+   for (entry = conf->entries; entry; entry = entry->next)
+   {
+      config_map_add(conf, entry);
+      conf->tail = entry;
+   }
+}
+
+static struct config_entry_list *config_add_entry(config_file_t *conf,
+      const char *key, size_t key_len, const char *value)
+{
+   struct config_entry_list *entry = (struct config_entry_list*)
+      malloc(sizeof(*entry));
+
+   if (!entry)
+      return NULL;
+
+   entry->readonly = false;
+   entry->key      = config_strndup(conf, key, key_len);
+   entry->value    = config_strndup(conf, value, strlen(value));
+   entry->next     = NULL;
+   entry->map_next = NULL;
+
+   if (!entry->key || !entry->value)
+   {
+      free(entry);
+      return NULL;
+   }
+
+   entry->hash     = config_hash(entry->key);
+
+   if (conf->tail)
+      conf->tail->next = entry;
+   else
+      conf->entries    = entry;
+
+   conf->tail      = entry;
+   config_map_add(conf, entry);
+
+   return entry;
+}
+
+static void config_file_init(config_file_t *conf)
+{
+   conf->path                     = NULL;
+   conf->entries                  = NULL;
+   conf->tail                     = NULL;
+   conf->includes                 = NULL;
+   conf->include_depth            = 0;
+   conf->guaranteed_no_duplicates = false;
+   conf->map                      = NULL;
+   conf->map_size                 = 0;
+   conf->map_count                = 0;
+   conf->arena                    = NULL;
+}
+
 static int config_sort_compare_func(struct config_entry_list *a,
       struct config_entry_list *b)
 {
@@ -219,7 +474,7 @@ static char *extract_value(char *line, bool is_value)
       tok = strtok_r(line, " \n\t\f\r\v", &save);
 
    if (tok && *tok)
-      return strdup(tok);
+      return tok;
    return NULL;
 }
 
@@ -227,45 +482,27 @@ static char *extract_value(char *line, bool is_value)
 static void add_child_list(config_file_t *parent, config_file_t *child)
 {
    struct config_entry_list *list = child->entries;
-   if (parent->entries)
-   {
-      struct config_entry_list *head = parent->entries;
-      while (head->next)
-         head = head->next;
 
-      /* set list readonly */
-      while (list)
-      {
-         list->readonly = true;
-         list           = list->next;
-      }
-      head->next        = child->entries;
-   }
-   else
+   if (!list)
+      return;
+
+   /* set list readonly */
+   for (; list; list = list->next)
    {
-      /* set list readonly */
-      while (list)
-      {
-         list->readonly = true;
-         list           = list->next;
-      }
-      parent->entries   = child->entries;
+      list->readonly = true;
+      config_map_add(parent, list);
    }
 
-   child->entries = NULL;
+   if (parent->tail)
+      parent->tail->next = child->entries;
+   else
+      parent->entries    = child->entries;
 
-   /* Rebase tail. */
-   if (parent->entries)
-   {
-      struct config_entry_list *head =
-         (struct config_entry_list*)parent->entries;
+   parent->tail   = child->tail;
 
-      while (head->next)
-         head = head->next;
-      parent->tail = head;
-   }
-   else
-      parent->tail = NULL;
+   child->entries = NULL;
+   child->tail    = NULL;
+   config_arena_move(parent, child);
 }
 
 static void add_sub_conf(config_file_t *conf, char *path, config_file_cb_t *cb)
@@ -324,14 +561,14 @@ static void add_sub_conf(config_file_t *conf, char *path, config_file_cb_t *cb)
    config_file_free(sub_conf);
 }
 
-static bool parse_line(config_file_t *conf,
-      struct config_entry_list *list, char *line, config_file_cb_t *cb)
+static bool parse_line(config_file_t *conf, char *line,
+      config_file_cb_t *cb)
 {
-   char *key       = NULL;
-   char *key_tmp   = NULL;
-   size_t cur_size = 8;
-   size_t idx      = 0;
-   char *comment   = strip_comment(line);
+   char *key                       = NULL;
+   char *value                     = NULL;
+   size_t key_len                  = 0;
+   struct config_entry_list *entry = NULL;
+   char *comment                   = strip_comment(line);
 
    /* Starting line with #include includes config files. */
    if (comment == line)
@@ -349,7 +586,6 @@ static bool parse_line(config_file_t *conf,
             fprintf(stderr, "!!! #include depth exceeded for config. Might be a cycle.\n");
          else
             add_sub_conf(conf, path, cb);
-         free(path);
       }
    }
 
@@ -357,37 +593,23 @@ static bool parse_line(config_file_t *conf,
    while (isspace((int)*line))
       line++;
 
-   key             = (char*)malloc(9);
+   key = line;
 
    while (isgraph((int)*line))
-   {
-      if (idx == cur_size)
-      {
-         cur_size *= 2;
-         key_tmp   = (char*)realloc(key, cur_size + 1);
-
-         if (!key_tmp)
-         {
-            free(key);
-            return false;
-         }
-
-         key = key_tmp;
-      }
+      line++;
 
-      key[idx++] = *line++;
-   }
-   key[idx]      = '\0';
-   list->key     = key;
+   key_len = line - key;
 
-   list->value   = extract_value(line, true);
+   /* The value is read past the end of the key, so
+    * it can't overwrite it */
+   if (!(value = extract_value(line, true)))
+      return false;
 
-   if (!list->value)
-   {
-      list->key = NULL;
-      free(key);
+   if (!(entry = config_add_entry(conf, key, key_len, value)))
       return false;
-   }
+
+   if (cb)
+      cb->config_file_new_entry_cb(entry->key, entry->value);
 
    return true;
 }
@@ -395,18 +617,15 @@ static bool parse_line(config_file_t *conf,
 static config_file_t *config_file_new_internal(
       const char *path, unsigned depth, config_file_cb_t *cb)
 {
-   RFILE              *file = NULL;
-   struct config_file *conf = (struct config_file*)malloc(sizeof(*conf));
+   int64_t size              = 0;
+   char *buf                 = NULL;
+   char *line                = NULL;
+   RFILE *file               = NULL;
+   struct config_file *conf  = (struct config_file*)malloc(sizeof(*conf));
    if (!conf)
       return NULL;
 
-   conf->path                     = NULL;
-   conf->entries                  = NULL;
-   conf->tail                     = NULL;
-   conf->last                     = NULL;
-   conf->includes                 = NULL;
-   conf->include_depth            = 0;
-   conf->guaranteed_no_duplicates = false ;
+   config_file_init(conf);
 
    if (!path || !*path)
       return conf;
@@ -425,52 +644,38 @@ static config_file_t *config_file_new_internal(
       goto error;
    }
 
-   while (!filestream_eof(file))
-   {
-      char *line                     = NULL;
-      struct config_entry_list *list = (struct config_entry_list*)
-         malloc(sizeof(*list));
+   /* Read the whole file at once, lines are parsed in place */
+   size = filestream_get_size(file);
 
-      if (!list)
-      {
-         config_file_free(conf);
-         filestream_close(file);
-         return NULL;
-      }
-
-      list->readonly  = false;
-      list->key       = NULL;
-      list->value     = NULL;
-      list->next      = NULL;
-
-      line            = filestream_getline(file);
-
-      if (!line)
-      {
-         free(list);
-         continue;
-      }
+   if (     size < 0
+         || !(buf = (char*)malloc((size_t)size + 1))
+         || (size = filestream_read(file, buf, size)) < 0)
+   {
+      free(buf);
+      filestream_close(file);
+      config_file_free(conf);
+      return NULL;
+   }
 
-      if (*line && parse_line(conf, list, line, cb))
-      {
-         if (conf->entries)
-            conf->tail->next = list;
-         else
-            conf->entries    = list;
+   filestream_close(file);
+   buf[size] = '\0';
 
-         conf->tail = list;
+   for (line = buf; line < buf + size; )
+   {
+      char *next = (char*)memchr(line, '\n', (buf + size) - line);
 
-         if (cb != NULL && list->key != NULL && list->value != NULL)
-            cb->config_file_new_entry_cb(list->key, list->value) ;
-      }
+      if (next)
+         *next++ = '\0';
+      else
+         next    = buf + size;
 
-      free(line);
+      if (*line)
+         parse_line(conf, line, cb);
 
-      if (list != conf->tail)
-         free(list);
+      line = next;
    }
 
-   filestream_close(file);
+   free(buf);
 
    return conf;
 
@@ -490,22 +695,20 @@ void config_file_free(config_file_t *conf)
    tmp = conf->entries;
    while (tmp)
    {
-      struct config_entry_list *hold = NULL;
-      if (tmp->key)
-         free(tmp->key);
-      if (tmp->value)
-         free(tmp->value);
-
-      tmp->value = NULL;
-      tmp->key   = NULL;
-
-      hold       = tmp;
-      tmp        = tmp->next;
+      struct config_entry_list *hold = tmp;
+      tmp                            = tmp->next;
+      free(hold);
+   }
 
-      if (hold)
-         free(hold);
+   while (conf->arena)
+   {
+      struct config_arena_block *next = conf->arena->next;
+      free(conf->arena);
+      conf->arena = next;
    }
 
+   free(conf->map);
+
    inc_tmp = (struct config_include_list*)conf->includes;
    while (inc_tmp)
    {
@@ -532,6 +735,11 @@ bool config_append_file(config_file_t *conf, const char *path)
       new_conf->tail->next = conf->entries;
       conf->entries        = new_conf->entries; /* Pilfer. */
       new_conf->entries    = NULL;
+      new_conf->tail       = NULL;
+
+      config_arena_move(conf, new_conf);
+      /* The new entries come first and take priority */
+      config_map_rebuild(conf);
    }
 
    config_file_free(new_conf);
@@ -546,54 +754,21 @@ config_file_t *config_file_new_from_string(const char *from_string)
    if (!conf)
       return NULL;
 
+   config_file_init(conf);
+
    if (!from_string)
       return conf;
 
-   conf->path                     = NULL;
-   conf->entries                  = NULL;
-   conf->tail                     = NULL;
-   conf->last                     = NULL;
-   conf->includes                 = NULL;
-   conf->include_depth            = 0;
-   conf->guaranteed_no_duplicates = false ;
-
    lines                          = string_split(from_string, "\n");
    if (!lines)
       return conf;
 
    for (i = 0; i < lines->size; i++)
    {
-      struct config_entry_list *list = (struct config_entry_list*)
-         malloc(sizeof(*list));
-      char                    *line  = lines->elems[i].data;
-
-      if (!list)
-      {
-         string_list_free(lines);
-         config_file_free(conf);
-         return NULL;
-      }
+      char *line = lines->elems[i].data;
 
-      list->readonly  = false;
-      list->key       = NULL;
-      list->value     = NULL;
-      list->next      = NULL;
-
-      if (line && conf)
-      {
-         if (*line && parse_line(conf, list, line, NULL))
-         {
-            if (conf->entries)
-               conf->tail->next = list;
-            else
-               conf->entries    = list;
-
-            conf->tail          = list;
-         }
-      }
-
-      if (list != conf->tail)
-         free(list);
+      if (line && *line)
+         parse_line(conf, line, NULL);
    }
 
    string_list_free(lines);
@@ -613,29 +788,14 @@ config_file_t *config_file_new(const char *path)
 }
 
 static struct config_entry_list *config_get_entry(
-      const config_file_t *conf,
-      const char *key, struct config_entry_list **prev)
+      const config_file_t *conf, const char *key)
 {
-   struct config_entry_list *entry    = NULL;
-   struct config_entry_list *previous = prev ? *prev : NULL;
-
-   for (entry = conf->entries; entry; entry = entry->next)
-   {
-      if (string_is_equal(key, entry->key))
-         return entry;
-
-      previous = entry;
-   }
-
-   if (prev)
-      *prev = previous;
-
-   return NULL;
+   return config_map_find(conf, key, config_hash(key));
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return false;
@@ -646,7 +806,7 @@ bool config_get_double(config_file_t *conf, const char *key, double *in)
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return false;
@@ -658,7 +818,7 @@ bool config_get_float(config_file_t *conf, const char *key, float *in)
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -677,7 +837,7 @@ bool config_get_int(config_file_t *conf, const char *key, int *in)
 
 bool config_get_size_t(config_file_t *conf, const char *key, size_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -696,7 +856,7 @@ bool config_get_size_t(config_file_t *conf, const char *key, size_t *in)
 #if defined(__STDC_VERSION__) && __STDC_VERSION__>=199901L
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -715,7 +875,7 @@ bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -734,7 +894,7 @@ bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -753,7 +913,7 @@ bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -769,7 +929,7 @@ bool config_get_char(config_file_t *conf, const char *key, char *in)
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return false;
@@ -788,7 +948,7 @@ bool config_get_config_path(config_file_t *conf, char *s, size_t len)
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       return strlcpy(buf, entry->value, size) < size;
@@ -802,7 +962,7 @@ bool config_get_path(config_file_t *conf, const char *key,
    if (config_get_array(conf, key, buf, size))
       return true;
 #else
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -815,7 +975,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -836,48 +996,64 @@ bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *last  = (conf->guaranteed_no_duplicates && conf->last) ? conf->last : conf->entries;
-   struct config_entry_list *entry = conf->guaranteed_no_duplicates?NULL:config_get_entry(conf, key, &last);
-
-   if (entry && !entry->readonly)
-   {
-      free(entry->value);
-      entry->value = strdup(val);
-      return;
-   }
+   struct config_entry_list *entry = NULL;
 
    if (!val)
       return;
 
-   entry = (struct config_entry_list*)malloc(sizeof(*entry));
-   if (!entry)
-      return;
+   entry = conf->guaranteed_no_duplicates
+      ? NULL : config_get_entry(conf, key);
 
-   entry->readonly  = false;
-   entry->key       = strdup(key);
-   entry->value     = strdup(val);
-   entry->next      = NULL;
+   if (entry && !entry->readonly)
+   {
+      size_t len = strlen(val);
 
-   if (last)
-      last->next    = entry;
-   else
-      conf->entries = entry;
+      /* Reuse the storage of the old value if it fits */
+      if (len <= strlen(entry->value))
+         memmove(entry->value, val, len + 1);
+      else if ((val = config_strndup(conf, val, len)))
+         entry->value = (char*)val;
+      return;
+   }
 
-   conf->last       = entry;
+   /* The new entry hides the one from the #include */
+   config_add_entry(conf, key, strlen(key), val);
 }
 
 void config_unset(config_file_t *conf, const char *key)
 {
-   struct config_entry_list *last  = conf->entries;
-   struct config_entry_list *entry = config_get_entry(conf, key, &last);
+   struct config_entry_list *prev  = NULL;
+   struct config_entry_list *list  = NULL;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return;
 
-   entry->key   = NULL;
-   entry->value = NULL;
-   free(entry->key);
-   free(entry->value);
+   config_map_remove(conf, entry);
+
+   for (list = conf->entries; list; list = list->next)
+   {
+      if (list == entry)
+         break;
+      prev = list;
+   }
+
+   if (prev)
+      prev->next    = entry->next;
+   else
+      conf->entries = entry->next;
+
+   if (conf->tail == entry)
+      conf->tail    = prev;
+
+   /* The next entry with the same key takes its place */
+   for (list = conf->entries; list; list = list->next)
+   {
+      if (string_is_equal(list->key, entry->key))
+         config_map_add(conf, list);
+   }
+
+   free(entry);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -1017,6 +1193,7 @@ void config_file_dump_orbis(config_file_t *conf, int fd)
 
    list = merge_sort_linked_list((struct config_entry_list*)conf->entries, config_sort_compare_func);
    conf->entries = list;
+   config_map_rebuild(conf);
 
    while (list)
    {
@@ -1043,13 +1220,15 @@ void config_file_dump(config_file_t *conf, FILE *file, bool sort)
    }
 
    if (sort)
+   {
       list = merge_sort_linked_list((struct config_entry_list*)
             conf->entries, config_sort_compare_func);
+      conf->entries = list;
+      config_map_rebuild(conf);
+   }
    else
       list = (struct config_entry_list*)conf->entries;
 
-   conf->entries = list;
-
    while (list)
    {
       if (!list->readonly && list->key)
@@ -1060,16 +1239,7 @@ void config_file_dump(config_file_t *conf, FILE *file, bool sort)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (string_is_equal(entry, list->key))
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
@@ -185,6 +185,23 @@ int32_t path_get_size(const char *path)
    return -1;
 }
 
+bool path_get_size_mtime(const char *path, int64_t *size, int64_t *mtime)
+{
+   int32_t filesize = 0;
+
+   if (path_stat_cb == NULL)
+      return (retro_vfs_stat_mtime_impl(path, size, mtime)
+            & RETRO_VFS_STAT_IS_VALID) != 0;
+
+   /* The VFS interface has no modification time */
+   if (!(path_stat_cb(path, &filesize) & RETRO_VFS_STAT_IS_VALID))
+      return false;
+
+   *size  = filesize;
+   *mtime = 0;
+   return true;
+}
+
 /**
  * path_mkdir:
  * @dir                : directory
@@ -62,6 +62,10 @@
 #include <retro_inline.h>
 #include <streams/file_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #define TRUE 1
 #define FALSE 0
 
@@ -1175,6 +1179,236 @@ chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 	return hunk_read_into_memory(chd, hunknum, (UINT8 *)buffer);
 }
 
+/*-------------------------------------------------
+    chd_batch - decodes ranges of hunks, spread
+    over several threads that each have their own
+    handle on the file and codecs
+-------------------------------------------------*/
+
+#ifdef HAVE_THREADS
+typedef struct _chd_batch_worker chd_batch_worker;
+struct _chd_batch_worker
+{
+	chd_batch *				batch;			/* owning batch */
+	chd_file *				chd;			/* file handle of this thread */
+	sthread_t *				thread;			/* the thread itself */
+};
+#endif
+
+struct _chd_batch
+{
+	chd_file *				chd;			/* file of the caller, decoded by the calling thread */
+	UINT32					hunkbytes;		/* size of a hunk */
+#ifdef HAVE_THREADS
+	unsigned				count;			/* number of worker threads */
+	chd_batch_worker *		workers;		/* worker threads */
+	slock_t *				lock;			/* protects the fields below */
+	scond_t *				cond;			/* signaled when there is work, or to quit */
+	scond_t *				done;			/* signaled when the last hunk is decoded */
+	UINT8 *					buffer;			/* output of the current range */
+	UINT32					first;			/* first hunk of the current range */
+	UINT32					next;			/* next hunk to decode */
+	UINT32					end;			/* end of the current range */
+	UINT32					pending;		/* hunks not decoded yet */
+	chd_error				err;			/* first error of the current range */
+	int						quit;			/* the threads should exit */
+#endif
+};
+
+#ifdef HAVE_THREADS
+/* Decodes hunks of the current range until there are none
+ * left, called with the lock held. */
+static void chd_batch_work(chd_batch *batch, chd_file *chd)
+{
+	while (batch->next < batch->end)
+	{
+		chd_error err;
+		UINT32 hunknum = batch->next++;
+		UINT8 *dest    = batch->buffer + (size_t)(hunknum - batch->first) * batch->hunkbytes;
+
+		slock_unlock(batch->lock);
+		err = hunk_read_into_memory(chd, hunknum, dest);
+		slock_lock(batch->lock);
+
+		if (err != CHDERR_NONE && batch->err == CHDERR_NONE)
+		{
+			batch->err  = err;
+			/* skip what nobody has started yet */
+			batch->pending -= batch->end - batch->next;
+			batch->next = batch->end;
+		}
+
+		if (--batch->pending == 0)
+			scond_signal(batch->done);
+	}
+}
+
+static void chd_batch_thread(void *data)
+{
+	chd_batch_worker *worker = (chd_batch_worker *)data;
+	chd_batch *batch         = worker->batch;
+
+	slock_lock(batch->lock);
+	while (!batch->quit)
+	{
+		if (batch->next < batch->end)
+			chd_batch_work(batch, worker->chd);
+		else
+			scond_wait(batch->cond, batch->lock);
+	}
+	slock_unlock(batch->lock);
+}
+#endif
+
+chd_error chd_batch_open(chd_file *chd, unsigned threads, chd_batch **batch)
+{
+	chd_batch *newbatch;
+
+	if (chd == NULL || chd->cookie != COOKIE_VALUE || batch == NULL)
+		return CHDERR_INVALID_PARAMETER;
+
+	newbatch = (chd_batch *)calloc(1, sizeof(*newbatch));
+	if (newbatch == NULL)
+		return CHDERR_OUT_OF_MEMORY;
+
+	newbatch->chd       = chd;
+	newbatch->hunkbytes = chd->header.hunkbytes;
+
+#ifdef HAVE_THREADS
+	/* parent files can't be shared, and the file has to be
+	 * opened again for each thread */
+	if (threads > 1 && chd->parent == NULL && chd->file != NULL
+			&& filestream_get_path(chd->file) != NULL)
+	{
+		unsigned i;
+		const char *path = filestream_get_path(chd->file);
+
+		newbatch->workers = (chd_batch_worker *)calloc(threads - 1, sizeof(*newbatch->workers));
+		newbatch->lock    = slock_new();
+		newbatch->cond    = scond_new();
+		newbatch->done    = scond_new();
+
+		if (newbatch->workers == NULL || newbatch->lock == NULL || newbatch->cond == NULL
+				|| newbatch->done == NULL)
+		{
+			chd_batch_close(newbatch);
+			return CHDERR_OUT_OF_MEMORY;
+		}
+
+		/* fewer threads is fine if some can't be started */
+		for (i = 0; i < threads - 1; i++)
+		{
+			chd_batch_worker *worker = &newbatch->workers[i];
+
+			if (chd_open(path, CHD_OPEN_READ, NULL, &worker->chd) != CHDERR_NONE)
+				break;
+
+			worker->batch  = newbatch;
+			worker->thread = sthread_create(chd_batch_thread, worker);
+			if (worker->thread == NULL)
+			{
+				chd_close(worker->chd);
+				worker->chd = NULL;
+				break;
+			}
+
+			newbatch->count++;
+		}
+	}
+#endif
+
+	*batch = newbatch;
+	return CHDERR_NONE;
+}
+
+chd_error chd_batch_read(chd_batch *batch, UINT32 first, UINT32 count, void *buffer)
+{
+	chd_error err = CHDERR_NONE;
+
+	if (batch == NULL || buffer == NULL)
+		return CHDERR_INVALID_PARAMETER;
+
+	if (first + count < first || first + count > batch->chd->header.totalhunks)
+		return CHDERR_HUNK_OUT_OF_RANGE;
+
+#ifdef HAVE_THREADS
+	if (batch->count > 0 && count > 1)
+	{
+		slock_lock(batch->lock);
+
+		batch->buffer  = (UINT8 *)buffer;
+		batch->first   = first;
+		batch->next    = first;
+		batch->end     = first + count;
+		batch->pending = count;
+		batch->err     = CHDERR_NONE;
+		scond_broadcast(batch->cond);
+
+		/* the calling thread takes its share too */
+		chd_batch_work(batch, batch->chd);
+
+		while (batch->pending > 0)
+			scond_wait(batch->done, batch->lock);
+
+		err = batch->err;
+		slock_unlock(batch->lock);
+
+		return err;
+	}
+#endif
+
+	while (count-- > 0 && err == CHDERR_NONE)
+	{
+		err = hunk_read_into_memory(batch->chd, first++, (UINT8 *)buffer);
+		buffer = (UINT8 *)buffer + batch->hunkbytes;
+	}
+
+	return err;
+}
+
+unsigned chd_batch_threads(chd_batch *batch)
+{
+#ifdef HAVE_THREADS
+	if (batch != NULL)
+		return batch->count + 1;
+#endif
+	return 1;
+}
+
+void chd_batch_close(chd_batch *batch)
+{
+	if (batch == NULL)
+		return;
+
+#ifdef HAVE_THREADS
+	if (batch->lock != NULL)
+	{
+		unsigned i;
+
+		slock_lock(batch->lock);
+		batch->quit = TRUE;
+		scond_broadcast(batch->cond);
+		slock_unlock(batch->lock);
+
+		for (i = 0; i < batch->count; i++)
+		{
+			sthread_join(batch->workers[i].thread);
+			chd_close(batch->workers[i].chd);
+		}
+	}
+
+	if (batch->done != NULL)
+		scond_free(batch->done);
+	if (batch->cond != NULL)
+		scond_free(batch->cond);
+	if (batch->lock != NULL)
+		slock_free(batch->lock);
+	free(batch->workers);
+#endif
+
+	free(batch);
+}
+
 /***************************************************************************
     METADATA MANAGEMENT
 ***************************************************************************/
@@ -0,0 +1,666 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (hash_stream.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libretro.h>
+#include <hash/hash_stream.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#include <cpuid.h>
+#include <immintrin.h>
+#define HASH_X86
+#define HASH_X86_TARGET(x) __attribute__((target(x)))
+#elif defined(_MSC_VER) && _MSC_VER >= 1900
+#include <intrin.h>
+#include <immintrin.h>
+#define HASH_X86
+#define HASH_X86_TARGET(x)
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && !defined(__AARCH64EB__)
+#include <arm_acle.h>
+#define HASH_ARMV8_CRC32
+#endif
+
+#define HASH_STREAM_READ_SIZE (256 * 1024)
+
+#define HASH_ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+typedef uint32_t (*hash_crc32_func_t)(uint32_t crc,
+      const uint8_t *data, size_t len);
+typedef void (*hash_sha1_func_t)(uint32_t *h,
+      const uint8_t *data, size_t blocks);
+
+/* Picked on first use. Concurrent first calls
+ * all store the same pointers. */
+static hash_crc32_func_t hash_crc32_func = NULL;
+static hash_sha1_func_t hash_sha1_func   = NULL;
+static const char *hash_crc32_name       = "c";
+static const char *hash_sha1_name        = "c";
+static bool hash_accelerated             = true;
+
+static void hash_sha1_blocks_c(uint32_t *h,
+      const uint8_t *data, size_t blocks)
+{
+   while (blocks--)
+   {
+      unsigned i;
+      uint32_t w[80];
+      uint32_t a = h[0];
+      uint32_t b = h[1];
+      uint32_t c = h[2];
+      uint32_t d = h[3];
+      uint32_t e = h[4];
+
+      for (i = 0; i < 16; i++)
+         w[i] = ((uint32_t)data[i * 4 + 0] << 24)
+              | ((uint32_t)data[i * 4 + 1] << 16)
+              | ((uint32_t)data[i * 4 + 2] <<  8)
+              |  (uint32_t)data[i * 4 + 3];
+
+      for (; i < 80; i++)
+         w[i] = HASH_ROL32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+      for (i = 0; i < 80; i++)
+      {
+         uint32_t f, k, t;
+
+         if (i < 20)
+         {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+         }
+         else if (i < 40)
+         {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+         }
+         else if (i < 60)
+         {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+         }
+         else
+         {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+         }
+
+         t = HASH_ROL32(a, 5) + f + e + k + w[i];
+         e = d;
+         d = c;
+         c = HASH_ROL32(b, 30);
+         b = a;
+         a = t;
+      }
+
+      h[0] += a;
+      h[1] += b;
+      h[2] += c;
+      h[3] += d;
+      h[4] += e;
+
+      data += 64;
+   }
+}
+
+#ifdef HASH_X86
+#define HASH_CPU_PCLMUL (1 << 0)
+#define HASH_CPU_SHA    (1 << 1)
+
+/* cpu_features_get doesn't report these two */
+static unsigned hash_cpu_extensions(void)
+{
+   unsigned ext = 0;
+#ifdef _MSC_VER
+   int regs[4];
+
+   __cpuid(regs, 0);
+   if (regs[0] >= 1)
+   {
+      __cpuid(regs, 1);
+      if (regs[2] & (1 << 1))
+         ext |= HASH_CPU_PCLMUL;
+   }
+   __cpuid(regs, 0);
+   if (regs[0] >= 7)
+   {
+      __cpuidex(regs, 7, 0);
+      if (regs[1] & (1 << 29))
+         ext |= HASH_CPU_SHA;
+   }
+#else
+   unsigned eax, ebx, ecx, edx;
+   unsigned max = __get_cpuid_max(0, NULL);
+
+   if (max >= 1)
+   {
+      __cpuid(1, eax, ebx, ecx, edx);
+      if (ecx & (1 << 1))
+         ext |= HASH_CPU_PCLMUL;
+   }
+   if (max >= 7)
+   {
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      if (ebx & (1 << 29))
+         ext |= HASH_CPU_SHA;
+   }
+#endif
+
+   return ext;
+}
+
+/* Folds 64 bytes at a time with carry-less multiplies,
+ * see Intel's "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction". */
+HASH_X86_TARGET("pclmul,sse2")
+static uint32_t hash_crc32_pclmul(uint32_t crc,
+      const uint8_t *data, size_t len)
+{
+   __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+   size_t tail;
+
+   if (len < 64)
+      return encoding_crc32(crc, data, len);
+
+   tail = len & 15;
+   len -= tail;
+
+   x1   = _mm_loadu_si128((const __m128i*)(data + 0x00));
+   x2   = _mm_loadu_si128((const __m128i*)(data + 0x10));
+   x3   = _mm_loadu_si128((const __m128i*)(data + 0x20));
+   x4   = _mm_loadu_si128((const __m128i*)(data + 0x30));
+
+   x1   = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)~crc));
+
+   /* k1, k2 */
+   x0   = _mm_set_epi32(0x00000001, 0xc6e41596, 0x00000001, 0x54442bd4);
+
+   data += 64;
+   len  -= 64;
+
+   while (len >= 64)
+   {
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+      x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+      x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+      x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+      x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+            _mm_loadu_si128((const __m128i*)(data + 0x00)));
+      x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+            _mm_loadu_si128((const __m128i*)(data + 0x10)));
+      x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+            _mm_loadu_si128((const __m128i*)(data + 0x20)));
+      x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+            _mm_loadu_si128((const __m128i*)(data + 0x30)));
+
+      data += 64;
+      len  -= 64;
+   }
+
+   /* Fold into 128 bits, k3, k4 */
+   x0 = _mm_set_epi32(0x00000000, 0xccaa009e, 0x00000001, 0x751997d0);
+
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+   while (len >= 16)
+   {
+      x2 = _mm_loadu_si128((const __m128i*)data);
+
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+      data += 16;
+      len  -= 16;
+   }
+
+   /* Fold 128 bits to 64 bits, k5 */
+   x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+   x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+   x1 = _mm_srli_si128(x1, 8);
+   x1 = _mm_xor_si128(x1, x2);
+
+   x0 = _mm_set_epi32(0x00000000, 0x00000000, 0x00000001, 0x63cd6124);
+
+   x2 = _mm_srli_si128(x1, 4);
+   x1 = _mm_and_si128(x1, x3);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   /* Barrett reduction to 32 bits */
+   x0 = _mm_set_epi32(0x00000001, 0xf7011641, 0x00000001, 0xdb710641);
+
+   x2 = _mm_and_si128(x1, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+   x2 = _mm_and_si128(x2, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   crc = ~(uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+
+   return encoding_crc32(crc, data, tail);
+}
+
+#define HASH_SHA1_RNDS4(abcd, e, func) \
+   switch (func) \
+   { \
+      case 0:  abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break; \
+      case 1:  abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break; \
+      case 2:  abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break; \
+      default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break; \
+   }
+
+HASH_X86_TARGET("sha,sse4.1,ssse3")
+static void hash_sha1_blocks_shani(uint32_t *h,
+      const uint8_t *data, size_t blocks)
+{
+   __m128i abcd, abcd_save, e_save;
+   __m128i e[2];
+   __m128i msg[4];
+   const __m128i mask = _mm_set_epi32(
+         0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f);
+
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)h), 0x1b);
+   e[0] = _mm_set_epi32((int)h[4], 0, 0, 0);
+
+   while (blocks--)
+   {
+      unsigned i;
+
+      abcd_save = abcd;
+      e_save    = e[0];
+
+      for (i = 0; i < 4; i++)
+         msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+                  (const __m128i*)(data + i * 16)), mask);
+
+      /* 20 times 4 rounds, the message schedule for the
+       * next rounds is computed alongside. */
+      for (i = 0; i < 20; i++)
+      {
+         __m128i *cur = &e[i & 1];
+
+         if (i == 0)
+            *cur = _mm_add_epi32(*cur, msg[0]);
+         else
+            *cur = _mm_sha1nexte_epu32(*cur, msg[i & 3]);
+
+         e[(i + 1) & 1] = abcd;
+
+         if (i >= 3 && i <= 18)
+            msg[(i + 1) & 3] = _mm_sha1msg2_epu32(msg[(i + 1) & 3], msg[i & 3]);
+
+         HASH_SHA1_RNDS4(abcd, *cur, i / 5);
+
+         if (i >= 1 && i <= 16)
+            msg[(i + 3) & 3] = _mm_sha1msg1_epu32(msg[(i + 3) & 3], msg[i & 3]);
+         if (i >= 2 && i <= 17)
+            msg[(i + 2) & 3] = _mm_xor_si128(msg[(i + 2) & 3], msg[i & 3]);
+      }
+
+      e[0] = _mm_sha1nexte_epu32(e[0], e_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+
+      data += 64;
+   }
+
+   _mm_storeu_si128((__m128i*)h, _mm_shuffle_epi32(abcd, 0x1b));
+   h[4] = (uint32_t)_mm_extract_epi32(e[0], 3);
+}
+#endif
+
+#ifdef HASH_ARMV8_CRC32
+static uint32_t hash_crc32_armv8(uint32_t crc,
+      const uint8_t *data, size_t len)
+{
+   crc = ~crc;
+
+   while (len && ((uintptr_t)data & 7))
+   {
+      crc = __crc32b(crc, *data++);
+      len--;
+   }
+
+   while (len >= 8)
+   {
+      uint64_t val;
+      memcpy(&val, data, sizeof(val));
+      crc   = __crc32d(crc, val);
+      data += 8;
+      len  -= 8;
+   }
+
+   while (len--)
+      crc = __crc32b(crc, *data++);
+
+   return ~crc;
+}
+#endif
+
+static void hash_stream_dispatch(void)
+{
+   hash_crc32_func_t crc32 = encoding_crc32;
+   hash_sha1_func_t sha1   = hash_sha1_blocks_c;
+   const char *crc32_name  = "c";
+   const char *sha1_name   = "c";
+
+   if (hash_accelerated)
+   {
+#if defined(HASH_X86)
+      uint64_t simd = cpu_features_get();
+      unsigned ext  = hash_cpu_extensions();
+
+      if ((ext & HASH_CPU_PCLMUL) && (simd & RETRO_SIMD_SSE2))
+      {
+         crc32      = hash_crc32_pclmul;
+         crc32_name = "pclmul";
+      }
+
+      if ((ext & HASH_CPU_SHA) && (simd & RETRO_SIMD_SSE4)
+            && (simd & RETRO_SIMD_SSSE3))
+      {
+         sha1       = hash_sha1_blocks_shani;
+         sha1_name  = "sha-ni";
+      }
+#elif defined(HASH_ARMV8_CRC32)
+      crc32         = hash_crc32_armv8;
+      crc32_name    = "armv8";
+#endif
+   }
+
+   hash_crc32_name = crc32_name;
+   hash_sha1_name  = sha1_name;
+   hash_sha1_func  = sha1;
+   hash_crc32_func = crc32;
+}
+
+uint32_t hash_crc32(uint32_t crc, const void *data, size_t len)
+{
+   if (!hash_crc32_func)
+      hash_stream_dispatch();
+   return hash_crc32_func(crc, (const uint8_t*)data, len);
+}
+
+void hash_stream_init(hash_stream_t *hash, enum hash_stream_type type)
+{
+   memset(hash, 0, sizeof(*hash));
+
+   hash->type = type;
+
+   switch (type)
+   {
+      case HASH_STREAM_MD5:
+         MD5_Init(&hash->ctx.md5);
+         break;
+      case HASH_STREAM_SHA1:
+         hash->ctx.sha1.h[0] = 0x67452301;
+         hash->ctx.sha1.h[1] = 0xefcdab89;
+         hash->ctx.sha1.h[2] = 0x98badcfe;
+         hash->ctx.sha1.h[3] = 0x10325476;
+         hash->ctx.sha1.h[4] = 0xc3d2e1f0;
+
+         if (!hash_sha1_func)
+            hash_stream_dispatch();
+         break;
+      case HASH_STREAM_CRC32:
+      default:
+         break;
+   }
+}
+
+static void hash_stream_sha1_update(hash_stream_t *hash,
+      const uint8_t *data, size_t len)
+{
+   unsigned *block_len = &hash->ctx.sha1.block_len;
+
+   hash->ctx.sha1.len += len;
+
+   if (*block_len)
+   {
+      size_t copy = 64 - *block_len;
+      if (copy > len)
+         copy = len;
+
+      memcpy(hash->ctx.sha1.block + *block_len, data, copy);
+      *block_len += (unsigned)copy;
+      data       += copy;
+      len        -= copy;
+
+      if (*block_len < 64)
+         return;
+
+      hash_sha1_func(hash->ctx.sha1.h, hash->ctx.sha1.block, 1);
+      *block_len = 0;
+   }
+
+   if (len >= 64)
+   {
+      hash_sha1_func(hash->ctx.sha1.h, data, len / 64);
+      data += len & ~(size_t)63;
+      len  &= 63;
+   }
+
+   memcpy(hash->ctx.sha1.block, data, len);
+   *block_len = (unsigned)len;
+}
+
+void hash_stream_update(hash_stream_t *hash, const void *data, size_t len)
+{
+   switch (hash->type)
+   {
+      case HASH_STREAM_CRC32:
+         hash->ctx.crc32 = hash_crc32(hash->ctx.crc32, data, len);
+         break;
+      case HASH_STREAM_MD5:
+         /* MD5_Update takes an unsigned long size */
+         while (len)
+         {
+            unsigned long chunk = (len > 0x40000000) ? 0x40000000 : (unsigned long)len;
+            MD5_Update(&hash->ctx.md5, data, chunk);
+            data = (const uint8_t*)data + chunk;
+            len -= chunk;
+         }
+         break;
+      case HASH_STREAM_SHA1:
+         hash_stream_sha1_update(hash, (const uint8_t*)data, len);
+         break;
+   }
+}
+
+size_t hash_stream_final(hash_stream_t *hash, uint8_t *digest)
+{
+   unsigned i;
+
+   switch (hash->type)
+   {
+      case HASH_STREAM_CRC32:
+         digest[0] = (uint8_t)(hash->ctx.crc32 >> 24);
+         digest[1] = (uint8_t)(hash->ctx.crc32 >> 16);
+         digest[2] = (uint8_t)(hash->ctx.crc32 >>  8);
+         digest[3] = (uint8_t)(hash->ctx.crc32 >>  0);
+         return 4;
+      case HASH_STREAM_MD5:
+         MD5_Final(digest, &hash->ctx.md5);
+         return 16;
+      case HASH_STREAM_SHA1:
+         {
+            uint8_t pad[72];
+            uint64_t bits   = hash->ctx.sha1.len * 8;
+            size_t pad_len  = ((hash->ctx.sha1.block_len < 56) ? 56 : 120)
+               - hash->ctx.sha1.block_len;
+
+            memset(pad, 0, sizeof(pad));
+            pad[0] = 0x80;
+
+            for (i = 0; i < 8; i++)
+               pad[pad_len + i] = (uint8_t)(bits >> (56 - i * 8));
+
+            hash_stream_sha1_update(hash, pad, pad_len + 8);
+
+            for (i = 0; i < 5; i++)
+            {
+               digest[i * 4 + 0] = (uint8_t)(hash->ctx.sha1.h[i] >> 24);
+               digest[i * 4 + 1] = (uint8_t)(hash->ctx.sha1.h[i] >> 16);
+               digest[i * 4 + 2] = (uint8_t)(hash->ctx.sha1.h[i] >>  8);
+               digest[i * 4 + 3] = (uint8_t)(hash->ctx.sha1.h[i] >>  0);
+            }
+         }
+         return 20;
+   }
+
+   return 0;
+}
+
+size_t hash_stream_digest_size(enum hash_stream_type type)
+{
+   switch (type)
+   {
+      case HASH_STREAM_CRC32:
+         return 4;
+      case HASH_STREAM_MD5:
+         return 16;
+      case HASH_STREAM_SHA1:
+         return 20;
+   }
+
+   return 0;
+}
+
+void hash_stream_digest_to_string(const uint8_t *digest, size_t len,
+      char *s, size_t s_len)
+{
+   size_t i;
+   static const char hex[] = "0123456789abcdef";
+
+   if (!s_len)
+      return;
+
+   for (i = 0; i < len && (i * 2 + 2) < s_len; i++)
+   {
+      s[i * 2 + 0] = hex[digest[i] >> 4];
+      s[i * 2 + 1] = hex[digest[i] & 15];
+   }
+
+   s[i * 2] = '\0';
+}
+
+int64_t hash_stream_intfstream(hash_stream_t *hash, intfstream_t *intf)
+{
+   int64_t read  = 0;
+   int64_t total = 0;
+   uint8_t *buf  = (uint8_t*)malloc(HASH_STREAM_READ_SIZE);
+
+   if (!buf)
+      return -1;
+
+   while ((read = intfstream_read(intf, buf, HASH_STREAM_READ_SIZE)) > 0)
+   {
+      hash_stream_update(hash, buf, (size_t)read);
+      total += read;
+   }
+
+   free(buf);
+
+   return (read < 0) ? -1 : total;
+}
+
+size_t hash_stream_file(const char *path, enum hash_stream_type type,
+      uint8_t *digest)
+{
+   hash_stream_t hash;
+   int64_t read = 0;
+   uint8_t *buf = NULL;
+   RFILE *file  = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return 0;
+
+   if (!(buf = (uint8_t*)malloc(HASH_STREAM_READ_SIZE)))
+   {
+      filestream_close(file);
+      return 0;
+   }
+
+   hash_stream_init(&hash, type);
+
+   while ((read = filestream_read(file, buf, HASH_STREAM_READ_SIZE)) > 0)
+      hash_stream_update(&hash, buf, (size_t)read);
+
+   free(buf);
+   filestream_close(file);
+
+   if (read < 0)
+      return 0;
+
+   return hash_stream_final(&hash, digest);
+}
+
+const char *hash_stream_implementation(enum hash_stream_type type)
+{
+   if (!hash_crc32_func)
+      hash_stream_dispatch();
+
+   switch (type)
+   {
+      case HASH_STREAM_CRC32:
+         return hash_crc32_name;
+      case HASH_STREAM_SHA1:
+         return hash_sha1_name;
+      case HASH_STREAM_MD5:
+      default:
+         break;
+   }
+
+   return "c";
+}
+
+void hash_stream_set_accelerated(bool enable)
+{
+   hash_accelerated = enable;
+   hash_stream_dispatch();
+}
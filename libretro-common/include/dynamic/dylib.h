@@ -53,6 +53,19 @@ typedef void (*function_t)(void);
  **/
 dylib_t dylib_load(const char *path);
 
+/**
+ * dylib_load_isolated:
+ * @path                         : Path to libretro core library.
+ *
+ * Loads the library into a new link-map namespace, so that it
+ * gets its own copy of its global state even if the same file
+ * has already been loaded with dylib_load.
+ *
+ * Returns: library handle on success, otherwise NULL. Always
+ * fails on platforms without dlmopen().
+ **/
+dylib_t dylib_load_isolated(const char *path);
+
 /**
  * dylib_close:
  * @lib                          : Library handle.
@@ -135,6 +135,21 @@ struct file_archive_file_backend
    uint32_t (*stream_crc_calculate)(uint32_t, const uint8_t *, size_t);
    int (*compressed_file_read)(const char *path, const char *needle, void **buf,
          const char *optional_outfile);
+   /* (Optional) Looks up the CRC32 of a member, or of the
+    * first one if needle is NULL */
+   bool (*compressed_file_crc32)(const char *path, const char *needle,
+         uint32_t *crc);
+   /* (Optional) Extracts every file, decoding independent
+    * parts of the archive on several threads */
+   bool (*archive_extract_all)(const char *path, const char *target_dir,
+         unsigned threads);
+   /* (Optional) Sets up, empties and frees what the backend
+    * keeps across calls */
+   void (*cache_init)(void);
+   void (*cache_flush)(void);
+   void (*cache_deinit)(void);
+   /* (Optional) Keeps decoded data of any size while held */
+   void (*cache_hold)(bool hold);
    int (*archive_parse_file_init)(
       file_archive_transfer_t *state,
       const char *file);
@@ -175,6 +190,63 @@ bool file_archive_extract_file(char *archive_path, size_t archive_path_size,
       const char *valid_exts, const char *extraction_dir,
       char *out_path, size_t len);
 
+/**
+ * file_archive_init:
+ *
+ * Sets up what the archive backends keep across calls. To be
+ * called once, before archives are read from several threads.
+ **/
+void file_archive_init(void);
+
+/**
+ * file_archive_cache_flush:
+ *
+ * Releases the archives kept for reading more of their members,
+ * once content has been loaded or a scan is done.
+ **/
+void file_archive_cache_flush(void);
+
+/**
+ * file_archive_cache_hold:
+ *
+ * Keeps the decoded solid blocks of 7z archives whatever their
+ * size, for reading several members of one block in a row,
+ * until the matching file_archive_cache_release(). Holds nest.
+ **/
+void file_archive_cache_hold(void);
+
+/**
+ * file_archive_cache_release:
+ *
+ * Drops a hold taken by file_archive_cache_hold(). Once the
+ * last one is gone, the blocks over the usual size cap are
+ * freed.
+ **/
+void file_archive_cache_release(void);
+
+/**
+ * file_archive_deinit:
+ *
+ * Frees what the archive backends keep across calls, once no
+ * archive is read anymore.
+ **/
+void file_archive_deinit(void);
+
+/**
+ * file_archive_extract_all:
+ * @path                        : filename path of archive.
+ * @target_dir                  : directory to extract the files to.
+ * @threads                     : threads decoding the archive, 1 to
+ *                                decode on the calling thread only.
+ *
+ * Extract every file from archive, keeping the directories
+ * inside it. Solid 7z archives decode their blocks in parallel.
+ *
+ * Returns : true (1) on success, otherwise false (0).
+ **/
+bool file_archive_extract_all(const char *path, const char *target_dir,
+      unsigned threads);
+
 /**
  * file_archive_get_file_list:
  * @path                        : filename path of archive
@@ -56,11 +56,17 @@ struct config_file
    char *path;
    struct config_entry_list *entries;
    struct config_entry_list *tail;
-   struct config_entry_list *last;
    unsigned include_depth;
    bool guaranteed_no_duplicates;
 
    struct config_include_list *includes;
+
+   /* Hash map of the first entry of each key */
+   struct config_entry_list **map;
+   size_t map_size;
+   size_t map_count;
+   /* Storage of the keys and values */
+   struct config_arena_block *arena;
 };
 
 typedef struct config_file config_file_t;
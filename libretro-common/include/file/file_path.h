@@ -498,6 +498,16 @@ bool path_is_valid(const char *path);
 
 int32_t path_get_size(const char *path);
 
+/**
+ * path_get_size_mtime:
+ * @path               : path
+ * @size               : size of the file
+ * @mtime              : modification time, 0 if unknown
+ *
+ * Returns: true (1) if path exists, otherwise false (0).
+ */
+bool path_get_size_mtime(const char *path, int64_t *size, int64_t *mtime);
+
 bool is_path_accessible_using_standard_io(const char *path);
 
 RETRO_END_DECLS
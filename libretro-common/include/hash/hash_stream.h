@@ -0,0 +1,130 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (hash_stream.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_HASH_STREAM_H
+#define __LIBRETRO_SDK_HASH_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <rhash.h>
+#include <streams/interface_stream.h>
+
+RETRO_BEGIN_DECLS
+
+enum hash_stream_type
+{
+   HASH_STREAM_CRC32 = 0,
+   HASH_STREAM_MD5,
+   HASH_STREAM_SHA1
+};
+
+/* Largest digest, in bytes */
+#define HASH_STREAM_DIGEST_MAX 20
+
+typedef struct hash_stream
+{
+   enum hash_stream_type type;
+   union
+   {
+      uint32_t crc32;
+      MD5_CTX md5;
+      struct
+      {
+         uint32_t h[5];
+         uint64_t len;
+         uint8_t block[64];
+         unsigned block_len;
+      } sha1;
+   } ctx;
+} hash_stream_t;
+
+/**
+ * hash_crc32:
+ * @crc               : CRC32 to continue from, 0 to start.
+ * @data              : Input.
+ * @len               : Size of @data.
+ *
+ * Same as encoding_crc32, but uses the PCLMULQDQ or the
+ * ARMv8 CRC32 instructions when the CPU supports them.
+ *
+ * Returns: the updated CRC32.
+ **/
+uint32_t hash_crc32(uint32_t crc, const void *data, size_t len);
+
+void hash_stream_init(hash_stream_t *hash, enum hash_stream_type type);
+
+void hash_stream_update(hash_stream_t *hash, const void *data, size_t len);
+
+/**
+ * hash_stream_final:
+ * @hash              : Hash state.
+ * @digest            : Output, at least HASH_STREAM_DIGEST_MAX bytes.
+ *
+ * Finishes the hash. The CRC32 is stored big-endian, so that
+ * the digests of all the types print the same way.
+ *
+ * Returns: size of the digest in bytes.
+ **/
+size_t hash_stream_final(hash_stream_t *hash, uint8_t *digest);
+
+size_t hash_stream_digest_size(enum hash_stream_type type);
+
+/* Writes @digest as a lowercase hex string. */
+void hash_stream_digest_to_string(const uint8_t *digest, size_t len,
+      char *s, size_t s_len);
+
+/**
+ * hash_stream_intfstream:
+ * @hash              : Hash state.
+ * @intf              : Stream to read.
+ *
+ * Feeds the rest of @intf to @hash.
+ *
+ * Returns: amount of bytes read, or -1 on a read error.
+ **/
+int64_t hash_stream_intfstream(hash_stream_t *hash, intfstream_t *intf);
+
+/**
+ * hash_stream_file:
+ * @path              : Path of the file to hash.
+ * @type              : Hash type.
+ * @digest            : Output, at least HASH_STREAM_DIGEST_MAX bytes.
+ *
+ * Returns: size of the digest, or 0 if the file couldn't be read.
+ **/
+size_t hash_stream_file(const char *path, enum hash_stream_type type,
+      uint8_t *digest);
+
+/* Name of the implementation used for @type,
+ * e.g. "pclmul" or "c". */
+const char *hash_stream_implementation(enum hash_stream_type type);
+
+/* Allows or forbids the use of the CPU extensions,
+ * mostly useful to compare the results. */
+void hash_stream_set_accelerated(bool enable);
+
+RETRO_END_DECLS
+
+#endif
@@ -284,6 +284,9 @@ typedef enum _chd_error chd_error;
 /* opaque types */
 typedef struct _chd_file chd_file;
 
+/* opaque type for decoding ranges of hunks on several threads */
+typedef struct _chd_batch chd_batch;
+
 /* extract header structure (NOT the on-disk header structure) */
 typedef struct _chd_header chd_header;
 struct _chd_header
@@ -365,6 +368,19 @@ const chd_header *chd_get_header(chd_file *chd);
 /* read one hunk from the CHD file */
 chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer);
 
+/* prepare to decode ranges of hunks on up to the given number of threads,
+   each with its own handle on the file; the calling thread counts as one */
+chd_error chd_batch_open(chd_file *chd, unsigned threads, chd_batch **batch);
+
+/* read hunks [first, first + count) back to back into buffer */
+chd_error chd_batch_read(chd_batch *batch, UINT32 first, UINT32 count, void *buffer);
+
+/* return the number of threads actually decoding */
+unsigned chd_batch_threads(chd_batch *batch);
+
+/* stop the threads and free the batch */
+void chd_batch_close(chd_batch *batch);
+
 /* ----- metadata management ----- */
 
 /* get indexed metadata of a particular sort */
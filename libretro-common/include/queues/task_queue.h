@@ -42,6 +42,20 @@ enum task_type
    TASK_TYPE_BLOCKING
 };
 
+/* Scheduling classes of the threaded task queue.
+ * Workers always pick up the interactive tasks first,
+ * then the I/O ones and the background ones last. */
+enum task_priority
+{
+   /* default, e.g. downloads and saving files */
+   TASK_PRIORITY_IO = 0,
+   /* something the user is waiting on, e.g. thumbnails */
+   TASK_PRIORITY_INTERACTIVE,
+   /* long running work, e.g. scanning content */
+   TASK_PRIORITY_BACKGROUND,
+   TASK_PRIORITY_LAST
+};
+
 typedef struct retro_task retro_task_t;
 typedef void (*retro_task_callback_t)(retro_task_t *task,
       void *task_data,
@@ -123,8 +137,18 @@ struct retro_task
    task progress display */
    bool alternative_look;
 
+   /* scheduling class in the threaded task queue */
+   enum task_priority priority;
+
+   /* if set to true, the task may run on any worker thread,
+    * alongside other tasks. Otherwise it runs on the first
+    * worker, one such task at a time, as handlers are free
+    * to touch state that isn't thread-safe. */
+   bool concurrent;
+
    /* don't touch this. */
    retro_task_t *next;
+   retro_task_t *worker_next;
 };
 
 typedef struct task_finder_data
@@ -192,6 +216,16 @@ void task_queue_unset_threaded(void);
 
 bool task_queue_is_threaded(void);
 
+/**
+ * task_queue_set_worker_count:
+ * @count                   : amount of worker threads, 0 picks
+ *                            one less than the amount of CPU cores
+ *
+ * Takes effect the next time the threaded task queue is
+ * initialized.
+ **/
+void task_queue_set_worker_count(unsigned count);
+
 /**
  * Calls func for every running task
  * until it returns true.
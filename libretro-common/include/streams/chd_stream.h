@@ -39,7 +39,53 @@ typedef struct chdstream chdstream_t;
 /* Primary (largest) data track, used for CRC identification purposes */
 #define CHDSTREAM_TRACK_PRIMARY (-3)
 
-chdstream_t *chdstream_open(const char *path, int32_t track);
+/* Decompressed hunks kept by each stream */
+#define CHDSTREAM_CACHE_HUNKS_DEFAULT 8
+
+typedef struct chdstream_stats
+{
+   /* Hunk changes served from the cache */
+   uint64_t hits;
+   /* Hunks decompressed by the reader */
+   uint64_t misses;
+   /* Hunks decompressed ahead by the prefetch thread */
+   uint64_t prefetched;
+   /* Hits that had to wait for the prefetch thread */
+   uint64_t waits;
+   /* Hunks decompressed by the batch decoder */
+   uint64_t batched;
+} chdstream_stats_t;
+
+typedef struct chdstream_options
+{
+   /* Decompressed hunks kept by the stream,
+    * 0 for CHDSTREAM_CACHE_HUNKS_DEFAULT */
+   unsigned cache_hunks;
+   /* Hunks decompressed ahead by a background thread on
+    * sequential reads, 0 to disable. Needs HAVE_THREADS,
+    * and the cache is grown to hold at least
+    * prefetch_hunks + 2 hunks. */
+   unsigned prefetch_hunks;
+   /* Threads decompressing the hunks of long reads, 0 or
+    * 1 to disable. Reads spanning several hunks, such as
+    * whole-image hashing, decode them all at once, each
+    * thread with its own file handle and codecs. Needs
+    * HAVE_THREADS and a CHD without a parent. */
+   unsigned decode_threads;
+   /* If set, receives the stats of the stream when
+    * it is closed */
+   chdstream_stats_t *stats;
+} chdstream_options_t;
+
+/**
+ * chdstream_open:
+ * @path              : Path to the CHD image.
+ * @track             : Track to open, or one of CHDSTREAM_TRACK_*.
+ * @options           : Cache and decoding options of the
+ *                      stream, NULL for the defaults.
+ **/
+chdstream_t *chdstream_open(const char *path, int32_t track,
+      const chdstream_options_t *options);
 
 void chdstream_close(chdstream_t *stream);
 
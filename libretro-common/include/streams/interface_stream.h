@@ -30,6 +30,8 @@
 #include <retro_common_api.h>
 #include <boolean.h>
 
+#include <streams/chd_stream.h>
+
 RETRO_BEGIN_DECLS
 
 enum intfstream_type
@@ -56,6 +58,7 @@ typedef struct intfstream_info
    {
       void *handle;
       int32_t track;
+      chdstream_options_t options;
    } chd;
    enum intfstream_type type;
 } intfstream_info_t;
@@ -101,7 +104,8 @@ intfstream_t *intfstream_open_memory(void *data,
       unsigned mode, unsigned hints, uint64_t size);
 
 intfstream_t *intfstream_open_chd_track(const char *path,
-      unsigned mode, unsigned hints, int32_t track);
+      unsigned mode, unsigned hints, int32_t track,
+      const chdstream_options_t *options);
 
 RETRO_END_DECLS
 
@@ -23,10 +23,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include <queues/task_queue.h>
 
 #ifdef HAVE_THREADS
+#include <features/features_cpu.h>
 #include <rthreads/rthreads.h>
 #define SLOCK_LOCK(x) slock_lock(x)
 #define SLOCK_UNLOCK(x) slock_unlock(x)
@@ -287,60 +289,191 @@ static struct retro_task_impl impl_regular = {
 };
 
 #ifdef HAVE_THREADS
+#define TASK_WORKERS_MAX 16
+
+typedef struct
+{
+   /* One deque per priority class, tasks are taken
+    * from the front and re-added to the back after
+    * each run of their handler. */
+   task_queue_t deque[TASK_PRIORITY_LAST];
+   sthread_t *thread;
+   unsigned count;
+   unsigned index;
+} task_worker_t;
+
+/* Order in which the priority classes are scheduled */
+static const enum task_priority task_priority_order[TASK_PRIORITY_LAST] = {
+   TASK_PRIORITY_INTERACTIVE,
+   TASK_PRIORITY_IO,
+   TASK_PRIORITY_BACKGROUND
+};
+
 static slock_t *running_lock    = NULL;
 static slock_t *finished_lock   = NULL;
 static slock_t *property_lock   = NULL;
-static slock_t *queue_lock      = NULL;
+static slock_t *queue_lock      = NULL; /* protects the worker deques */
 static scond_t *worker_cond     = NULL;
-static sthread_t *worker_thread = NULL;
-static bool worker_continue     = true; /* use running_lock when touching it */
+static bool worker_continue     = true; /* use queue_lock when touching it */
 
-static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
+static task_worker_t task_workers[TASK_WORKERS_MAX];
+/* Tasks that aren't concurrent, only ever run by the first worker */
+static task_queue_t tasks_serial[TASK_PRIORITY_LAST];
+static unsigned task_workers_count  = 0;
+static unsigned task_workers_wanted = 0;
+static unsigned task_workers_idle   = 0;
+static unsigned task_workers_next   = 0;
+static unsigned tasks_queued        = 0;
+static unsigned tasks_queued_serial = 0;
+
+static void task_deque_put(task_queue_t *queue, retro_task_t *task)
 {
-   retro_task_t     *t = NULL;
-   retro_task_t *front = NULL;
+   task->worker_next = NULL;
 
-   slock_lock(queue_lock);
-   front = queue->front;
-   slock_unlock(queue_lock);
+   if (queue->front)
+      queue->back->worker_next = task;
+   else
+      queue->front = task;
 
-   /* Remove first element if needed */
-   if (task == front)
+   queue->back = task;
+}
+
+static retro_task_t *task_deque_get(task_queue_t *queue)
+{
+   retro_task_t *task = queue->front;
+
+   if (task)
    {
-      slock_lock(queue_lock);
-      queue->front = task->next;
-      slock_unlock(queue_lock);
-      task->next   = NULL;
+      queue->front      = task->worker_next;
+      task->worker_next = NULL;
+   }
+
+   return task;
+}
+
+static enum task_priority task_get_priority(retro_task_t *task)
+{
+   if ((unsigned)task->priority >= TASK_PRIORITY_LAST)
+      return TASK_PRIORITY_IO;
+   return task->priority;
+}
+
+/* Must be called with queue_lock held. */
+static void task_worker_put(task_worker_t *worker, retro_task_t *task)
+{
+   enum task_priority priority = task_get_priority(task);
 
+   if (!task->concurrent)
+   {
+      task_deque_put(&tasks_serial[priority], task);
+      tasks_queued_serial++;
       return;
    }
 
-   /* Parse queue */
-   t = front;
+   task_deque_put(&worker->deque[priority], task);
+   worker->count++;
+   tasks_queued++;
+}
+
+/* Picks the worker with the least queued tasks, going
+ * round-robin between the ones that are equally busy.
+ * Must be called with queue_lock held. */
+static task_worker_t *task_worker_pick(void)
+{
+   unsigned i;
+   task_worker_t *best = NULL;
+
+   for (i = 0; i < task_workers_count; i++)
+   {
+      task_worker_t *worker = &task_workers[
+         (task_workers_next + i) % task_workers_count];
+
+      if (!best || worker->count < best->count)
+         best = worker;
+   }
+
+   task_workers_next = (best->index + 1) % task_workers_count;
+
+   return best;
+}
+
+/* Takes the next task to run for @worker, stealing from
+ * the other workers if there is nothing of the same
+ * priority left in its own deque.
+ * Must be called with queue_lock held. */
+static retro_task_t *task_worker_take(task_worker_t *worker)
+{
+   unsigned i, j;
 
-   while (t && t->next)
+   for (i = 0; i < TASK_PRIORITY_LAST; i++)
    {
-      /* Remove task and update queue */
-      if (t->next == task)
+      retro_task_t *task          = NULL;
+      enum task_priority priority = task_priority_order[i];
+
+      if (worker->index == 0 && tasks_serial[priority].front)
       {
-         t->next    = task->next;
-         task->next = NULL;
-         break;
+         tasks_queued_serial--;
+         return task_deque_get(&tasks_serial[priority]);
       }
 
-      /* Update iterator */
-      t = t->next;
+      for (j = 0; j < task_workers_count; j++)
+      {
+         task_worker_t *victim = &task_workers[
+            (worker->index + j) % task_workers_count];
+
+         if ((task = task_deque_get(&victim->deque[priority])) != NULL)
+         {
+            victim->count--;
+            tasks_queued--;
+            return task;
+         }
+      }
+   }
+
+   return NULL;
+}
+
+static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
+{
+   retro_task_t *t    = NULL;
+   retro_task_t *prev = NULL;
+
+   for (t = queue->front; t; prev = t, t = t->next)
+   {
+      if (t != task)
+         continue;
+
+      if (prev)
+         prev->next   = task->next;
+      else
+         queue->front = task->next;
+
+      if (queue->back == task)
+         queue->back  = prev;
+
+      task->next = NULL;
+      break;
    }
 }
 
 static void retro_task_threaded_push_running(retro_task_t *task)
 {
    slock_lock(running_lock);
-   slock_lock(queue_lock);
    task_queue_put(&tasks_running, task);
-   scond_signal(worker_cond);
-   slock_unlock(queue_lock);
    slock_unlock(running_lock);
+
+   slock_lock(queue_lock);
+   if (task_workers_count)
+   {
+      task_worker_put(task_worker_pick(), task);
+
+      /* Only the first worker can run a serial task */
+      if (!task->concurrent)
+         scond_broadcast(worker_cond);
+      else
+         scond_signal(worker_cond);
+   }
+   slock_unlock(queue_lock);
 }
 
 static void retro_task_threaded_cancel(void *task)
@@ -437,28 +570,24 @@ static void retro_task_threaded_retrieve(task_retriever_data_t *data)
 
 static void threaded_worker(void *userdata)
 {
-   (void)userdata;
+   task_worker_t *worker = (task_worker_t*)userdata;
 
    for (;;)
    {
       retro_task_t *task  = NULL;
       bool finished = false;
 
-      if (!worker_continue)
-         break; /* should we keep running until all tasks finished? */
-
-      slock_lock(running_lock);
-
-      /* Get first task to run */
-      task = tasks_running.front;
-      if (task == NULL)
+      slock_lock(queue_lock);
+      while (worker_continue && !(task = task_worker_take(worker)))
       {
-         scond_wait(worker_cond, running_lock);
-         slock_unlock(running_lock);
-         continue;
+         task_workers_idle++;
+         scond_wait(worker_cond, queue_lock);
+         task_workers_idle--;
       }
+      slock_unlock(queue_lock);
 
-      slock_unlock(running_lock);
+      if (!task)
+         break; /* should we keep running until all tasks finished? */
 
       task->handler(task);
 
@@ -466,49 +595,93 @@ static void threaded_worker(void *userdata)
       finished = task->finished;
       slock_unlock(property_lock);
 
+      if (!finished)
+      {
+         /* Re-add task to our own deque, the idle
+          * workers may still steal it from there */
+         slock_lock(queue_lock);
+         task_worker_put(worker, task);
+         if (task_workers_idle && task->concurrent)
+            scond_signal(worker_cond);
+         slock_unlock(queue_lock);
+         continue;
+      }
+
       slock_lock(running_lock);
       task_queue_remove(&tasks_running, task);
       slock_unlock(running_lock);
 
-      /* Update queue */
-      if (!finished)
-      {
-         /* Re-add task to running queue */
-         retro_task_threaded_push_running(task);
-      }
-      else
-      {
-         /* Add task to finished queue */
-         slock_lock(finished_lock);
-         task_queue_put(&tasks_finished, task);
-         slock_unlock(finished_lock);
-      }
+      /* Add task to finished queue */
+      slock_lock(finished_lock);
+      task_queue_put(&tasks_finished, task);
+      slock_unlock(finished_lock);
    }
 }
 
+static unsigned task_worker_count_default(void)
+{
+   unsigned cores = cpu_features_get_core_amount();
+
+   /* Leave one core to the main thread */
+   return (cores > 1) ? cores - 1 : 1;
+}
+
 static void retro_task_threaded_init(void)
 {
+   unsigned i;
+   unsigned count = task_workers_wanted;
+   retro_task_t *task = NULL;
+
+   if (!count)
+      count = task_worker_count_default();
+   if (count > TASK_WORKERS_MAX)
+      count = TASK_WORKERS_MAX;
+
    running_lock  = slock_new();
    finished_lock = slock_new();
    property_lock = slock_new();
    queue_lock    = slock_new();
    worker_cond   = scond_new();
 
-   slock_lock(running_lock);
-   worker_continue = true;
-   slock_unlock(running_lock);
+   slock_lock(queue_lock);
+   worker_continue     = true;
+   task_workers_count  = count;
+   task_workers_idle   = 0;
+   task_workers_next   = 0;
+   tasks_queued        = 0;
+   tasks_queued_serial = 0;
+
+   memset(task_workers, 0, sizeof(task_workers));
+   memset(tasks_serial, 0, sizeof(tasks_serial));
+
+   for (i = 0; i < count; i++)
+      task_workers[i].index = i;
+
+   /* Reschedule the tasks that were put on hold
+    * when the task queue was last deinitialized */
+   for (task = tasks_running.front; task; task = task->next)
+      task_worker_put(task_worker_pick(), task);
+   slock_unlock(queue_lock);
 
-   worker_thread = sthread_create(threaded_worker, NULL);
+   for (i = 0; i < count; i++)
+      task_workers[i].thread = sthread_create(threaded_worker,
+            &task_workers[i]);
 }
 
 static void retro_task_threaded_deinit(void)
 {
-   slock_lock(running_lock);
+   unsigned i;
+
+   slock_lock(queue_lock);
    worker_continue = false;
-   scond_signal(worker_cond);
-   slock_unlock(running_lock);
+   scond_broadcast(worker_cond);
+   slock_unlock(queue_lock);
 
-   sthread_join(worker_thread);
+   for (i = 0; i < task_workers_count; i++)
+   {
+      if (task_workers[i].thread)
+         sthread_join(task_workers[i].thread);
+   }
 
    scond_free(worker_cond);
    slock_free(running_lock);
@@ -516,7 +689,10 @@ static void retro_task_threaded_deinit(void)
    slock_free(property_lock);
    slock_free(queue_lock);
 
-   worker_thread = NULL;
+   memset(task_workers, 0, sizeof(task_workers));
+   memset(tasks_serial, 0, sizeof(tasks_serial));
+
+   task_workers_count = 0;
    worker_cond   = NULL;
    running_lock  = NULL;
    finished_lock = NULL;
@@ -582,6 +758,13 @@ bool task_queue_is_threaded(void)
    return task_threaded_enable;
 }
 
+void task_queue_set_worker_count(unsigned count)
+{
+#ifdef HAVE_THREADS
+   task_workers_wanted = count;
+#endif
+}
+
 bool task_queue_find(task_finder_data_t *find_data)
 {
    if (!impl_current->find(find_data->func, find_data->userdata))
@@ -618,7 +801,7 @@ bool task_queue_push(retro_task_t *task)
       retro_task_t *running = NULL;
       bool found = false;
 
-      SLOCK_LOCK(queue_lock);
+      SLOCK_LOCK(running_lock);
       running = tasks_running.front;
 
       for (; running; running = running->next)
@@ -630,7 +813,7 @@ bool task_queue_push(retro_task_t *task)
          }
       }
 
-      SLOCK_UNLOCK(queue_lock);
+      SLOCK_UNLOCK(running_lock);
 
       /* skip this task, user must try again later */
       if (found)
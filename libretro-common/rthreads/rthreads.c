@@ -218,6 +218,11 @@ sthread_t *sthread_create_with_priority(void (*thread_func)(void*), void *userda
       sp.sched_priority = thread_priority;
       pthread_attr_setschedpolicy(&thread_attr, SCHED_RR);
       pthread_attr_setschedparam(&thread_attr, &sp);
+#if defined(PTHREAD_EXPLICIT_SCHED) && !defined(ANDROID)
+      /* Otherwise the policy is ignored and inherited from
+       * the creating thread. */
+      pthread_attr_setinheritsched(&thread_attr, PTHREAD_EXPLICIT_SCHED);
+#endif
 
       thread_attr_needed = true;
    }
@@ -231,7 +236,10 @@ sthread_t *sthread_create_with_priority(void (*thread_func)(void*), void *userda
 #ifdef HAVE_THREAD_ATTR
    if (thread_attr_needed)
       thread_created = pthread_create(&thread->id, &thread_attr, thread_wrap, data) == 0;
-   else
+
+   /* The priority is only a hint, fall back to the default
+    * one if the caller may not create such threads. */
+   if (!thread_created)
 #endif
       thread_created = pthread_create(&thread->id, NULL, thread_wrap, data) == 0;
 
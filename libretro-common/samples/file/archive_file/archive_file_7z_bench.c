@@ -0,0 +1,192 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (archive_file_7z_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <compat/strl.h>
+#include <file/archive_file.h>
+#include <file/file_path.h>
+#include <lists/string_list.h>
+#include <streams/file_stream.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+
+#define BENCH_DIR "archive_file_bench"
+
+/* Checks the files extracted under @dir against the CRCs
+ * stored in the archive. */
+static unsigned bench_verify(const char *archive, const char *dir,
+      struct string_list *list)
+{
+   size_t i;
+   unsigned bad = 0;
+
+   for (i = 0; i < list->size; i++)
+   {
+      char path[PATH_MAX_LENGTH];
+      char member[PATH_MAX_LENGTH];
+      void *buf   = NULL;
+      int64_t len = 0;
+
+      if (!*list->elems[i].data)
+         continue;
+
+      fill_pathname_join(path, dir, list->elems[i].data, sizeof(path));
+      strlcpy(member, archive, sizeof(member));
+      strlcat(member, "#", sizeof(member));
+      strlcat(member, list->elems[i].data, sizeof(member));
+
+      if (!filestream_read_file(path, &buf, &len)
+            || encoding_crc32(0, (const uint8_t*)buf, (size_t)len)
+            != file_archive_get_file_crc32(member))
+      {
+         printf("  mismatch: %s\n", path);
+         bad++;
+      }
+
+      free(buf);
+   }
+
+   return bad;
+}
+
+/* Reads the members of @archive one by one */
+static unsigned bench_read(const char *archive,
+      struct string_list *list, bool hold)
+{
+   size_t i;
+   unsigned bad    = 0;
+   uint64_t bytes  = 0;
+   retro_time_t start;
+
+   file_archive_cache_flush();
+   if (hold)
+      file_archive_cache_hold();
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < list->size; i++)
+   {
+      char member[PATH_MAX_LENGTH];
+      void *buf   = NULL;
+      int64_t len = 0;
+
+      /* Directories are listed without a name */
+      if (!*list->elems[i].data)
+         continue;
+
+      strlcpy(member, archive, sizeof(member));
+      strlcat(member, "#", sizeof(member));
+      strlcat(member, list->elems[i].data, sizeof(member));
+
+      if (!file_archive_compressed_read(member, &buf, NULL, &len)
+            || len < 0)
+         bad++;
+      else
+         bytes += (uint64_t)len;
+
+      free(buf);
+   }
+   printf("Read %u members (%.1f MB) one by one%s: %.1f ms\n",
+         (unsigned)list->size, bytes / (1024.0 * 1024.0),
+         hold ? ", blocks held" : "",
+         (cpu_features_get_time_usec() - start) / 1000.0);
+
+   if (hold)
+      file_archive_cache_release();
+
+   return bad;
+}
+
+int main(int argc, char *argv[])
+{
+   char dir[PATH_MAX_LENGTH];
+   char archive[PATH_MAX_LENGTH];
+   retro_time_t start;
+   unsigned bad             = 0;
+   unsigned threads         = cpu_features_get_core_amount();
+   struct string_list *list = NULL;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s <archive.7z> [threads]\n", argv[0]);
+      return 1;
+   }
+
+   if (argc > 2)
+      threads = (unsigned)atoi(argv[2]);
+   if (threads < 1)
+      threads = 1;
+
+   /* Archive delimiters are only looked for after a slash */
+   if (!path_is_absolute(argv[1]))
+   {
+      char cwd[PATH_MAX_LENGTH];
+
+      if (!getcwd(cwd, sizeof(cwd)))
+         return 1;
+      fill_pathname_join(archive, cwd, argv[1], sizeof(archive));
+   }
+   else
+      strlcpy(archive, argv[1], sizeof(archive));
+
+   file_archive_init();
+
+   if (!(list = file_archive_get_file_list(archive, NULL)))
+   {
+      fprintf(stderr, "Could not list %s\n", archive);
+      file_archive_deinit();
+      return 1;
+   }
+
+   /* One member at a time, as content loading does it, then
+    * with the decoded blocks held whatever their size */
+   bad += bench_read(archive, list, false);
+   bad += bench_read(archive, list, true);
+
+   /* Everything at once, on one thread then on several */
+   snprintf(dir, sizeof(dir), "%s/1", BENCH_DIR);
+   start = cpu_features_get_time_usec();
+   if (!file_archive_extract_all(archive, dir, 1))
+      bad++;
+   printf("Extracted all on 1 thread: %.1f ms\n",
+         (cpu_features_get_time_usec() - start) / 1000.0);
+   bad += bench_verify(archive, dir, list);
+
+   snprintf(dir, sizeof(dir), "%s/%u", BENCH_DIR, threads);
+   start = cpu_features_get_time_usec();
+   if (!file_archive_extract_all(archive, dir, threads))
+      bad++;
+   printf("Extracted all on %u threads: %.1f ms\n", threads,
+         (cpu_features_get_time_usec() - start) / 1000.0);
+   bad += bench_verify(archive, dir, list);
+
+   string_list_free(list);
+   file_archive_deinit();
+
+   if (bad)
+      printf("%u errors\n", bad);
+
+   return bad ? 1 : 0;
+}
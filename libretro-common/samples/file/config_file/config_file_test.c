@@ -0,0 +1,410 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (config_file_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <compat/strl.h>
+#include <file/config_file.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <features/features_cpu.h>
+
+#define BENCH_DIR         "config_file_bench"
+#define BENCH_CFG_KEYS    1500
+#define BENCH_INFO_FILES  300
+#define BENCH_INFO_KEYS   60
+#define BENCH_ROUNDS      5
+
+static const char *key_prefixes[] = {
+   "video", "audio", "input_player1", "input_player2", "menu",
+   "netplay", "savestate", "playlist", "content", "cheevos"
+};
+
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t next_rand(void)
+{
+   rand_state = rand_state * 1103515245 + 12345;
+   return rand_state >> 8;
+}
+
+static bool write_config(const char *path, unsigned keys, bool info)
+{
+   unsigned i;
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+      return false;
+
+   for (i = 0; i < keys; i++)
+   {
+      if (info && i < 8)
+         fprintf(file, "firmware%u_desc = \"bios%u.bin (BIOS)\"\n", i, i);
+      else if ((next_rand() & 3) == 0)
+         fprintf(file, "%s_option_%u = \"%u\"\n",
+               key_prefixes[next_rand() % 10], i, next_rand() % 1000);
+      else
+         fprintf(file, "%s_setting_%u = \"/some/path/to/value_%08x\"\n",
+               key_prefixes[next_rand() % 10], i, next_rand());
+   }
+
+   fclose(file);
+   return true;
+}
+
+/* Checks */
+
+static int failed = 0;
+
+static void check(bool ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("FAIL %s\n", what);
+      failed++;
+   }
+}
+
+static bool value_is(config_file_t *conf, const char *key, const char *value)
+{
+   char buf[256];
+
+   return config_get_array(conf, key, buf, sizeof(buf))
+      && !strcmp(buf, value);
+}
+
+/* Keys of the entry list in order, space separated */
+static void list_keys(config_file_t *conf, char *s, size_t len)
+{
+   struct config_file_entry entry;
+
+   *s = '\0';
+
+   if (!config_get_entry_list_head(conf, &entry))
+      return;
+
+   do
+   {
+      if (*s)
+         strlcat(s, " ", len);
+      strlcat(s, entry.key, len);
+   } while (config_get_entry_list_next(&entry));
+}
+
+static const char *entry_value(config_file_t *conf, const char *key)
+{
+   struct config_file_entry entry;
+
+   if (!config_get_entry_list_head(conf, &entry))
+      return NULL;
+
+   do
+   {
+      if (!strcmp(entry.key, key))
+         return entry.value;
+   } while (config_get_entry_list_next(&entry));
+
+   return NULL;
+}
+
+static void check_unset(void)
+{
+   char keys[256];
+   config_file_t *conf = config_file_new_from_string(
+         "a = \"1\"\nb = \"2\"\nc = \"3\"\n");
+
+   if (!conf)
+   {
+      check(false, "unset: parse");
+      return;
+   }
+
+   config_unset(conf, "b");
+   list_keys(conf, keys, sizeof(keys));
+   check(!config_entry_exists(conf, "b"), "unset: middle key still found");
+   check(!strcmp(keys, "a c"), "unset: middle entry still listed");
+
+   /* The tail moves back, so that new entries stay listed */
+   config_unset(conf, "c");
+   config_set_string(conf, "d", "4");
+   list_keys(conf, keys, sizeof(keys));
+   check(!strcmp(keys, "a d"), "unset: tail entry");
+
+   config_unset(conf, "a");
+   list_keys(conf, keys, sizeof(keys));
+   check(!strcmp(keys, "d"), "unset: head entry");
+   check(value_is(conf, "d", "4"), "unset: remaining value");
+
+   config_unset(conf, "does_not_exist");
+   config_unset(conf, "d");
+   list_keys(conf, keys, sizeof(keys));
+   check(!*keys, "unset: last entry");
+
+   config_set_string(conf, "e", "5");
+   list_keys(conf, keys, sizeof(keys));
+   check(!strcmp(keys, "e") && value_is(conf, "e", "5"),
+         "unset: set after emptying");
+
+   config_file_free(conf);
+}
+
+static void check_include(void)
+{
+   char path[PATH_MAX_LENGTH];
+   char inc_path[PATH_MAX_LENGTH];
+   char out_path[PATH_MAX_LENGTH];
+   config_file_t *conf = NULL;
+   FILE *file          = NULL;
+
+   fill_pathname_join(inc_path, BENCH_DIR, "include.cfg", sizeof(inc_path));
+   fill_pathname_join(path, BENCH_DIR, "main.cfg", sizeof(path));
+   fill_pathname_join(out_path, BENCH_DIR, "out.cfg", sizeof(out_path));
+
+   if ((file = fopen(inc_path, "w")))
+   {
+      fputs("inc_key = \"old\"\nother_key = \"kept\"\n", file);
+      fclose(file);
+   }
+   if ((file = fopen(path, "w")))
+   {
+      fputs("#include \"include.cfg\"\nmain_key = \"m\"\n", file);
+      fclose(file);
+   }
+
+   if (!(conf = config_file_new(path)))
+   {
+      check(false, "include: parse");
+      return;
+   }
+
+   check(value_is(conf, "inc_key", "old"), "include: included value");
+
+   /* The included entry is read-only, the new one hides it */
+   config_set_string(conf, "inc_key", "new");
+   check(value_is(conf, "inc_key", "new"), "include: set value");
+   config_set_string(conf, "inc_key", "newer");
+   check(value_is(conf, "inc_key", "newer"), "include: set value twice");
+   check(value_is(conf, "other_key", "kept"), "include: other value");
+
+   check(config_file_write(conf, out_path, false), "include: write");
+   config_file_free(conf);
+
+   if ((conf = config_file_new(out_path)))
+   {
+      check(value_is(conf, "inc_key", "newer"), "include: value written");
+      check(value_is(conf, "other_key", "kept"),
+            "include: include written");
+      config_file_free(conf);
+   }
+   else
+      check(false, "include: parse written file");
+
+   if ((conf = config_file_new(inc_path)))
+   {
+      check(value_is(conf, "inc_key", "old"), "include: file untouched");
+      config_file_free(conf);
+   }
+   else
+      check(false, "include: parse included file");
+
+   remove(inc_path);
+   remove(path);
+   remove(out_path);
+}
+
+static void check_from_null_string(void)
+{
+   struct config_file_entry entry;
+   config_file_t *conf = config_file_new_from_string(NULL);
+
+   if (!conf)
+   {
+      check(false, "from NULL string: no config");
+      return;
+   }
+
+   check(!config_get_entry_list_head(conf, &entry),
+         "from NULL string: entries");
+   check(!config_entry_exists(conf, "a"), "from NULL string: lookup");
+
+   config_set_string(conf, "a", "1");
+   check(value_is(conf, "a", "1"), "from NULL string: set");
+
+   config_file_free(conf);
+}
+
+static void check_set_in_place(void)
+{
+   const char *value   = NULL;
+   config_file_t *conf = config_file_new_from_string(
+         "a = \"abcdef\"\nb = \"xyz\"\n");
+
+   if (!conf)
+   {
+      check(false, "set in place: parse");
+      return;
+   }
+
+   /* A shorter value goes where the old one was */
+   value = entry_value(conf, "a");
+   config_set_string(conf, "a", "abc");
+   check(entry_value(conf, "a") == value, "set in place: storage reused");
+   check(value_is(conf, "a", "abc"), "set in place: shorter value");
+   check(value_is(conf, "b", "xyz"), "set in place: next value");
+
+   config_set_string(conf, "a", "abcdef");
+   check(value_is(conf, "a", "abcdef"), "set in place: same length");
+
+   config_set_string(conf, "a", "abcdefghijklmnop");
+   check(value_is(conf, "a", "abcdefghijklmnop"), "set in place: longer value");
+   check(value_is(conf, "b", "xyz"), "set in place: next value after growing");
+
+   config_set_string(conf, "a", "");
+   check(value_is(conf, "a", ""), "set in place: empty value");
+
+   config_file_free(conf);
+}
+
+/* Reads every key back, like the frontend does after loading */
+static unsigned lookup_all(config_file_t *conf)
+{
+   struct config_file_entry entry;
+   unsigned found = 0;
+   char buf[256];
+
+   if (!config_get_entry_list_head(conf, &entry))
+      return 0;
+
+   do
+   {
+      found += config_get_array(conf, entry.key, buf, sizeof(buf));
+   } while (config_get_entry_list_next(&entry));
+
+   /* Misses walk a whole bucket, or the whole list */
+   found += config_get_array(conf, "does_not_exist", buf, sizeof(buf));
+
+   return found;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, round;
+   char path[PATH_MAX_LENGTH];
+   const char **files = NULL;
+   unsigned count     = 0;
+   unsigned found     = 0;
+   retro_time_t parse = 0;
+   retro_time_t get   = 0;
+   bool bench         = true;
+
+   path_mkdir(BENCH_DIR);
+
+   check_unset();
+   check_include();
+   check_from_null_string();
+   check_set_in_place();
+
+   printf("%s, %d failures\n", failed ? "FAILED" : "PASSED", failed);
+
+   if (argc > 1 && !strcmp(argv[1], "--no-bench"))
+      bench = false;
+
+   if (failed || !bench)
+   {
+      remove(BENCH_DIR);
+      return failed ? 1 : 0;
+   }
+
+   if (argc > 1)
+   {
+      /* config_file_test [--no-bench | retroarch.cfg [core.info ...]] */
+      files = (const char**)(argv + 1);
+      count = argc - 1;
+   }
+   else
+   {
+      files = (const char**)calloc(BENCH_INFO_FILES + 1, sizeof(*files));
+
+      for (i = 0; i <= BENCH_INFO_FILES; i++)
+      {
+         if (i == 0)
+            snprintf(path, sizeof(path), BENCH_DIR "/retroarch.cfg");
+         else
+            snprintf(path, sizeof(path), BENCH_DIR "/core%03u_libretro.info", i);
+
+         if (!write_config(path, i ? BENCH_INFO_KEYS : BENCH_CFG_KEYS, i != 0))
+         {
+            fprintf(stderr, "Can't write %s\n", path);
+            return 1;
+         }
+
+         files[i] = strdup(path);
+      }
+
+      count = BENCH_INFO_FILES + 1;
+   }
+
+   for (round = 0; round < BENCH_ROUNDS; round++)
+   {
+      found = 0;
+
+      for (i = 0; i < count; i++)
+      {
+         config_file_t *conf = NULL;
+         retro_time_t start  = cpu_features_get_time_usec();
+
+         if (!(conf = config_file_new(files[i])))
+         {
+            fprintf(stderr, "Can't read %s\n", files[i]);
+            return 1;
+         }
+
+         parse  += cpu_features_get_time_usec() - start;
+
+         start   = cpu_features_get_time_usec();
+         found  += lookup_all(conf);
+         get    += cpu_features_get_time_usec() - start;
+
+         config_file_free(conf);
+      }
+   }
+
+   printf("%u files, %u keys\n", count, found);
+   printf("parse  %8.2f ms\n", parse / 1000.0 / BENCH_ROUNDS);
+   printf("lookup %8.2f ms\n", get   / 1000.0 / BENCH_ROUNDS);
+
+   if (argc <= 1)
+   {
+      for (i = 0; i < count; i++)
+      {
+         remove(files[i]);
+         free((void*)files[i]);
+      }
+      free(files);
+   }
+   remove(BENCH_DIR);
+
+   return 0;
+}
@@ -0,0 +1,224 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (hash_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <hash/hash_stream.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+#include <streams/interface_stream.h>
+
+#define BENCH_SIZE   (64 * 1024 * 1024)
+#define CHECK_ROUNDS 2000
+
+struct hash_kat
+{
+   enum hash_stream_type type;
+   const char *input;
+   unsigned repeat;
+   const char *digest;
+};
+
+static const struct hash_kat kats[] = {
+   { HASH_STREAM_CRC32, "", 1, "00000000" },
+   { HASH_STREAM_CRC32, "123456789", 1, "cbf43926" },
+   { HASH_STREAM_CRC32, "The quick brown fox jumps over the lazy dog", 1, "414fa339" },
+   { HASH_STREAM_CRC32, "a", 1000000, "dc25bfbc" },
+   { HASH_STREAM_MD5,   "", 1, "d41d8cd98f00b204e9800998ecf8427e" },
+   { HASH_STREAM_MD5,   "abc", 1, "900150983cd24fb0d6963f7d28e17f72" },
+   { HASH_STREAM_MD5,   "a", 1000000, "7707d6ae4e027c70eea2a935c2296f21" },
+   { HASH_STREAM_SHA1,  "", 1, "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+   { HASH_STREAM_SHA1,  "abc", 1, "a9993e364706816aba3e25717850c26c9cd0d89d" },
+   { HASH_STREAM_SHA1,  "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+   { HASH_STREAM_SHA1,  "a", 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+};
+
+static const char *type_names[] = { "crc32", "md5", "sha1" };
+
+static uint32_t rand_state = 0x12345678;
+
+static uint32_t next_rand(void)
+{
+   rand_state = rand_state * 1103515245 + 12345;
+   return rand_state >> 8;
+}
+
+static void digest_buffer(enum hash_stream_type type,
+      const uint8_t *data, size_t len, size_t split, uint8_t *digest)
+{
+   hash_stream_t hash;
+
+   hash_stream_init(&hash, type);
+   hash_stream_update(&hash, data, split);
+   hash_stream_update(&hash, data + split, len - split);
+   hash_stream_final(&hash, digest);
+}
+
+static int run_kats(void)
+{
+   unsigned i, j;
+   int failed = 0;
+
+   for (i = 0; i < sizeof(kats) / sizeof(kats[0]); i++)
+   {
+      hash_stream_t hash;
+      char out[HASH_STREAM_DIGEST_MAX * 2 + 1];
+      uint8_t digest[HASH_STREAM_DIGEST_MAX];
+      size_t len = strlen(kats[i].input);
+
+      hash_stream_init(&hash, kats[i].type);
+      for (j = 0; j < kats[i].repeat; j++)
+         hash_stream_update(&hash, kats[i].input, len);
+
+      hash_stream_digest_to_string(digest,
+            hash_stream_final(&hash, digest), out, sizeof(out));
+
+      if (strcmp(out, kats[i].digest))
+      {
+         printf("FAIL %s(\"%.16s\" x%u): %s, expected %s\n",
+               type_names[kats[i].type], kats[i].input,
+               kats[i].repeat, out, kats[i].digest);
+         failed++;
+      }
+   }
+
+   return failed;
+}
+
+/* Compares the accelerated paths against the plain C
+ * code, on odd sizes and split updates. */
+static int run_cross_check(uint8_t *buf, size_t size)
+{
+   unsigned i, t;
+   int failed = 0;
+
+   for (i = 0; i < CHECK_ROUNDS; i++)
+   {
+      size_t len   = next_rand() % ((i & 1) ? 4096 : 300);
+      size_t off   = next_rand() % 16;
+      size_t split = len ? next_rand() % len : 0;
+
+      if (off + len > size)
+         continue;
+
+      for (t = HASH_STREAM_CRC32; t <= HASH_STREAM_SHA1; t++)
+      {
+         uint8_t ref[HASH_STREAM_DIGEST_MAX];
+         uint8_t out[HASH_STREAM_DIGEST_MAX];
+
+         hash_stream_set_accelerated(false);
+         digest_buffer((enum hash_stream_type)t, buf + off, len, split, ref);
+         hash_stream_set_accelerated(true);
+         digest_buffer((enum hash_stream_type)t, buf + off, len, split, out);
+
+         if (memcmp(ref, out, hash_stream_digest_size((enum hash_stream_type)t)))
+         {
+            printf("FAIL %s mismatch, len %u, offset %u, split %u\n",
+                  type_names[t], (unsigned)len, (unsigned)off, (unsigned)split);
+            failed++;
+         }
+      }
+   }
+
+   /* intfstream reads must match hashing the buffer */
+   {
+      hash_stream_t hash;
+      uint32_t crc       = 0;
+      intfstream_t *intf = intfstream_open_memory(buf,
+            RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE,
+            size);
+
+      hash_stream_init(&hash, HASH_STREAM_CRC32);
+      if (!intf || hash_stream_intfstream(&hash, intf) != (int64_t)size)
+         failed++;
+      else if ((crc = encoding_crc32(0, buf, size)) != hash.ctx.crc32)
+      {
+         printf("FAIL intfstream crc32 %08x, expected %08x\n",
+               hash.ctx.crc32, crc);
+         failed++;
+      }
+
+      if (intf)
+      {
+         intfstream_close(intf);
+         free(intf);
+      }
+   }
+
+   return failed;
+}
+
+static void run_bench(const uint8_t *buf, size_t size)
+{
+   unsigned t, accel;
+
+   for (t = HASH_STREAM_CRC32; t <= HASH_STREAM_SHA1; t++)
+   {
+      for (accel = 0; accel < 2; accel++)
+      {
+         uint8_t digest[HASH_STREAM_DIGEST_MAX];
+         retro_time_t start, elapsed;
+
+         hash_stream_set_accelerated(accel != 0);
+
+         start   = cpu_features_get_time_usec();
+         digest_buffer((enum hash_stream_type)t, buf, size, 0, digest);
+         elapsed = cpu_features_get_time_usec() - start;
+
+         printf("%-6s %-8s %8.1f MB/s\n", type_names[t],
+               hash_stream_implementation((enum hash_stream_type)t),
+               elapsed > 0 ? (double)size / elapsed : 0.0);
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   int failed   = 0;
+   uint8_t *buf = (uint8_t*)malloc(BENCH_SIZE);
+
+   if (!buf)
+      return 1;
+
+   for (i = 0; i < BENCH_SIZE; i++)
+      buf[i] = (uint8_t)(next_rand() >> 4);
+
+   failed += run_kats();
+   hash_stream_set_accelerated(false);
+   failed += run_kats();
+   hash_stream_set_accelerated(true);
+   failed += run_cross_check(buf, 65536);
+
+   printf("%s, %d failures\n", failed ? "FAILED" : "PASSED", failed);
+
+   if (!failed && !(argc > 1 && !strcmp(argv[1], "--no-bench")))
+      run_bench(buf, BENCH_SIZE);
+
+   free(buf);
+
+   return failed ? 1 : 0;
+}
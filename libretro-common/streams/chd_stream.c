@@ -30,9 +30,27 @@
 #include <retro_endianness.h>
 #include <libchdr/chd.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #define SECTOR_SIZE 2352
 #define SUBCODE_SIZE 96
 #define TRACK_PAD 4
+/* Reads spanning fewer hunks go through the cache */
+#define BATCH_MIN_HUNKS 4
+
+typedef struct chdstream_hunk
+{
+   /* Allocated the first time the slot is used */
+   uint8_t *data;
+   /* Hunk number, -1 if the slot is empty */
+   int32_t hunknum;
+   /* Stream clock when the hunk was last used */
+   uint32_t used;
+   /* Being decompressed, data can't be read yet */
+   bool loading;
+} chdstream_hunk_t;
 
 struct chdstream
 {
@@ -53,10 +71,39 @@ struct chdstream
    size_t track_end;
    /* Byte offset of read cursor */
    size_t offset;
-   /* Loaded hunk number */
-   int32_t hunknum;
-   /* Loaded hunk */
-   uint8_t *hunkmem;
+   /* Decompressed hunks, least recently used goes first */
+   chdstream_hunk_t *hunks;
+   unsigned hunks_count;
+   /* Slot of the hunk read last */
+   chdstream_hunk_t *current;
+   int32_t last_hunknum;
+   uint32_t clock;
+   uint32_t hunkbytes;
+   uint32_t totalhunks;
+   chdstream_stats_t stats;
+   /* Where the stats go when the stream is closed */
+   chdstream_stats_t *stats_out;
+   /* Decodes long reads on several threads */
+   chd_batch *batch;
+   unsigned decode_threads;
+   /* Hunks decoded by the batch, back to back */
+   uint8_t *batch_data;
+   uint32_t batch_first;
+   uint32_t batch_count;
+   uint32_t batch_capacity;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   /* Protects the slots and the stats */
+   slock_t *lock;
+   /* libchdr can't decode two hunks at once */
+   slock_t *chd_lock;
+   scond_t *cond;
+   /* Amount of hunks decoded ahead */
+   unsigned prefetch;
+   /* First hunk to decode ahead, -1 if there is nothing to do */
+   int32_t prefetch_hunknum;
+   bool quit;
+#endif
 };
 
 typedef struct metadata {
@@ -199,8 +246,14 @@ chdstream_find_track(chd_file *fd, int32_t track, metadata_t *meta)
    return chdstream_find_track_number(fd, track, meta);
 }
 
-chdstream_t *chdstream_open(const char *path, int32_t track)
+#ifdef HAVE_THREADS
+static void chdstream_prefetch_thread(void *data);
+#endif
+
+chdstream_t *chdstream_open(const char *path, int32_t track,
+      const chdstream_options_t *options)
 {
+   unsigned i;
    metadata_t meta;
    uint32_t pregap      = 0;
    const chd_header *hd = NULL;
@@ -218,11 +271,24 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    if (!stream)
       goto error;
 
-   hd              = chd_get_header(chd);
-   stream->hunkmem = (uint8_t*)malloc(hd->hunkbytes);
-   if (!stream->hunkmem)
+   hd                  = chd_get_header(chd);
+   stream->hunks_count = (options && options->cache_hunks)
+      ? options->cache_hunks : CHDSTREAM_CACHE_HUNKS_DEFAULT;
+#ifdef HAVE_THREADS
+   stream->prefetch    = options ? options->prefetch_hunks : 0;
+   /* Keeps room for the hunk being read and the one
+    * being decoded */
+   if (stream->prefetch && stream->hunks_count < stream->prefetch + 2)
+      stream->hunks_count = stream->prefetch + 2;
+#endif
+   stream->hunks       = (chdstream_hunk_t*)calloc(
+         stream->hunks_count, sizeof(*stream->hunks));
+   if (!stream->hunks)
       goto error;
 
+   for (i = 0; i < stream->hunks_count; i++)
+      stream->hunks[i].hunknum = -1;
+
    if (!strcmp(meta.type, "MODE1_RAW"))
    {
       stream->frame_size = SECTOR_SIZE;
@@ -258,12 +324,36 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    stream->track_end       = stream->track_start +
       (size_t) meta.frames * stream->frame_size;
    stream->offset          = 0;
-   stream->hunknum         = -1;
+   stream->hunkbytes       = hd->hunkbytes;
+   stream->totalhunks      = hd->totalhunks;
+   stream->last_hunknum    = -1;
+   stream->decode_threads  = (options && options->decode_threads)
+      ? options->decode_threads : 1;
+   stream->stats_out       = options ? options->stats : NULL;
+
+#ifdef HAVE_THREADS
+   if (stream->prefetch)
+   {
+      stream->prefetch_hunknum = -1;
+      stream->lock             = slock_new();
+      stream->chd_lock         = slock_new();
+      stream->cond             = scond_new();
+
+      if (!stream->lock || !stream->chd_lock || !stream->cond)
+         goto error;
+
+      if (!(stream->thread = sthread_create(
+                  chdstream_prefetch_thread, stream)))
+         goto error;
+   }
+#endif
 
    return stream;
 
 error:
 
+   if (stream)
+      stream->chd = NULL;
    chdstream_close(stream);
 
    if (chd)
@@ -274,43 +364,364 @@ error:
 
 void chdstream_close(chdstream_t *stream)
 {
-   if (stream)
+   unsigned i;
+
+   if (!stream)
+      return;
+
+#ifdef HAVE_THREADS
+   if (stream->thread)
+   {
+      slock_lock(stream->lock);
+      stream->quit = true;
+      scond_signal(stream->cond);
+      slock_unlock(stream->lock);
+      sthread_join(stream->thread);
+   }
+   if (stream->cond)
+      scond_free(stream->cond);
+   if (stream->chd_lock)
+      slock_free(stream->chd_lock);
+   if (stream->lock)
+      slock_free(stream->lock);
+#endif
+
+   if (stream->batch)
+      chd_batch_close(stream->batch);
+   free(stream->batch_data);
+
+   /* The prefetch thread is done, no need to lock */
+   if (stream->stats_out)
+      *stream->stats_out = stream->stats;
+
+   if (stream->hunks)
    {
-      if (stream->hunkmem)
-         free(stream->hunkmem);
-      if (stream->chd)
-         chd_close(stream->chd);
-      free(stream);
+      for (i = 0; i < stream->hunks_count; i++)
+         free(stream->hunks[i].data);
+      free(stream->hunks);
    }
+   if (stream->chd)
+      chd_close(stream->chd);
+   free(stream);
 }
 
-static bool
-chdstream_load_hunk(chdstream_t *stream, uint32_t hunknum)
+static void chdstream_lock(chdstream_t *stream)
 {
-   chd_error err;
-   uint16_t *array;
-   uint32_t i;
-   uint32_t count;
+#ifdef HAVE_THREADS
+   if (stream->lock)
+      slock_lock(stream->lock);
+#endif
+}
 
-   if (hunknum == stream->hunknum)
-      return true;
+static void chdstream_unlock(chdstream_t *stream)
+{
+#ifdef HAVE_THREADS
+   if (stream->lock)
+      slock_unlock(stream->lock);
+#endif
+}
 
-   err = chd_read(stream->chd, hunknum, stream->hunkmem);
-   if (err != CHDERR_NONE)
-      return false;
+static chdstream_hunk_t *chdstream_find_hunk(chdstream_t *stream,
+      uint32_t hunknum)
+{
+   unsigned i;
+
+   for (i = 0; i < stream->hunks_count; i++)
+      if (stream->hunks[i].hunknum == (int32_t)hunknum)
+         return &stream->hunks[i];
+
+   return NULL;
+}
+
+/* Returns the least recently used slot, the prefetch
+ * thread must leave the one being read alone. */
+static chdstream_hunk_t *chdstream_evict(chdstream_t *stream,
+      bool keep_current)
+{
+   unsigned i;
+   chdstream_hunk_t *slot = NULL;
+
+   for (i = 0; i < stream->hunks_count; i++)
+   {
+      chdstream_hunk_t *hunk = &stream->hunks[i];
+
+      if (hunk->loading || (keep_current && hunk == stream->current))
+         continue;
+
+      if (hunk->hunknum < 0)
+      {
+         slot = hunk;
+         break;
+      }
+
+      if (!slot || (uint32_t)(stream->clock - hunk->used)
+            > (uint32_t)(stream->clock - slot->used))
+         slot = hunk;
+   }
 
+   if (slot && !slot->data)
+      slot->data = (uint8_t*)malloc(stream->hunkbytes);
+
+   return (slot && slot->data) ? slot : NULL;
+}
+
+static void chdstream_swab(chdstream_t *stream,
+      uint8_t *data, uint32_t hunks)
+{
    if (stream->swab)
    {
-      count = chd_get_header(stream->chd)->hunkbytes / 2;
-      array = (uint16_t*) stream->hunkmem;
+      uint32_t i;
+      uint32_t count  = hunks * (stream->hunkbytes / 2);
+      uint16_t *array = (uint16_t*)data;
       for (i = 0; i < count; ++i)
          array[i] = SWAP16(array[i]);
    }
+}
+
+/* Called with the slot marked as loading, but without
+ * holding the stream lock. */
+static bool chdstream_decode_hunk(chdstream_t *stream,
+      uint8_t *data, uint32_t hunknum)
+{
+   chd_error err;
+
+#ifdef HAVE_THREADS
+   if (stream->chd_lock)
+      slock_lock(stream->chd_lock);
+#endif
+
+   err = chd_read(stream->chd, hunknum, data);
+
+#ifdef HAVE_THREADS
+   if (stream->chd_lock)
+      slock_unlock(stream->chd_lock);
+#endif
+
+   if (err != CHDERR_NONE)
+      return false;
+
+   chdstream_swab(stream, data, 1);
 
-   stream->hunknum = hunknum;
    return true;
 }
 
+/* Decodes hunks [first, last] into the batch buffer, keeping
+ * the last hunk of the previous batch when the reads follow
+ * each other. Called without holding the stream lock. */
+static bool chdstream_decode_batch(chdstream_t *stream,
+      uint32_t first, uint32_t last)
+{
+   chd_error err;
+   uint32_t count = last - first + 1;
+   uint32_t kept  = 0;
+
+   if (!stream->batch)
+   {
+      if (chd_batch_open(stream->chd, stream->decode_threads,
+               &stream->batch) != CHDERR_NONE)
+      {
+         stream->batch          = NULL;
+         stream->decode_threads = 1;
+         return false;
+      }
+
+      /* Nothing to gain over the cache */
+      if (chd_batch_threads(stream->batch) < 2)
+      {
+         chd_batch_close(stream->batch);
+         stream->batch          = NULL;
+         stream->decode_threads = 1;
+         return false;
+      }
+   }
+
+   if (count > stream->batch_capacity)
+   {
+      uint8_t *data = (uint8_t*)realloc(stream->batch_data,
+            (size_t)count * stream->hunkbytes);
+
+      if (!data)
+         return false;
+
+      stream->batch_data     = data;
+      stream->batch_capacity = count;
+   }
+
+   if (stream->batch_count
+         && first == stream->batch_first + stream->batch_count - 1)
+   {
+      memmove(stream->batch_data, stream->batch_data
+            + (size_t)(stream->batch_count - 1) * stream->hunkbytes,
+            stream->hunkbytes);
+      kept = 1;
+   }
+
+   stream->batch_count = 0;
+
+#ifdef HAVE_THREADS
+   if (stream->chd_lock)
+      slock_lock(stream->chd_lock);
+#endif
+
+   err = chd_batch_read(stream->batch, first + kept, count - kept,
+         stream->batch_data + (size_t)kept * stream->hunkbytes);
+
+#ifdef HAVE_THREADS
+   if (stream->chd_lock)
+      slock_unlock(stream->chd_lock);
+#endif
+
+   if (err != CHDERR_NONE)
+      return false;
+
+   chdstream_swab(stream,
+         stream->batch_data + (size_t)kept * stream->hunkbytes,
+         count - kept);
+
+   stream->batch_first = first;
+   stream->batch_count = count;
+
+   chdstream_lock(stream);
+   stream->stats.batched += count - kept;
+   stream->last_hunknum   = (int32_t)last;
+   chdstream_unlock(stream);
+
+   return true;
+}
+
+#ifdef HAVE_THREADS
+static void chdstream_prefetch_thread(void *data)
+{
+   chdstream_t *stream = (chdstream_t*)data;
+
+   slock_lock(stream->lock);
+
+   while (!stream->quit)
+   {
+      uint32_t i;
+      bool decoded;
+      chdstream_hunk_t *slot = NULL;
+      int32_t hunknum        = -1;
+
+      if (stream->prefetch_hunknum >= 0)
+      {
+         for (i = 0; i < stream->prefetch; i++)
+         {
+            uint32_t next = (uint32_t)stream->prefetch_hunknum + i;
+
+            if (next >= stream->totalhunks)
+               break;
+
+            if (!chdstream_find_hunk(stream, next))
+            {
+               hunknum = (int32_t)next;
+               break;
+            }
+         }
+      }
+
+      if (hunknum < 0 || !(slot = chdstream_evict(stream, true)))
+      {
+         stream->prefetch_hunknum = -1;
+         scond_wait(stream->cond, stream->lock);
+         continue;
+      }
+
+      slot->hunknum = hunknum;
+      slot->used    = ++stream->clock;
+      slot->loading = true;
+      slock_unlock(stream->lock);
+
+      decoded       = chdstream_decode_hunk(stream, slot->data, hunknum);
+
+      slock_lock(stream->lock);
+      slot->loading = false;
+      if (decoded)
+         stream->stats.prefetched++;
+      else
+      {
+         slot->hunknum            = -1;
+         stream->prefetch_hunknum = -1;
+      }
+      scond_broadcast(stream->cond);
+   }
+
+   slock_unlock(stream->lock);
+}
+#endif
+
+/* Called with the stream lock held. Returns the slot
+ * holding @hunknum, or NULL if it couldn't be read. */
+static chdstream_hunk_t *chdstream_load_hunk(chdstream_t *stream,
+      uint32_t hunknum)
+{
+   chdstream_hunk_t *slot = stream->current;
+
+   if (slot && slot->hunknum == (int32_t)hunknum && !slot->loading)
+      return slot;
+
+   slot = chdstream_find_hunk(stream, hunknum);
+
+#ifdef HAVE_THREADS
+   /* Wait for the prefetch thread to be done with it */
+   if (slot && slot->loading)
+   {
+      stream->stats.waits++;
+      while (slot->loading)
+         scond_wait(stream->cond, stream->lock);
+      if (slot->hunknum != (int32_t)hunknum)
+         slot = NULL;
+   }
+#endif
+
+   if (slot)
+      stream->stats.hits++;
+   else
+   {
+      bool decoded;
+
+      if (!(slot = chdstream_evict(stream, false)))
+         return NULL;
+
+      if (slot == stream->current)
+         stream->current = NULL;
+
+      slot->hunknum = (int32_t)hunknum;
+      slot->loading = true;
+      chdstream_unlock(stream);
+
+      decoded       = chdstream_decode_hunk(stream, slot->data, hunknum);
+
+      chdstream_lock(stream);
+      slot->loading = false;
+      stream->stats.misses++;
+
+      if (!decoded)
+      {
+         slot->hunknum = -1;
+         return NULL;
+      }
+   }
+
+   slot->used      = ++stream->clock;
+   stream->current = slot;
+
+#ifdef HAVE_THREADS
+   /* Sequential reads decode the next hunks ahead */
+   if (     stream->thread
+         && stream->last_hunknum >= 0
+         && hunknum == (uint32_t)stream->last_hunknum + 1)
+   {
+      stream->prefetch_hunknum = (int32_t)hunknum + 1;
+      scond_signal(stream->cond);
+   }
+#endif
+
+   stream->last_hunknum = (int32_t)hunknum;
+
+   return slot;
+}
+
 ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
 {
    size_t end;
@@ -319,6 +730,8 @@ ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
    uint32_t chd_frame;
    uint32_t hunk;
    uint32_t amount;
+   chdstream_hunk_t *slot = NULL;
+   const uint8_t *hunk_data = NULL;
    size_t data_offset   = 0;
    const chd_header *hd = chd_get_header(stream->chd);
    uint8_t         *out = (uint8_t*)data;
@@ -327,6 +740,26 @@ ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
       bytes = stream->track_end - stream->offset;
 
    end = stream->offset + bytes;
+
+   /* Long reads decode all their hunks at once */
+   if (stream->decode_threads > 1 && end > stream->track_start)
+   {
+      size_t start   = stream->offset > stream->track_start
+         ? stream->offset : stream->track_start;
+      uint32_t first = (stream->track_frame + (uint32_t)((start
+                  - stream->track_start) / stream->frame_size))
+         / stream->frames_per_hunk;
+      uint32_t last  = (stream->track_frame + (uint32_t)((end - 1
+                  - stream->track_start) / stream->frame_size))
+         / stream->frames_per_hunk;
+
+      if (     last - first + 1 >= BATCH_MIN_HUNKS
+            && last < stream->totalhunks)
+         chdstream_decode_batch(stream, first, last);
+   }
+
+   chdstream_lock(stream);
+
    while (stream->offset < end)
    {
       frame_offset = stream->offset % stream->frame_size;
@@ -344,12 +777,19 @@ ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
          hunk = chd_frame / stream->frames_per_hunk;
          hunk_offset = (chd_frame % stream->frames_per_hunk) * hd->unitbytes;
 
-         if (!chdstream_load_hunk(stream, hunk))
+         if (     stream->batch_count
+               && hunk - stream->batch_first < stream->batch_count)
+            hunk_data = stream->batch_data + (size_t)(hunk
+                  - stream->batch_first) * stream->hunkbytes;
+         else if ((slot = chdstream_load_hunk(stream, hunk)))
+            hunk_data = slot->data;
+         else
          {
+            chdstream_unlock(stream);
             return -1;
          }
          memcpy(out + data_offset,
-                stream->hunkmem + frame_offset
+                hunk_data + frame_offset
                 + hunk_offset + stream->frame_offset, amount);
       }
 
@@ -357,6 +797,8 @@ ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
       stream->offset += amount;
    }
 
+   chdstream_unlock(stream);
+
    return bytes;
 }
 
@@ -21,6 +21,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
@@ -52,6 +53,7 @@ struct intfstream_internal
    struct
    {
       int32_t track;
+      chdstream_options_t options;
       chdstream_t *fp;
    } chd;
 #endif
@@ -124,7 +126,8 @@ bool intfstream_open(intfstream_internal_t *intf, const char *path,
          break;
       case INTFSTREAM_CHD:
 #ifdef HAVE_CHD
-         intf->chd.fp = chdstream_open(path, intf->chd.track);
+         intf->chd.fp = chdstream_open(path, intf->chd.track,
+               &intf->chd.options);
          if (!intf->chd.fp)
             return false;
          break;
@@ -204,7 +207,8 @@ void *intfstream_init(intfstream_info_t *info)
          break;
       case INTFSTREAM_CHD:
 #ifdef HAVE_CHD
-         intf->chd.track = info->chd.track;
+         intf->chd.track   = info->chd.track;
+         intf->chd.options = info->chd.options;
          break;
 #else
          goto error;
@@ -460,13 +464,19 @@ error:
 }
 
 intfstream_t *intfstream_open_chd_track(const char *path,
-      unsigned mode, unsigned hints, int32_t track)
+      unsigned mode, unsigned hints, int32_t track,
+      const chdstream_options_t *options)
 {
    intfstream_info_t info;
    intfstream_t *fd = NULL;
 
-   info.type        = INTFSTREAM_CHD;
-   info.chd.track   = track;
+   info.type               = INTFSTREAM_CHD;
+   info.chd.track          = track;
+
+   if (options)
+      info.chd.options     = *options;
+   else
+      memset(&info.chd.options, 0, sizeof(info.chd.options));
 
    fd               = (intfstream_t*)intfstream_init(&info);
 
@@ -786,6 +786,18 @@ const char *retro_vfs_file_get_path_impl(libretro_vfs_implementation_file *strea
 }
 
 int retro_vfs_stat_impl(const char *path, int32_t *size)
+{
+   int64_t size64 = 0;
+   int ret        = retro_vfs_stat_mtime_impl(path, &size64, NULL);
+
+   if (size)
+      *size = (int32_t)size64;
+
+   return ret;
+}
+
+int retro_vfs_stat_mtime_impl(const char *path,
+      int64_t *size, int64_t *mtime)
 {
    bool is_dir, is_character_special;
 #if defined(ORBIS)
@@ -856,9 +868,17 @@ int retro_vfs_stat_impl(const char *path, int32_t *size)
 
    if (size)
 #if defined(PS2)
-      *size = (int32_t)buf.size;
+      *size = (int64_t)buf.size;
+#else
+      *size = (int64_t)buf.st_size;
+#endif
+
+   /* Left at 0 where the modification time is not a time_t */
+   if (mtime)
+#if defined(VITA) || defined(PSP) || defined(PS2)
+      *mtime = 0;
 #else
-      *size = (int32_t)buf.st_size;
+      *mtime = (int64_t)buf.st_mtime;
 #endif
 
 #if defined(VITA) || defined(PSP)
@@ -32,6 +32,15 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <memmap.h>
+#endif
+
 #include <streams/file_stream.h>
 #include <retro_endianness.h>
 #include <string/stdstring.h>
@@ -46,9 +55,12 @@
 
 #define MAGIC_NUMBER "RARCHDB"
 
+/* Most values of an indexed field a query is looked up with */
+#define LIBRETRODB_MAX_INDEX_KEYS 64
+
 struct node_iter_ctx
 {
-	libretrodb_t *db;
+	RFILE *fd;
 	libretrodb_index_t *idx;
 };
 
@@ -59,6 +71,12 @@ struct libretrodb
 	uint64_t count;
 	uint64_t first_index_offset;
    char *path;
+   /* Whole database, if it could be mapped */
+   const uint8_t *map;
+   uint64_t map_size;
+   /* Index headers, read once by libretrodb_open */
+   libretrodb_index_t *indexes;
+   unsigned indexes_count;
 };
 
 struct libretrodb_index
@@ -66,6 +84,11 @@ struct libretrodb_index
 	char name[50];
 	uint64_t key_size;
 	uint64_t next;
+   /* Offset of the index entries */
+   uint64_t offset;
+   /* Index entries, read on first use if the database
+    * isn't mapped */
+   uint8_t *entries;
 };
 
 typedef struct libretrodb_metadata
@@ -86,6 +109,15 @@ struct libretrodb_cursor
 	int eof;
 	libretrodb_query_t *query;
 	libretrodb_t *db;
+   /* Read position, used instead of fd if the database
+    * is mapped */
+   uint64_t pos;
+   /* Offsets of the items to read, if the query could be
+    * answered with an index */
+   uint64_t *offsets;
+   size_t offsets_count;
+   size_t offsets_pos;
+   int indexed;
 };
 
 static struct rmsgpack_dom_value sentinal;
@@ -173,8 +205,7 @@ int libretrodb_create(RFILE *fd, libretrodb_value_provider value_provider,
    if ((rv = rmsgpack_dom_write(fd, &sentinal)) < 0)
       goto clean;
 
-   header.metadata_offset = swap_if_little64(filestream_seek(
-            fd, 0, RETRO_VFS_SEEK_POSITION_CURRENT));
+   header.metadata_offset = swap_if_little64(filestream_tell(fd));
    md.count = item_count;
    libretrodb_write_metadata(fd, &md);
    filestream_seek(fd, root, RETRO_VFS_SEEK_POSITION_START);
@@ -204,14 +235,92 @@ static void libretrodb_write_index_header(RFILE *fd, libretrodb_index_t *idx)
    rmsgpack_write_uint(fd, idx->next);
 }
 
+#ifdef HAVE_MMAP
+static void libretrodb_map(libretrodb_t *db, const char *path)
+{
+   struct stat buf;
+   void *map = NULL;
+   int fd    = open(path, O_RDONLY);
+
+   if (fd < 0)
+      return;
+
+   if (fstat(fd, &buf) == 0 && buf.st_size > 0)
+   {
+      map = mmap(NULL, (size_t)buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (map != MAP_FAILED)
+      {
+         db->map      = (const uint8_t*)map;
+         db->map_size = (uint64_t)buf.st_size;
+      }
+   }
+
+   close(fd);
+}
+#endif
+
+static int libretrodb_read_indexes(libretrodb_t *db, RFILE *fd)
+{
+   libretrodb_index_t idx;
+   int64_t eof = filestream_get_size(fd);
+
+   if (filestream_seek(fd, (int64_t)db->first_index_offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+      return 0;
+
+   while (filestream_tell(fd) < eof)
+   {
+      libretrodb_index_t *indexes = NULL;
+
+      memset(&idx, 0, sizeof(idx));
+
+      if (libretrodb_read_index_header(fd, &idx) < 0)
+         break;
+
+      idx.offset = filestream_tell(fd);
+
+      if (idx.offset + idx.next > (uint64_t)eof)
+         break;
+
+      indexes = (libretrodb_index_t*)realloc(db->indexes,
+            (db->indexes_count + 1) * sizeof(*indexes));
+
+      if (!indexes)
+         return -ENOMEM;
+
+      db->indexes                      = indexes;
+      db->indexes[db->indexes_count++] = idx;
+
+      if (filestream_seek(fd, (int64_t)idx.next,
+               RETRO_VFS_SEEK_POSITION_CURRENT) < 0)
+         break;
+   }
+
+   return 0;
+}
+
 void libretrodb_close(libretrodb_t *db)
 {
+   unsigned i;
+
    if (db->fd)
       filestream_close(db->fd);
    if (!string_is_empty(db->path))
       free(db->path);
-   db->path = NULL;
-   db->fd   = NULL;
+#ifdef HAVE_MMAP
+   if (db->map)
+      munmap((void*)db->map, (size_t)db->map_size);
+#endif
+   for (i = 0; i < db->indexes_count; i++)
+      free(db->indexes[i].entries);
+   free(db->indexes);
+   db->path          = NULL;
+   db->fd            = NULL;
+   db->map           = NULL;
+   db->map_size      = 0;
+   db->indexes       = NULL;
+   db->indexes_count = 0;
 }
 
 int libretrodb_open(const char *path, libretrodb_t *db)
@@ -238,7 +347,7 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       goto error;
    }
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (memcmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1) != 0)
    {
       rv = -EINVAL;
       goto error;
@@ -256,7 +365,14 @@ int libretrodb_open(const char *path, libretrodb_t *db)
 
    db->count              = md.count;
    db->first_index_offset = filestream_tell(fd);
+
+   if ((rv = libretrodb_read_indexes(db, fd)) < 0)
+      goto error;
+
    db->fd                 = fd;
+#ifdef HAVE_MMAP
+   libretrodb_map(db, path);
+#endif
    return 0;
 
 error:
@@ -265,92 +381,106 @@ error:
    return rv;
 }
 
-static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
-      libretrodb_index_t *idx)
+static libretrodb_index_t *libretrodb_find_index(libretrodb_t *db,
+      const char *index_name)
 {
-   ssize_t eof    = filestream_get_size(db->fd);
-   ssize_t offset = filestream_seek(db->fd,
-         (ssize_t)db->first_index_offset,
-         RETRO_VFS_SEEK_POSITION_START);
+   unsigned i;
 
-   /* TODO: this should use filestream_eof instead */
-   while (offset < eof)
+   for (i = 0; i < db->indexes_count; i++)
    {
-      libretrodb_read_index_header(db->fd, idx);
+      libretrodb_index_t *idx = &db->indexes[i];
 
       if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
-         return 0;
-
-      filestream_seek(db->fd, (ssize_t)idx->next,
-            RETRO_VFS_SEEK_POSITION_CURRENT);
-      offset = filestream_tell(db->fd);
+         return idx;
    }
 
-   return -1;
+   return NULL;
 }
 
-static int binsearch(const void *buff, const void *item,
-      uint64_t count, uint8_t field_size, uint64_t *offset)
+static const uint8_t *libretrodb_index_entries(libretrodb_t *db,
+      libretrodb_index_t *idx)
 {
-   int mid            = (int)(count / 2);
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t *current  = (uint64_t *)buff + (mid * item_size);
-   int rv             = memcmp(current, item, field_size);
+   if (db->map)
+      return db->map + idx->offset;
 
-   if (rv == 0)
+   if (!idx->entries)
    {
-      *offset = *(uint64_t *)(current + field_size);
-      return 0;
+      uint8_t *entries = (uint8_t*)malloc((size_t)idx->next);
+
+      if (!entries)
+         return NULL;
+
+      if (filestream_seek(db->fd, (ssize_t)idx->offset,
+               RETRO_VFS_SEEK_POSITION_START) < 0
+            || filestream_read(db->fd, entries, (int64_t)idx->next)
+            != (int64_t)idx->next)
+      {
+         free(entries);
+         return NULL;
+      }
+
+      idx->entries = entries;
    }
 
-   if (count == 0)
-      return -1;
+   return idx->entries;
+}
+
+static int binsearch(const uint8_t *buff, const void *item,
+      uint64_t count, uint64_t field_size, uint64_t *offset)
+{
+   uint64_t item_size = field_size + sizeof(uint64_t);
+   uint64_t low       = 0;
+   uint64_t high      = count;
+
+   while (low < high)
+   {
+      uint64_t mid           = low + (high - low) / 2;
+      const uint8_t *current = buff + mid * item_size;
+      int rv                 = memcmp(current, item, (size_t)field_size);
+
+      if (rv == 0)
+      {
+         memcpy(offset, current + field_size, sizeof(uint64_t));
+         return 0;
+      }
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+      if (rv > 0)
+         high = mid;
+      else
+         low  = mid + 1;
+   }
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+   return -1;
 }
 
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
       const void *key, struct rmsgpack_dom_value *out)
 {
-   libretrodb_index_t idx;
-   int rv;
-   void *buff;
    uint64_t offset;
-   ssize_t bufflen, nread = 0;
+   const uint8_t *entries  = NULL;
+   libretrodb_index_t *idx = libretrodb_find_index(db, index_name);
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
+   if (!idx || idx->key_size == 0)
       return -1;
 
-   bufflen = idx.next;
-   buff = malloc(bufflen);
-
-   if (!buff)
+   if (!(entries = libretrodb_index_entries(db, idx)))
       return -ENOMEM;
 
-   while (nread < bufflen)
-   {
-      void *buff_ = (uint64_t *)buff + nread;
-      rv = (int)filestream_read(db->fd, buff_, bufflen - nread);
+   if (binsearch(entries, key, idx->next / (idx->key_size + sizeof(uint64_t)),
+            idx->key_size, &offset) != 0)
+      return -1;
 
-      if (rv <= 0)
-      {
-         free(buff);
-         return -errno;
-      }
-      nread += rv;
-   }
+   if (db->map)
+   {
+      const uint8_t *pos = db->map + offset;
 
-   rv = binsearch(buff, key, db->count, (ssize_t)idx.key_size, &offset);
-   free(buff);
+      if (offset >= db->map_size)
+         return -EINVAL;
 
-   if (rv == 0)
-      filestream_seek(db->fd, (ssize_t)offset,
-            RETRO_VFS_SEEK_POSITION_START);
+      return rmsgpack_dom_read_buf(&pos, db->map + db->map_size, out);
+   }
 
+   filestream_seek(db->fd, (ssize_t)offset, RETRO_VFS_SEEK_POSITION_START);
    return rmsgpack_dom_read(db->fd, out);
 }
 
@@ -364,22 +494,92 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
-   cursor->eof = 0;
+   cursor->eof         = 0;
+   cursor->pos         = cursor->db->root + sizeof(libretrodb_header_t);
+   cursor->offsets_pos = 0;
+
+   if (cursor->db->map)
+      return 0;
+
    return (int)filestream_seek(cursor->fd,
          (ssize_t)(cursor->db->root + sizeof(libretrodb_header_t)),
          RETRO_VFS_SEEK_POSITION_START);
 }
 
+/* Moves an indexed cursor to its next item.
+ * Returns: 0 if successful, EOF after the last item. */
+static int libretrodb_cursor_next_offset(libretrodb_cursor_t *cursor)
+{
+   uint64_t offset;
+
+   if (cursor->offsets_pos >= cursor->offsets_count)
+   {
+      cursor->eof = 1;
+      return EOF;
+   }
+
+   offset = cursor->offsets[cursor->offsets_pos++];
+
+   if (cursor->db->map)
+      cursor->pos = offset;
+   else if (filestream_seek(cursor->fd, (int64_t)offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+      return -EINVAL;
+
+   return 0;
+}
+
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out)
 {
    int rv;
+   int filtered = 0;
 
    if (cursor->eof)
       return EOF;
 
 retry:
-   rv = rmsgpack_dom_read(cursor->fd, out);
+   if (cursor->indexed && (rv = libretrodb_cursor_next_offset(cursor)) != 0)
+      return rv;
+
+   if (cursor->db->map)
+   {
+      struct rmsgpack_view view;
+      const uint8_t *map   = cursor->db->map;
+      const uint8_t *end   = map + cursor->db->map_size;
+      const uint8_t *start = map + cursor->pos;
+      const uint8_t *pos   = start;
+
+      if (cursor->pos >= cursor->db->map_size)
+         return -EINVAL;
+
+      /* Filter the encoded item first, so that only the
+       * matching items get decoded */
+      if (     cursor->query
+            && libretrodb_query_is_compiled(cursor->query)
+            && rmsgpack_read_view(&pos, end, &view) == 0
+            && view.type != RDT_NULL)
+      {
+         pos = start;
+         if ((rv = rmsgpack_skip_view(&pos, end)) < 0)
+            return rv;
+
+         if (!libretrodb_query_filter_buf(cursor->query,
+                  start, pos - start))
+         {
+            cursor->pos = pos - map;
+            goto retry;
+         }
+
+         filtered = 1;
+      }
+
+      pos         = start;
+      rv          = rmsgpack_dom_read_buf(&pos, end, out);
+      cursor->pos = pos - map;
+   }
+   else
+      rv = rmsgpack_dom_read(cursor->fd, out);
    if (rv < 0)
       return rv;
 
@@ -389,7 +589,7 @@ retry:
       return EOF;
    }
 
-   if (cursor->query)
+   if (cursor->query && !filtered)
    {
       if (!libretrodb_query_filter(cursor->query, out))
       {
@@ -401,6 +601,85 @@ retry:
    return 0;
 }
 
+int libretrodb_cursor_read_item_buf(libretrodb_cursor_t *cursor,
+      const uint8_t **data, size_t *len)
+{
+   struct rmsgpack_view view;
+   const uint8_t *map = cursor->db->map;
+   const uint8_t *end = map + cursor->db->map_size;
+
+   if (!map)
+      return 1;
+
+   if (cursor->eof)
+      return EOF;
+
+   for (;;)
+   {
+      int rv;
+      const uint8_t *start = NULL;
+      const uint8_t *pos   = NULL;
+
+      if (cursor->indexed && (rv = libretrodb_cursor_next_offset(cursor)) != 0)
+         return rv;
+
+      start = map + cursor->pos;
+      pos   = start;
+
+      if (cursor->pos >= cursor->db->map_size)
+         return -EINVAL;
+
+      if ((rv = rmsgpack_read_view(&pos, end, &view)) < 0)
+         return rv;
+
+      if (view.type == RDT_NULL)
+      {
+         cursor->pos = pos - map;
+         cursor->eof = 1;
+         return EOF;
+      }
+
+      pos = start;
+      if ((rv = rmsgpack_skip_view(&pos, end)) < 0)
+         return rv;
+
+      cursor->pos = pos - map;
+
+      if (     cursor->query
+            && !libretrodb_query_filter_buf(cursor->query,
+               start, pos - start))
+         continue;
+
+      *data = start;
+      *len  = pos - start;
+      return 0;
+   }
+}
+
+uint64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor)
+{
+   if (cursor->db->map)
+      return cursor->pos;
+   return (uint64_t)filestream_tell(cursor->fd);
+}
+
+int libretrodb_cursor_seek(libretrodb_cursor_t *cursor, uint64_t offset)
+{
+   cursor->eof     = 0;
+   cursor->indexed = 0;
+   if (cursor->db->map)
+   {
+      if (offset >= cursor->db->map_size)
+         return -1;
+      cursor->pos = offset;
+      return 0;
+   }
+   if (filestream_seek(cursor->fd, (int64_t)offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+      return -1;
+   return 0;
+}
+
 /**
  * libretrodb_cursor_close:
  * @cursor              : Handle to database cursor.
@@ -418,6 +697,11 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (cursor->query)
       libretrodb_query_free(cursor->query);
 
+   free(cursor->offsets);
+
+   cursor->offsets       = NULL;
+   cursor->offsets_count = 0;
+   cursor->indexed       = 0;
    cursor->is_valid = 0;
    cursor->eof      = 1;
    cursor->fd       = NULL;
@@ -425,6 +709,68 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    cursor->query    = NULL;
 }
 
+/* Looks up the items of the cursor's query in the first index
+ * whose field the query limits to a set of values. The items
+ * are still filtered by the rest of the query. */
+static void libretrodb_cursor_plan(libretrodb_cursor_t *cursor)
+{
+   unsigned i;
+   libretrodb_t *db = cursor->db;
+
+   for (i = 0; i < db->indexes_count; i++)
+   {
+      int j, count;
+      size_t k;
+      const struct rmsgpack_dom_value *keys[LIBRETRODB_MAX_INDEX_KEYS];
+      libretrodb_index_t *idx = &db->indexes[i];
+      const uint8_t *entries  = NULL;
+      uint64_t *offsets       = NULL;
+      size_t offsets_count    = 0;
+
+      if ((count = libretrodb_query_get_keys(cursor->query, idx->name,
+                  keys, LIBRETRODB_MAX_INDEX_KEYS)) < 0)
+         continue;
+
+      for (j = 0; j < count; j++)
+         if (     keys[j]->type != RDT_BINARY
+               || keys[j]->val.binary.len != idx->key_size)
+            break;
+
+      if (     j < count
+            || !(entries = libretrodb_index_entries(db, idx))
+            || (count && !(offsets = (uint64_t*)
+                  malloc(count * sizeof(*offsets)))))
+         continue;
+
+      for (j = 0; j < count; j++)
+      {
+         uint64_t offset;
+
+         if (binsearch(entries, keys[j]->val.binary.buff,
+                  idx->next / (idx->key_size + sizeof(uint64_t)),
+                  idx->key_size, &offset) != 0)
+            continue;
+
+         /* Keep the items in database order, without duplicates */
+         for (k = offsets_count; k > 0 && offsets[k - 1] > offset; k--);
+
+         if (k > 0 && offsets[k - 1] == offset)
+            continue;
+
+         memmove(&offsets[k + 1], &offsets[k],
+               (offsets_count - k) * sizeof(*offsets));
+         offsets[k] = offset;
+         offsets_count++;
+      }
+
+      cursor->offsets       = offsets;
+      cursor->offsets_count = offsets_count;
+      cursor->offsets_pos   = 0;
+      cursor->indexed       = 1;
+      return;
+   }
+}
+
 /**
  * libretrodb_cursor_open:
  * @db                  : Handle to database.
@@ -442,12 +788,16 @@ int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
    if (!db || string_is_empty(db->path))
       return -errno;
 
-   fd = filestream_open(db->path,
-         RETRO_VFS_FILE_ACCESS_READ,
-         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   /* Mapped databases are read without a file handle */
+   if (!db->map)
+   {
+      fd = filestream_open(db->path,
+            RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
-   if (!fd)
-      return -errno;
+      if (!fd)
+         return -errno;
+   }
 
    cursor->fd       = fd;
    cursor->db       = db;
@@ -456,7 +806,10 @@ int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
    cursor->query    = q;
 
    if (q)
+   {
       libretrodb_query_inc_ref(q);
+      libretrodb_cursor_plan(cursor);
+   }
 
    return 0;
 }
@@ -465,16 +818,17 @@ static int node_iter(void *value, void *ctx)
 {
    struct node_iter_ctx *nictx = (struct node_iter_ctx*)ctx;
 
-   if (filestream_write(nictx->db->fd, value,
+   if (filestream_write(nictx->fd, value,
             (ssize_t)(nictx->idx->key_size + sizeof(uint64_t))) > 0)
       return 0;
 
    return -1;
 }
 
-static uint64_t libretrodb_tell(libretrodb_t *db)
+static int node_free(void *value, void *ctx)
 {
-   return filestream_tell(db->fd);
+   free(value);
+   return 0;
 }
 
 static int node_compare(const void *a, const void *b, void *ctx)
@@ -491,10 +845,11 @@ int libretrodb_create_index(libretrodb_t *db,
    struct rmsgpack_dom_value item;
    libretrodb_cursor_t cur          = {0};
    struct rmsgpack_dom_value *field = NULL;
+   RFILE *fd                        = NULL;
    void *buff                       = NULL;
    uint64_t *buff_u64               = NULL;
    uint8_t field_size               = 0;
-   uint64_t item_loc                = libretrodb_tell(db);
+   uint64_t item_loc                = 0;
    bintree_t *tree                  = bintree_new(node_compare, &field_size);
 
    item.type                        = RDT_NULL;
@@ -502,6 +857,8 @@ int libretrodb_create_index(libretrodb_t *db,
    if (!tree || (libretrodb_cursor_open(db, &cur, NULL) != 0))
       goto clean;
 
+   item_loc            = libretrodb_cursor_tell(&cur);
+
    key.type            = RDT_STRING;
    key.val.string.len  = (uint32_t)strlen(field_name);
    key.val.string.buff = (char *) field_name;   /* We know we aren't going to change it */
@@ -548,7 +905,7 @@ int libretrodb_create_index(libretrodb_t *db,
 
       memcpy(buff, field->val.binary.buff, field_size);
 
-      buff_u64 = (uint64_t *)buff + field_size;
+      buff_u64 = (uint64_t *)((uint8_t *)buff + field_size);
 
       memcpy(buff_u64, &item_loc, sizeof(uint64_t));
 
@@ -561,30 +918,44 @@ int libretrodb_create_index(libretrodb_t *db,
       }
       buff     = NULL;
       rmsgpack_dom_value_free(&item);
-      item_loc = libretrodb_tell(db);
+      item_loc = libretrodb_cursor_tell(&cur);
    }
 
-   filestream_seek(db->fd, 0, RETRO_VFS_SEEK_POSITION_END);
+   /* The database is opened read only, the index is appended
+    * through a handle of its own. It is only used once the
+    * database is opened again. */
+   if (!(fd = filestream_open(db->path,
+               RETRO_VFS_FILE_ACCESS_READ_WRITE
+             | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto clean;
+
+   filestream_seek(fd, 0, RETRO_VFS_SEEK_POSITION_END);
 
    strncpy(idx.name, name, 50);
 
    idx.name[49] = '\0';
    idx.key_size = field_size;
    idx.next     = db->count * (field_size + sizeof(uint64_t));
-   libretrodb_write_index_header(db->fd, &idx);
+   libretrodb_write_index_header(fd, &idx);
 
-   nictx.db  = db;
+   nictx.fd  = fd;
    nictx.idx = &idx;
    bintree_iterate(tree, node_iter, &nictx);
 
 clean:
+   if (fd)
+      filestream_close(fd);
    rmsgpack_dom_value_free(&item);
    if (buff)
       free(buff);
    if (cur.is_valid)
       libretrodb_cursor_close(&cur);
    if (tree)
+   {
+      bintree_iterate(tree, node_free, NULL);
       bintree_free(tree);
+   }
    free(tree);
    return 0;
 }
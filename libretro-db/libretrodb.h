@@ -105,6 +105,42 @@ void libretrodb_query_free(void *q);
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_cursor_read_item_buf:
+ * @cursor              : Handle to database cursor.
+ * @data                : Encoded item.
+ * @len                 : Size of @data.
+ *
+ * Same as libretrodb_cursor_read_item, but hands out the encoded
+ * item from the mapped database instead of decoding it. @data
+ * stays valid until the database is closed, it can be decoded
+ * with rmsgpack_read_view.
+ *
+ * Returns: 0 if successful, EOF at the end of the database,
+ * 1 if the database isn't mapped, otherwise negative.
+ **/
+int libretrodb_cursor_read_item_buf(libretrodb_cursor_t *cursor,
+      const uint8_t **data, size_t *len);
+
+/**
+ * libretrodb_cursor_tell:
+ * @cursor              : Handle to database cursor.
+ *
+ * Returns: file offset of the next item read by @cursor.
+ **/
+uint64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor);
+
+/**
+ * libretrodb_cursor_seek:
+ * @cursor              : Handle to database cursor.
+ * @offset              : Item offset, as returned by libretrodb_cursor_tell.
+ *
+ * Moves @cursor to the item at @offset.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_cursor_seek(libretrodb_cursor_t *cursor, uint64_t offset);
+
 RETRO_END_DECLS
 
 #endif
@@ -22,6 +22,8 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include <string/stdstring.h>
 
@@ -33,7 +35,7 @@ int main(int argc, char ** argv)
    int rv;
    libretrodb_t *db;
    libretrodb_cursor_t *cur;
-   libretrodb_query_t *q;
+   libretrodb_query_t *q = NULL;
    struct rmsgpack_dom_value item;
    const char *command, *path, *query_exp, *error;
 
@@ -45,6 +47,7 @@ int main(int argc, char ** argv)
       printf("\tcreate-index <index name> <field name>\n");
       printf("\tfind <query expression>\n");
       printf("\tget-names <query expression>\n");
+      printf("\tbench [passes]\n");
       return 1;
    }
 
@@ -156,6 +159,59 @@ int main(int argc, char ** argv)
          rmsgpack_dom_value_free(&item);
       }
    }
+   else if (memcmp(command, "bench", 5) == 0)
+   {
+      /* Cursor throughput, decoding every item into a DOM
+       * compared to walking the mapped items in place */
+      unsigned i;
+      size_t len;
+      clock_t start;
+      const uint8_t *data = NULL;
+      uint64_t items      = 0;
+      unsigned passes     = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 10;
+
+      if (argc > 4 || passes == 0)
+      {
+         printf("Usage: %s <db file> bench [passes]\n", argv[0]);
+         goto error;
+      }
+
+      if ((rv = libretrodb_cursor_open(db, cur, NULL)) != 0)
+      {
+         printf("Could not open cursor: %s\n", strerror(-rv));
+         goto error;
+      }
+
+      start = clock();
+      for (i = 0; i < passes; i++)
+      {
+         libretrodb_cursor_reset(cur);
+         while (libretrodb_cursor_read_item(cur, &item) == 0)
+         {
+            rmsgpack_dom_value_free(&item);
+            items++;
+         }
+      }
+      printf("dom:  %u items, %.0f items/s\n", (unsigned)(items / passes),
+            items / ((double)(clock() - start) / CLOCKS_PER_SEC + 1e-9));
+
+      items = 0;
+      start = clock();
+      for (i = 0; i < passes; i++)
+      {
+         libretrodb_cursor_reset(cur);
+         while ((rv = libretrodb_cursor_read_item_buf(cur, &data, &len)) == 0)
+            items++;
+         if (rv == 1)
+            break;
+      }
+
+      if (rv == 1)
+         printf("view: database isn't mapped\n");
+      else
+         printf("view: %u items, %.0f items/s\n", (unsigned)(items / passes),
+               items / ((double)(clock() - start) / CLOCKS_PER_SEC + 1e-9));
+   }
    else if (memcmp(command, "create-index", 12) == 0)
    {
       const char * index_name, * field_name;
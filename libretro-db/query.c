@@ -37,9 +37,11 @@
 #include "libretrodb.h"
 #include "query.h"
 #include "rmsgpack_dom.h"
+#include "rmsgpack.h"
 
-#define MAX_ERROR_LEN   256
-#define QUERY_MAX_ARGS  50
+#define MAX_ERROR_LEN     256
+#define QUERY_MAX_ARGS    50
+#define QUERY_MAX_FIELDS  (QUERY_MAX_ARGS / 2)
 
 struct buffer
 {
@@ -79,10 +81,42 @@ struct argument
    } a;
 };
 
+/* Queries whose root is a table are also compiled into a flat
+ * list of operations, in prefix order, which is evaluated on the
+ * encoded items without building a DOM. */
+enum query_op_type
+{
+   QUERY_OP_FALSE = 0,
+   QUERY_OP_MAP,
+   QUERY_OP_FIELD,
+   QUERY_OP_EQUALS,
+   QUERY_OP_IS_TRUE,
+   QUERY_OP_GLOB,
+   QUERY_OP_BETWEEN,
+   QUERY_OP_OR,
+   QUERY_OP_AND
+};
+
+struct query_op
+{
+   enum query_op_type type;
+   /* Operations in this subtree, including this one */
+   unsigned len;
+   /* Children for MAP, OR and AND, arguments otherwise */
+   unsigned argc;
+   /* Field slot for FIELD */
+   unsigned field;
+   const struct argument *argv;
+};
+
 struct query
 {
    unsigned ref_count;
    struct invocation root;
+   struct query_op *ops;
+   unsigned ops_count;
+   const struct rmsgpack_dom_value *fields[QUERY_MAX_FIELDS];
+   unsigned fields_count;
 };
 
 struct registered_func
@@ -718,13 +752,14 @@ static struct buffer query_parse_method_call(struct buffer buff,
    invocation->argv = (argi > 0) ? (struct argument*)
       malloc(sizeof(struct argument) * argi) : NULL;
 
-   if (!invocation->argv)
+   if (argi > 0 && !invocation->argv)
    {
       query_raise_enomem(error);
       goto clean;
    }
-   memcpy(invocation->argv, args,
-         sizeof(struct argument) * argi);
+   if (argi > 0)
+      memcpy(invocation->argv, args,
+            sizeof(struct argument) * argi);
 
    goto success;
 clean:
@@ -889,8 +924,9 @@ static struct buffer query_parse_table(struct buffer buff,
       query_raise_enomem(error);
       goto clean;
    }
-   memcpy(invocation->argv, args,
-         sizeof(struct argument) * argi);
+   if (argi > 0)
+      memcpy(invocation->argv, args,
+            sizeof(struct argument) * argi);
 
    goto success;
 clean:
@@ -900,6 +936,123 @@ success:
    return buff;
 }
 
+static int query_program_push(struct query *q, enum query_op_type type,
+      unsigned argc, const struct argument *argv)
+{
+   struct query_op *op = NULL;
+   struct query_op *ops = (struct query_op*)realloc(q->ops,
+         (q->ops_count + 1) * sizeof(*ops));
+
+   if (!ops)
+      return -1;
+
+   q->ops     = ops;
+   op         = &q->ops[q->ops_count];
+   op->type   = type;
+   op->len    = 1;
+   op->argc   = argc;
+   op->field  = 0;
+   op->argv   = argv;
+   return (int)q->ops_count++;
+}
+
+static int query_compile_argument(struct query *q,
+      const struct argument *arg)
+{
+   unsigned i;
+   int op                      = -1;
+   const struct invocation *inv = &arg->a.invocation;
+
+   if (arg->type == AT_VALUE)
+      return query_program_push(q, QUERY_OP_EQUALS, 1, arg) < 0 ? -1 : 0;
+
+   if (inv->func == query_func_is_true)
+      op = query_program_push(q, QUERY_OP_IS_TRUE, inv->argc, inv->argv);
+   else if (inv->func == query_func_glob)
+   {
+      if (     inv->argc == 1
+            && inv->argv[0].type == AT_VALUE
+            && inv->argv[0].a.value.type == RDT_STRING)
+         op = query_program_push(q, QUERY_OP_GLOB, 1, inv->argv);
+      else
+         op = query_program_push(q, QUERY_OP_FALSE, 0, NULL);
+   }
+   else if (inv->func == query_func_between)
+   {
+      if (     inv->argc == 2
+            && inv->argv[0].type == AT_VALUE
+            && inv->argv[1].type == AT_VALUE
+            && inv->argv[0].a.value.type == RDT_INT
+            && inv->argv[1].a.value.type == RDT_INT)
+         op = query_program_push(q, QUERY_OP_BETWEEN, 2, inv->argv);
+      else
+         op = query_program_push(q, QUERY_OP_FALSE, 0, NULL);
+   }
+   else if (inv->func == query_func_operator_or
+         || inv->func == query_func_operator_and)
+   {
+      op = query_program_push(q,
+            inv->func == query_func_operator_or
+            ? QUERY_OP_OR : QUERY_OP_AND, inv->argc, NULL);
+
+      for (i = 0; op >= 0 && i < inv->argc; i++)
+         if (query_compile_argument(q, &inv->argv[i]) < 0)
+            return -1;
+   }
+
+   /* Nested tables and other functions only run on the DOM */
+   if (op < 0)
+      return -1;
+
+   q->ops[op].len = q->ops_count - op;
+   return 0;
+}
+
+static void query_compile(struct query *q)
+{
+   unsigned i;
+   int op = -1;
+
+   if (q->root.func != query_func_all_map)
+      return;
+
+   if (q->root.argc % 2 != 0)
+      op = query_program_push(q, QUERY_OP_FALSE, 0, NULL);
+   else
+   {
+      op = query_program_push(q, QUERY_OP_MAP, q->root.argc / 2, NULL);
+
+      for (i = 0; op >= 0 && i < q->root.argc; i += 2)
+      {
+         int field = -1;
+
+         if (     q->root.argv[i].type != AT_VALUE
+               || q->fields_count >= QUERY_MAX_FIELDS
+               || (field = query_program_push(q, QUERY_OP_FIELD, 1, NULL)) < 0
+               || query_compile_argument(q, &q->root.argv[i + 1]) < 0)
+         {
+            op = -1;
+            break;
+         }
+
+         q->ops[field].field = q->fields_count;
+         q->ops[field].len   = q->ops_count - field;
+         q->fields[q->fields_count++] = &q->root.argv[i].a.value;
+      }
+   }
+
+   if (op < 0)
+   {
+      free(q->ops);
+      q->ops          = NULL;
+      q->ops_count    = 0;
+      q->fields_count = 0;
+      return;
+   }
+
+   q->ops[op].len = q->ops_count - op;
+}
+
 void libretrodb_query_free(void *q)
 {
    unsigned i;
@@ -912,6 +1065,7 @@ void libretrodb_query_free(void *q)
    for (i = 0; i < real_q->root.argc; i++)
       query_argument_free(&real_q->root.argv[i]);
 
+   free(real_q->ops);
    free(real_q->root.argv);
    real_q->root.argv = NULL;
    real_q->root.argc = 0;
@@ -954,6 +1108,8 @@ void *libretrodb_query_compile(libretrodb_t *db,
       goto error;
    }
 
+   query_compile(q);
+
    return q;
 
 error:
@@ -976,3 +1132,232 @@ int libretrodb_query_filter(libretrodb_query_t *q,
    struct rmsgpack_dom_value res = inv.func(*v, inv.argc, inv.argv);
    return (res.type == RDT_BOOL && res.val.bool_);
 }
+
+static int query_view_equals(const struct rmsgpack_view *input,
+      const struct rmsgpack_dom_value *value)
+{
+   if (input->type == RDT_UINT && value->type == RDT_INT)
+      return input->val.uint_ == (uint64_t)value->val.int_;
+
+   if (input->type != value->type)
+      return 0;
+
+   switch (input->type)
+   {
+      case RDT_NULL:
+         return 1;
+      case RDT_BOOL:
+         return input->val.bool_ == value->val.bool_;
+      case RDT_INT:
+         return input->val.int_ == value->val.int_;
+      case RDT_UINT:
+         return input->val.uint_ == value->val.uint_;
+      case RDT_STRING:
+         return input->val.string.len == value->val.string.len
+            && strncmp(input->val.string.buff, value->val.string.buff,
+                  input->val.string.len) == 0;
+      case RDT_BINARY:
+         return input->val.binary.len == value->val.binary.len
+            && memcmp(input->val.binary.buff, value->val.binary.buff,
+                  input->val.binary.len) == 0;
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+static int query_view_glob(const struct rmsgpack_view *input,
+      const char *pattern)
+{
+   int rv;
+   char buf[256];
+   char *str = buf;
+
+   if (input->type != RDT_STRING)
+      return 0;
+
+   if (input->val.string.len >= sizeof(buf))
+      if (!(str = (char*)malloc(input->val.string.len + 1)))
+         return 0;
+
+   memcpy(str, input->val.string.buff, input->val.string.len);
+   str[input->val.string.len] = '\0';
+
+   rv = rl_fnmatch(pattern, str, 0) == 0;
+
+   if (str != buf)
+      free(str);
+   return rv;
+}
+
+static int query_op_eval(const struct query *q, unsigned i,
+      const struct rmsgpack_view *input, const struct rmsgpack_view *fields)
+{
+   unsigned n;
+   unsigned child            = i + 1;
+   const struct query_op *op = &q->ops[i];
+
+   switch (op->type)
+   {
+      case QUERY_OP_MAP:
+         for (n = 0; n < op->argc; n++, child += q->ops[child].len)
+            if (!query_op_eval(q, child, input, fields))
+               return 0;
+         return 1;
+      case QUERY_OP_FIELD:
+         return query_op_eval(q, child, &fields[op->field], fields);
+      case QUERY_OP_EQUALS:
+         return query_view_equals(input, &op->argv->a.value);
+      case QUERY_OP_IS_TRUE:
+         return op->argc == 0 && input->type == RDT_BOOL && input->val.bool_;
+      case QUERY_OP_GLOB:
+         return query_view_glob(input, op->argv[0].a.value.val.string.buff);
+      case QUERY_OP_BETWEEN:
+         if (input->type == RDT_INT)
+            return input->val.int_ >= op->argv[0].a.value.val.int_
+               && input->val.int_ <= op->argv[1].a.value.val.int_;
+         if (input->type == RDT_UINT)
+            return (unsigned)input->val.int_ >= op->argv[0].a.value.val.uint_
+               && input->val.int_ <= op->argv[1].a.value.val.int_;
+         return 0;
+      case QUERY_OP_OR:
+         for (n = 0; n < op->argc; n++, child += q->ops[child].len)
+            if (query_op_eval(q, child, input, fields))
+               return 1;
+         return 0;
+      case QUERY_OP_AND:
+         for (n = 0; n < op->argc; n++, child += q->ops[child].len)
+            if (!query_op_eval(q, child, input, fields))
+               return 0;
+         return op->argc > 0;
+      case QUERY_OP_FALSE:
+         break;
+   }
+
+   return 0;
+}
+
+int libretrodb_query_is_compiled(libretrodb_query_t *q)
+{
+   return ((struct query*)q)->ops != NULL;
+}
+
+int libretrodb_query_filter_buf(libretrodb_query_t *q,
+      const uint8_t *data, size_t len)
+{
+   uint32_t i;
+   unsigned j;
+   struct rmsgpack_view item;
+   struct rmsgpack_view fields[QUERY_MAX_FIELDS];
+   uint8_t found[QUERY_MAX_FIELDS];
+   const struct query *rq = (const struct query*)q;
+   const uint8_t *pos     = data;
+   const uint8_t *end     = data + len;
+
+   if (!rq->ops)
+   {
+      struct rmsgpack_dom_value value;
+      int rv = 0;
+
+      if (rmsgpack_dom_read_buf(&pos, end, &value) < 0)
+         return 0;
+
+      rv = libretrodb_query_filter(q, &value);
+      rmsgpack_dom_value_free(&value);
+      return rv;
+   }
+
+   if (rmsgpack_read_view(&pos, end, &item) < 0)
+      return 0;
+
+   if (item.type != RDT_MAP)
+      return rq->ops[0].type == QUERY_OP_MAP;
+
+   /* All missing fields are nil */
+   for (j = 0; j < rq->fields_count; j++)
+   {
+      fields[j].type = RDT_NULL;
+      found[j]       = 0;
+   }
+
+   for (i = 0; i < item.val.len; i++)
+   {
+      struct rmsgpack_view key, value;
+      const uint8_t *value_pos = NULL;
+
+      if (rmsgpack_read_view(&pos, end, &key) < 0)
+         return 0;
+
+      value_pos = pos;
+
+      if (rmsgpack_read_view(&pos, end, &value) < 0)
+         return 0;
+
+      if (value.type == RDT_MAP || value.type == RDT_ARRAY)
+      {
+         pos = value_pos;
+         if (rmsgpack_skip_view(&pos, end) < 0)
+            return 0;
+      }
+
+      if (key.type != RDT_STRING && key.type != RDT_BINARY)
+         continue;
+
+      /* Only the first occurrence of a key counts */
+      for (j = 0; j < rq->fields_count; j++)
+         if (!found[j] && query_view_equals(&key, rq->fields[j]))
+         {
+            fields[j] = value;
+            found[j]  = 1;
+         }
+   }
+
+   return query_op_eval(rq, 0, NULL, fields);
+}
+
+int libretrodb_query_get_keys(libretrodb_query_t *q, const char *name,
+      const struct rmsgpack_dom_value **keys, unsigned max)
+{
+   unsigned i, j;
+   const struct query *rq = (const struct query*)q;
+   size_t name_len        = strlen(name);
+
+   if (!rq->ops || rq->ops[0].type != QUERY_OP_MAP)
+      return -1;
+
+   for (i = 1; i < rq->ops_count; i += rq->ops[i].len)
+   {
+      const struct query_op *op              = &rq->ops[i + 1];
+      const struct rmsgpack_dom_value *field = rq->fields[rq->ops[i].field];
+
+      if (     field->type != RDT_STRING
+            || field->val.string.len != name_len
+            || memcmp(field->val.string.buff, name, name_len) != 0)
+         continue;
+
+      if (op->type == QUERY_OP_EQUALS)
+      {
+         if (max < 1)
+            continue;
+         keys[0] = &op->argv->a.value;
+         return 1;
+      }
+
+      if (op->type != QUERY_OP_OR || op->argc > max)
+         continue;
+
+      for (j = 0; j < op->argc; j++)
+         if (op[j + 1].type != QUERY_OP_EQUALS)
+            break;
+
+      if (j < op->argc)
+         continue;
+
+      for (j = 0; j < op->argc; j++)
+         keys[j] = &op[j + 1].argv->a.value;
+      return (int)op->argc;
+   }
+
+   return -1;
+}
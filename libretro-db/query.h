@@ -38,6 +38,42 @@ void libretrodb_query_dec_ref(libretrodb_query_t *q);
 
 int libretrodb_query_filter(libretrodb_query_t *q, struct rmsgpack_dom_value *v);
 
+/* Returns: non-zero if @q can be evaluated on encoded items
+ * without decoding them. */
+int libretrodb_query_is_compiled(libretrodb_query_t *q);
+
+/**
+ * libretrodb_query_filter_buf:
+ * @q                   : Query.
+ * @data                : Encoded item.
+ * @len                 : Size of @data.
+ *
+ * Same as libretrodb_query_filter, but runs on the encoded item.
+ * Table queries are evaluated without decoding the item into
+ * a DOM.
+ *
+ * Returns: non-zero if the item matches @q.
+ **/
+int libretrodb_query_filter_buf(libretrodb_query_t *q,
+      const uint8_t *data, size_t len);
+
+/**
+ * libretrodb_query_get_keys:
+ * @q                   : Query.
+ * @name                : Field name.
+ * @keys                : Values of the field an item can match with.
+ * @max                 : Size of @keys.
+ *
+ * Used to look up the items of @q in the index of @name instead of
+ * filtering every item. Only tables whose @name field is equal to
+ * a value, or to one of the values of an or(), are supported.
+ *
+ * Returns: amount of values in @keys, or -1 if @q doesn't limit
+ * @name to a set of values.
+ **/
+int libretrodb_query_get_keys(libretrodb_query_t *q, const char *name,
+      const struct rmsgpack_dom_value **keys, unsigned max);
+
 RETRO_END_DECLS
 
 #endif
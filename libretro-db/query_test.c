@@ -0,0 +1,398 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (query_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Checks that compiled queries, index probes and the DOM interpreter
+ * agree. A database is written with libretrodb_create and indexed on
+ * crc and md5, then every query below is run three ways:
+ *
+ * - a full scan that filters each item with the DOM interpreter, and
+ *   with libretrodb_query_filter_buf on the same encoded item,
+ * - a cursor opened on the query, which plans index probes and
+ *   filters with the compiled query, read with
+ *   libretrodb_cursor_read_item,
+ * - the same cursor read with libretrodb_cursor_read_item_buf.
+ *
+ * All three have to return the same items in the same order, and the
+ * amount the query is written to match. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <streams/file_stream.h>
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
+
+#define ITEM_COUNT 1000
+
+struct query_case
+{
+   const char *query;
+   /* Index the cursor is expected to probe, or NULL */
+   const char *index;
+   unsigned matches;
+};
+
+/* Items have a crc of C0DE0000 plus their number and an md5 that
+ * starts with their number followed by AB bytes. One in ten has no
+ * developer. */
+static const struct query_case query_cases[] = {
+   { "{}",                                                   NULL,  ITEM_COUNT },
+   { "{'name':'Game 42 (Rev 0)'}",                           NULL,  1 },
+   { "{'releaseyear':1999}",                                 NULL,  25 },
+   { "{'releaseyear':between(1990,1992)}",                   NULL,  75 },
+   { "{'releaseyear':and(between(1980,1990),or(1981,1985))}",NULL,  50 },
+   { "{'releaseyear':and()}",                                NULL,  0 },
+   { "{'releaseyear':or()}",                                 NULL,  0 },
+   { "{'size':between(1,5000)}",                             NULL,  4 },
+   { "{'developer':glob('Dev 4*')}",                         NULL,  200 },
+   { "{'developer':glob('*|Dev 3')}",                        NULL,  129 },
+   { "{'developer':nil}",                                    NULL,  100 },
+   { "{'missing':nil}",                                      NULL,  ITEM_COUNT },
+   { "{'homebrew':true}",                                    NULL,  250 },
+   { "{'homebrew':is_true()}",                               NULL,  250 },
+   { "{'users':1}",                                          NULL,  200 },
+   { "{'serial':or('SLUS-00001','SLUS-00002','x')}",         NULL,  2 },
+   { "{'name':glob('Game 1?? (Rev *'),'users':or(0,3)}",     NULL,  40 },
+   { "{name:glob('*Rev 2*'), releaseyear:between(2000, 2010), "
+     "developer:glob('Dev 1*')}",                            NULL,  19 },
+   { "{'crc':b'C0DE002A'}",                                  "crc", 1 },
+   { "{'crc':or(b'C0DE004D',b'C0DE002A',b'FFFFFFFF',"
+     "b'C0DE002A',b'C0DE0005')}",                            "crc", 3 },
+   { "{'crc':b'C0DE002A','releaseyear':1999}",               "crc", 0 },
+   { "{'crc':b'C0DE002A','releaseyear':1982}",               "crc", 1 },
+   { "{'crc':b'0011'}",                                      "crc", 0 },
+   { "{'md5':b'0005ABABABABABABABABABABABABABAB'}",          "md5", 1 },
+   /* Nested tables and method-call roots stay on the DOM. A table
+    * matches anything that isn't a map. */
+   { "{'a':{'b':1}}",                                        NULL,  ITEM_COUNT },
+   { "glob('x')",                                            NULL,  0 },
+};
+
+static unsigned item_number;
+
+static void set_key(struct rmsgpack_dom_pair *pair, const char *key)
+{
+   pair->key.type            = RDT_STRING;
+   pair->key.val.string.len  = (uint32_t)strlen(key);
+   pair->key.val.string.buff = strdup(key);
+}
+
+static void set_string(struct rmsgpack_dom_pair *pair, const char *key,
+      enum rmsgpack_dom_type type, const void *value, uint32_t len)
+{
+   set_key(pair, key);
+   pair->value.type            = type;
+   pair->value.val.string.len  = len;
+   pair->value.val.string.buff = (char*)malloc(len + 1);
+   memcpy(pair->value.val.string.buff, value, len);
+   pair->value.val.string.buff[len] = '\0';
+}
+
+static void set_uint(struct rmsgpack_dom_pair *pair, const char *key,
+      uint64_t value)
+{
+   set_key(pair, key);
+   pair->value.type      = RDT_UINT;
+   pair->value.val.uint_ = value;
+}
+
+static int value_provider(void *ctx, struct rmsgpack_dom_value *out)
+{
+   char buf[64];
+   uint8_t bin[16];
+   unsigned i = item_number;
+   struct rmsgpack_dom_pair *items;
+   uint32_t len = 0;
+
+   if (i >= ITEM_COUNT)
+      return 1;
+
+   items = (struct rmsgpack_dom_pair*)calloc(9, sizeof(*items));
+
+   snprintf(buf, sizeof(buf), "Game %u (Rev %u)", i, i % 3);
+   set_string(&items[len++], "name", RDT_STRING, buf, (uint32_t)strlen(buf));
+
+   bin[0] = 0xC0;
+   bin[1] = 0xDE;
+   bin[2] = (uint8_t)(i >> 8);
+   bin[3] = (uint8_t)i;
+   set_string(&items[len++], "crc", RDT_BINARY, bin, 4);
+
+   memset(bin, 0xAB, sizeof(bin));
+   bin[0] = (uint8_t)(i >> 8);
+   bin[1] = (uint8_t)i;
+   set_string(&items[len++], "md5", RDT_BINARY, bin, 16);
+
+   snprintf(buf, sizeof(buf), "SLUS-%05u", i);
+   set_string(&items[len++], "serial", RDT_STRING, buf, (uint32_t)strlen(buf));
+
+   if (i % 10 != 9)
+   {
+      snprintf(buf, sizeof(buf), "Dev %u|Dev %u", i % 50, i % 7);
+      set_string(&items[len++], "developer", RDT_STRING, buf,
+            (uint32_t)strlen(buf));
+   }
+
+   set_uint(&items[len++], "releaseyear", 1980 + i % 40);
+   set_uint(&items[len++], "users", i % 5);
+   set_uint(&items[len++], "size", 1024 * (i + 1));
+
+   set_key(&items[len], "homebrew");
+   items[len].value.type        = RDT_BOOL;
+   items[len++].value.val.bool_ = (i % 4 == 0);
+
+   out->type          = RDT_MAP;
+   out->val.map.len   = len;
+   out->val.map.items = items;
+
+   item_number++;
+   return 0;
+}
+
+static int create_db(const char *path)
+{
+   int rv;
+   libretrodb_t *db;
+   RFILE *fd = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!fd)
+      return -1;
+
+   item_number = 0;
+   rv          = libretrodb_create(fd, value_provider, NULL);
+   filestream_close(fd);
+
+   if (rv < 0 || !(db = libretrodb_new()))
+      return -1;
+
+   if ((rv = libretrodb_open(path, db)) == 0)
+   {
+      libretrodb_create_index(db, "crc", "crc");
+      libretrodb_create_index(db, "md5", "md5");
+      libretrodb_close(db);
+   }
+
+   libretrodb_free(db);
+   return rv;
+}
+
+/* Appends the name of @item to @names, the item results are compared
+ * by the names they list. */
+static void append_name(struct rmsgpack_dom_value *item,
+      char *names, size_t size)
+{
+   struct rmsgpack_dom_value key;
+   struct rmsgpack_dom_value *name;
+
+   key.type            = RDT_STRING;
+   key.val.string.len  = 4;
+   key.val.string.buff = (char*)"name";
+
+   if ((name = rmsgpack_dom_value_map_value(item, &key)))
+      strlcat(names, name->val.string.buff, size);
+   strlcat(names, "\n", size);
+}
+
+static int run_query(libretrodb_t *db, const struct query_case *qc,
+      char *names[3], size_t size)
+{
+   unsigned i;
+   int mapped;
+   const uint8_t *data      = NULL;
+   size_t len               = 0;
+   struct rmsgpack_dom_value item;
+   unsigned counts[3]       = {0};
+   const char *error        = NULL;
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+   libretrodb_query_t *q    = (libretrodb_query_t*)
+      libretrodb_query_compile(db, qc->query, strlen(qc->query), &error);
+   int ret                  = 0;
+
+   for (i = 0; i < 3; i++)
+      names[i][0] = '\0';
+
+   if (!q || error)
+   {
+      printf("%s: %s\n", qc->query, error ? error : "not compiled");
+      ret = -1;
+      goto end;
+   }
+
+   if (qc->index)
+   {
+      const struct rmsgpack_dom_value *keys[16];
+
+      if (libretrodb_query_get_keys(q, qc->index, keys, 16) < 0)
+      {
+         printf("%s: no keys for the %s index\n", qc->query, qc->index);
+         ret = -1;
+      }
+   }
+
+   libretrodb_cursor_open(db, cur, NULL);
+   mapped = libretrodb_cursor_read_item_buf(cur, &data, &len) != 1;
+   libretrodb_cursor_close(cur);
+
+   /* Full scan, DOM interpreter and compiled query on each item.
+    * Without a memory map the encoded items aren't available and
+    * only the DOM interpreter runs. */
+   libretrodb_cursor_open(db, cur, NULL);
+   for (;;)
+   {
+      int match;
+
+      if (mapped)
+      {
+         const uint8_t *pos;
+
+         if (libretrodb_cursor_read_item_buf(cur, &data, &len) != 0)
+            break;
+         pos = data;
+         if (rmsgpack_dom_read_buf(&pos, data + len, &item) < 0)
+         {
+            printf("%s: could not decode item\n", qc->query);
+            ret = -1;
+            break;
+         }
+      }
+      else if (libretrodb_cursor_read_item(cur, &item) != 0)
+         break;
+
+      match = libretrodb_query_filter(q, &item);
+
+      if (mapped && !match != !libretrodb_query_filter_buf(q, data, len))
+      {
+         printf("%s: compiled query disagrees on ", qc->query);
+         rmsgpack_dom_value_print(&item);
+         printf("\n");
+         ret = -1;
+      }
+
+      if (match)
+      {
+         append_name(&item, names[0], size);
+         counts[0]++;
+      }
+      rmsgpack_dom_value_free(&item);
+   }
+   libretrodb_cursor_close(cur);
+
+   /* Planned cursor */
+   libretrodb_cursor_open(db, cur, q);
+   while (libretrodb_cursor_read_item(cur, &item) == 0)
+   {
+      append_name(&item, names[1], size);
+      counts[1]++;
+      rmsgpack_dom_value_free(&item);
+   }
+   libretrodb_cursor_close(cur);
+
+   if (mapped)
+   {
+      libretrodb_cursor_open(db, cur, q);
+      while (libretrodb_cursor_read_item_buf(cur, &data, &len) == 0)
+      {
+         const uint8_t *pos = data;
+
+         if (rmsgpack_dom_read_buf(&pos, data + len, &item) < 0)
+            break;
+         append_name(&item, names[2], size);
+         counts[2]++;
+         rmsgpack_dom_value_free(&item);
+      }
+      libretrodb_cursor_close(cur);
+   }
+
+   if (counts[0] != qc->matches)
+   {
+      printf("%s: %u items match, expected %u\n",
+            qc->query, counts[0], qc->matches);
+      ret = -1;
+   }
+
+   for (i = 1; i < (mapped ? 3 : 2); i++)
+   {
+      if (counts[i] != counts[0] || strcmp(names[i], names[0]))
+      {
+         printf("%s: %s returned %u items, the DOM interpreter %u\n",
+               qc->query,
+               i == 1 ? "libretrodb_cursor_read_item"
+                      : "libretrodb_cursor_read_item_buf",
+               counts[i], counts[0]);
+         ret = -1;
+      }
+   }
+
+end:
+   if (q)
+      libretrodb_query_free(q);
+   libretrodb_cursor_free(cur);
+   return ret;
+}
+
+int main(int argc, char **argv)
+{
+   unsigned i;
+   char *names[3];
+   const char *path  = argc > 1 ? argv[1] : "query_test.rdb";
+   size_t size       = ITEM_COUNT * 32;
+   unsigned failures = 0;
+   libretrodb_t *db  = NULL;
+
+   if (create_db(path) != 0)
+   {
+      printf("Could not create db file '%s'\n", path);
+      return 1;
+   }
+
+   if (!(db = libretrodb_new()) || libretrodb_open(path, db) != 0)
+   {
+      printf("Could not open db file '%s'\n", path);
+      libretrodb_free(db);
+      return 1;
+   }
+
+   for (i = 0; i < 3; i++)
+      names[i] = (char*)malloc(size);
+
+   for (i = 0; i < sizeof(query_cases) / sizeof(query_cases[0]); i++)
+   {
+      if (run_query(db, &query_cases[i], names, size) != 0)
+         failures++;
+   }
+
+   for (i = 0; i < 3; i++)
+      free(names[i]);
+   libretrodb_close(db);
+   libretrodb_free(db);
+   remove(path);
+
+   printf("%u queries, %u failed\n",
+         (unsigned)(sizeof(query_cases) / sizeof(query_cases[0])),
+         failures);
+   return failures ? 1 : 0;
+}
@@ -271,8 +271,7 @@ int rmsgpack_write_bool(RFILE *fd, int value)
       if (filestream_write(fd, &MPF_TRUE, sizeof(MPF_TRUE)) == -1)
          goto error;
    }
-
-   if (filestream_write(fd, &MPF_FALSE, sizeof(MPF_FALSE)) == -1)
+   else if (filestream_write(fd, &MPF_FALSE, sizeof(MPF_FALSE)) == -1)
       goto error;
 
    return sizeof(uint8_t);
@@ -658,3 +657,179 @@ int rmsgpack_read(RFILE *fd,
 error:
    return -errno;
 }
+
+static int rmsgpack_read_view_uint(const uint8_t **pos,
+      const uint8_t *end, size_t size, uint64_t *out)
+{
+   size_t i;
+   uint64_t val = 0;
+
+   if ((size_t)(end - *pos) < size)
+      return -EINVAL;
+
+   for (i = 0; i < size; i++)
+      val = (val << 8) | (*pos)[i];
+
+   *pos += size;
+   *out  = val;
+   return 0;
+}
+
+static int rmsgpack_read_view_buff(const uint8_t **pos,
+      const uint8_t *end, size_t size, uint32_t *len, const char **buff)
+{
+   uint64_t tmp_len = 0;
+
+   if (rmsgpack_read_view_uint(pos, end, size, &tmp_len) < 0
+         || (uint64_t)(end - *pos) < tmp_len)
+      return -EINVAL;
+
+   *len  = (uint32_t)tmp_len;
+   *buff = (const char*)*pos;
+   *pos += tmp_len;
+   return 0;
+}
+
+int rmsgpack_read_view(const uint8_t **pos, const uint8_t *end,
+      struct rmsgpack_view *out)
+{
+   uint64_t tmp = 0;
+   uint8_t type = 0;
+
+   if (*pos >= end)
+      return -EINVAL;
+
+   type = *(*pos)++;
+
+   if (type < MPF_FIXMAP)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = type;
+      return 0;
+   }
+   else if (type < MPF_FIXARRAY)
+   {
+      out->type    = RDT_MAP;
+      out->val.len = type - MPF_FIXMAP;
+      return 0;
+   }
+   else if (type < MPF_FIXSTR)
+   {
+      out->type    = RDT_ARRAY;
+      out->val.len = type - MPF_FIXARRAY;
+      return 0;
+   }
+   else if (type < MPF_NIL)
+   {
+      out->type           = RDT_STRING;
+      out->val.string.len = type - MPF_FIXSTR;
+      if ((uint32_t)(end - *pos) < out->val.string.len)
+         return -EINVAL;
+      out->val.string.buff = (const char*)*pos;
+      *pos                += out->val.string.len;
+      return 0;
+   }
+   else if (type > MPF_MAP32)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = (int8_t)type;
+      return 0;
+   }
+
+   switch (type)
+   {
+      case _MPF_NIL:
+         out->type = RDT_NULL;
+         return 0;
+      case _MPF_FALSE:
+      case _MPF_TRUE:
+         out->type      = RDT_BOOL;
+         out->val.bool_ = type == _MPF_TRUE;
+         return 0;
+      case _MPF_BIN8:
+      case _MPF_BIN16:
+      case _MPF_BIN32:
+         out->type = RDT_BINARY;
+         return rmsgpack_read_view_buff(pos, end,
+               (size_t)1 << (type - _MPF_BIN8),
+               &out->val.binary.len, &out->val.binary.buff);
+      case _MPF_UINT8:
+      case _MPF_UINT16:
+      case _MPF_UINT32:
+      case _MPF_UINT64:
+         out->type = RDT_UINT;
+         return rmsgpack_read_view_uint(pos, end,
+               (size_t)1 << (type - _MPF_UINT8), &out->val.uint_);
+      case _MPF_INT8:
+      case _MPF_INT16:
+      case _MPF_INT32:
+      case _MPF_INT64:
+         out->type = RDT_INT;
+         if (rmsgpack_read_view_uint(pos, end,
+                  (size_t)1 << (type - _MPF_INT8), &tmp) < 0)
+            return -EINVAL;
+         switch (type)
+         {
+            case _MPF_INT8:
+               out->val.int_ = (int8_t)tmp;
+               break;
+            case _MPF_INT16:
+               out->val.int_ = (int16_t)tmp;
+               break;
+            case _MPF_INT32:
+               out->val.int_ = (int32_t)tmp;
+               break;
+            default:
+               out->val.int_ = (int64_t)tmp;
+               break;
+         }
+         return 0;
+      case _MPF_STR8:
+      case _MPF_STR16:
+      case _MPF_STR32:
+         out->type = RDT_STRING;
+         return rmsgpack_read_view_buff(pos, end,
+               (size_t)1 << (type - _MPF_STR8),
+               &out->val.string.len, &out->val.string.buff);
+      case _MPF_ARRAY16:
+      case _MPF_ARRAY32:
+         out->type = RDT_ARRAY;
+         if (rmsgpack_read_view_uint(pos, end,
+                  (size_t)2 << (type - _MPF_ARRAY16), &tmp) < 0)
+            return -EINVAL;
+         out->val.len = (uint32_t)tmp;
+         return 0;
+      case _MPF_MAP16:
+      case _MPF_MAP32:
+         out->type = RDT_MAP;
+         if (rmsgpack_read_view_uint(pos, end,
+                  (size_t)2 << (type - _MPF_MAP16), &tmp) < 0)
+            return -EINVAL;
+         out->val.len = (uint32_t)tmp;
+         return 0;
+   }
+
+   return -EINVAL;
+}
+
+int rmsgpack_skip_view(const uint8_t **pos, const uint8_t *end)
+{
+   int rv;
+   uint64_t i;
+   uint64_t items = 0;
+   struct rmsgpack_view view;
+
+   if ((rv = rmsgpack_read_view(pos, end, &view)) < 0)
+      return rv;
+
+   if (view.type == RDT_MAP)
+      items = (uint64_t)view.val.len * 2;
+   else if (view.type == RDT_ARRAY)
+      items = view.val.len;
+
+   for (i = 0; i < items; i++)
+      if ((rv = rmsgpack_skip_view(pos, end)) < 0)
+         return rv;
+
+   return 0;
+}
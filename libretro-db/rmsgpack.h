@@ -27,6 +27,8 @@
 
 #include <streams/file_stream.h>
 
+#include "rmsgpack_dom.h"
+
 struct rmsgpack_read_callbacks
 {
    int (*read_nil        )(void *);
@@ -57,4 +59,47 @@ int rmsgpack_write_uint(RFILE *fd, uint64_t value );
 
 int rmsgpack_read(RFILE *fd, struct rmsgpack_read_callbacks *callbacks, void *data);
 
+/* Value decoded in place from a buffer. Strings and binaries
+ * point into the buffer and aren't NUL terminated, maps and
+ * arrays only hold their length, their items follow. */
+struct rmsgpack_view
+{
+   enum rmsgpack_dom_type type;
+   union
+   {
+      uint64_t uint_;
+      int64_t int_;
+      int bool_;
+      struct
+      {
+         uint32_t len;
+         const char *buff;
+      } string;
+      struct
+      {
+         uint32_t len;
+         const char *buff;
+      } binary;
+      uint32_t len;
+   } val;
+};
+
+/**
+ * rmsgpack_read_view:
+ * @pos                 : Position in the buffer, moved past the value.
+ * @end                 : End of the buffer.
+ * @out                 : Decoded value.
+ *
+ * Decodes one value without copying it. For maps and arrays,
+ * only the header is read.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_read_view(const uint8_t **pos, const uint8_t *end,
+      struct rmsgpack_view *out);
+
+/* Moves @pos past one whole value, including the
+ * items of maps and arrays. */
+int rmsgpack_skip_view(const uint8_t **pos, const uint8_t *end);
+
 #endif
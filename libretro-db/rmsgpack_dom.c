@@ -418,6 +418,114 @@ int rmsgpack_dom_read(RFILE *fd, struct rmsgpack_dom_value *out)
    return rv;
 }
 
+static int rmsgpack_dom_read_buf_depth(const uint8_t **pos,
+      const uint8_t *end, struct rmsgpack_dom_value *out, unsigned depth)
+{
+   uint32_t i;
+   uint32_t len = 0;
+   struct rmsgpack_view view;
+   int rv       = rmsgpack_read_view(pos, end, &view);
+
+   out->type = RDT_NULL;
+
+   if (rv < 0)
+      return rv;
+
+   if (depth == MAX_DEPTH)
+      return -ENOMEM;
+
+   switch (view.type)
+   {
+      case RDT_STRING:
+      case RDT_BINARY:
+         {
+            char *buff = (char*)malloc(view.val.string.len + 1);
+
+            if (!buff)
+               return -ENOMEM;
+
+            memcpy(buff, view.val.string.buff, view.val.string.len);
+            buff[view.val.string.len] = '\0';
+
+            out->type            = view.type;
+            out->val.string.len  = view.val.string.len;
+            out->val.string.buff = buff;
+         }
+         break;
+      case RDT_MAP:
+         out->val.map.items = (struct rmsgpack_dom_pair*)
+            calloc(view.val.len, sizeof(struct rmsgpack_dom_pair));
+
+         if (!out->val.map.items && view.val.len)
+            return -ENOMEM;
+
+         out->type        = RDT_MAP;
+         out->val.map.len = 0;
+         len              = view.val.len;
+
+         for (i = 0; i < len; i++)
+         {
+            struct rmsgpack_dom_pair *pair = &out->val.map.items[i];
+
+            out->val.map.len++;
+
+            if (     (rv = rmsgpack_dom_read_buf_depth(pos, end,
+                        &pair->key, depth + 1)) < 0
+                  || (rv = rmsgpack_dom_read_buf_depth(pos, end,
+                        &pair->value, depth + 1)) < 0)
+               return rv;
+         }
+         break;
+      case RDT_ARRAY:
+         out->val.array.items = (struct rmsgpack_dom_value*)
+            calloc(view.val.len, sizeof(struct rmsgpack_dom_value));
+
+         if (!out->val.array.items && view.val.len)
+            return -ENOMEM;
+
+         out->type          = RDT_ARRAY;
+         out->val.array.len = 0;
+         len                = view.val.len;
+
+         for (i = 0; i < len; i++)
+         {
+            out->val.array.len++;
+
+            if ((rv = rmsgpack_dom_read_buf_depth(pos, end,
+                        &out->val.array.items[i], depth + 1)) < 0)
+               return rv;
+         }
+         break;
+      case RDT_BOOL:
+         out->type      = RDT_BOOL;
+         out->val.bool_ = view.val.bool_;
+         break;
+      case RDT_UINT:
+         out->type      = RDT_UINT;
+         out->val.uint_ = view.val.uint_;
+         break;
+      case RDT_INT:
+         out->type      = RDT_INT;
+         out->val.int_  = view.val.int_;
+         break;
+      case RDT_NULL:
+         break;
+   }
+
+   return 0;
+}
+
+int rmsgpack_dom_read_buf(const uint8_t **pos, const uint8_t *end,
+      struct rmsgpack_dom_value *out)
+{
+   int rv = rmsgpack_dom_read_buf_depth(pos, end, out, 0);
+
+   if (rv < 0)
+      rmsgpack_dom_value_free(out);
+
+   return rv;
+}
+
 int rmsgpack_dom_read_into(RFILE *fd, ...)
 {
    va_list ap;
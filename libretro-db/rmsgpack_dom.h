@@ -91,6 +91,11 @@ struct rmsgpack_dom_value *rmsgpack_dom_value_map_value(
 
 int rmsgpack_dom_read(RFILE *fd, struct rmsgpack_dom_value *out);
 
+/* Same as rmsgpack_dom_read, but decodes from memory. @pos is
+ * moved past the value. */
+int rmsgpack_dom_read_buf(const uint8_t **pos, const uint8_t *end,
+      struct rmsgpack_dom_value *out);
+
 int rmsgpack_dom_write(RFILE *fd, const struct rmsgpack_dom_value *obj);
 
 int rmsgpack_dom_read_into(RFILE *fd, ...);
@@ -24,14 +24,25 @@
 #include <string.h>
 
 #include <retro_inline.h>
+#include <retro_miscellaneous.h>
 #include <compat/strl.h>
 #include <compat/intrinsics.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+#include <streams/trans_stream.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "state_manager.h"
 #include "../msg_hash.h"
 #include "../movie.h"
 #include "../core.h"
+#include "../retroarch.h"
 #include "../verbosity.h"
+#include "../performance_counters.h"
 #include "../audio/audio_driver.h"
 
 #ifdef HAVE_NETWORKING
@@ -63,6 +74,23 @@
 #include <emmintrin.h>
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Size of the blocks the 'blocked' engine splits a savestate into.
+ * Must be a multiple of 32 bytes. */
+#define STATE_MANAGER_BLOCK_SIZE (16 * 1024)
+
+/* Upper bound of compression threads used by the 'blocked' engine. */
+#define STATE_MANAGER_MAX_WORKERS 8
+
+enum state_manager_engine
+{
+   STATE_MANAGER_ENGINE_LEGACY = 0,
+   STATE_MANAGER_ENGINE_BLOCKED
+};
+
 /* There's no equivalent in libc, you'd think so ...
  * std::mismatch exists, but it's not optimized at all. */
 static size_t find_change(const uint16_t *a, const uint16_t *b)
@@ -160,6 +188,108 @@ static size_t find_same(const uint16_t *a, const uint16_t *b)
    return a - a_org;
 }
 
+/* Bounded variants of find_change/find_same, used by the 'blocked'
+ * engine. They work on a slice of the savestate and can not rely on
+ * the sentinel at the end of the buffer. */
+typedef size_t (*state_manager_find_change_t)(const uint16_t *a,
+      const uint16_t *b, size_t len);
+
+static size_t find_change_bounded_c(const uint16_t *a,
+      const uint16_t *b, size_t len)
+{
+   size_t i = 0;
+   while (i < len && a[i] == b[i])
+      i++;
+   return i;
+}
+
+#if __SSE2__
+static size_t find_change_bounded_sse2(const uint16_t *a,
+      const uint16_t *b, size_t len)
+{
+   size_t i = 0;
+
+   for (; i + 8 <= len; i += 8)
+   {
+      __m128i v0    = _mm_loadu_si128((const __m128i*)(a + i));
+      __m128i v1    = _mm_loadu_si128((const __m128i*)(b + i));
+      uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi16(v0, v1));
+
+      if (mask != 0xffff)
+         return i + (compat_ctz(~mask) >> 1);
+   }
+
+   while (i < len && a[i] == b[i])
+      i++;
+   return i;
+}
+#endif
+
+#if defined(__AVX2__)
+static size_t find_change_bounded_avx2(const uint16_t *a,
+      const uint16_t *b, size_t len)
+{
+   size_t i = 0;
+
+   for (; i + 16 <= len; i += 16)
+   {
+      __m256i v0    = _mm256_loadu_si256((const __m256i*)(a + i));
+      __m256i v1    = _mm256_loadu_si256((const __m256i*)(b + i));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi16(v0, v1));
+
+      if (mask != 0xffffffffu)
+         return i + (compat_ctz(~mask) >> 1);
+   }
+
+   while (i < len && a[i] == b[i])
+      i++;
+   return i;
+}
+#endif
+
+/* Stops at the first two consecutive identical words, a single one
+ * costs more to skip than to copy. */
+static size_t find_same_bounded(const uint16_t *a,
+      const uint16_t *b, size_t len)
+{
+   size_t i = 0;
+   while (i < len && (a[i] != b[i] || (i + 1 < len && a[i + 1] != b[i + 1])))
+      i++;
+   return i;
+}
+
+static state_manager_find_change_t state_manager_get_find_change(void)
+{
+#if defined(__AVX2__) || __SSE2__
+   uint64_t cpu = cpu_features_get();
+#endif
+
+#if defined(__AVX2__)
+   if (cpu & RETRO_SIMD_AVX2)
+      return find_change_bounded_avx2;
+#endif
+#if __SSE2__
+   if (cpu & RETRO_SIMD_SSE2)
+      return find_change_bounded_sse2;
+#endif
+   return find_change_bounded_c;
+}
+
+struct state_manager_worker
+{
+   state_manager_t *state;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+#endif
+   uint8_t *scratch;
+   size_t scratch_len;
+   /* Range of blocks handled by this worker. */
+   size_t first;
+   size_t last;
+   uint32_t count;
+};
+
 struct state_manager
 {
    uint8_t *data;
@@ -182,6 +312,38 @@ struct state_manager
 
    unsigned entries;
    bool thisblock_valid;
+
+   /* Logical index of the state in thisblock, used to match the
+    * keyframes of the warm and cold tiers against the ring. */
+   uint64_t frame;
+
+   enum state_manager_engine engine;
+
+   /* Everything below is only used by the 'blocked' engine. */
+   state_manager_find_change_t find_change;
+   size_t numblocks;
+   uint64_t *hashes;
+   uint8_t *hashes_valid;
+
+   /* Buffers read by the workers until the pending frame is committed. */
+   const uint8_t *job_old;
+   const uint8_t *job_new;
+   bool job_pending;
+
+   struct state_manager_worker workers[STATE_MANAGER_MAX_WORKERS];
+   unsigned num_workers;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   scond_t *cond_work;
+   scond_t *cond_done;
+   unsigned generation;
+   unsigned busy;
+   bool quit;
+#endif
+
+   uint64_t pushes;
+   uint64_t bytes_raw;
+   uint64_t bytes_compressed;
 #if STRICT_BUF_SIZE
    size_t debugsize;
    uint8_t *debugblock;
@@ -208,16 +370,99 @@ repeat {
 size thisstart;
 #endif
 
+/* The 'blocked' engine stores one record per changed block instead,
+ * each holding a frame in the above format that covers only that block: */
+#if 0
+size nextstart;
+uint32 numrecords;
+repeat numrecords {
+   uint32 blockindex;
+   uint32 patchlen; /* in bytes */
+   uint8[patchlen] patch;
+}
+size thisstart;
+#endif
+
+/* Keyframes are full savestates taken every 'interval' frames and
+ * compressed through trans_stream. They outlive the delta ring so that
+ * rewinding past its end continues one keyframe at a time.
+ *
+ * The newest keyframes stay in RAM (warm tier). Once these exceed
+ * their budget, the oldest ones are either dropped or appended to a
+ * spill file in the savestate directory (cold tier), which is read
+ * back through a memory-mapped VFS handle.
+ *
+ * With threads, a keyframe is copied and handed to a worker which
+ * compresses it and spills the old ones, the list is only touched
+ * by the main thread once the worker is done with it. */
+struct state_manager_keyframe
+{
+   uint64_t frame;
+   /* NULL once spilled to disk. */
+   uint8_t *data;
+   size_t size;
+   /* Offset in the spill file. */
+   int64_t offset;
+};
+
+struct state_manager_tiers
+{
+   const struct trans_stream_backend *deflate_backend;
+   const struct trans_stream_backend *inflate_backend;
+   void *deflate_stream;
+   void *inflate_stream;
+
+   /* Oldest first, the ones before first_warm are on disk. */
+   struct state_manager_keyframe *keyframes;
+   size_t count;
+   size_t capacity;
+   size_t first_warm;
+
+   size_t warm_size;
+   size_t warm_capacity;
+   unsigned interval;
+
+   uint8_t *scratch;
+   size_t scratch_size;
+   uint8_t *state;
+   size_t state_size;
+
+   char spill_path[PATH_MAX_LENGTH];
+   RFILE *spill;
+   /* Read handle, reopened whenever the file was written to. */
+   RFILE *spill_map;
+   int64_t spill_size;
+   bool spill_dirty;
+
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond_work;
+   scond_t *cond_done;
+   /* Copy of the keyframe being compressed by the worker. */
+   uint8_t *pending;
+   uint64_t pending_frame;
+   bool busy;
+   bool quit;
+#endif
+};
+
 struct state_manager_rewind_state
 {
    /* Rewind support. */
    state_manager_t *state;
+   struct state_manager_tiers *tiers;
    size_t size;
 };
 
 static struct state_manager_rewind_state rewind_state;
 static bool frame_is_reversed                         = false;
 
+/* Lets the engines be compared through the performance counters. */
+static struct retro_perf_counter state_manager_push_where_perf = {0};
+static struct retro_perf_counter state_manager_push_do_perf    = {0};
+static struct retro_perf_counter state_manager_pop_perf        = {0};
+
 /* Returns the maximum compressed size of a savestate.
  * It is very likely to compress to far less. */
 static size_t state_manager_raw_maxsize(size_t uncomp)
@@ -409,11 +654,593 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+static INLINE void write_uint32(void *ptr, uint32_t val)
+{
+   memcpy(ptr, &val, sizeof(val));
+}
+
+static INLINE uint32_t read_uint32(const void *ptr)
+{
+   uint32_t ret;
+
+   memcpy(&ret, ptr, sizeof(ret));
+   return ret;
+}
+
+/* Makes sure there is room for a frame of up to maxcompsize bytes
+ * at the head, discarding the oldest frames if needed.
+ * Returns where the compressed data should be written. */
+static uint8_t *state_manager_ring_begin(state_manager_t *state)
+{
+   for (;;)
+   {
+      size_t headpos   = state->head - state->data;
+      size_t tailpos   = state->tail - state->data;
+      size_t remaining = (tailpos + state->capacity -
+            sizeof(size_t) - headpos - 1) % state->capacity + 1;
+
+      if (remaining > state->maxcompsize)
+         break;
+
+      state->tail = state->data + read_size_t(state->tail);
+      state->entries--;
+   }
+
+   return state->head + sizeof(size_t);
+}
+
+/* Links a frame ending at 'compressed' into the ring. */
+static void state_manager_ring_end(state_manager_t *state,
+      uint8_t *compressed)
+{
+   state->bytes_compressed += compressed - state->head;
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+         state->tail = state->data + read_size_t(state->tail);
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head = compressed;
+}
+
+/* Not a cryptographic hash, it only has to tell apart two versions
+ * of the same block. */
+static uint64_t state_manager_block_hash(const uint8_t *data, size_t len)
+{
+   uint64_t hash = UINT64_C(0x9e3779b97f4a7c15) ^ len;
+
+   while (len >= sizeof(uint64_t))
+   {
+      uint64_t v;
+      memcpy(&v, data, sizeof(v));
+      v    *= UINT64_C(0x87c37b91114253d5);
+      v     = (v << 31) | (v >> 33);
+      v    *= UINT64_C(0x4cf5ad432745937f);
+      hash ^= v;
+      hash  = ((hash << 27) | (hash >> 37)) * 5 + 0x52dce729;
+      data += sizeof(uint64_t);
+      len  -= sizeof(uint64_t);
+   }
+
+   while (len--)
+      hash  = (hash ^ *data++) * UINT64_C(0x100000001b3);
+
+   hash ^= hash >> 33;
+   hash *= UINT64_C(0xff51afd7ed558ccd);
+   hash ^= hash >> 33;
+   return hash;
+}
+
+/* Same output as state_manager_raw_compress, for one block.
+ * Returns the number of bytes written to 'patch'. */
+static size_t state_manager_block_compress(
+      state_manager_find_change_t find_change_cb,
+      const uint16_t *old16, const uint16_t *new16,
+      size_t num16s, uint16_t *patch)
+{
+   uint16_t *compressed16 = patch;
+
+   while (num16s)
+   {
+      size_t i, changed;
+      size_t skip = find_change_cb(old16, new16, num16s);
+
+      if (skip >= num16s)
+         break;
+
+      old16  += skip;
+      new16  += skip;
+      num16s -= skip;
+
+      if (skip > UINT16_MAX)
+      {
+         *compressed16++ = 0;
+         *compressed16++ = skip;
+         *compressed16++ = skip >> 16;
+         continue;
+      }
+
+      changed = find_same_bounded(old16, new16, num16s);
+      if (changed > UINT16_MAX)
+         changed = UINT16_MAX;
+
+      *compressed16++ = changed;
+      *compressed16++ = skip;
+
+      for (i = 0; i < changed; i++)
+         compressed16[i] = old16[i];
+
+      old16        += changed;
+      new16        += changed;
+      num16s       -= changed;
+      compressed16 += changed;
+   }
+
+   compressed16[0] = 0;
+   compressed16[1] = 0;
+   compressed16[2] = 0;
+
+   return (uint8_t*)(compressed16 + 3) - (uint8_t*)patch;
+}
+
+static void state_manager_worker_run(struct state_manager_worker *worker)
+{
+   size_t i;
+   state_manager_t *state = worker->state;
+   uint8_t *out           = worker->scratch;
+
+   worker->count          = 0;
+
+   for (i = worker->first; i < worker->last; i++)
+   {
+      size_t patch_len;
+      size_t offset        = i * STATE_MANAGER_BLOCK_SIZE;
+      size_t len           = MIN(STATE_MANAGER_BLOCK_SIZE,
+            state->blocksize - offset);
+      const uint8_t *newb  = state->job_new + offset;
+      uint64_t hash        = state_manager_block_hash(newb, len);
+
+      if (state->hashes_valid[i] && state->hashes[i] == hash)
+         continue;
+
+      state->hashes[i]       = hash;
+      state->hashes_valid[i] = 1;
+
+      patch_len = state_manager_block_compress(state->find_change,
+            (const uint16_t*)(state->job_old + offset),
+            (const uint16_t*)newb, len / sizeof(uint16_t),
+            (uint16_t*)(out + sizeof(uint32_t) * 2));
+
+      /* Only the terminator, the block didn't actually change. */
+      if (patch_len == sizeof(uint16_t) * 3)
+         continue;
+
+      write_uint32(out, (uint32_t)i);
+      write_uint32(out + sizeof(uint32_t), (uint32_t)patch_len);
+      out += sizeof(uint32_t) * 2 + patch_len;
+      worker->count++;
+   }
+
+   worker->scratch_len = out - worker->scratch;
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_worker_thread(void *data)
+{
+   struct state_manager_worker *worker = (struct state_manager_worker*)data;
+   state_manager_t *state              = worker->state;
+   unsigned generation                 = 0;
+
+   for (;;)
+   {
+      slock_lock(state->lock);
+      while (!state->quit && state->generation == generation)
+         scond_wait(state->cond_work, state->lock);
+
+      if (state->quit)
+      {
+         slock_unlock(state->lock);
+         break;
+      }
+
+      generation = state->generation;
+      slock_unlock(state->lock);
+
+      state_manager_worker_run(worker);
+
+      slock_lock(state->lock);
+      if (--state->busy == 0)
+         scond_signal(state->cond_done);
+      slock_unlock(state->lock);
+   }
+}
+#endif
+
+static void state_manager_blocked_dispatch(state_manager_t *state)
+{
+   state->job_pending = true;
+
+#ifdef HAVE_THREADS
+   if (state->lock)
+   {
+      slock_lock(state->lock);
+      state->busy = state->num_workers;
+      state->generation++;
+      scond_broadcast(state->cond_work);
+      slock_unlock(state->lock);
+      return;
+   }
+#endif
+
+   state_manager_worker_run(&state->workers[0]);
+}
+
+/* Waits for the frame handed to the workers by the last push and
+ * stores it in the ring. Must be called before the buffers are
+ * touched again. */
+static void state_manager_blocked_join(state_manager_t *state)
+{
+   unsigned i;
+   uint32_t count = 0;
+   uint8_t *compressed;
+
+   if (!state->job_pending)
+      return;
+
+#ifdef HAVE_THREADS
+   if (state->lock)
+   {
+      slock_lock(state->lock);
+      while (state->busy)
+         scond_wait(state->cond_done, state->lock);
+      slock_unlock(state->lock);
+   }
+#endif
+
+   state->job_pending = false;
+   compressed         = state_manager_ring_begin(state);
+
+   for (i = 0; i < state->num_workers; i++)
+      count += state->workers[i].count;
+
+   write_uint32(compressed, count);
+   compressed += sizeof(uint32_t);
+
+   for (i = 0; i < state->num_workers; i++)
+   {
+      struct state_manager_worker *worker = &state->workers[i];
+      memcpy(compressed, worker->scratch, worker->scratch_len);
+      compressed += worker->scratch_len;
+   }
+
+   state_manager_ring_end(state, compressed);
+}
+
+/* The block hashes describe thisblock. Whenever thisblock is replaced
+ * by a state they weren't computed from, they have to go, or the
+ * workers would skip blocks that did change. */
+static void state_manager_blocked_invalidate(state_manager_t *state)
+{
+   if (state->hashes_valid)
+      memset(state->hashes_valid, 0,
+            state->numblocks * sizeof(*state->hashes_valid));
+}
+
+static void state_manager_blocked_decompress(state_manager_t *state,
+      const uint8_t *compressed)
+{
+   uint32_t i;
+   uint32_t count = read_uint32(compressed);
+
+   compressed    += sizeof(uint32_t);
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t index     = read_uint32(compressed);
+      uint32_t patch_len = read_uint32(compressed + sizeof(uint32_t));
+      size_t offset      = (size_t)index * STATE_MANAGER_BLOCK_SIZE;
+
+      compressed        += sizeof(uint32_t) * 2;
+
+      state_manager_raw_decompress(compressed, patch_len,
+            state->thisblock + offset,
+            MIN(STATE_MANAGER_BLOCK_SIZE, state->blocksize - offset));
+
+      state->hashes_valid[index] = 0;
+      compressed        += patch_len;
+   }
+}
+
+/* Like state_manager_raw_decompress, but for patches that come from
+ * elsewhere: never reads past the patch or writes past 'num16s' words.
+ * With 'out16' NULL, only checks the patch. */
+static bool state_manager_raw_decompress_checked(const uint16_t *patch16,
+      size_t patch16s, uint16_t *out16, size_t num16s)
+{
+   const uint16_t *end = patch16 + patch16s;
+   size_t pos          = 0;
+
+   for (;;)
+   {
+      uint16_t numchanged;
+
+      if (patch16 == end)
+         return false;
+      numchanged = *(patch16++);
+
+      if (numchanged)
+      {
+         uint16_t skip;
+
+         if ((size_t)(end - patch16) < (size_t)numchanged + 1)
+            return false;
+         skip = *(patch16++);
+         if ((size_t)skip + numchanged > num16s - pos)
+            return false;
+
+         if (out16)
+            memcpy(out16 + pos + skip, patch16,
+                  numchanged * sizeof(uint16_t));
+
+         patch16 += numchanged;
+         pos     += (size_t)skip + numchanged;
+      }
+      else
+      {
+         uint32_t numunchanged;
+
+         if (end - patch16 < 2)
+            return false;
+         numunchanged = patch16[0] | ((uint32_t)patch16[1] << 16);
+         patch16     += 2;
+
+         if (!numunchanged)
+            return patch16 == end;
+         if (numunchanged > num16s - pos)
+            return false;
+         pos         += numunchanged;
+      }
+   }
+}
+
+size_t state_manager_delta_maxsize(size_t len)
+{
+   size_t numblocks = (len / sizeof(uint16_t) * sizeof(uint16_t)
+         + STATE_MANAGER_BLOCK_SIZE - 1) / STATE_MANAGER_BLOCK_SIZE;
+
+   /* Every record after the first in a block covers at least as many
+    * words as it takes, so a block costs at most its own size, its
+    * index and length, one record header and the terminator. */
+   return sizeof(uint32_t) + (len & 1) + numblocks *
+      (STATE_MANAGER_BLOCK_SIZE + sizeof(uint32_t) * 2
+       + sizeof(uint16_t) * 5);
+}
+
+size_t state_manager_delta_compress(const void *base, const void *state,
+      size_t len, void *patch)
+{
+   size_t offset;
+   uint32_t count                           = 0;
+   size_t len16                             = len & ~(size_t)1;
+   uint8_t *out                             = (uint8_t*)patch
+      + sizeof(uint32_t);
+   state_manager_find_change_t find_change_cb =
+      state_manager_get_find_change();
+
+   for (offset = 0; offset < len16; offset += STATE_MANAGER_BLOCK_SIZE)
+   {
+      size_t patch_len;
+      size_t blen        = MIN(STATE_MANAGER_BLOCK_SIZE, len16 - offset);
+      const uint8_t *oldb = (const uint8_t*)base  + offset;
+      const uint8_t *newb = (const uint8_t*)state + offset;
+
+      if (!memcmp(oldb, newb, blen))
+         continue;
+
+      /* The patch holds the words of its first argument, here the
+       * state we want to end up with. */
+      patch_len = state_manager_block_compress(find_change_cb,
+            (const uint16_t*)newb, (const uint16_t*)oldb,
+            blen / sizeof(uint16_t),
+            (uint16_t*)(out + sizeof(uint32_t) * 2));
+
+      write_uint32(out, (uint32_t)(offset / STATE_MANAGER_BLOCK_SIZE));
+      write_uint32(out + sizeof(uint32_t), (uint32_t)patch_len);
+      out += sizeof(uint32_t) * 2 + patch_len;
+      count++;
+   }
+
+   if (len & 1)
+      *out++ = ((const uint8_t*)state)[len - 1];
+
+   write_uint32(patch, count);
+   return out - (uint8_t*)patch;
+}
+
+bool state_manager_delta_apply(const void *patch, size_t patch_len,
+      void *data, size_t len)
+{
+   uint32_t i, count;
+   const uint8_t *in  = (const uint8_t*)patch;
+   const uint8_t *end = in + patch_len;
+   size_t len16       = len & ~(size_t)1;
+
+   if (patch_len < sizeof(uint32_t))
+      return false;
+   count = read_uint32(in);
+   in   += sizeof(uint32_t);
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t index, record_len;
+      size_t offset;
+
+      if ((size_t)(end - in) < sizeof(uint32_t) * 2)
+         return false;
+      index      = read_uint32(in);
+      record_len = read_uint32(in + sizeof(uint32_t));
+      in        += sizeof(uint32_t) * 2;
+      offset     = (size_t)index * STATE_MANAGER_BLOCK_SIZE;
+
+      if (     offset >= len16
+            || (record_len & 1)
+            || record_len > (size_t)(end - in))
+         return false;
+
+      if (!state_manager_raw_decompress_checked((const uint16_t*)in,
+               record_len / sizeof(uint16_t),
+               data ? (uint16_t*)((uint8_t*)data + offset) : NULL,
+               MIN(STATE_MANAGER_BLOCK_SIZE, len16 - offset)
+               / sizeof(uint16_t)))
+         return false;
+      in += record_len;
+   }
+
+   if (len & 1)
+   {
+      if (in == end)
+         return false;
+      if (data)
+         ((uint8_t*)data)[len - 1] = *in;
+      in++;
+   }
+
+   return in == end;
+}
+
+static void state_manager_blocked_free(state_manager_t *state)
+{
+   unsigned i;
+
+   state_manager_blocked_join(state);
+
+#ifdef HAVE_THREADS
+   if (state->lock)
+   {
+      slock_lock(state->lock);
+      state->quit = true;
+      scond_broadcast(state->cond_work);
+      slock_unlock(state->lock);
+   }
+
+   for (i = 0; i < state->num_workers; i++)
+   {
+      if (state->workers[i].thread)
+         sthread_join(state->workers[i].thread);
+      state->workers[i].thread = NULL;
+   }
+
+   if (state->cond_work)
+      scond_free(state->cond_work);
+   if (state->cond_done)
+      scond_free(state->cond_done);
+   if (state->lock)
+      slock_free(state->lock);
+   state->cond_work = NULL;
+   state->cond_done = NULL;
+   state->lock      = NULL;
+#endif
+
+   for (i = 0; i < state->num_workers; i++)
+   {
+      if (state->workers[i].scratch)
+         free(state->workers[i].scratch);
+      state->workers[i].scratch = NULL;
+   }
+
+   if (state->hashes)
+      free(state->hashes);
+   if (state->hashes_valid)
+      free(state->hashes_valid);
+   state->hashes       = NULL;
+   state->hashes_valid = NULL;
+   state->num_workers  = 0;
+}
+
+static bool state_manager_blocked_init(state_manager_t *state)
+{
+   unsigned i;
+   size_t block_maxcompsize = sizeof(uint32_t) * 2 +
+      state_manager_raw_maxsize(STATE_MANAGER_BLOCK_SIZE);
+   unsigned num_workers     = cpu_features_get_core_amount();
+
+   if (num_workers > 1)
+      num_workers--;
+   if (num_workers > STATE_MANAGER_MAX_WORKERS)
+      num_workers = STATE_MANAGER_MAX_WORKERS;
+
+   state->find_change  = state_manager_get_find_change();
+   state->numblocks    = (state->blocksize + STATE_MANAGER_BLOCK_SIZE - 1)
+      / STATE_MANAGER_BLOCK_SIZE;
+   if (num_workers > state->numblocks)
+      num_workers = (unsigned)state->numblocks;
+#ifndef HAVE_THREADS
+   num_workers         = 1;
+#endif
+
+   state->maxcompsize  = sizeof(uint32_t) + state->numblocks *
+      block_maxcompsize + sizeof(size_t) * 2;
+   state->hashes       = (uint64_t*)calloc(state->numblocks,
+         sizeof(*state->hashes));
+   state->hashes_valid = (uint8_t*)calloc(state->numblocks,
+         sizeof(*state->hashes_valid));
+
+   if (!state->hashes || !state->hashes_valid)
+      return false;
+
+   state->num_workers  = num_workers;
+
+   for (i = 0; i < num_workers; i++)
+   {
+      struct state_manager_worker *worker = &state->workers[i];
+
+      worker->state   = state;
+      worker->first   = state->numblocks * i / num_workers;
+      worker->last    = state->numblocks * (i + 1) / num_workers;
+      worker->scratch = (uint8_t*)malloc(
+            (worker->last - worker->first) * block_maxcompsize);
+
+      if (!worker->scratch)
+         return false;
+   }
+
+#ifdef HAVE_THREADS
+   state->lock      = slock_new();
+   state->cond_work = scond_new();
+   state->cond_done = scond_new();
+
+   if (!state->lock || !state->cond_work || !state->cond_done)
+      return false;
+
+   for (i = 0; i < num_workers; i++)
+   {
+      state->workers[i].thread = sthread_create(
+            state_manager_worker_thread, &state->workers[i]);
+      if (!state->workers[i].thread)
+         return false;
+   }
+#endif
+
+   RARCH_LOG("[Rewind]: Blocked engine, %u blocks of %u KB, %u worker(s).\n",
+         (unsigned)state->numblocks,
+         (unsigned)(STATE_MANAGER_BLOCK_SIZE / 1024),
+         num_workers);
+
+   return true;
+}
+
 static void state_manager_free(state_manager_t *state)
 {
    if (!state)
       return;
 
+   if (state->engine == STATE_MANAGER_ENGINE_BLOCKED)
+      state_manager_blocked_free(state);
+
    if (state->data)
       free(state->data);
    if (state->thisblock)
@@ -430,7 +1257,8 @@ static void state_manager_free(state_manager_t *state)
    state->nextblock  = NULL;
 }
 
-static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
+static state_manager_t *state_manager_new(size_t state_size,
+      size_t buffer_size, enum state_manager_engine engine)
 {
    size_t max_comp_size, block_size;
    uint8_t *next_block    = NULL;
@@ -462,6 +1290,7 @@ static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    state->thisblock   = this_block;
    state->nextblock   = next_block;
    state->capacity    = buffer_size;
+   state->engine      = engine;
 
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
@@ -471,11 +1300,17 @@ static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    state->debugblock  = (uint8_t*)malloc(state_size);
 #endif
 
+   if (engine == STATE_MANAGER_ENGINE_BLOCKED)
+      if (!state_manager_blocked_init(state))
+         goto error_free;
+
    return state;
 
 error:
    if (state_data)
       free(state_data);
+   state->data = NULL;
+error_free:
    state_manager_free(state);
    free(state);
 
@@ -490,6 +1325,9 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
 
    *data = NULL;
 
+   if (state->engine == STATE_MANAGER_ENGINE_BLOCKED)
+      state_manager_blocked_join(state);
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid = false;
@@ -508,15 +1346,23 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
    compressed = state->data + start + sizeof(size_t);
    out = state->thisblock;
 
-   state_manager_raw_decompress(compressed,
-         state->maxcompsize, out, state->blocksize);
+   if (state->engine == STATE_MANAGER_ENGINE_BLOCKED)
+      state_manager_blocked_decompress(state, compressed);
+   else
+      state_manager_raw_decompress(compressed,
+            state->maxcompsize, out, state->blocksize);
 
    state->entries--;
+   state->frame--;
    return true;
 }
 
 static void state_manager_push_where(state_manager_t *state, void **data)
 {
+   /* The workers may still be reading nextblock. */
+   if (state->engine == STATE_MANAGER_ENGINE_BLOCKED)
+      state_manager_blocked_join(state);
+
    /* We need to ensure we have an uncompressed copy of the last
     * pushed state, or we could end up applying a 'patch' to wrong
     * savestate, and that'd blow up rather quickly. */
@@ -547,52 +1393,406 @@ static void state_manager_push_do(state_manager_t *state)
 
    if (state->thisblock_valid)
    {
-      const uint8_t *oldb, *newb;
-      uint8_t *compressed;
-      size_t headpos, tailpos, remaining;
       if (state->capacity < sizeof(size_t) + state->maxcompsize)
          return;
 
-recheckcapacity:;
+      state->pushes++;
+      state->bytes_raw += state->blocksize;
 
-      headpos = state->head - state->data;
-      tailpos = state->tail - state->data;
-      remaining = (tailpos + state->capacity -
-            sizeof(size_t) - headpos - 1) % state->capacity + 1;
-
-      if (remaining <= state->maxcompsize)
+      if (state->engine == STATE_MANAGER_ENGINE_BLOCKED)
       {
-         state->tail = state->data + read_size_t(state->tail);
-         state->entries--;
-         goto recheckcapacity;
+         /* Compressed in the background, the frame is committed
+          * by the next push or pop. */
+         state->job_old = state->thisblock;
+         state->job_new = state->nextblock;
+         state_manager_blocked_dispatch(state);
       }
+      else
+      {
+         uint8_t *compressed = state_manager_ring_begin(state);
 
-      oldb        = state->thisblock;
-      newb        = state->nextblock;
-      compressed  = state->head + sizeof(size_t);
-
-      compressed += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
+         compressed         += state_manager_raw_compress(
+               state->thisblock, state->nextblock,
+               state->blocksize, compressed);
 
-      if (compressed - state->data + state->maxcompsize > state->capacity)
-      {
-         compressed = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         state_manager_ring_end(state, compressed);
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head = compressed;
    }
    else
+   {
+      /* Nothing to compress against, nextblock simply takes over. */
+      state_manager_blocked_invalidate(state);
       state->thisblock_valid = true;
+   }
 
    swap             = state->thisblock;
    state->thisblock = state->nextblock;
    state->nextblock = swap;
 
    state->entries++;
+   state->frame++;
+}
+
+static void state_manager_tiers_free(struct state_manager_tiers *tiers)
+{
+   size_t i;
+
+   if (!tiers)
+      return;
+
+#ifdef HAVE_THREADS
+   if (tiers->thread)
+   {
+      slock_lock(tiers->lock);
+      tiers->quit = true;
+      scond_signal(tiers->cond_work);
+      slock_unlock(tiers->lock);
+      sthread_join(tiers->thread);
+   }
+   if (tiers->cond_work)
+      scond_free(tiers->cond_work);
+   if (tiers->cond_done)
+      scond_free(tiers->cond_done);
+   if (tiers->lock)
+      slock_free(tiers->lock);
+   if (tiers->pending)
+      free(tiers->pending);
+#endif
+
+   for (i = 0; i < tiers->count; i++)
+      if (tiers->keyframes[i].data)
+         free(tiers->keyframes[i].data);
+
+   if (tiers->spill_map)
+      filestream_close(tiers->spill_map);
+   if (tiers->spill)
+   {
+      filestream_close(tiers->spill);
+      filestream_delete(tiers->spill_path);
+   }
+   if (tiers->deflate_stream)
+      tiers->deflate_backend->stream_free(tiers->deflate_stream);
+   if (tiers->inflate_stream)
+      tiers->inflate_backend->stream_free(tiers->inflate_stream);
+
+   if (tiers->keyframes)
+      free(tiers->keyframes);
+   if (tiers->scratch)
+      free(tiers->scratch);
+   if (tiers->state)
+      free(tiers->state);
+   free(tiers);
+}
+
+/* Moves the oldest keyframes out of RAM until the warm tier fits
+ * in its budget again. */
+static void state_manager_tiers_evict(struct state_manager_tiers *tiers)
+{
+   while (tiers->warm_size > tiers->warm_capacity &&
+         tiers->first_warm < tiers->count)
+   {
+      struct state_manager_keyframe *keyframe =
+         &tiers->keyframes[tiers->first_warm];
+
+      if (tiers->spill &&
+            filestream_seek(tiers->spill, tiers->spill_size,
+               RETRO_VFS_SEEK_POSITION_START) == 0 &&
+            filestream_write(tiers->spill, keyframe->data,
+               keyframe->size) == (int64_t)keyframe->size)
+      {
+         keyframe->offset  = tiers->spill_size;
+         tiers->spill_size += keyframe->size;
+         tiers->spill_dirty = true;
+         tiers->warm_size  -= keyframe->size;
+         free(keyframe->data);
+         keyframe->data    = NULL;
+         tiers->first_warm++;
+         continue;
+      }
+
+      /* No cold tier, the oldest keyframe is gone for good. */
+      tiers->warm_size -= keyframe->size;
+      free(keyframe->data);
+      tiers->count--;
+      memmove(keyframe, keyframe + 1,
+            (tiers->count - tiers->first_warm) * sizeof(*keyframe));
+   }
+}
+
+/* Compresses a keyframe and appends it to the warm tier. */
+static void state_manager_tiers_store(struct state_manager_tiers *tiers,
+      uint64_t frame, const uint8_t *data)
+{
+   uint32_t rd, wn;
+   uint8_t *copy = NULL;
+   struct state_manager_keyframe *keyframe;
+
+   if (tiers->count == tiers->capacity)
+   {
+      size_t new_capacity = tiers->capacity ? tiers->capacity * 2 : 64;
+      struct state_manager_keyframe *keyframes =
+         (struct state_manager_keyframe*)realloc(tiers->keyframes,
+               new_capacity * sizeof(*keyframes));
+
+      if (!keyframes)
+         return;
+
+      tiers->keyframes = keyframes;
+      tiers->capacity  = new_capacity;
+   }
+
+   tiers->deflate_backend->set_in(tiers->deflate_stream,
+         data, (uint32_t)tiers->state_size);
+   tiers->deflate_backend->set_out(tiers->deflate_stream,
+         tiers->scratch, (uint32_t)tiers->scratch_size);
+
+   if (!tiers->deflate_backend->trans(tiers->deflate_stream,
+            true, &rd, &wn, NULL))
+      return;
+
+   copy = (uint8_t*)malloc(wn);
+   if (!copy)
+      return;
+   memcpy(copy, tiers->scratch, wn);
+
+   keyframe          = &tiers->keyframes[tiers->count++];
+   keyframe->frame   = frame;
+   keyframe->data    = copy;
+   keyframe->size    = wn;
+   keyframe->offset  = -1;
+   tiers->warm_size += wn;
+
+   state_manager_tiers_evict(tiers);
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_tiers_thread(void *data)
+{
+   struct state_manager_tiers *tiers = (struct state_manager_tiers*)data;
+
+   for (;;)
+   {
+      slock_lock(tiers->lock);
+      while (!tiers->quit && !tiers->busy)
+         scond_wait(tiers->cond_work, tiers->lock);
+
+      if (tiers->quit)
+      {
+         slock_unlock(tiers->lock);
+         break;
+      }
+      slock_unlock(tiers->lock);
+
+      state_manager_tiers_store(tiers,
+            tiers->pending_frame, tiers->pending);
+
+      slock_lock(tiers->lock);
+      tiers->busy = false;
+      scond_signal(tiers->cond_done);
+      slock_unlock(tiers->lock);
+   }
+}
+#endif
+
+/* Waits for the keyframe handed to the worker by the last push.
+ * Must be called before the keyframes are touched again. */
+static void state_manager_tiers_join(struct state_manager_tiers *tiers)
+{
+#ifdef HAVE_THREADS
+   if (tiers->thread)
+   {
+      slock_lock(tiers->lock);
+      while (tiers->busy)
+         scond_wait(tiers->cond_done, tiers->lock);
+      slock_unlock(tiers->lock);
+   }
+#endif
+}
+
+static void state_manager_tiers_push(struct state_manager_tiers *tiers,
+      uint64_t frame, const uint8_t *data)
+{
+   if (frame % tiers->interval)
+      return;
+
+   state_manager_tiers_join(tiers);
+
+   /* The ring could not store the last frame. */
+   if (tiers->count && tiers->keyframes[tiers->count - 1].frame >= frame)
+      return;
+
+#ifdef HAVE_THREADS
+   if (tiers->thread)
+   {
+      memcpy(tiers->pending, data, tiers->state_size);
+
+      slock_lock(tiers->lock);
+      tiers->pending_frame = frame;
+      tiers->busy          = true;
+      scond_signal(tiers->cond_work);
+      slock_unlock(tiers->lock);
+      return;
+   }
+#endif
+
+   state_manager_tiers_store(tiers, frame, data);
+}
+
+static struct state_manager_tiers *state_manager_tiers_new(
+      size_t state_size, unsigned interval,
+      size_t warm_capacity, const char *spill_path)
+{
+   struct state_manager_tiers *tiers = (struct state_manager_tiers*)
+      calloc(1, sizeof(*tiers));
+
+   if (!tiers)
+      return NULL;
+
+   tiers->interval        = interval;
+   tiers->warm_capacity   = warm_capacity;
+   tiers->state_size      = state_size;
+   /* Room for incompressible data. */
+   tiers->scratch_size    = state_size + (state_size >> 8) + 64;
+   tiers->scratch         = (uint8_t*)malloc(tiers->scratch_size);
+   tiers->state           = (uint8_t*)malloc(state_size);
+
+   tiers->deflate_backend = trans_stream_get_zlib_deflate_backend();
+   if (!tiers->deflate_backend)
+      tiers->deflate_backend = trans_stream_get_pipe_backend();
+   tiers->inflate_backend = tiers->deflate_backend->reverse;
+
+   tiers->deflate_stream  = tiers->deflate_backend->stream_new();
+   tiers->inflate_stream  = tiers->inflate_backend->stream_new();
+
+   if (!tiers->scratch || !tiers->state ||
+       !tiers->deflate_stream || !tiers->inflate_stream)
+      goto error;
+
+   /* Keyframes are taken while the game runs, favour speed. */
+   if (tiers->deflate_backend->define)
+      tiers->deflate_backend->define(tiers->deflate_stream, "level", 1);
+
+   if (!string_is_empty(spill_path))
+   {
+      strlcpy(tiers->spill_path, spill_path, sizeof(tiers->spill_path));
+      tiers->spill = filestream_open(spill_path,
+            RETRO_VFS_FILE_ACCESS_READ_WRITE,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (tiers->spill)
+         RARCH_LOG("[Rewind]: Spilling old keyframes to \"%s\".\n",
+               spill_path);
+      else
+         RARCH_WARN("[Rewind]: Could not open \"%s\", old keyframes "
+               "will be discarded.\n", spill_path);
+   }
+
+#ifdef HAVE_THREADS
+   /* Compressed inline if the worker can't be started. */
+   tiers->pending   = (uint8_t*)malloc(state_size);
+   tiers->lock      = slock_new();
+   tiers->cond_work = scond_new();
+   tiers->cond_done = scond_new();
+
+   if (tiers->pending && tiers->lock &&
+         tiers->cond_work && tiers->cond_done)
+      tiers->thread = sthread_create(state_manager_tiers_thread, tiers);
+#endif
+
+   return tiers;
+
+error:
+   state_manager_tiers_free(tiers);
+   return NULL;
+}
+
+/* Forgets keyframes newer than 'frame', history
+ * is rewritten from there on. */
+static void state_manager_tiers_truncate(struct state_manager_tiers *tiers,
+      uint64_t frame)
+{
+   state_manager_tiers_join(tiers);
+
+   while (tiers->count && tiers->keyframes[tiers->count - 1].frame > frame)
+   {
+      struct state_manager_keyframe *keyframe =
+         &tiers->keyframes[--tiers->count];
+
+      if (keyframe->data)
+      {
+         tiers->warm_size -= keyframe->size;
+         free(keyframe->data);
+      }
+      else
+         tiers->spill_size = keyframe->offset;
+   }
+
+   if (tiers->first_warm > tiers->count)
+      tiers->first_warm = tiers->count;
+}
+
+static const uint8_t *state_manager_tiers_read_spill(
+      struct state_manager_tiers *tiers,
+      const struct state_manager_keyframe *keyframe)
+{
+   if (!tiers->spill)
+      return NULL;
+
+   if (!tiers->spill_map || tiers->spill_dirty)
+   {
+      if (tiers->spill_map)
+         filestream_close(tiers->spill_map);
+      filestream_flush(tiers->spill);
+      tiers->spill_map   = filestream_open(tiers->spill_path,
+            RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS);
+      tiers->spill_dirty = false;
+   }
+
+   if (!tiers->spill_map || keyframe->size > tiers->scratch_size)
+      return NULL;
+
+   if (filestream_seek(tiers->spill_map, keyframe->offset,
+            RETRO_VFS_SEEK_POSITION_START) != 0 ||
+         filestream_read(tiers->spill_map, tiers->scratch,
+            keyframe->size) != (int64_t)keyframe->size)
+      return NULL;
+
+   return tiers->scratch;
+}
+
+/* Called once the delta ring is exhausted at 'frame'. Decodes the
+ * newest older keyframe into tiers->state and forgets it. */
+static bool state_manager_tiers_pop(struct state_manager_tiers *tiers,
+      uint64_t frame, uint64_t *keyframe_frame)
+{
+   uint32_t rd, wn;
+   bool ret = false;
+   const uint8_t *data;
+   struct state_manager_keyframe *keyframe;
+
+   state_manager_tiers_truncate(tiers, frame ? frame - 1 : 0);
+
+   if (!tiers->count)
+      return false;
+
+   keyframe = &tiers->keyframes[tiers->count - 1];
+   data     = keyframe->data
+      ? keyframe->data : state_manager_tiers_read_spill(tiers, keyframe);
+
+   if (data)
+   {
+      tiers->inflate_backend->set_in(tiers->inflate_stream,
+            data, (uint32_t)keyframe->size);
+      tiers->inflate_backend->set_out(tiers->inflate_stream,
+            tiers->state, (uint32_t)tiers->state_size);
+      ret = tiers->inflate_backend->trans(tiers->inflate_stream,
+            true, &rd, &wn, NULL) && wn == tiers->state_size;
+   }
+
+   *keyframe_frame = keyframe->frame;
+   state_manager_tiers_truncate(tiers, keyframe->frame - 1);
+   return ret;
 }
 
 #if 0
@@ -613,11 +1813,51 @@ static void state_manager_capacity(state_manager_t *state,
 }
 #endif
 
-void state_manager_event_init(unsigned rewind_buffer_size)
+static void state_manager_push_keyframe(void)
+{
+   if (rewind_state.tiers)
+      state_manager_tiers_push(rewind_state.tiers,
+            rewind_state.state->frame, rewind_state.state->thisblock);
+}
+
+/* Falls back to the keyframes once the delta ring is exhausted. */
+static bool state_manager_pop_keyframe(const void **data)
+{
+   struct state_manager_tiers *tiers = rewind_state.tiers;
+
+   if (!tiers)
+      return false;
+
+   state_manager_tiers_join(tiers);
+
+   while (tiers->count)
+   {
+      uint64_t frame;
+
+      if (state_manager_tiers_pop(tiers,
+               rewind_state.state->frame, &frame))
+      {
+         /* The core goes back to the keyframe, which thisblock
+          * knows nothing about. */
+         rewind_state.state->thisblock_valid = false;
+         state_manager_blocked_invalidate(rewind_state.state);
+         rewind_state.state->frame = frame;
+         *data                     = tiers->state;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void state_manager_event_init(unsigned rewind_buffer_size,
+      const char *rewind_engine, unsigned keyframe_interval,
+      size_t keyframe_buffer_size, const char *spill_path)
 {
    retro_ctx_serialize_info_t serial_info;
    retro_ctx_size_info_t info;
-   void *state          = NULL;
+   void *state                      = NULL;
+   enum state_manager_engine engine = STATE_MANAGER_ENGINE_LEGACY;
 
    if (rewind_state.state)
       return;
@@ -643,11 +1883,28 @@ void state_manager_event_init(unsigned rewind_buffer_size)
          msg_hash_to_str(MSG_REWIND_INIT),
          (unsigned)(rewind_buffer_size / 1000000));
 
+   if (string_is_equal(rewind_engine, "blocked"))
+      engine = STATE_MANAGER_ENGINE_BLOCKED;
+
    rewind_state.state = state_manager_new(rewind_state.size,
-         rewind_buffer_size);
+         rewind_buffer_size, engine);
 
    if (!rewind_state.state)
+   {
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
+      return;
+   }
+
+   if (keyframe_interval)
+   {
+      rewind_state.tiers = state_manager_tiers_new(rewind_state.size,
+            keyframe_interval, keyframe_buffer_size, spill_path);
+
+      if (rewind_state.tiers)
+         RARCH_LOG("[Rewind]: Keyframe every %u frames, %u MB in RAM.\n",
+               keyframe_interval,
+               (unsigned)(keyframe_buffer_size / 1000000));
+   }
 
    state_manager_push_where(rewind_state.state, &state);
 
@@ -657,6 +1914,7 @@ void state_manager_event_init(unsigned rewind_buffer_size)
    core_serialize(&serial_info);
 
    state_manager_push_do(rewind_state.state);
+   state_manager_push_keyframe();
 }
 
 bool state_manager_frame_is_reversed(void)
@@ -668,10 +1926,38 @@ void state_manager_event_deinit(void)
 {
    if (rewind_state.state)
    {
+      state_manager_t *state = rewind_state.state;
+
+      if (state->pushes)
+         RARCH_LOG("[Rewind]: %s engine, %u frames pushed, "
+               "%.2f%% of the raw state size on average.\n",
+               state->engine == STATE_MANAGER_ENGINE_BLOCKED
+               ? "Blocked" : "Legacy",
+               (unsigned)state->pushes,
+               100.0 * (double)state->bytes_compressed
+               / (double)state->bytes_raw);
+
       state_manager_free(rewind_state.state);
       free(rewind_state.state);
    }
+
+   if (rewind_state.tiers)
+   {
+      struct state_manager_tiers *tiers = rewind_state.tiers;
+
+      state_manager_tiers_join(tiers);
+
+      RARCH_LOG("[Rewind]: %u keyframes in RAM (%u KB), %u on disk (%u KB).\n",
+            (unsigned)(tiers->count - tiers->first_warm),
+            (unsigned)(tiers->warm_size / 1024),
+            (unsigned)tiers->first_warm,
+            (unsigned)(tiers->spill_size / 1024));
+
+      state_manager_tiers_free(rewind_state.tiers);
+   }
+
    rewind_state.state = NULL;
+   rewind_state.tiers = NULL;
    rewind_state.size  = 0;
 }
 
@@ -687,6 +1973,7 @@ bool state_manager_check_rewind(bool pressed,
 {
    bool ret             = false;
    static bool first    = true;
+   bool is_perfcnt_enable = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
 #ifdef HAVE_NETWORKING
    bool was_reversed    = false;
 #endif
@@ -711,9 +1998,23 @@ bool state_manager_check_rewind(bool pressed,
 
    if (pressed)
    {
+      bool popped;
       const void *buf    = NULL;
 
-      if (state_manager_pop(rewind_state.state, &buf))
+      performance_counter_init(state_manager_pop_perf, "state_manager_pop");
+      performance_counter_start_plus(is_perfcnt_enable, state_manager_pop_perf);
+      popped = state_manager_pop(rewind_state.state, &buf);
+      if (popped)
+      {
+         if (rewind_state.tiers)
+            state_manager_tiers_truncate(rewind_state.tiers,
+                  rewind_state.state->frame);
+      }
+      else
+         popped = state_manager_pop_keyframe(&buf);
+      performance_counter_stop_plus(is_perfcnt_enable, state_manager_pop_perf);
+
+      if (popped)
       {
          retro_ctx_serialize_info_t serial_info;
 
@@ -779,14 +2080,21 @@ bool state_manager_check_rewind(bool pressed,
          retro_ctx_serialize_info_t serial_info;
          void *state = NULL;
 
+         performance_counter_init(state_manager_push_where_perf, "state_manager_push_where");
+         performance_counter_start_plus(is_perfcnt_enable, state_manager_push_where_perf);
          state_manager_push_where(rewind_state.state, &state);
+         performance_counter_stop_plus(is_perfcnt_enable, state_manager_push_where_perf);
 
          serial_info.data = state;
          serial_info.size = rewind_state.size;
 
          core_serialize(&serial_info);
 
+         performance_counter_init(state_manager_push_do_perf, "state_manager_push_do");
+         performance_counter_start_plus(is_perfcnt_enable, state_manager_push_do_perf);
          state_manager_push_do(rewind_state.state);
+         state_manager_push_keyframe();
+         performance_counter_stop_plus(is_perfcnt_enable, state_manager_push_do_perf);
       }
    }
 
@@ -32,7 +32,18 @@ bool state_manager_frame_is_reversed(void);
 
 void state_manager_event_deinit(void);
 
-void state_manager_event_init(unsigned rewind_buffer_size);
+/**
+ * state_manager_event_init:
+ * @rewind_buffer_size   : size of the in-RAM delta ring, in bytes.
+ * @rewind_engine        : "legacy" or "blocked".
+ * @keyframe_interval    : frames between two keyframes, 0 disables them.
+ * @keyframe_buffer_size : RAM budget for keyframes, in bytes.
+ * @spill_path           : file receiving the keyframes that no longer fit
+ *                         in RAM, NULL to discard them instead.
+ **/
+void state_manager_event_init(unsigned rewind_buffer_size,
+      const char *rewind_engine, unsigned keyframe_interval,
+      size_t keyframe_buffer_size, const char *spill_path);
 
 /**
  * check_rewind:
@@ -44,6 +55,47 @@ bool state_manager_check_rewind(bool pressed,
       unsigned rewind_granularity, bool is_paused,
       char *s, size_t len, unsigned *time);
 
+/**
+ * state_manager_delta_maxsize:
+ * @len                  : size of the savestates.
+ *
+ * Returns the largest patch state_manager_delta_compress() can write.
+ **/
+size_t state_manager_delta_maxsize(size_t len);
+
+/**
+ * state_manager_delta_compress:
+ * @base                 : the savestate the other side already has.
+ * @state                : the savestate it should end up with.
+ * @len                  : size of both savestates.
+ * @patch                : buffer of state_manager_delta_maxsize(@len) bytes.
+ *
+ * Creates a patch turning @base into @state, made of the same per-block
+ * records the 'blocked' rewind engine stores. Unchanged blocks cost nothing.
+ *
+ * Returns the number of bytes written to @patch.
+ **/
+size_t state_manager_delta_compress(const void *base, const void *state,
+      size_t len, void *patch);
+
+/**
+ * state_manager_delta_apply:
+ * @patch                : patch from state_manager_delta_compress().
+ * @patch_len            : size of @patch.
+ * @data                 : holds the base savestate, receives the new one.
+ *                         NULL to only check the patch.
+ * @len                  : size of @data.
+ *
+ * The patch may come from an untrusted source, it is checked against
+ * @len before anything is written outside of @data. It is not checked
+ * against the base, though, and a malformed one can leave @data half
+ * patched, so check it first when that matters.
+ *
+ * Returns false if the patch is malformed.
+ **/
+bool state_manager_delta_apply(const void *patch, size_t patch_len,
+      void *data, size_t len);
+
 RETRO_END_DECLS
 
 #endif
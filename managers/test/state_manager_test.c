@@ -0,0 +1,247 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2019 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Drives the rewind code through state_manager_check_rewind, against a
+ * fake core whose savestate is a plain buffer, and checks that every
+ * rewound state comes back byte-exact. */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../state_manager.c"
+
+/* Three blocks of the 'blocked' engine and a bit. Block 0 never
+ * changes unless a test says so, the others change every frame. */
+#define TEST_STATE_SIZE (3 * STATE_MANAGER_BLOCK_SIZE + 100)
+#define TEST_MAX_FRAMES 64
+
+static uint8_t core_state[TEST_STATE_SIZE];
+static uint8_t history[TEST_MAX_FRAMES][TEST_STATE_SIZE];
+static unsigned history_count;
+static unsigned failures;
+
+/* Fake frontend */
+
+bool core_serialize_size(retro_ctx_size_info_t *info)
+{
+   info->size = TEST_STATE_SIZE;
+   return true;
+}
+
+bool core_serialize(retro_ctx_serialize_info_t *info)
+{
+   memcpy(info->data, core_state, TEST_STATE_SIZE);
+   return true;
+}
+
+bool core_unserialize(retro_ctx_serialize_info_t *info)
+{
+   memcpy(core_state, info->data_const, TEST_STATE_SIZE);
+   return true;
+}
+
+bool core_set_rewind_callbacks(void) { return true; }
+bool rarch_ctl(enum rarch_ctl_state state, void *data) { return false; }
+bool bsv_movie_ctl(enum bsv_ctl_state state, void *data) { return false; }
+void audio_driver_setup_rewind(void) { }
+void audio_driver_frame_is_reverse(void) { }
+bool audio_driver_has_callback(void) { return false; }
+const char *msg_hash_to_str(enum msg_hash_enums msg) { return ""; }
+void rarch_perf_register(struct retro_perf_counter *perf) { }
+
+void RARCH_LOG(const char *fmt, ...) { }
+void RARCH_WARN(const char *fmt, ...) { }
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+/* Helpers */
+
+static void fill_block(unsigned block, unsigned seed)
+{
+   size_t i;
+   size_t offset = (size_t)block * STATE_MANAGER_BLOCK_SIZE;
+   size_t len    = MIN(STATE_MANAGER_BLOCK_SIZE, TEST_STATE_SIZE - offset);
+
+   for (i = 0; i < len; i++)
+      core_state[offset + i] = (uint8_t)((seed * 2654435761u + i * 40503u)
+            >> 13);
+}
+
+/* Runs a frame: the core moves on, and the frontend pushes it. */
+static void run_frame(unsigned seed)
+{
+   char msg[64];
+   unsigned time;
+
+   fill_block(1, seed);
+   fill_block(2, seed + 1000);
+   fill_block(3, seed + 2000);
+
+   state_manager_check_rewind(false, 1, false, msg, sizeof(msg), &time);
+
+   memcpy(history[history_count++], core_state, TEST_STATE_SIZE);
+}
+
+/* Pushes the current state as is. */
+static void push_frame(void)
+{
+   char msg[64];
+   unsigned time;
+
+   state_manager_check_rewind(false, 1, false, msg, sizeof(msg), &time);
+   memcpy(history[history_count++], core_state, TEST_STATE_SIZE);
+}
+
+static unsigned find_history(void)
+{
+   unsigned i;
+
+   for (i = history_count; i-- > 0; )
+      if (!memcmp(history[i], core_state, TEST_STATE_SIZE))
+         return i;
+   return (unsigned)-1;
+}
+
+/* Rewinds until neither the ring nor the keyframes have anything older,
+ * checking that each state is one pushed before, going back in time.
+ * Returns how many states were rewound. */
+static unsigned rewind_to_end(const char *test)
+{
+   char msg[64];
+   unsigned time;
+   unsigned count = 0;
+   unsigned last  = history_count;
+
+   for (;;)
+   {
+      unsigned index;
+      bool popped;
+
+      /* Same check state_manager_check_rewind does, to see the end
+       * coming: it restores the oldest state again from there on.
+       * The last keyframe may still be with the worker. */
+      if (rewind_state.tiers)
+         state_manager_tiers_join(rewind_state.tiers);
+      popped = rewind_state.state->thisblock_valid ||
+         rewind_state.state->head != rewind_state.state->tail ||
+         (rewind_state.tiers && rewind_state.tiers->count);
+
+      state_manager_check_rewind(true, 1, false, msg, sizeof(msg), &time);
+
+      index = find_history();
+      if (index == (unsigned)-1 || (popped && index >= last))
+      {
+         printf("%s: rewind %u restored a state that was never pushed "
+               "or not an older one.\n", test, count);
+         failures++;
+         return count;
+      }
+
+      if (!popped)
+         break;
+
+      last = index;
+      count++;
+   }
+
+   /* History is rewritten from here on */
+   history_count = last + 1;
+   return count;
+}
+
+static void check_rewind_once(const char *test, unsigned expected)
+{
+   char msg[64];
+   unsigned time;
+
+   state_manager_check_rewind(true, 1, false, msg, sizeof(msg), &time);
+
+   if (memcmp(core_state, history[expected], TEST_STATE_SIZE))
+   {
+      printf("%s: rewinding to state %u was not byte-exact.\n",
+            test, expected);
+      failures++;
+   }
+}
+
+/* After the ring is emptied, the first push swaps in a new thisblock.
+ * Block 0 is then set and cleared again, and clearing it has to be
+ * recorded even though the hash of the cleared block is the one the
+ * old thisblock had. */
+static void test_push_after_empty(const char *test,
+      unsigned ring_size, unsigned keyframe_interval, unsigned frames)
+{
+   unsigned i, first;
+
+   memset(core_state, 0, sizeof(core_state));
+   history_count = 0;
+
+   state_manager_event_init(ring_size, "blocked", keyframe_interval,
+         64 * 1024 * 1024, NULL);
+   memcpy(history[history_count++], core_state, TEST_STATE_SIZE);
+
+   for (i = 1; i < frames; i++)
+      run_frame(i);
+
+   if (!rewind_to_end(test))
+   {
+      printf("%s: nothing could be rewound.\n", test);
+      failures++;
+   }
+
+   first = history_count;
+
+   fill_block(0, 12345);
+   push_frame();
+   memset(core_state, 0, STATE_MANAGER_BLOCK_SIZE);
+   push_frame();
+
+   /* The newest state first, then the one with block 0 set */
+   check_rewind_once(test, first + 1);
+   check_rewind_once(test, first);
+
+   state_manager_event_deinit();
+}
+
+int main(void)
+{
+   char msg[64];
+   unsigned time;
+
+   /* The first call only primes the rewind check */
+   state_manager_check_rewind(false, 1, false, msg, sizeof(msg), &time);
+
+   /* Rewinding until the delta ring is empty */
+   test_push_after_empty("ring", 16 * 1024 * 1024, 0, 8);
+
+   /* The ring only holds a few frames, the rest comes from keyframes */
+   test_push_after_empty("keyframes", 200 * 1024, 4, 40);
+
+   if (failures)
+   {
+      printf("%u failure(s).\n", failures);
+      return 1;
+   }
+
+   printf("All rewinds were byte-exact.\n");
+   return 0;
+}
@@ -170,6 +170,7 @@ default_sublabel_macro(action_bind_sublabel_input_bind_hold,               MENU_
 default_sublabel_macro(action_bind_sublabel_audio_volume,                  MENU_ENUM_SUBLABEL_AUDIO_VOLUME)
 default_sublabel_macro(action_bind_sublabel_audio_mixer_volume,            MENU_ENUM_SUBLABEL_AUDIO_MIXER_VOLUME)
 default_sublabel_macro(action_bind_sublabel_audio_sync,                    MENU_ENUM_SUBLABEL_AUDIO_SYNC)
+default_sublabel_macro(action_bind_sublabel_audio_pipeline,                MENU_ENUM_SUBLABEL_AUDIO_PIPELINE)
 default_sublabel_macro(action_bind_sublabel_axis_threshold,                MENU_ENUM_SUBLABEL_INPUT_BUTTON_AXIS_THRESHOLD)
 default_sublabel_macro(action_bind_sublabel_input_turbo_period,            MENU_ENUM_SUBLABEL_INPUT_TURBO_PERIOD)
 default_sublabel_macro(action_bind_sublabel_input_duty_cycle,              MENU_ENUM_SUBLABEL_INPUT_DUTY_CYCLE)
@@ -231,6 +232,7 @@ default_sublabel_macro(action_bind_sublabel_vrr_runloop_enable,            MENU_
 default_sublabel_macro(action_bind_sublabel_slowmotion_ratio,              MENU_ENUM_SUBLABEL_SLOWMOTION_RATIO)
 default_sublabel_macro(action_bind_sublabel_run_ahead_enabled,             MENU_ENUM_SUBLABEL_RUN_AHEAD_ENABLED)
 default_sublabel_macro(action_bind_sublabel_run_ahead_secondary_instance,  MENU_ENUM_SUBLABEL_RUN_AHEAD_SECONDARY_INSTANCE)
+default_sublabel_macro(action_bind_sublabel_run_ahead_skip_reload,         MENU_ENUM_SUBLABEL_RUN_AHEAD_SKIP_RELOAD)
 default_sublabel_macro(action_bind_sublabel_run_ahead_hide_warnings,       MENU_ENUM_SUBLABEL_RUN_AHEAD_HIDE_WARNINGS)
 default_sublabel_macro(action_bind_sublabel_run_ahead_frames,              MENU_ENUM_SUBLABEL_RUN_AHEAD_FRAMES)
 default_sublabel_macro(action_bind_sublabel_input_block_timeout,           MENU_ENUM_SUBLABEL_INPUT_BLOCK_TIMEOUT)
@@ -1890,6 +1892,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_secondary_instance);
             break;
+         case MENU_ENUM_LABEL_RUN_AHEAD_SKIP_RELOAD:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_skip_reload);
+            break;
          case MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_hide_warnings);
             break;
@@ -2073,6 +2078,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_AUDIO_SYNC:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_sync);
             break;
+         case MENU_ENUM_LABEL_AUDIO_PIPELINE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_pipeline);
+            break;
          case MENU_ENUM_LABEL_AUDIO_VOLUME:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_volume);
             break;
@@ -128,7 +128,7 @@ static int menu_displaylist_parse_core_info(menu_displaylist_info_t *info)
 
    core_info_get_current_core(&core_info);
 
-   if (!core_info || !core_info->config_data)
+   if (!core_info || !core_info->has_info)
    {
       menu_entries_append_enum(info->list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO_CORE_INFORMATION_AVAILABLE),
@@ -2131,7 +2131,7 @@ static int menu_displaylist_parse_information_list(
           !string_is_equal(system->library_name,
              msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO_CORE))
          )
-         && core_info && core_info->config_data
+         && core_info && core_info->has_info
       )
       menu_entries_append_enum(info->list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_CORE_INFORMATION),
@@ -3842,6 +3842,7 @@ unsigned menu_displaylist_build_list(file_list_t *list, enum menu_displaylist_ct
                {MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,                     PARSE_ONLY_BOOL },
                {MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,                      PARSE_ONLY_UINT },
                {MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE,          PARSE_ONLY_BOOL },
+               {MENU_ENUM_LABEL_RUN_AHEAD_SKIP_RELOAD,                 PARSE_ONLY_BOOL },
                {MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS,               PARSE_ONLY_BOOL },
                {MENU_ENUM_LABEL_INPUT_BLOCK_TIMEOUT,                   PARSE_ONLY_UINT },
             };
@@ -5845,6 +5846,11 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type,
          menu_displaylist_parse_settings_enum(info->list,
                MENU_ENUM_LABEL_AUDIO_SYNC,
                PARSE_ONLY_BOOL, false);
+#ifdef HAVE_THREADS
+         menu_displaylist_parse_settings_enum(info->list,
+               MENU_ENUM_LABEL_AUDIO_PIPELINE,
+               PARSE_ONLY_BOOL, false);
+#endif
          if (menu_displaylist_parse_settings_enum(info->list,
                MENU_ENUM_LABEL_AUDIO_LATENCY,
                PARSE_ONLY_UINT, false) == 0)
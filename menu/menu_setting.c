@@ -9163,6 +9163,24 @@ static bool setting_append_list(
                );
          SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_LAKKA_ADVANCED);
 
+#ifdef HAVE_THREADS
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->bools.audio_pipeline,
+               MENU_ENUM_LABEL_AUDIO_PIPELINE,
+               MENU_ENUM_LABEL_VALUE_AUDIO_PIPELINE,
+               audio_pipeline,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_ADVANCED
+               );
+#endif
+
          CONFIG_UINT(
                list, list_info,
                &settings->uints.audio_latency,
@@ -10200,6 +10218,22 @@ static bool setting_append_list(
                );
 #endif
 
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->bools.run_ahead_skip_reload,
+               MENU_ENUM_LABEL_RUN_AHEAD_SKIP_RELOAD,
+               MENU_ENUM_LABEL_VALUE_RUN_AHEAD_SKIP_RELOAD,
+               run_ahead_skip_reload,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_NONE
+               );
+
          CONFIG_BOOL(
                list, list_info,
                &settings->bools.run_ahead_hide_warnings,
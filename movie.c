@@ -33,6 +33,10 @@
 #include "command.h"
 #include "file_path_special.h"
 
+#ifdef HAVE_RUNAHEAD
+#include "runahead/run_ahead.h"
+#endif
+
 bsv_movie_t     *bsv_movie_state_handle = NULL;
 struct bsv_state bsv_movie_state;
 
@@ -168,6 +172,9 @@ static bool bsv_movie_init_record(bsv_movie_t *handle, const char *path)
       serial_info.data = handle->state;
       serial_info.size = state_size;
 
+#ifdef HAVE_RUNAHEAD
+      runahead_ring_restore();
+#endif
       core_serialize(&serial_info);
 
       intfstream_write(handle->file,
@@ -265,6 +272,9 @@ static void bsv_movie_frame_rewind(bsv_movie_t *handle)
          serial_info.data = handle->state;
          serial_info.size = handle->state_size;
 
+#ifdef HAVE_RUNAHEAD
+         runahead_ring_restore();
+#endif
          core_serialize(&serial_info);
 
          intfstream_write(handle->file, handle->state, handle->state_size);
@@ -1297,6 +1297,7 @@ enum msg_hash_enums
    MENU_LABEL(AUDIO_MUTE),
    MENU_LABEL(AUDIO_MIXER_MUTE),
    MENU_LABEL(AUDIO_SYNC),
+   MENU_LABEL(AUDIO_PIPELINE),
    MENU_LABEL(AUDIO_VOLUME),
    MENU_LABEL(AUDIO_MIXER_VOLUME),
    MENU_LABEL(AUDIO_RATE_CONTROL_DELTA),
@@ -1516,6 +1517,7 @@ enum msg_hash_enums
    MENU_LABEL(SLOWMOTION_RATIO),
    MENU_LABEL(RUN_AHEAD_ENABLED),
    MENU_LABEL(RUN_AHEAD_SECONDARY_INSTANCE),
+   MENU_LABEL(RUN_AHEAD_SKIP_RELOAD),
    MENU_LABEL(RUN_AHEAD_HIDE_WARNINGS),
    MENU_LABEL(RUN_AHEAD_FRAMES),
    MENU_LABEL(INPUT_BLOCK_TIMEOUT),
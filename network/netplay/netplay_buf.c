@@ -14,12 +14,17 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <net/net_compat.h>
 #include <net/net_socket.h>
 
 #include "netplay_private.h"
 
+#if defined(HAVE_NETPLAY_EPOLL) && !defined(DEBUG_NETPLAY_NETSIM)
+#include <sys/uio.h>
+#endif
+
 static size_t buf_used(struct socket_buffer *sbuf)
 {
    if (sbuf->end < sbuf->start)
@@ -180,6 +185,11 @@ bool netplay_send_flush(struct socket_buffer *sbuf, int sockfd, bool block)
    if (buf_used(sbuf) == 0)
       return true;
 
+#ifdef DEBUG_NETPLAY_NETSIM
+   if (!block && netplay_netsim_tcp_hold(sbuf))
+      return true;
+#endif
+
    if (sbuf->end > sbuf->start)
    {
       /* Usual case: Everything's in order */
@@ -235,6 +245,74 @@ bool netplay_send_flush(struct socket_buffer *sbuf, int sockfd, bool block)
    return true;
 }
 
+/**
+ * netplay_send_shared
+ *
+ * Send the given data after anything already queued, without copying it into
+ * the buffer unless it can't all be sent now. For data sent to many
+ * connections at once.
+ *
+ * Returns false only on socket failures, true otherwise.
+ */
+bool netplay_send_shared(struct socket_buffer *sbuf, int sockfd,
+   const void *buf, size_t len)
+{
+#if defined(HAVE_NETPLAY_EPOLL) && !defined(DEBUG_NETPLAY_NETSIM)
+   struct iovec iov[3];
+   struct msghdr msg;
+   size_t used = buf_used(sbuf);
+   size_t iovcnt = 0;
+   ssize_t sent;
+
+   /* Whatever's queued has to go out first */
+   if (sbuf->end > sbuf->start)
+   {
+      iov[iovcnt].iov_base = sbuf->data + sbuf->start;
+      iov[iovcnt++].iov_len = used;
+   }
+   else if (sbuf->end < sbuf->start)
+   {
+      iov[iovcnt].iov_base = sbuf->data + sbuf->start;
+      iov[iovcnt++].iov_len = sbuf->bufsz - sbuf->start;
+      iov[iovcnt].iov_base = sbuf->data;
+      iov[iovcnt++].iov_len = sbuf->end;
+   }
+   iov[iovcnt].iov_base = (void *) buf;
+   iov[iovcnt++].iov_len = len;
+
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov    = iov;
+   msg.msg_iovlen = iovcnt;
+
+   sent = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+   if (sent < 0)
+   {
+      if (!isagain((int) sent))
+         return false;
+      sent = 0;
+   }
+
+   if ((size_t) sent < used)
+   {
+      /* Didn't even get through the queue, so this goes behind it */
+      sbuf->start = (sbuf->start + sent) % sbuf->bufsz;
+      return netplay_send(sbuf, sockfd, buf, len);
+   }
+
+   sbuf->start = sbuf->end = 0;
+   sent -= used;
+   if ((size_t) sent < len)
+      return netplay_send(sbuf, sockfd, (const unsigned char *) buf + sent,
+            len - sent);
+
+   return true;
+#else
+   if (!netplay_send(sbuf, sockfd, buf, len))
+      return false;
+   return netplay_send_flush(sbuf, sockfd, false);
+#endif
+}
+
 /**
  * netplay_recv
  *
@@ -249,7 +327,11 @@ ssize_t netplay_recv(struct socket_buffer *sbuf, int sockfd, void *buf,
    ssize_t recvd;
 
    /* Receive whatever we can into the buffer */
-   if (sbuf->end >= sbuf->start)
+   if (buf_unread(sbuf) >= len)
+   {
+      /* Already have all of it, so don't bother the socket */
+   }
+   else if (sbuf->end >= sbuf->start)
    {
       error = false;
       recvd = socket_receive_all_nonblocking(sockfd, &error,
@@ -354,3 +436,13 @@ void netplay_recv_flush(struct socket_buffer *sbuf)
 {
    sbuf->start = sbuf->read;
 }
+
+/**
+ * netplay_recv_pending
+ *
+ * Is there data in our recv buffer that hasn't been read yet?
+ */
+bool netplay_recv_pending(struct socket_buffer *sbuf)
+{
+   return sbuf->read != sbuf->end;
+}
@@ -19,7 +19,7 @@
 #include <sys/types.h>
 
 #include <boolean.h>
-#include <encodings/crc32.h>
+#include <hash/hash_stream.h>
 
 #include "netplay_private.h"
 
@@ -78,7 +78,7 @@ uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta)
 {
    if (!netplay->state_size)
       return 0;
-   return encoding_crc32(0L, (const unsigned char*)delta->state, netplay->state_size);
+   return hash_crc32(0L, delta->state, netplay->state_size);
 }
 
 /*
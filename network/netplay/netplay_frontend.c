@@ -116,6 +116,24 @@ static bool netplay_can_poll(netplay_t *netplay)
    return netplay->can_poll;
 }
 
+/**
+ * netplay_cpu_time_usec
+ *
+ * CPU time of the calling thread, so that the per-frame netplay
+ * time leaves out the time spent waiting for the network. Falls
+ * back to the wall clock where there is no thread CPU clock.
+ */
+static retro_time_t netplay_cpu_time_usec(void)
+{
+#ifdef NETPLAY_CPU_TIME
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return (retro_time_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+   return cpu_features_get_time_usec();
+#endif
+}
+
 /**
  * get_self_input_state:
  * @netplay              : pointer to netplay object
@@ -195,6 +213,9 @@ static bool get_self_input_state(netplay_t *netplay)
                         RETRO_DEVICE_JOYPAD, 0, (unsigned)i);
                   state[0] |= tmp ? 1 << i : 0;
                }
+#ifdef DEBUG_NETPLAY_NETSIM
+               state[0] = netplay_netsim_input(netplay->self_frame_count);
+#endif
                break;
 
             case RETRO_DEVICE_MOUSE:
@@ -248,12 +269,7 @@ static bool get_self_input_state(netplay_t *netplay)
    }
 
    /* And send this input to our peers */
-   for (i = 0; i < netplay->connections_size; i++)
-   {
-      struct netplay_connection *connection = &netplay->connections[i];
-      if (connection->active && connection->mode >= NETPLAY_CONNECTION_CONNECTED)
-         netplay_send_cur_input(netplay, &netplay->connections[i]);
-   }
+   netplay_send_cur_input_all(netplay);
 
    /* Handle any delayed state changes */
    if (netplay->is_server)
@@ -1104,11 +1120,23 @@ bool netplay_pre_frame(netplay_t *netplay)
        ((!netplay->is_server || (netplay->connected_players>1)) &&
         (netplay->stall || netplay->remote_paused)))
    {
+      /* Count the time spent waiting on the network */
+      if (sync_stalled || (netplay->stall &&
+            netplay->stall != NETPLAY_STALL_INPUT_LATENCY))
+      {
+         if (!netplay->stats.stalled)
+            netplay->stats.stalls++;
+         netplay->stats.stalled = true;
+         netplay->stats.stall_frames++;
+      }
+
       /* We may have received data even if we're stalled, so run post-frame
        * sync */
       netplay_sync_post_frame(netplay, true);
+      netplay_udp_send(netplay);
       return false;
    }
+   netplay->stats.stalled = false;
    return true;
 }
 
@@ -1126,6 +1154,8 @@ void netplay_post_frame(netplay_t *netplay)
    retro_assert(netplay);
    netplay_update_unread_ptr(netplay);
    netplay_sync_post_frame(netplay, false);
+   netplay_record_frames(netplay);
+   netplay_udp_send(netplay);
 
    for (i = 0; i < netplay->connections_size; i++)
    {
@@ -1181,6 +1211,8 @@ static void netplay_force_future(netplay_t *netplay)
       netplay->other_ptr = netplay->run_ptr;
       netplay->other_frame_count = netplay->run_frame_count;
    }
+
+   netplay_record_reload(netplay, netplay->run_frame_count);
 }
 
 /**
@@ -1191,7 +1223,7 @@ static void netplay_force_future(netplay_t *netplay)
  * @z                    : compression backend to use
  *
  * Send a loaded savestate to those connected peers using the given compression
- * scheme.
+ * scheme, as a delta to those we share a base with.
  */
 void netplay_send_savestate(netplay_t *netplay,
    retro_ctx_serialize_info_t *serial_info, uint32_t cx,
@@ -1200,24 +1232,10 @@ void netplay_send_savestate(netplay_t *netplay,
    uint32_t header[4];
    uint32_t rd, wn;
    size_t i;
-
-   /* Compress it */
-   z->compression_backend->set_in(z->compression_stream,
-      (const uint8_t*)serial_info->data_const, (uint32_t)serial_info->size);
-   z->compression_backend->set_out(z->compression_stream,
-      netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
-   if (!z->compression_backend->trans(z->compression_stream, true, &rd,
-         &wn, NULL))
-   {
-      /* Catastrophe! */
-      for (i = 0; i < netplay->connections_size; i++)
-         netplay_hangup(netplay, &netplay->connections[i]);
-      return;
-   }
+   bool compressed = false;
 
    /* Send it to relevant peers */
    header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE);
-   header[1] = htonl(wn + 2*sizeof(uint32_t));
    header[2] = htonl(netplay->run_frame_count);
    header[3] = htonl(serial_info->size);
 
@@ -1228,11 +1246,46 @@ void netplay_send_savestate(netplay_t *netplay,
           connection->mode < NETPLAY_CONNECTION_CONNECTED ||
           connection->compression_supported != cx) continue;
 
+      /* Deltas are compressed into zbuffer as well */
+      if (netplay_state_send_delta(netplay, connection, serial_info, z))
+      {
+         compressed = false;
+         continue;
+      }
+
+      if (!compressed)
+      {
+         /* Compress it */
+         z->compression_backend->set_in(z->compression_stream,
+            (const uint8_t*)serial_info->data_const, (uint32_t)serial_info->size);
+         z->compression_backend->set_out(z->compression_stream,
+            netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
+         if (!z->compression_backend->trans(z->compression_stream, true, &rd,
+               &wn, NULL))
+         {
+            /* Catastrophe! */
+            for (i = 0; i < netplay->connections_size; i++)
+               netplay_hangup(netplay, &netplay->connections[i]);
+            return;
+         }
+         header[1]  = htonl(wn + 2*sizeof(uint32_t));
+         compressed = true;
+      }
+
       if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
             sizeof(header)) ||
           !netplay_send(&connection->send_packet_buffer, connection->fd,
             netplay->zbuffer, wn))
          netplay_hangup(netplay, connection);
+      else
+      {
+         connection->sync_cmds_sent++;
+         netplay->stats.states_sent++;
+         netplay->stats.state_bytes_sent += sizeof(header) + wn;
+         RARCH_LOG("[netplay] Sent savestate for frame %u: %u bytes (%u state).\n",
+               netplay->run_frame_count, (unsigned)(sizeof(header) + wn),
+               (unsigned)serial_info->size);
+      }
    }
 }
 
@@ -1330,6 +1383,8 @@ static void netplay_core_reset(netplay_t *netplay)
       if (!netplay_send(&connection->send_packet_buffer, connection->fd, cmd,
                sizeof(cmd)))
          netplay_hangup(netplay, connection);
+      else
+         connection->sync_cmds_sent++;
    }
 }
 
@@ -1519,10 +1574,16 @@ bool init_netplay(void *direct_host, const char *server, unsigned port)
          discord_get_own_username() ? discord_get_own_username() :
 #endif
          settings->paths.username,
-         quirks);
+         quirks,
+         (settings->bools.netplay_udp_input &&
+          !settings->bools.netplay_use_mitm_server) ?
+            settings->uints.netplay_udp_input_frames : 0);
 
    if (netplay_data)
    {
+      if (!string_is_empty(settings->paths.directory_netplay_record))
+         netplay_record_init(netplay_data,
+               settings->paths.directory_netplay_record);
       if (netplay_data->is_server && !settings->bools.netplay_start_as_spectator)
          netplay_toggle_play_spectate(netplay_data);
       return true;
@@ -1619,10 +1680,29 @@ bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
          ret = netplay_data->is_connected;
          goto done;
       case RARCH_NETPLAY_CTL_POST_FRAME:
-         netplay_post_frame(netplay_data);
+         {
+            retro_time_t start = netplay_cpu_time_usec();
+            netplay_post_frame(netplay_data);
+            if (netplay_data)
+            {
+               struct netplay_stats *stats = &netplay_data->stats;
+               retro_time_t spent          = netplay_data->frame_pre_time +
+                  netplay_cpu_time_usec() - start;
+               stats->frames++;
+               stats->frame_time += spent;
+               if (spent > stats->frame_time_max)
+                  stats->frame_time_max = spent;
+            }
+         }
          break;
       case RARCH_NETPLAY_CTL_PRE_FRAME:
-         ret = netplay_pre_frame(netplay_data);
+         {
+            retro_time_t start = netplay_cpu_time_usec();
+            ret = netplay_pre_frame(netplay_data);
+            if (netplay_data)
+               netplay_data->frame_pre_time = netplay_cpu_time_usec()
+                  - start;
+         }
          goto done;
       case RARCH_NETPLAY_CTL_GAME_WATCH:
          netplay_toggle_play_spectate(netplay_data);
@@ -210,7 +210,9 @@ bool netplay_handshake_init_send(netplay_t *netplay,
 
    header[0] = htonl(netplay_magic);
    header[1] = htonl(netplay_platform_magic());
-   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED);
+   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED |
+         NETPLAY_FEATURE_DELTA_STATE |
+         (netplay->udp_input_frames ? NETPLAY_FEATURE_UDP_INPUT : 0));
    header[3] = 0;
    header[4] = htonl(NETPLAY_PROTOCOL_VERSION);
    header[5] = htonl(netplay_impl_magic());
@@ -374,6 +376,9 @@ bool netplay_handshake_init(netplay_t *netplay,
 
    /* Check what compression is supported */
    compression  = ntohl(header[2]);
+   connection->udp_supported = netplay->udp_input_frames &&
+      (compression & NETPLAY_FEATURE_UDP_INPUT);
+   connection->delta_states = !!(compression & NETPLAY_FEATURE_DELTA_STATE);
    compression &= NETPLAY_COMPRESSION_SUPPORTED;
 
    if (compression & NETPLAY_COMPRESSION_ZLIB)
@@ -669,6 +674,17 @@ bool netplay_handshake_sync(netplay_t *netplay,
    }
    autosave_unlock();
 
+   /* Offer them the UDP input channel if they can use it */
+   if (connection->udp_supported)
+   {
+      if (simple_rand_next == 1)
+         simple_srand((unsigned int) time(NULL));
+      connection->udp_token = simple_rand_uint32();
+      if (connection->udp_token == 0) connection->udp_token = 1;
+      if (!netplay_udp_offer(netplay, connection))
+         return false;
+   }
+
    /* Now we're ready! */
    connection->mode = NETPLAY_CONNECTION_SPECTATING;
    netplay_handshake_ready(netplay, connection);
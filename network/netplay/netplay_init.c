@@ -410,6 +410,7 @@ static bool netplay_init_buffers(netplay_t *netplay)
  * @nat_traversal        : If true, attempt NAT traversal.
  * @nick                 : Nickname of user.
  * @quirks               : Netplay quirks required for this session.
+ * @udp_input_frames     : Frames of input per UDP datagram, 0 for no UDP.
  *
  * Creates a new netplay handle. A NULL server means we're
  * hosting.
@@ -419,13 +420,15 @@ static bool netplay_init_buffers(netplay_t *netplay)
 netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    bool stateless_mode, int check_frames,
    const struct retro_callbacks *cb, bool nat_traversal, const char *nick,
-   uint64_t quirks)
+   uint64_t quirks, unsigned udp_input_frames)
 {
    netplay_t *netplay = (netplay_t*)calloc(1, sizeof(*netplay));
    if (!netplay)
       return NULL;
 
    netplay->listen_fd            = -1;
+   netplay->udp_fd               = -1;
+   netplay->poll_fd              = -1;
    netplay->tcp_port             = port;
    netplay->cbs                  = *cb;
    netplay->is_server            = (direct_host == NULL && server == NULL);
@@ -436,6 +439,8 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    netplay->crc_validity_checked = false;
    netplay->crcs_valid           = true;
    netplay->quirks               = quirks;
+   netplay->udp_input_frames     = udp_input_frames > NETPLAY_UDP_MAX_FRAMES ?
+                                NETPLAY_UDP_MAX_FRAMES : udp_input_frames;
    netplay->self_mode            = netplay->is_server ?
                                 NETPLAY_CONNECTION_SPECTATING :
                                 NETPLAY_CONNECTION_NONE;
@@ -462,8 +467,22 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
       return NULL;
    }
 
+   /* Watch our sockets for input, where we can */
+   netplay_poll_init(netplay);
+   if (!netplay->is_server)
+      netplay_poll_watch(netplay, netplay->connections[0].fd, 0);
+
+   /* Without a socket for it, don't offer UDP input at all */
+   if (netplay->is_server && netplay->udp_input_frames &&
+         !netplay_udp_init(netplay))
+   {
+      RARCH_WARN("[netplay] Failed to open UDP input socket.\n");
+      netplay->udp_input_frames = 0;
+   }
+
    if (!netplay_init_buffers(netplay))
    {
+      netplay_poll_deinit(netplay);
       free(netplay);
       return NULL;
    }
@@ -513,9 +532,13 @@ error:
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   if (netplay->udp_fd >= 0)
+      socket_close(netplay->udp_fd);
+
    if (netplay->connections && netplay->connections[0].fd >= 0)
       socket_close(netplay->connections[0].fd);
 
+   netplay_poll_deinit(netplay);
    free(netplay);
    return NULL;
 }
@@ -530,9 +553,33 @@ void netplay_free(netplay_t *netplay)
 {
    size_t i;
 
+   RARCH_LOG("[netplay] %u stalls (%u frames), %u rollbacks (%u frames replayed).\n",
+         netplay->stats.stalls, netplay->stats.stall_frames,
+         netplay->stats.rollbacks, netplay->stats.replayed_frames);
+   RARCH_LOG("[netplay] Savestates: %u sent (%u as deltas, %u bytes), %u received (%u bytes), %u resyncs (%u ms on average).\n",
+         netplay->stats.states_sent, netplay->stats.state_deltas_sent,
+         netplay->stats.state_bytes_sent, netplay->stats.states_received,
+         netplay->stats.state_bytes_received, netplay->stats.resyncs,
+         netplay->stats.resyncs ? (unsigned)(netplay->stats.resync_time
+            / 1000 / netplay->stats.resyncs) : 0);
+
+   RARCH_LOG("[netplay] %u frames, %u us %sper frame in netplay on average (%u us at most).\n",
+         netplay->stats.frames, netplay->stats.frames ?
+            (unsigned)(netplay->stats.frame_time / netplay->stats.frames) : 0,
+#ifdef NETPLAY_CPU_TIME
+         "of CPU time ",
+#else
+         "",
+#endif
+         (unsigned) netplay->stats.frame_time_max);
+
+   netplay_record_deinit(netplay);
+
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   netplay_udp_deinit(netplay);
+
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
@@ -544,6 +591,8 @@ void netplay_free(netplay_t *netplay)
       }
    }
 
+   netplay_poll_deinit(netplay);
+
    if (netplay->connections && netplay->connections != &netplay->one_connection)
       free(netplay->connections);
 
@@ -561,6 +610,8 @@ void netplay_free(netplay_t *netplay)
    if (netplay->zbuffer)
       free(netplay->zbuffer);
 
+   netplay_state_deinit(netplay);
+
    if (netplay->compress_nil.compression_stream)
    {
       netplay->compress_nil.compression_backend->stream_free(netplay->compress_nil.compression_stream);
@@ -24,6 +24,12 @@
 
 #include "netplay_private.h"
 
+#ifdef HAVE_NETPLAY_EPOLL
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#endif
+
 #include "../../configuration.h"
 #include "../../retroarch.h"
 #include "../../command.h"
@@ -133,8 +139,10 @@ void netplay_hangup(netplay_t *netplay, struct netplay_connection *connection)
    RARCH_LOG("[netplay] %s\n", dmsg);
    runloop_msg_queue_push(dmsg, 1, 180, false, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
 
+   netplay_poll_unwatch(netplay, connection->fd);
    socket_close(connection->fd);
-   connection->active = false;
+   connection->active     = false;
+   connection->udp_active = false;
    netplay_deinit_socket_buffer(&connection->send_packet_buffer);
    netplay_deinit_socket_buffer(&connection->recv_packet_buffer);
 
@@ -223,13 +231,14 @@ void netplay_delayed_state_change(netplay_t *netplay)
    }
 }
 
-/* Send the specified input data */
-static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
-      struct netplay_connection *only, struct netplay_connection *except,
-      uint32_t client_num, bool slave)
+#define INPUT_BUFSZ 16 /* FIXME: Arbitrary restriction */
+
+/* Put the specified input data into a buffer of INPUT_BUFSZ words, returning
+ * the number of words used */
+static size_t encode_input_frame(netplay_t *netplay, struct delta_frame *dframe,
+      uint32_t client_num, bool slave, uint32_t *buffer)
 {
-#define BUFSZ 16 /* FIXME: Arbitrary restriction */
-   uint32_t buffer[BUFSZ], devices, device;
+   uint32_t devices, device;
    size_t bufused, i;
 
    /* Set up the basic buffer */
@@ -250,7 +259,7 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
          istate = istate->next;
       if (!istate)
          continue;
-      if (bufused + istate->size >= BUFSZ)
+      if (bufused + istate->size >= INPUT_BUFSZ)
          continue; /* FIXME: More severe? */
       for (i = 0; i < istate->size; i++)
          buffer[bufused+i] = htonl(istate->data[i]);
@@ -263,6 +272,19 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
    print_state(netplay);
 #endif
 
+   return bufused;
+}
+
+/* Send the specified input data */
+static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
+      struct netplay_connection *only, struct netplay_connection *except,
+      uint32_t client_num, bool slave)
+{
+   uint32_t buffer[INPUT_BUFSZ];
+   size_t bufused, i;
+
+   bufused = encode_input_frame(netplay, dframe, client_num, slave, buffer);
+
    if (only)
    {
       if (!netplay_send(&only->send_packet_buffer, only->fd, buffer, bufused*sizeof(uint32_t)))
@@ -290,28 +312,47 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
    }
 
    return true;
-#undef BUFSZ
 }
 
 /**
- * netplay_send_cur_input
+ * netplay_input_received
  *
- * Send the current input frame to a given connection.
- *
- * Returns true if successful, false otherwise.
+ * Advance past a frame of input from the given client that was just filled in
+ * out of band, forwarding it to other connections as the TCP path would.
  */
-bool netplay_send_cur_input(netplay_t *netplay,
-   struct netplay_connection *connection)
+void netplay_input_received(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t client_num,
+   struct delta_frame *dframe)
 {
-   uint32_t from_client, to_client;
-   struct delta_frame *dframe = &netplay->buffer[netplay->self_ptr];
+   netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
+   netplay->read_frame_count[client_num]++;
 
    if (netplay->is_server)
    {
-      to_client = (uint32_t)(connection - netplay->connections + 1);
+      /* Forward it on if it's past data */
+      if (dframe->frame <= netplay->self_frame_count)
+         send_input_frame(netplay, dframe, NULL, connection, client_num, false);
+   }
+   else if (client_num == 0)
+   {
+      /* If this was server data, advance our server pointer too */
+      netplay->server_ptr = netplay->read_ptr[0];
+      netplay->server_frame_count = netplay->read_frame_count[0];
+   }
+}
 
-      /* Send the other players' input data (FIXME: This involves an
-       * unacceptable amount of recalculating) */
+/* Put together the current input frame as sent to the given client (0 for
+ * any that isn't playing), returning its length in words */
+static size_t encode_cur_input(netplay_t *netplay, uint32_t to_client,
+   uint32_t *buffer)
+{
+   uint32_t from_client;
+   struct delta_frame *dframe = &netplay->buffer[netplay->self_ptr];
+   size_t bufused = 0;
+
+   if (netplay->is_server)
+   {
+      /* Send the other players' input data */
       for (from_client = 1; from_client < MAX_CLIENTS; from_client++)
       {
          if (from_client == to_client)
@@ -320,33 +361,51 @@ bool netplay_send_cur_input(netplay_t *netplay,
          if ((netplay->connected_players & (1<<from_client)))
          {
             if (dframe->have_real[from_client])
-            {
-               if (!send_input_frame(netplay, dframe, connection, NULL, from_client, false))
-                  return false;
-            }
+               bufused += encode_input_frame(netplay, dframe, from_client,
+                     false, buffer + bufused);
          }
       }
 
       /* If we're not playing, send a NOINPUT */
       if (netplay->self_mode != NETPLAY_CONNECTION_PLAYING)
       {
-         uint32_t payload = htonl(netplay->self_frame_count);
-         if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_NOINPUT,
-               &payload, sizeof(payload)))
-            return false;
+         buffer[bufused++] = htonl(NETPLAY_CMD_NOINPUT);
+         buffer[bufused++] = htonl(sizeof(uint32_t));
+         buffer[bufused++] = htonl(netplay->self_frame_count);
       }
-
    }
 
    /* Send our own data */
    if (netplay->self_mode == NETPLAY_CONNECTION_PLAYING
          || netplay->self_mode == NETPLAY_CONNECTION_SLAVE)
-   {
-      if (!send_input_frame(netplay, dframe, connection, NULL,
-            netplay->self_client_num,
-            netplay->self_mode == NETPLAY_CONNECTION_SLAVE))
-         return false;
-   }
+      bufused += encode_input_frame(netplay, dframe, netplay->self_client_num,
+            netplay->self_mode == NETPLAY_CONNECTION_SLAVE, buffer + bufused);
+
+   return bufused;
+}
+
+/**
+ * netplay_send_cur_input
+ *
+ * Send the current input frame to a given connection.
+ *
+ * Returns true if successful, false otherwise.
+ */
+bool netplay_send_cur_input(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   uint32_t buffer[MAX_CLIENTS * INPUT_BUFSZ + 3];
+   uint32_t to_client = 0;
+   size_t bufused;
+
+   if (netplay->is_server)
+      to_client = (uint32_t)(connection - netplay->connections + 1);
+
+   bufused = encode_cur_input(netplay, to_client, buffer);
+
+   if (bufused && !netplay_send(&connection->send_packet_buffer,
+         connection->fd, buffer, bufused * sizeof(uint32_t)))
+      return false;
 
    if (!netplay_send_flush(&connection->send_packet_buffer, connection->fd,
          false))
@@ -355,6 +414,47 @@ bool netplay_send_cur_input(netplay_t *netplay,
    return true;
 }
 
+/**
+ * netplay_send_cur_input_all
+ *
+ * Send the current input frame to every connected peer. Spectators all get
+ * the same data, so it's only put together once.
+ */
+void netplay_send_cur_input_all(netplay_t *netplay)
+{
+   uint32_t shared[MAX_CLIENTS * INPUT_BUFSZ + 3];
+   size_t shared_len = 0, i;
+   bool have_shared = false;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (!connection->active ||
+          connection->mode < NETPLAY_CONNECTION_CONNECTED)
+         continue;
+
+      /* Players don't get their own input back, so theirs is put together
+       * for each of them */
+      if (!netplay->is_server ||
+          (netplay->connected_players & (1<<(i+1))))
+      {
+         if (!netplay_send_cur_input(netplay, connection))
+            netplay_hangup(netplay, connection);
+         continue;
+      }
+
+      if (!have_shared)
+      {
+         shared_len  = encode_cur_input(netplay, 0, shared);
+         have_shared = true;
+      }
+
+      if (!netplay_send_shared(&connection->send_packet_buffer,
+            connection->fd, shared, shared_len * sizeof(uint32_t)))
+         netplay_hangup(netplay, connection);
+   }
+}
+
 /**
  * netplay_send_raw_cmd
  *
@@ -379,6 +479,9 @@ bool netplay_send_raw_cmd(netplay_t *netplay,
       if (!netplay_send(&connection->send_packet_buffer, connection->fd, data, size))
          return false;
 
+   if (cmd == NETPLAY_CMD_MODE)
+      connection->sync_cmds_sent++;
+
    return true;
 }
 
@@ -472,6 +575,7 @@ bool netplay_cmd_request_savestate(netplay_t *netplay)
    if (netplay->savestate_request_outstanding)
       return true;
    netplay->savestate_request_outstanding = true;
+   netplay->resync_start                  = cpu_features_get_time_usec();
    return netplay_send_raw_cmd(netplay, &netplay->connections[0],
       NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0);
 }
@@ -1056,24 +1160,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
              * if latency is choppy, so we advance and send their data after
              * handling all network data this frame */
             if (connection->mode == NETPLAY_CONNECTION_PLAYING)
-            {
-               netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
-               netplay->read_frame_count[client_num]++;
-
-               if (netplay->is_server)
-               {
-                  /* Forward it on if it's past data */
-                  if (dframe->frame <= netplay->self_frame_count)
-                     send_input_frame(netplay, dframe, NULL, connection, client_num, false);
-               }
-            }
-
-            /* If this was server data, advance our server pointer too */
-            if (!netplay->is_server && client_num == 0)
-            {
-               netplay->server_ptr = netplay->read_ptr[0];
-               netplay->server_frame_count = netplay->read_frame_count[0];
-            }
+               netplay_input_received(netplay, connection, client_num, dframe);
 
 #ifdef DEBUG_NETPLAY_STEPS
             RARCH_LOG("[netplay] Received input from %u\n", client_num);
@@ -1237,6 +1324,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
             RARCH_ERR("NETPLAY_CMD_MODE failed to receive payload.\n");
             return netplay_cmd_nak(netplay, connection);
          }
+         connection->sync_cmds_recvd++;
 
          frame = ntohl(payload[0]);
 
@@ -1545,6 +1633,11 @@ static bool netplay_get_cmd(netplay_t *netplay,
                   /* Problem! */
                   netplay_cmd_request_savestate(netplay);
                }
+               else
+               {
+                  netplay->buffer[tmp_ptr].crc = local_crc;
+                  netplay_state_confirm_base(netplay, &netplay->buffer[tmp_ptr]);
+               }
             }
             else
             {
@@ -1562,6 +1655,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
          break;
 
       case NETPLAY_CMD_LOAD_SAVESTATE:
+      case NETPLAY_CMD_LOAD_SAVESTATE_DELTA:
       case NETPLAY_CMD_RESET:
          {
             uint32_t frame;
@@ -1569,7 +1663,9 @@ static bool netplay_get_cmd(netplay_t *netplay,
             uint32_t rd, wn;
             uint32_t client;
             uint32_t load_frame_count;
+            uint32_t delta_header[3];
             size_t load_ptr;
+            size_t header_size = 2*sizeof(uint32_t);
             struct compression_transcoder *ctrans = NULL;
             uint32_t                   client_num = (uint32_t)
              (connection - netplay->connections + 1);
@@ -1619,8 +1715,11 @@ static bool netplay_get_cmd(netplay_t *netplay,
              * too many places. */
 
             /* Check the payload size */
-            if ((cmd == NETPLAY_CMD_LOAD_SAVESTATE &&
-                 (cmd_size < 2*sizeof(uint32_t) || cmd_size > netplay->zbuffer_size + 2*sizeof(uint32_t))) ||
+            if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               header_size += sizeof(delta_header);
+            if ((cmd != NETPLAY_CMD_RESET &&
+                 (cmd_size < header_size || cmd_size > netplay->zbuffer_size + header_size)) ||
+                (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA && !connection->delta_states) ||
                 (cmd == NETPLAY_CMD_RESET && cmd_size != sizeof(uint32_t)))
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE received an unexpected payload size.\n");
@@ -1658,7 +1757,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
             }
 
             /* Now we switch based on whether we're loading a state or resetting */
-            if (cmd == NETPLAY_CMD_LOAD_SAVESTATE)
+            if (cmd != NETPLAY_CMD_RESET)
             {
                RECV(&isize, sizeof(isize))
                {
@@ -1673,7 +1772,18 @@ static bool netplay_get_cmd(netplay_t *netplay,
                   return netplay_cmd_nak(netplay, connection);
                }
 
-               RECV(netplay->zbuffer, cmd_size - 2*sizeof(uint32_t))
+               if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               {
+                  RECV(delta_header, sizeof(delta_header))
+                  {
+                     RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive delta base.\n");
+                     return netplay_cmd_nak(netplay, connection);
+                  }
+                  delta_header[0] = ntohl(delta_header[0]);
+                  delta_header[1] = ntohl(delta_header[1]);
+               }
+
+               RECV(netplay->zbuffer, cmd_size - header_size)
                {
                   RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive savestate.\n");
                   return netplay_cmd_nak(netplay, connection);
@@ -1689,12 +1799,69 @@ static bool netplay_get_cmd(netplay_t *netplay,
                      ctrans = &netplay->compress_nil;
                }
                ctrans->decompression_backend->set_in(ctrans->decompression_stream,
-                  netplay->zbuffer, cmd_size - 2*sizeof(uint32_t));
-               ctrans->decompression_backend->set_out(ctrans->decompression_stream,
-                  (uint8_t*)netplay->buffer[load_ptr].state,
-                  (unsigned)netplay->state_size);
-               ctrans->decompression_backend->trans(ctrans->decompression_stream,
-                  true, &rd, &wn, NULL);
+                  netplay->zbuffer, (uint32_t)(cmd_size - header_size));
+
+               if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               {
+                  /* Patches are never bigger than the state itself */
+                  if (netplay->delta_patch_size < netplay->state_size)
+                  {
+                     free(netplay->delta_patch);
+                     netplay->delta_patch_size = 0;
+                     netplay->delta_patch      = (uint8_t*)malloc(
+                           netplay->state_size);
+                     if (netplay->delta_patch)
+                        netplay->delta_patch_size = netplay->state_size;
+                  }
+
+                  wn = 0;
+                  if (netplay->delta_patch)
+                  {
+                     ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+                        netplay->delta_patch, (uint32_t)netplay->state_size);
+                     ctrans->decompression_backend->trans(ctrans->decompression_stream,
+                        true, &rd, &wn, NULL);
+                  }
+
+                  /* Without the base, or from a peer of the other byte order,
+                   * it's of no use, and we'll need the full state instead */
+                  if (     !netplay->delta_patch
+                        || delta_header[2] != 1
+                        || !netplay_state_load_delta(netplay,
+                           delta_header[0], delta_header[1],
+                           netplay->delta_patch, wn,
+                           netplay->buffer[load_ptr].state))
+                  {
+                     RARCH_WARN("[netplay] Could not load delta savestate against frame %u, requesting the full state.\n",
+                           delta_header[0]);
+                     connection->sync_cmds_recvd++;
+                     if (!netplay_state_request_full(netplay, connection))
+                        netplay_hangup(netplay, connection);
+                     break;
+                  }
+               }
+               else
+               {
+                  ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+                     (uint8_t*)netplay->buffer[load_ptr].state,
+                     (unsigned)netplay->state_size);
+                  ctrans->decompression_backend->trans(ctrans->decompression_stream,
+                     true, &rd, &wn, NULL);
+               }
+
+               netplay->stats.states_received++;
+               netplay->stats.state_bytes_received += (uint32_t)cmd_size;
+               if (netplay->savestate_request_outstanding)
+               {
+                  retro_time_t elapsed = cpu_features_get_time_usec()
+                     - netplay->resync_start;
+                  netplay->stats.resyncs++;
+                  netplay->stats.resync_time += elapsed;
+                  RARCH_LOG("[netplay] Resynchronized in %u ms with a %s savestate of %u bytes.\n",
+                        (unsigned)(elapsed / 1000),
+                        cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA ? "delta" : "full",
+                        (unsigned)cmd_size);
+               }
 
                /* Force a rewind to the relevant frame */
                netplay->force_rewind = true;
@@ -1735,10 +1902,13 @@ static bool netplay_get_cmd(netplay_t *netplay,
                }
             }
 
+            netplay_record_reload(netplay, load_frame_count);
+
             /* Make sure our states are correct */
             netplay->savestate_request_outstanding = false;
             netplay->other_ptr                     = load_ptr;
             netplay->other_frame_count             = load_frame_count;
+            connection->sync_cmds_recvd++;
 
 #ifdef DEBUG_NETPLAY_STEPS
             RARCH_LOG("[netplay] Loading state at %u\n", load_frame_count);
@@ -1832,6 +2002,56 @@ static bool netplay_get_cmd(netplay_t *netplay,
             break;
          }
 
+      case NETPLAY_CMD_UDP_INFO:
+         {
+            uint32_t payload[2];
+
+            if (netplay->is_server)
+            {
+               RARCH_ERR("NETPLAY_CMD_UDP_INFO from a client.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (cmd_size != sizeof(payload))
+            {
+               RARCH_ERR("NETPLAY_CMD_UDP_INFO with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(payload, sizeof(payload))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_UDP_INFO payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            /* Not fatal, we still have TCP */
+            if (!netplay_udp_accept(netplay, connection,
+                     (uint16_t) ntohl(payload[0]), ntohl(payload[1])))
+               RARCH_WARN("[netplay] Failed to open UDP input socket.\n");
+            break;
+         }
+
+      case NETPLAY_CMD_STATE_BASE:
+         {
+            uint32_t payload[2];
+
+            if (cmd_size != sizeof(payload) || !connection->delta_states)
+            {
+               RARCH_ERR("NETPLAY_CMD_STATE_BASE with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(payload, sizeof(payload))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_STATE_BASE payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            netplay_state_set_base(netplay, connection,
+                  ntohl(payload[0]), ntohl(payload[1]));
+            break;
+         }
+
       default:
          RARCH_ERR("%s.\n", msg_hash_to_str(MSG_UNKNOWN_NETPLAY_COMMAND_RECEIVED));
          return netplay_cmd_nak(netplay, connection);
@@ -1851,6 +2071,124 @@ shrt:
 #undef RECV
 }
 
+/**
+ * netplay_poll_init
+ *
+ * Set up the readiness poller for our sockets, if this platform has one.
+ */
+void netplay_poll_init(netplay_t *netplay)
+{
+#ifdef HAVE_NETPLAY_EPOLL
+   netplay->poll_fd = epoll_create(NETPLAY_POLL_EVENTS);
+   if (netplay->poll_fd < 0)
+      RARCH_WARN("[netplay] Could not create a poller, reading every connection.\n");
+#else
+   netplay->poll_fd = -1;
+#endif
+}
+
+/**
+ * netplay_poll_deinit
+ *
+ * Free the readiness poller.
+ */
+void netplay_poll_deinit(netplay_t *netplay)
+{
+#ifdef HAVE_NETPLAY_EPOLL
+   if (netplay->poll_fd >= 0)
+      close(netplay->poll_fd);
+#endif
+   netplay->poll_fd = -1;
+}
+
+/**
+ * netplay_poll_watch
+ *
+ * Watch a socket for readiness, identified by its connection index or
+ * NETPLAY_POLL_UDP.
+ */
+void netplay_poll_watch(netplay_t *netplay, int fd, uint32_t id)
+{
+#ifdef HAVE_NETPLAY_EPOLL
+   struct epoll_event ev;
+
+   if (netplay->poll_fd < 0 || fd < 0)
+      return;
+
+   memset(&ev, 0, sizeof(ev));
+   ev.events   = EPOLLIN;
+   ev.data.u32 = id;
+   if (epoll_ctl(netplay->poll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+   {
+      /* Without every socket in there, the poller is no use */
+      RARCH_WARN("[netplay] Could not watch a socket, reading every connection.\n");
+      netplay_poll_deinit(netplay);
+   }
+#endif
+}
+
+/**
+ * netplay_poll_unwatch
+ *
+ * Stop watching a socket. Must be called before it's closed.
+ */
+void netplay_poll_unwatch(netplay_t *netplay, int fd)
+{
+#ifdef HAVE_NETPLAY_EPOLL
+   struct epoll_event ev;
+
+   if (netplay->poll_fd < 0 || fd < 0)
+      return;
+
+   /* Older kernels want an event even though it's ignored */
+   memset(&ev, 0, sizeof(ev));
+   epoll_ctl(netplay->poll_fd, EPOLL_CTL_DEL, fd, &ev);
+#endif
+}
+
+/* Find out which connections have something to read, waiting up to the given
+ * time for any of them to. Returns false if we can't tell, in which case
+ * every connection has to be tried. */
+static bool netplay_poll_ready(netplay_t *netplay, int timeout_ms)
+{
+#ifdef HAVE_NETPLAY_EPOLL
+   struct epoll_event events[NETPLAY_POLL_EVENTS];
+   size_t i;
+   int ready;
+
+   if (netplay->poll_fd < 0)
+      return false;
+
+   for (i = 0; i < netplay->connections_size; i++)
+      netplay->connections[i].readable = false;
+
+   /* One call only. epoll is level-triggered, so anything left over
+    * because more than NETPLAY_POLL_EVENTS were ready comes back next
+    * time, and the kernel hands out the ready ones in turn. */
+   ready = epoll_wait(netplay->poll_fd, events, NETPLAY_POLL_EVENTS,
+         timeout_ms);
+   if (ready < 0)
+   {
+      if (errno == EINTR)
+         return true;
+      RARCH_WARN("[netplay] Poller failed, reading every connection.\n");
+      netplay_poll_deinit(netplay);
+      return false;
+   }
+
+   for (i = 0; i < (size_t) ready; i++)
+   {
+      uint32_t id = events[i].data.u32;
+      if (id < netplay->connections_size)
+         netplay->connections[id].readable = true;
+   }
+
+   return true;
+#else
+   return false;
+#endif
+}
+
 /**
  * netplay_poll_net_input
  *
@@ -1859,6 +2197,7 @@ shrt:
 int netplay_poll_net_input(netplay_t *netplay, bool block)
 {
    bool had_input = false;
+   bool polled;
    int max_fd = 0;
    size_t i;
 
@@ -1872,6 +2211,9 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
    if (max_fd == 0)
       return 0;
 
+   if (netplay->udp_fd >= max_fd)
+      max_fd = netplay->udp_fd + 1;
+
    netplay->timeout_cnt = 0;
 
    do
@@ -1880,11 +2222,24 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
 
       netplay->timeout_cnt++;
 
-      /* Read input from each connection */
+      /* Datagrams first, so TCP can skip whatever they had */
+      if (netplay_udp_poll(netplay))
+         had_input = true;
+
+      /* Read input from each connection that has any. Those still
+       * handshaking are always tried, as are those with commands left over
+       * from last time. */
+      polled = netplay_poll_ready(netplay, 0);
       for (i = 0; i < netplay->connections_size; i++)
       {
          struct netplay_connection *connection = &netplay->connections[i];
-         if (connection->active && !netplay_get_cmd(netplay, connection, &had_input))
+         if (!connection->active)
+            continue;
+         if (polled && !connection->readable &&
+             connection->mode >= NETPLAY_CONNECTION_CONNECTED &&
+             !netplay_recv_pending(&connection->recv_packet_buffer))
+            continue;
+         if (!netplay_get_cmd(netplay, connection, &had_input))
             netplay_hangup(netplay, connection);
       }
 
@@ -1897,7 +2252,15 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
             break;
 
          /* If we're supposed to block but we didn't have enough input, wait for it */
-         if (!had_input)
+         if (!had_input && netplay_poll_ready(netplay, RETRY_MS))
+         {
+            RARCH_LOG("[netplay] Network is stalling at frame %u, count %u of %d ...\n",
+                  netplay->run_frame_count, netplay->timeout_cnt, MAX_RETRIES);
+
+            if (netplay->timeout_cnt >= MAX_RETRIES && !netplay->remote_paused)
+               return -1;
+         }
+         else if (!had_input)
          {
             fd_set fds;
             struct timeval tv = {0};
@@ -1910,6 +2273,8 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
                if (connection->active)
                   FD_SET(connection->fd, &fds);
             }
+            if (netplay->udp_fd >= 0)
+               FD_SET(netplay->udp_fd, &fds);
 
             if (socket_select(max_fd, &fds, NULL, NULL, &tv) < 0)
                return -1;
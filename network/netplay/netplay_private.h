@@ -18,11 +18,14 @@
 #ifndef __RARCH_NETPLAY_PRIVATE_H
 #define __RARCH_NETPLAY_PRIVATE_H
 
+#include <time.h>
+
 #include "netplay.h"
 
 #include <net/net_compat.h>
 #include <net/net_natt.h>
 #include <features/features_cpu.h>
+#include <streams/file_stream.h>
 #include <streams/trans_stream.h>
 
 #include "../../msg_hash.h"
@@ -95,6 +98,67 @@ typedef uint32_t client_bitmap_t;
 #define NETPLAY_COMPRESSION_SUPPORTED 0
 #endif
 
+/* Optional features, advertised in the upper half of the compression word of
+ * the header (older peers mask them off) */
+#define NETPLAY_FEATURE_UDP_INPUT (1<<16)
+#define NETPLAY_FEATURE_DELTA_STATE (1<<17)
+
+/* Checked states kept as bases for delta savestates (see netplay_state.c) */
+#define NETPLAY_STATE_BASES 2
+
+/* Unreliable input channel: datagram magic ("RAUI"), the most redundant frames
+ * we'll put in one datagram, and the largest datagram we'll send */
+#define NETPLAY_UDP_MAGIC              0x52415549
+#define NETPLAY_UDP_MAX_FRAMES         16
+#define NETPLAY_UDP_MAX_SIZE           1200
+#define NETPLAY_UDP_RESEND_TIME_USEC   16666
+
+/* On Linux, readiness of our sockets is tracked with epoll, so each poll only
+ * reads from connections that have something to read, and data shared by
+ * many connections is sent with one sendmsg each instead of being copied
+ * into every send buffer first */
+#if defined(__linux__) && !defined(HAVE_SOCKET_LEGACY)
+#define HAVE_NETPLAY_EPOLL 1
+#endif
+
+/* Time spent in netplay each frame is measured as CPU time of the main
+ * thread where there is a clock for it, so waiting on the network isn't
+ * counted */
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+#define NETPLAY_CPU_TIME 1
+#endif
+
+/* Events taken per epoll_wait, and the ID the UDP socket is watched with
+ * (connections are watched by index) */
+#define NETPLAY_POLL_EVENTS            64
+#define NETPLAY_POLL_UDP               0xFFFFFFFF
+
+/* Network simulator for testing over loopback: drops and delays datagrams,
+ * and delays TCP data by the same jitter, or by a retransmission timeout as
+ * if a segment had been lost. The local joypad input is replaced with a
+ * pattern that changes every NETSIM_INPUT_FRAMES frames and differs on each
+ * peer, so that input predictions fail as they would with players. Stall
+ * and rollback counts are logged at the end of the session. Build with
+ * DEBUG_NETPLAY_NETSIM=1, and see tools/ranetplayer/ranetsim.py. */
+#if 0
+#define DEBUG_NETPLAY_NETSIM 1
+#endif
+
+#ifdef DEBUG_NETPLAY_NETSIM
+#ifndef NETSIM_LOSS_PERCENT
+#define NETSIM_LOSS_PERCENT 5
+#endif
+#ifndef NETSIM_JITTER_MS
+#define NETSIM_JITTER_MS 20
+#endif
+#ifndef NETSIM_TCP_RTO_MS
+#define NETSIM_TCP_RTO_MS 200
+#endif
+#ifndef NETSIM_INPUT_FRAMES
+#define NETSIM_INPUT_FRAMES 7
+#endif
+#endif
+
 enum netplay_cmd
 {
    /* Basic commands */
@@ -166,6 +230,13 @@ enum netplay_cmd
    /* Sends over cheats enabled on client (unsupported) */
    NETPLAY_CMD_CHEATS         = 0x0047,
 
+   /* Send a savestate for the client to load, as a delta against a base
+    * state both sides have */
+   NETPLAY_CMD_LOAD_SAVESTATE_DELTA = 0x0048,
+
+   /* Report the checked frame we keep as a base for delta savestates */
+   NETPLAY_CMD_STATE_BASE     = 0x0049,
+
    /* Misc. commands */
 
    /* Sends multiple config requests over,
@@ -175,7 +246,15 @@ enum netplay_cmd
    /* CMD_CFG streamlines sending multiple
       configurations. This acknowledges
       each one individually */
-   NETPLAY_CMD_CFG_ACK        = 0x0062
+   NETPLAY_CMD_CFG_ACK        = 0x0062,
+
+   /* Server's UDP input port and this connection's token (see
+    * netplay_udp.c) */
+   NETPLAY_CMD_UDP_INFO       = 0x0063,
+
+   /* Device type on each port. Only found in recordings (see
+    * netplay_record.c) */
+   NETPLAY_CMD_RECORD_DEVICES = 0x0064
 };
 
 #define NETPLAY_CMD_SYNC_BIT_PAUSED    (1U<<31)
@@ -322,6 +401,9 @@ struct socket_buffer
    size_t bufsz;
    size_t start, end;
    size_t read;
+#ifdef DEBUG_NETPLAY_NETSIM
+   retro_time_t netsim_hold;
+#endif
 };
 
 /* Each connection gets a connection struct */
@@ -369,6 +451,79 @@ struct netplay_connection
    /* For the server: When was the last time we requested this client to stall?
     * For the client: How many frames of stall do we have left? */
    uint32_t stall_frame;
+
+   /* Frame-synchronizing commands (MODE, LOAD_SAVESTATE, RESET) sent to and
+    * processed from this peer, so that input arriving over UDP can tell
+    * whether it has overtaken one of them */
+   uint32_t sync_cmds_sent, sync_cmds_recvd;
+
+   /* Did the peer advertise the UDP input channel, and do we know where to
+    * send datagrams yet? */
+   bool udp_supported, udp_active;
+
+   /* Did the poller report this connection readable this time around? */
+   bool readable;
+
+   /* Token identifying this connection's datagrams, and the peer's address */
+   uint32_t udp_token;
+   struct sockaddr_storage udp_addr;
+   socklen_t udp_addr_len;
+
+   /* Sequence numbers of the last datagram sent and received */
+   uint32_t udp_seq, udp_recv_seq;
+
+   /* For each client in udp_acked, the next frame the peer is missing */
+   uint32_t udp_acks[MAX_CLIENTS];
+   client_bitmap_t udp_acked;
+
+   /* Does the peer take delta savestates, and which checked frame (with its
+    * CRC) do we both keep as a base for them? */
+   bool delta_states, state_base_valid;
+   uint32_t state_base_frame, state_base_crc;
+};
+
+/* Counters for the life of a netplay session, logged when it ends */
+struct netplay_stats
+{
+   /* Times we stalled for the network, and frames spent stalled */
+   uint32_t stalls, stall_frames;
+
+   /* Times we rewound to replay corrected input, and frames replayed */
+   uint32_t rollbacks, replayed_frames;
+
+   /* Datagrams sent, received and missing from the sequence */
+   uint32_t udp_sent, udp_received, udp_lost;
+
+   /* Frames of input that arrived over UDP before TCP */
+   uint32_t udp_frames;
+
+   /* Savestates sent (in total and as deltas) and received, and their bytes
+    * on the wire */
+   uint32_t states_sent, state_deltas_sent, state_bytes_sent;
+   uint32_t states_received, state_bytes_received;
+
+   /* Savestates we requested to recover from a desync, and the total time
+    * until they were loaded */
+   uint32_t resyncs;
+   retro_time_t resync_time;
+
+   /* Frames run, and the time spent in netplay before and after them
+    * (CPU time with NETPLAY_CPU_TIME, wall time otherwise) */
+   uint32_t frames;
+   retro_time_t frame_time, frame_time_max;
+
+   /* Were we stalled for the network last frame? */
+   bool stalled;
+};
+
+/* A checked state that both sides of a connection may keep */
+struct netplay_state_base
+{
+   uint32_t frame;
+   uint32_t crc;
+   void *state;
+   size_t size;
+   bool used;
 };
 
 /* Compression transcoder */
@@ -567,6 +722,40 @@ struct netplay
 
    /* Are they valid? */
    bool crcs_valid;
+
+   /* UDP socket for input (-1 if not in use), and how many frames of input
+    * to repeat in each datagram */
+   int udp_fd;
+   unsigned udp_input_frames;
+
+   /* When we last sent datagrams, and up to which frame */
+   retro_time_t udp_send_time;
+   uint32_t udp_send_frame;
+
+   /* Bases for delta savestates, the next one to replace, and a buffer for
+    * the patches */
+   struct netplay_state_base state_bases[NETPLAY_STATE_BASES];
+   unsigned state_base_next;
+   uint8_t *delta_patch;
+   size_t delta_patch_size;
+
+   /* When we requested the savestate we're waiting for */
+   retro_time_t resync_start;
+
+   /* Readiness poller for our sockets (-1 if not in use, in which case every
+    * connection is read on every poll) */
+   int poll_fd;
+
+   /* Time spent in netplay before running this frame */
+   retro_time_t frame_pre_time;
+
+   /* Desync recording (NULL if not recording), the next frame to record,
+    * and whether it needs its state in full */
+   RFILE *record_file;
+   uint32_t record_frame;
+   bool record_state;
+
+   struct netplay_stats stats;
 };
 
 /***************************************************************
@@ -638,6 +827,25 @@ void netplay_recv_reset(struct socket_buffer *sbuf);
  */
 void netplay_recv_flush(struct socket_buffer *sbuf);
 
+/**
+ * netplay_recv_pending
+ *
+ * Is there data in our recv buffer that hasn't been read yet?
+ */
+bool netplay_recv_pending(struct socket_buffer *sbuf);
+
+/**
+ * netplay_send_shared
+ *
+ * Send the given data after anything already queued, without copying it into
+ * the buffer unless it can't all be sent now. For data sent to many
+ * connections at once.
+ *
+ * Returns false only on socket failures, true otherwise.
+ */
+bool netplay_send_shared(struct socket_buffer *sbuf, int sockfd,
+   const void *buf, size_t len);
+
 /***************************************************************
  * NETPLAY-DELTA.C
  **************************************************************/
@@ -779,6 +987,7 @@ bool netplay_wait_and_init_serialization(netplay_t *netplay);
  * @nat_traversal        : If true, attempt NAT traversal.
  * @nick                 : Nickname of user.
  * @quirks               : Netplay quirks required for this session.
+ * @udp_input_frames     : Frames of input per UDP datagram, 0 for no UDP.
  *
  * Creates a new netplay handle. A NULL server means we're
  * hosting.
@@ -788,7 +997,7 @@ bool netplay_wait_and_init_serialization(netplay_t *netplay);
 netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    bool stateless_mode, int check_frames,
    const struct retro_callbacks *cb, bool nat_traversal, const char *nick,
-   uint64_t quirks);
+   uint64_t quirks, unsigned udp_input_frames);
 
 /**
  * netplay_free
@@ -817,6 +1026,16 @@ void netplay_hangup(netplay_t *netplay, struct netplay_connection *connection);
  */
 void netplay_delayed_state_change(netplay_t *netplay);
 
+/**
+ * netplay_input_received
+ *
+ * Advance past a frame of input from the given client that was just filled in
+ * out of band, forwarding it to other connections as the TCP path would.
+ */
+void netplay_input_received(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t client_num,
+   struct delta_frame *dframe);
+
 /**
  * netplay_send_cur_input
  *
@@ -827,6 +1046,14 @@ void netplay_delayed_state_change(netplay_t *netplay);
 bool netplay_send_cur_input(netplay_t *netplay,
    struct netplay_connection *connection);
 
+/**
+ * netplay_send_cur_input_all
+ *
+ * Send the current input frame to every connected peer. Spectators all get
+ * the same data, so it's only put together once.
+ */
+void netplay_send_cur_input_all(netplay_t *netplay);
+
 /**
  * netplay_send_raw_cmd
  *
@@ -880,6 +1107,35 @@ bool netplay_cmd_stall(netplay_t *netplay,
    struct netplay_connection *connection,
    uint32_t frames);
 
+/**
+ * netplay_poll_init
+ *
+ * Set up the readiness poller for our sockets, if this platform has one.
+ */
+void netplay_poll_init(netplay_t *netplay);
+
+/**
+ * netplay_poll_deinit
+ *
+ * Free the readiness poller.
+ */
+void netplay_poll_deinit(netplay_t *netplay);
+
+/**
+ * netplay_poll_watch
+ *
+ * Watch a socket for readiness, identified by its connection index or
+ * NETPLAY_POLL_UDP.
+ */
+void netplay_poll_watch(netplay_t *netplay, int fd, uint32_t id);
+
+/**
+ * netplay_poll_unwatch
+ *
+ * Stop watching a socket. Must be called before it's closed.
+ */
+void netplay_poll_unwatch(netplay_t *netplay, int fd);
+
 /**
  * netplay_poll_net_input
  *
@@ -977,4 +1233,166 @@ bool netplay_sync_pre_frame(netplay_t *netplay);
  */
 void netplay_sync_post_frame(netplay_t *netplay, bool stalled);
 
+/***************************************************************
+ * NETPLAY-UDP.C
+ **************************************************************/
+
+/**
+ * netplay_udp_init
+ *
+ * Open the server's UDP input socket.
+ */
+bool netplay_udp_init(netplay_t *netplay);
+
+/**
+ * netplay_udp_deinit
+ *
+ * Close the UDP input socket and log its statistics.
+ */
+void netplay_udp_deinit(netplay_t *netplay);
+
+/**
+ * netplay_udp_offer
+ *
+ * Tell a freshly synchronized client where to send its datagrams (server).
+ */
+bool netplay_udp_offer(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_udp_accept
+ *
+ * Handle the server's offer of a UDP input channel (client).
+ */
+bool netplay_udp_accept(netplay_t *netplay,
+   struct netplay_connection *connection, uint16_t port, uint32_t token);
+
+/**
+ * netplay_udp_send
+ *
+ * Send the latest frames of input to every peer with a UDP channel.
+ */
+void netplay_udp_send(netplay_t *netplay);
+
+/**
+ * netplay_udp_poll
+ *
+ * Read any pending datagrams.
+ *
+ * Returns true if any new input was read.
+ */
+bool netplay_udp_poll(netplay_t *netplay);
+
+/***************************************************************
+ * NETPLAY-RECORD.C
+ **************************************************************/
+
+/**
+ * netplay_record_init
+ *
+ * Start recording this session into a new file in the given directory.
+ */
+bool netplay_record_init(netplay_t *netplay, const char *dir);
+
+/**
+ * netplay_record_deinit
+ *
+ * Finish the recording, if any.
+ */
+void netplay_record_deinit(netplay_t *netplay);
+
+/**
+ * netplay_record_reload
+ *
+ * The state at the start of the given frame was loaded or reset rather than
+ * run into, so record it in full, and record again from there.
+ */
+void netplay_record_reload(netplay_t *netplay, uint32_t frame);
+
+/**
+ * netplay_record_frames
+ *
+ * Record the frames we've finished with since the last call.
+ */
+void netplay_record_frames(netplay_t *netplay);
+
+/***************************************************************
+ * NETPLAY-STATE.C
+ **************************************************************/
+
+/**
+ * netplay_state_deinit
+ *
+ * Free the delta savestate bases and patch buffer.
+ */
+void netplay_state_deinit(netplay_t *netplay);
+
+/**
+ * netplay_state_store_base
+ *
+ * Keep a copy of a frame whose CRC we're sending to our clients (server).
+ */
+void netplay_state_store_base(netplay_t *netplay, struct delta_frame *delta);
+
+/**
+ * netplay_state_confirm_base
+ *
+ * Keep a copy of a frame whose CRC matched the server's and report it as our
+ * base (client).
+ */
+void netplay_state_confirm_base(netplay_t *netplay, struct delta_frame *delta);
+
+/**
+ * netplay_state_set_base
+ *
+ * Handle a peer's report of the base it keeps.
+ */
+void netplay_state_set_base(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t frame, uint32_t crc);
+
+/**
+ * netplay_state_send_delta
+ *
+ * Send a savestate as a delta against the base we share with this peer.
+ *
+ * Returns false if there's no usable base, so the full state should be sent.
+ */
+bool netplay_state_send_delta(netplay_t *netplay,
+   struct netplay_connection *connection,
+   retro_ctx_serialize_info_t *serial_info, struct compression_transcoder *z);
+
+/**
+ * netplay_state_load_delta
+ *
+ * Rebuild a state from a received delta into @state.
+ *
+ * Returns false if we don't have its base or it's malformed.
+ */
+bool netplay_state_load_delta(netplay_t *netplay, uint32_t base_frame,
+   uint32_t base_crc, const uint8_t *patch, size_t patch_len, void *state);
+
+/**
+ * netplay_state_request_full
+ *
+ * Forget our base with this peer and ask it for a full savestate.
+ */
+bool netplay_state_request_full(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+#ifdef DEBUG_NETPLAY_NETSIM
+/**
+ * netplay_netsim_tcp_hold
+ *
+ * Network simulator: should this flush of TCP data be held back?
+ */
+bool netplay_netsim_tcp_hold(struct socket_buffer *sbuf);
+
+/**
+ * netplay_netsim_input
+ *
+ * Network simulator: made-up joypad input for the given frame.
+ */
+uint32_t netplay_netsim_input(uint32_t frame);
+#endif
+
 #endif
@@ -0,0 +1,268 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Desync recordings.
+ *
+ * With netplay_record_directory set, each peer writes every frame it has
+ * finished with (all real input in, no more rewinding past it) to a file, so
+ * that tools/ranetplayer/ranetbisect can replay the session against the core
+ * and find where two peers went apart. The file is a stream of netplay
+ * commands, as in ranetplayer's recordings:
+ *
+ *    INFO            as in the handshake, once
+ *    RECORD_DEVICES  the device type on each port, once
+ *    LOAD_SAVESTATE  frame, size, uncompressed state: whenever the state
+ *                    didn't follow from the previous frame (the first frame,
+ *                    loads, resets and skipped frames)
+ *    CRC             frame, CRC of the state at the start of the frame
+ *    INPUT           frame, client 0, the input the core saw on each port
+ *                    that has a device, in port order
+ *
+ * CRC and LOAD_SAVESTATE are left out if the core can't serialize.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+
+#include "netplay_private.h"
+
+#include "../../content.h"
+#include "../../retroarch.h"
+
+/* Write one command, whose payload may come in two parts */
+static bool netplay_record_write(netplay_t *netplay, uint32_t cmd,
+      const void *payload, size_t size, const void *more, size_t more_size)
+{
+   uint32_t header[2];
+
+   header[0] = htonl(cmd);
+   header[1] = htonl((uint32_t)(size + more_size));
+
+   if (filestream_write(netplay->record_file, header, sizeof(header))
+            != sizeof(header)
+         || (size && filestream_write(netplay->record_file, payload, size)
+            != (int64_t)size)
+         || (more_size && filestream_write(netplay->record_file, more,
+            more_size) != (int64_t)more_size))
+   {
+      RARCH_ERR("[netplay] Failed to write recording, stopping it.\n");
+      netplay_record_deinit(netplay);
+      return false;
+   }
+
+   return true;
+}
+
+static bool netplay_record_header(netplay_t *netplay)
+{
+   uint32_t info[2 * NETPLAY_NICK_LEN / sizeof(uint32_t) + 1];
+   uint32_t devices[MAX_INPUT_DEVICES];
+   char *name                       = (char*)info;
+   struct retro_system_info *system = runloop_get_libretro_system_info();
+   unsigned i;
+
+   /* Same layout as the INFO of the handshake */
+   memset(info, 0, sizeof(info));
+   strlcpy(name, system ? system->library_name : "UNKNOWN",
+         NETPLAY_NICK_LEN);
+   strlcpy(name + NETPLAY_NICK_LEN,
+         system ? system->library_version : "UNKNOWN", NETPLAY_NICK_LEN);
+   info[2 * NETPLAY_NICK_LEN / sizeof(uint32_t)] = htonl(content_get_crc());
+
+   for (i = 0; i < MAX_INPUT_DEVICES; i++)
+      devices[i] = htonl(netplay->config_devices[i]);
+
+   return netplay_record_write(netplay, NETPLAY_CMD_INFO,
+            info, sizeof(info), NULL, 0)
+      && netplay_record_write(netplay, NETPLAY_CMD_RECORD_DEVICES,
+            devices, sizeof(devices), NULL, 0);
+}
+
+static bool netplay_record_frame(netplay_t *netplay, struct delta_frame *delta)
+{
+   uint32_t input[2 + MAX_INPUT_DEVICES * 5];
+   size_t used = 2;
+   uint32_t device, i;
+   bool have_state = netplay->state_size && delta->state &&
+      !(netplay->quirks & (NETPLAY_QUIRK_NO_SAVESTATES
+            | NETPLAY_QUIRK_INITIALIZATION));
+
+   if (netplay->record_state)
+   {
+      netplay->record_state = false;
+      if (have_state)
+      {
+         uint32_t header[2];
+         header[0] = htonl(delta->frame);
+         header[1] = htonl((uint32_t)netplay->state_size);
+         if (!netplay_record_write(netplay, NETPLAY_CMD_LOAD_SAVESTATE,
+               header, sizeof(header), delta->state, netplay->state_size))
+            return false;
+      }
+   }
+
+   if (have_state)
+   {
+      uint32_t crc[2];
+      crc[0] = htonl(delta->frame);
+      crc[1] = htonl(netplay_delta_frame_crc(netplay, delta));
+      if (!netplay_record_write(netplay, NETPLAY_CMD_CRC,
+            crc, sizeof(crc), NULL, 0))
+         return false;
+   }
+
+   /* The input as the core saw it, zeros where nobody was there */
+   input[0] = htonl(delta->frame);
+   input[1] = 0;
+   for (device = 0; device < MAX_INPUT_DEVICES; device++)
+   {
+      netplay_input_state_t istate = delta->resolved_input[device];
+      uint32_t dsize;
+
+      if ((netplay->config_devices[device]&RETRO_DEVICE_MASK)
+            == RETRO_DEVICE_NONE)
+         continue;
+
+      dsize = netplay_expected_input_size(netplay, 1 << device);
+      for (i = 0; i < dsize; i++)
+         input[used + i] = (istate && istate->used && istate->size == dsize)
+            ? htonl(istate->data[i]) : 0;
+      used += dsize;
+   }
+
+   return netplay_record_write(netplay, NETPLAY_CMD_INPUT,
+         input, used * sizeof(uint32_t), NULL, 0);
+}
+
+/**
+ * netplay_record_init
+ *
+ * Start recording this session into a new file in the given directory.
+ */
+bool netplay_record_init(netplay_t *netplay, const char *dir)
+{
+   char name[PATH_MAX_LENGTH];
+   char path[PATH_MAX_LENGTH];
+
+   name[0] = path[0] = '\0';
+
+   fill_str_dated_filename(name,
+         netplay->is_server ? "netplay-host" : "netplay-client",
+         "ranp", sizeof(name));
+   fill_pathname_join(path, dir, name, sizeof(path));
+
+   if (!path_is_directory(dir))
+      path_mkdir(dir);
+
+   netplay->record_file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   if (!netplay->record_file)
+   {
+      RARCH_ERR("[netplay] Could not open recording \"%s\".\n", path);
+      return false;
+   }
+
+   netplay->record_frame = 0;
+   netplay->record_state = true;
+   RARCH_LOG("[netplay] Recording to \"%s\".\n", path);
+   return true;
+}
+
+/**
+ * netplay_record_deinit
+ *
+ * Finish the recording, if any.
+ */
+void netplay_record_deinit(netplay_t *netplay)
+{
+   if (!netplay->record_file)
+      return;
+   filestream_close(netplay->record_file);
+   netplay->record_file = NULL;
+}
+
+/**
+ * netplay_record_reload
+ *
+ * The state at the start of the given frame was loaded or reset rather than
+ * run into, so record it in full, and record again from there.
+ */
+void netplay_record_reload(netplay_t *netplay, uint32_t frame)
+{
+   if (!netplay->record_file || !netplay->record_frame)
+      return;
+   netplay->record_frame = frame;
+   netplay->record_state = true;
+}
+
+/**
+ * netplay_record_frames
+ *
+ * Record the frames we've finished with since the last call.
+ */
+void netplay_record_frames(netplay_t *netplay)
+{
+   uint32_t end = netplay->other_frame_count < netplay->run_frame_count ?
+      netplay->other_frame_count : netplay->run_frame_count;
+
+   if (!netplay->record_file)
+      return;
+
+   if (!netplay->record_frame)
+   {
+      /* Frame 0 is never serialized, so the server starts after it. A
+       * client's frames only mean anything once it has synced. */
+      uint32_t start = 1;
+      if (!netplay->is_server)
+      {
+         if (netplay->connections[0].mode < NETPLAY_CONNECTION_CONNECTED)
+            return;
+         start = end;
+      }
+      if (end <= start && netplay->is_server)
+         return;
+      if (!netplay_record_header(netplay))
+         return;
+      netplay->record_frame = start;
+   }
+
+   /* Whatever has left the buffer is gone */
+   if (netplay->record_frame < end &&
+         end - netplay->record_frame >= netplay->buffer_size)
+   {
+      netplay->record_frame = end - (uint32_t)netplay->buffer_size + 1;
+      netplay->record_state = true;
+   }
+
+   while (netplay->record_frame < end)
+   {
+      size_t ptr = (netplay->run_ptr + netplay->buffer_size -
+            (netplay->run_frame_count - netplay->record_frame))
+         % netplay->buffer_size;
+      struct delta_frame *delta = &netplay->buffer[ptr];
+
+      if (!delta->used || delta->frame != netplay->record_frame)
+         netplay->record_state = true;
+      else if (!netplay_record_frame(netplay, delta))
+         return;
+
+      netplay->record_frame++;
+   }
+}
@@ -0,0 +1,324 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Delta savestates.
+ *
+ * Whenever a client joins, a desync is detected or someone loads a state,
+ * the whole serialized state goes over the wire, which is megabytes for some
+ * cores. But both sides usually still share a recent state: every check frame,
+ * the server sends the CRC of its state to the clients, and a client whose
+ * own state matches now holds the same data. So the server keeps a copy of the
+ * last few states it sent CRCs for, a client keeps a copy of the last few it
+ * confirmed and reports them back (NETPLAY_CMD_STATE_BASE), and savestates are
+ * then sent as a patch against the latest such base the peer has reported, in
+ * the block format of the rewind state manager.
+ *
+ * If the receiver doesn't have the base any more, it asks for a full state
+ * instead, and a peer that never reported a base gets one anyway.
+ *
+ * Delta payload (32-bit words, network order unless noted):
+ *    frame, inflated size, base frame, base CRC,
+ *    byte order mark (1, in the sender's order), compressed patch
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <features/features_cpu.h>
+
+#include "netplay_private.h"
+
+#include "../../managers/state_manager.h"
+
+#define DELTA_HEADER_WORDS 7
+
+static struct netplay_state_base *netplay_state_find_base(
+      netplay_t *netplay, uint32_t frame, uint32_t crc)
+{
+   unsigned i;
+
+   for (i = 0; i < NETPLAY_STATE_BASES; i++)
+   {
+      struct netplay_state_base *base = &netplay->state_bases[i];
+      if (     base->used
+            && base->frame == frame
+            && base->crc   == crc
+            && base->size  == netplay->state_size)
+         return base;
+   }
+
+   return NULL;
+}
+
+static bool netplay_state_keep(netplay_t *netplay,
+      struct delta_frame *delta, uint32_t crc)
+{
+   struct netplay_state_base *base =
+      &netplay->state_bases[netplay->state_base_next];
+
+   if (!delta->state || !crc)
+      return false;
+
+   if (base->size != netplay->state_size)
+   {
+      void *state = realloc(base->state, netplay->state_size);
+      if (!state)
+         return false;
+      base->state = state;
+      base->size  = netplay->state_size;
+   }
+
+   memcpy(base->state, delta->state, netplay->state_size);
+   base->frame = delta->frame;
+   base->crc   = crc;
+   base->used  = true;
+
+   netplay->state_base_next = (netplay->state_base_next + 1)
+      % NETPLAY_STATE_BASES;
+   return true;
+}
+
+/**
+ * netplay_state_deinit
+ *
+ * Free the delta savestate bases and patch buffer.
+ */
+void netplay_state_deinit(netplay_t *netplay)
+{
+   unsigned i;
+
+   for (i = 0; i < NETPLAY_STATE_BASES; i++)
+   {
+      free(netplay->state_bases[i].state);
+      netplay->state_bases[i].state = NULL;
+      netplay->state_bases[i].size  = 0;
+      netplay->state_bases[i].used  = false;
+   }
+
+   free(netplay->delta_patch);
+   netplay->delta_patch      = NULL;
+   netplay->delta_patch_size = 0;
+}
+
+/**
+ * netplay_state_store_base
+ *
+ * Keep a copy of a frame whose CRC we're sending to our clients (server).
+ */
+void netplay_state_store_base(netplay_t *netplay, struct delta_frame *delta)
+{
+   size_t i;
+
+   /* Not worth the copy if nobody will ever use it */
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (connection->active && connection->delta_states)
+         break;
+   }
+   if (i == netplay->connections_size)
+      return;
+
+   netplay_state_keep(netplay, delta, delta->crc);
+}
+
+/**
+ * netplay_state_confirm_base
+ *
+ * Keep a copy of a frame whose CRC matched the server's and report it as our
+ * base (client).
+ */
+void netplay_state_confirm_base(netplay_t *netplay, struct delta_frame *delta)
+{
+   uint32_t payload[2];
+   struct netplay_connection *connection = &netplay->connections[0];
+
+   if (     netplay->is_server
+         || netplay->connections_size == 0
+         || !connection->active
+         || !connection->delta_states
+         || connection->mode < NETPLAY_CONNECTION_CONNECTED)
+      return;
+
+   if (!netplay_state_keep(netplay, delta, delta->crc))
+      return;
+
+   payload[0] = htonl(delta->frame);
+   payload[1] = htonl(delta->crc);
+   if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_STATE_BASE,
+            payload, sizeof(payload)))
+   {
+      netplay_hangup(netplay, connection);
+      return;
+   }
+
+   /* The server kept this one when it sent us the CRC */
+   connection->state_base_valid = true;
+   connection->state_base_frame = delta->frame;
+   connection->state_base_crc   = delta->crc;
+}
+
+/**
+ * netplay_state_set_base
+ *
+ * Handle a peer's report of the base it keeps.
+ */
+void netplay_state_set_base(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t frame, uint32_t crc)
+{
+   connection->state_base_frame = frame;
+   connection->state_base_crc   = crc;
+   connection->state_base_valid = crc &&
+      netplay_state_find_base(netplay, frame, crc);
+}
+
+/**
+ * netplay_state_send_delta
+ *
+ * Send a savestate as a delta against the base we share with this peer.
+ *
+ * Returns false if there's no usable base, so the full state should be sent.
+ */
+bool netplay_state_send_delta(netplay_t *netplay,
+   struct netplay_connection *connection,
+   retro_ctx_serialize_info_t *serial_info, struct compression_transcoder *z)
+{
+   uint32_t header[DELTA_HEADER_WORDS];
+   uint32_t rd, wn;
+   size_t patch_len;
+   struct netplay_state_base *base = NULL;
+
+   if (     !connection->delta_states
+         || !connection->state_base_valid
+         || serial_info->size != netplay->state_size)
+      return false;
+
+   base = netplay_state_find_base(netplay,
+         connection->state_base_frame, connection->state_base_crc);
+   if (!base)
+      return false;
+
+   if (!netplay->delta_patch)
+   {
+      netplay->delta_patch_size = state_manager_delta_maxsize(
+            netplay->state_size);
+      netplay->delta_patch      = (uint8_t*)malloc(netplay->delta_patch_size);
+      if (!netplay->delta_patch)
+      {
+         netplay->delta_patch_size = 0;
+         return false;
+      }
+   }
+
+   patch_len = state_manager_delta_compress(base->state,
+         serial_info->data_const, netplay->state_size, netplay->delta_patch);
+
+   /* The receiver only has room for a patch up to the state's size, and
+    * anything bigger isn't worth it anyway */
+   if (patch_len >= netplay->state_size)
+      return false;
+
+   z->compression_backend->set_in(z->compression_stream,
+      netplay->delta_patch, (uint32_t)patch_len);
+   z->compression_backend->set_out(z->compression_stream,
+      netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
+   if (!z->compression_backend->trans(z->compression_stream, true, &rd,
+         &wn, NULL))
+      return false;
+
+   header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE_DELTA);
+   header[1] = htonl(wn + (DELTA_HEADER_WORDS - 2) * sizeof(uint32_t));
+   header[2] = htonl(netplay->run_frame_count);
+   header[3] = htonl(serial_info->size);
+   header[4] = htonl(base->frame);
+   header[5] = htonl(base->crc);
+   header[6] = 1;
+
+   if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
+         sizeof(header)) ||
+       !netplay_send(&connection->send_packet_buffer, connection->fd,
+         netplay->zbuffer, wn))
+   {
+      netplay_hangup(netplay, connection);
+      return true;
+   }
+
+   connection->sync_cmds_sent++;
+   netplay->stats.states_sent++;
+   netplay->stats.state_deltas_sent++;
+   netplay->stats.state_bytes_sent += sizeof(header) + wn;
+
+   RARCH_LOG("[netplay] Sent savestate for frame %u as a delta against frame %u: %u bytes (%u patch, %u state).\n",
+         netplay->run_frame_count, base->frame,
+         (unsigned)(sizeof(header) + wn), (unsigned)patch_len,
+         (unsigned)netplay->state_size);
+
+   return true;
+}
+
+/**
+ * netplay_state_load_delta
+ *
+ * Rebuild a state from a received delta into @state.
+ *
+ * Returns false if we don't have its base or it's malformed.
+ */
+bool netplay_state_load_delta(netplay_t *netplay, uint32_t base_frame,
+   uint32_t base_crc, const uint8_t *patch, size_t patch_len, void *state)
+{
+   struct netplay_state_base *base = netplay_state_find_base(netplay,
+         base_frame, base_crc);
+
+   if (!base)
+      return false;
+
+   /* Check it before touching the frame buffer */
+   if (!state_manager_delta_apply(patch, patch_len, NULL,
+            netplay->state_size))
+      return false;
+
+   memcpy(state, base->state, netplay->state_size);
+   return state_manager_delta_apply(patch, patch_len, state,
+         netplay->state_size);
+}
+
+/**
+ * netplay_state_request_full
+ *
+ * Forget our base with this peer and ask it for a full savestate.
+ */
+bool netplay_state_request_full(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   uint32_t payload[2];
+
+   payload[0] = 0;
+   payload[1] = 0;
+   connection->state_base_valid = false;
+
+   if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_STATE_BASE,
+            payload, sizeof(payload)))
+      return false;
+
+   if (!netplay->is_server)
+   {
+      netplay->savestate_request_outstanding = false;
+      return netplay_cmd_request_savestate(netplay);
+   }
+
+   return netplay_send_raw_cmd(netplay, connection,
+         NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0);
+}
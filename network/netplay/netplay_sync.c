@@ -507,6 +507,7 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
       {
          delta->crc = netplay_delta_frame_crc(netplay, delta);
          netplay_cmd_crc(netplay, delta);
+         netplay_state_store_base(netplay, delta);
       }
    }
    else if (delta->crc && netplay->crcs_valid)
@@ -531,8 +532,12 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
                netplay_cmd_request_savestate(netplay);
          }
       }
-      else if (!netplay->crc_validity_checked)
-         netplay->crc_validity_checked = true;
+      else
+      {
+         if (!netplay->crc_validity_checked)
+            netplay->crc_validity_checked = true;
+         netplay_state_confirm_base(netplay, delta);
+      }
    }
 }
 
@@ -702,6 +707,7 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
          memset(connection, 0, sizeof(*connection));
          connection->active = true;
          connection->fd = new_fd;
+         connection->addr = their_addr;
          connection->mode = NETPLAY_CONNECTION_INIT;
 
          if (!netplay_init_socket_buffer(&connection->send_packet_buffer,
@@ -716,6 +722,7 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
             goto process;
          }
 
+         netplay_poll_watch(netplay, new_fd, (uint32_t) connection_num);
          netplay_handshake_init_send(netplay, connection);
 
       }
@@ -829,6 +836,9 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
 
       /* Replay frames. */
       netplay->is_replay = true;
+      netplay->stats.rollbacks++;
+      netplay->stats.replayed_frames +=
+         netplay->run_frame_count - netplay->replay_frame_count;
 
       /* If we have a keyboard device, we replay the previous frame's input
        * just to assert that the keydown/keyup events work if the core
@@ -0,0 +1,768 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The unreliable input channel.
+ *
+ * Over TCP, one lost segment holds up every input frame behind it until it's
+ * retransmitted, which shows up as stalls and long rollbacks. When both sides
+ * support it, every frame we also send each peer a datagram carrying the last
+ * few frames of input it hasn't acknowledged yet, so a lost datagram is
+ * covered by the next one. TCP still carries everything (including the same
+ * input), and input that already arrived over UDP is simply ignored there.
+ *
+ * The only subtlety is ordering: over TCP, input is ordered with respect to
+ * mode changes and savestate loads, and the receiving code relies on that. So
+ * every datagram carries how many such commands the sender has sent us and the
+ * first frame a future one could refer to, and its input is only used once
+ * we've processed as many of those commands, and only before that frame.
+ *
+ * Expect more but shorter rollbacks than over TCP. A delayed TCP segment
+ * brings several frames at once, and every misprediction among them is
+ * fixed by one rollback. Datagrams bring the same frames one at a time, so
+ * each input change costs its own rollback. A resimulation also keeps the
+ * d-pad of its earlier guess (see netplay_resolve_input), so a d-pad change
+ * costs one more rollback for each frame of it that was already guessed.
+ *
+ * Datagram layout (32-bit words, network order):
+ *    magic, token, sequence, sync commands, sync frame, acks | (blocks << 16)
+ *    per ack:   client, next frame needed
+ *    per block: client | (words per frame << 16), first frame, count,
+ *               count * words of input
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <net/net_compat.h>
+#include <net/net_socket.h>
+
+#include "netplay_private.h"
+
+#if defined(AF_INET6) && !defined(HAVE_SOCKET_LEGACY)
+#define HAVE_INET6 1
+#endif
+
+#define UDP_HEADER_WORDS 6
+#define UDP_MAX_WORDS    (NETPLAY_UDP_MAX_SIZE / sizeof(uint32_t))
+
+#ifdef DEBUG_NETPLAY_NETSIM
+struct netsim_datagram
+{
+   retro_time_t due;
+   int fd;
+   struct sockaddr_storage addr;
+   socklen_t addr_len;
+   size_t len;
+   uint32_t data[UDP_MAX_WORDS];
+};
+
+#define NETSIM_QUEUE_SIZE 64
+static struct netsim_datagram netsim_queue[NETSIM_QUEUE_SIZE];
+
+static void netsim_flush(void)
+{
+   retro_time_t now = cpu_features_get_time_usec();
+   size_t i;
+
+   for (i = 0; i < NETSIM_QUEUE_SIZE; i++)
+   {
+      struct netsim_datagram *dg = &netsim_queue[i];
+      if (dg->len && dg->due <= now)
+      {
+         sendto(dg->fd, (const char *) dg->data, dg->len, 0,
+               (struct sockaddr *) &dg->addr, dg->addr_len);
+         dg->len = 0;
+      }
+   }
+}
+
+/**
+ * netplay_netsim_tcp_hold
+ *
+ * Network simulator: should this flush of TCP data be held back? Each batch
+ * of data is delayed once, by the jitter or, if its segment was "lost", by
+ * the retransmission timeout, and everything behind it waits too.
+ */
+bool netplay_netsim_tcp_hold(struct socket_buffer *sbuf)
+{
+   retro_time_t now = cpu_features_get_time_usec();
+
+   if (sbuf->netsim_hold)
+   {
+      if (now < sbuf->netsim_hold)
+         return true;
+      sbuf->netsim_hold = 0;
+      return false;
+   }
+
+   if (rand() % 100 < NETSIM_LOSS_PERCENT)
+      sbuf->netsim_hold = now + NETSIM_TCP_RTO_MS * 1000;
+   else
+      sbuf->netsim_hold = now + (rand() % (NETSIM_JITTER_MS + 1)) * 1000 + 1;
+   return true;
+}
+
+/**
+ * netplay_netsim_input
+ *
+ * Network simulator: joypad input for the given frame. It only depends on
+ * the frame, so replays see the same input, and on a seed taken at startup,
+ * so each peer has its own.
+ */
+uint32_t netplay_netsim_input(uint32_t frame)
+{
+   static uint32_t seed;
+
+   if (!seed)
+      seed = (uint32_t) cpu_features_get_time_usec() | 1;
+
+   return ((frame / NETSIM_INPUT_FRAMES) * 2654435761u ^ seed) & 0xFFF;
+}
+#endif
+
+static void send_datagram(netplay_t *netplay,
+      struct netplay_connection *connection, const uint32_t *data, size_t len)
+{
+#ifdef DEBUG_NETPLAY_NETSIM
+   size_t i;
+
+   netsim_flush();
+   if (rand() % 100 < NETSIM_LOSS_PERCENT)
+      return;
+
+   for (i = 0; i < NETSIM_QUEUE_SIZE; i++)
+   {
+      struct netsim_datagram *dg = &netsim_queue[i];
+      if (dg->len)
+         continue;
+      dg->due      = cpu_features_get_time_usec() +
+         (rand() % (NETSIM_JITTER_MS + 1)) * 1000;
+      dg->fd       = netplay->udp_fd;
+      dg->addr     = connection->udp_addr;
+      dg->addr_len = connection->udp_addr_len;
+      dg->len      = len;
+      memcpy(dg->data, data, len);
+      return;
+   }
+#endif
+
+   sendto(netplay->udp_fd, (const char *) data, len, 0,
+         (struct sockaddr *) &connection->udp_addr,
+         connection->udp_addr_len);
+}
+
+/* Do these addresses name the same host (and, if ports, the same port)? */
+static bool same_addr(const struct sockaddr_storage *a,
+      const struct sockaddr_storage *b, bool ports)
+{
+   if (a->ss_family != b->ss_family)
+      return false;
+
+   switch (a->ss_family)
+   {
+      case AF_INET:
+      {
+         const struct sockaddr_in *a4 = (const struct sockaddr_in *) a;
+         const struct sockaddr_in *b4 = (const struct sockaddr_in *) b;
+         return !memcmp(&a4->sin_addr, &b4->sin_addr, sizeof(a4->sin_addr)) &&
+            (!ports || a4->sin_port == b4->sin_port);
+      }
+#ifdef HAVE_INET6
+      case AF_INET6:
+      {
+         const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *) a;
+         const struct sockaddr_in6 *b6 = (const struct sockaddr_in6 *) b;
+         return !memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(a6->sin6_addr)) &&
+            (!ports || a6->sin6_port == b6->sin6_port);
+      }
+#endif
+      default:
+         break;
+   }
+
+   return false;
+}
+
+static void set_addr_port(struct sockaddr_storage *addr, uint16_t port)
+{
+   switch (addr->ss_family)
+   {
+      case AF_INET:
+         ((struct sockaddr_in *) addr)->sin_port = htons(port);
+         break;
+#ifdef HAVE_INET6
+      case AF_INET6:
+         ((struct sockaddr_in6 *) addr)->sin6_port = htons(port);
+         break;
+#endif
+      default:
+         break;
+   }
+}
+
+static socklen_t sockaddr_size(const struct sockaddr_storage *addr)
+{
+#ifdef HAVE_INET6
+   if (addr->ss_family == AF_INET6)
+      return sizeof(struct sockaddr_in6);
+#endif
+   return sizeof(struct sockaddr_in);
+}
+
+static int open_udp_socket(const struct sockaddr_storage *addr)
+{
+   int fd = socket(addr->ss_family, SOCK_DGRAM, 0);
+
+   if (fd < 0)
+      return -1;
+
+#if defined(HAVE_INET6) && defined(IPPROTO_IPV6) && defined(IPV6_V6ONLY)
+   if (addr->ss_family == AF_INET6)
+   {
+      /* Match the TCP socket, which takes both IPv6 and IPv4 */
+      int on = 0;
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&on, sizeof(on));
+   }
+#endif
+
+   if (!socket_nonblock(fd))
+   {
+      socket_close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+/**
+ * netplay_udp_init
+ *
+ * Open the server's UDP input socket.
+ */
+bool netplay_udp_init(netplay_t *netplay)
+{
+   struct sockaddr_storage addr;
+   socklen_t addr_size = sizeof(addr);
+   int fd;
+
+   /* Same family and address as our listening socket, any port (the
+    * netplay port itself is taken by LAN discovery) */
+   memset(&addr, 0, sizeof(addr));
+   if (getsockname(netplay->listen_fd, (struct sockaddr *) &addr,
+            &addr_size) < 0)
+      return false;
+   set_addr_port(&addr, 0);
+
+   fd = open_udp_socket(&addr);
+   if (fd < 0)
+      return false;
+
+   if (bind(fd, (struct sockaddr *) &addr, sockaddr_size(&addr)) < 0)
+   {
+      socket_close(fd);
+      return false;
+   }
+
+   netplay->udp_fd = fd;
+   netplay_poll_watch(netplay, fd, NETPLAY_POLL_UDP);
+   return true;
+}
+
+/**
+ * netplay_udp_deinit
+ *
+ * Close the UDP input socket and log its statistics.
+ */
+void netplay_udp_deinit(netplay_t *netplay)
+{
+   if (netplay->udp_fd < 0)
+      return;
+
+   RARCH_LOG("[netplay] UDP input: %u datagrams sent, %u received, %u lost, "
+         "%u frames ahead of TCP.\n",
+         netplay->stats.udp_sent, netplay->stats.udp_received,
+         netplay->stats.udp_lost, netplay->stats.udp_frames);
+
+   netplay_poll_unwatch(netplay, netplay->udp_fd);
+   socket_close(netplay->udp_fd);
+   netplay->udp_fd = -1;
+}
+
+/**
+ * netplay_udp_offer
+ *
+ * Tell a freshly synchronized client where to send its datagrams (server).
+ */
+bool netplay_udp_offer(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   struct sockaddr_storage addr;
+   socklen_t addr_size = sizeof(addr);
+   uint32_t payload[2];
+   uint16_t port       = 0;
+
+   if (netplay->udp_fd < 0)
+      return true;
+
+   memset(&addr, 0, sizeof(addr));
+   if (getsockname(netplay->udp_fd, (struct sockaddr *) &addr,
+            &addr_size) < 0)
+      return true;
+
+   switch (addr.ss_family)
+   {
+      case AF_INET:
+         port = ntohs(((struct sockaddr_in *) &addr)->sin_port);
+         break;
+#ifdef HAVE_INET6
+      case AF_INET6:
+         port = ntohs(((struct sockaddr_in6 *) &addr)->sin6_port);
+         break;
+#endif
+      default:
+         return true;
+   }
+
+   payload[0] = htonl(port);
+   payload[1] = htonl(connection->udp_token);
+
+   return netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_UDP_INFO,
+         payload, sizeof(payload)) &&
+      netplay_send_flush(&connection->send_packet_buffer, connection->fd,
+         false);
+}
+
+/**
+ * netplay_udp_accept
+ *
+ * Handle the server's offer of a UDP input channel (client).
+ */
+bool netplay_udp_accept(netplay_t *netplay,
+   struct netplay_connection *connection, uint16_t port, uint32_t token)
+{
+   struct sockaddr_storage addr;
+   socklen_t addr_size = sizeof(addr);
+
+   /* The datagrams go to the same host as the TCP connection */
+   memset(&addr, 0, sizeof(addr));
+   if (getpeername(connection->fd, (struct sockaddr *) &addr,
+            &addr_size) < 0)
+      return false;
+   set_addr_port(&addr, port);
+
+   if (netplay->udp_fd < 0)
+   {
+      netplay->udp_fd = open_udp_socket(&addr);
+      if (netplay->udp_fd < 0)
+         return false;
+      netplay_poll_watch(netplay, netplay->udp_fd, NETPLAY_POLL_UDP);
+   }
+
+   connection->udp_token    = token;
+   connection->udp_addr     = addr;
+   connection->udp_addr_len = sockaddr_size(&addr);
+   connection->udp_active   = true;
+
+   RARCH_LOG("[netplay] Sending input over UDP to port %u.\n",
+         (unsigned) port);
+   return true;
+}
+
+/* The buffered frame of input from this client, if we still have it */
+static struct delta_frame *buffered_input_frame(netplay_t *netplay, uint32_t client,
+      uint32_t frame)
+{
+   struct delta_frame *dframe;
+   uint32_t back = netplay->read_frame_count[client] - frame;
+
+   if (back == 0 || back >= netplay->buffer_size)
+      return NULL;
+
+   dframe = &netplay->buffer[(netplay->read_ptr[client] +
+         netplay->buffer_size - back) % netplay->buffer_size];
+   if (!dframe->used || dframe->frame != frame || !dframe->have_real[client])
+      return NULL;
+
+   return dframe;
+}
+
+/* Append one frame of a client's input, returning false if we don't have
+ * all of it */
+static bool put_input_frame(netplay_t *netplay, struct delta_frame *dframe,
+      uint32_t client, uint32_t *out)
+{
+   uint32_t device, devices = netplay->client_devices[client];
+   size_t i, used          = 0;
+
+   for (device = 0; device < MAX_INPUT_DEVICES; device++)
+   {
+      netplay_input_state_t istate;
+      uint32_t dsize;
+      if (!(devices & (1<<device)))
+         continue;
+      dsize  = netplay_expected_input_size(netplay, 1 << device);
+      istate = dframe->real_input[device];
+      while (istate && (!istate->used || istate->client_num != client))
+         istate = istate->next;
+      if (!istate || istate->size != dsize)
+         return false;
+      for (i = 0; i < dsize; i++)
+         out[used++] = htonl(istate->data[i]);
+   }
+
+   return true;
+}
+
+/* Build and send one connection's datagram */
+static void send_input_datagram(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t to_client)
+{
+   uint32_t buf[UDP_MAX_WORDS];
+   uint32_t client, nacks = 0, nblocks = 0;
+   uint32_t sync_frame = netplay->self_frame_count;
+   size_t used         = UDP_HEADER_WORDS;
+
+   buf[0] = htonl(NETPLAY_UDP_MAGIC);
+   buf[1] = htonl(connection->udp_token);
+   buf[2] = htonl(++connection->udp_seq);
+   buf[3] = htonl(connection->sync_cmds_sent);
+   buf[4] = htonl(sync_frame);
+
+   /* Tell them how far we've read. The server only takes input from the
+    * client itself, a client from everyone else. */
+   for (client = 0; client < MAX_CLIENTS; client++)
+   {
+      if (!(netplay->connected_players & (1<<client)) ||
+            client == netplay->self_client_num ||
+            (netplay->is_server && client != to_client))
+         continue;
+      buf[used++] = htonl(client);
+      buf[used++] = htonl(netplay->read_frame_count[client]);
+      nacks++;
+   }
+
+   /* Then the input they haven't acknowledged. A client only sends its own,
+    * the server everyone's but theirs, and none beyond the sync frame, as
+    * we might yet send a command that comes before it. */
+   for (client = 0; client < MAX_CLIENTS; client++)
+   {
+      uint32_t words, first, end, count, frame;
+      size_t block;
+
+      if (!(netplay->connected_players & (1<<client)) ||
+            (netplay->connected_slaves & (1<<client)))
+         continue;
+      if (netplay->is_server ? client == to_client :
+            (client != netplay->self_client_num ||
+             netplay->self_mode != NETPLAY_CONNECTION_PLAYING))
+         continue;
+
+      words = netplay_expected_input_size(netplay,
+            netplay->client_devices[client]);
+      end   = netplay->read_frame_count[client];
+      if (end > sync_frame)
+         end = sync_frame;
+      first = (end > netplay->udp_input_frames) ?
+         end - netplay->udp_input_frames : 0;
+      if (connection->udp_acked & (1<<client))
+      {
+         if (connection->udp_acks[client] >= end)
+            continue;
+         if (connection->udp_acks[client] > first)
+            first = connection->udp_acks[client];
+      }
+
+      /* Skip whatever we no longer have */
+      while (first < end && !buffered_input_frame(netplay, client, first))
+         first++;
+      if (!words || first >= end ||
+            used + 3 + words > UDP_MAX_WORDS)
+         continue;
+
+      block = used;
+      used += 3;
+      count = 0;
+      for (frame = first; frame < end; frame++)
+      {
+         struct delta_frame *dframe = buffered_input_frame(netplay, client, frame);
+         if (!dframe || used + words > UDP_MAX_WORDS ||
+               !put_input_frame(netplay, dframe, client, buf + used))
+            break;
+         used += words;
+         count++;
+      }
+
+      if (!count)
+      {
+         used = block;
+         continue;
+      }
+      buf[block]     = htonl(client | (words << 16));
+      buf[block + 1] = htonl(first);
+      buf[block + 2] = htonl(count);
+      nblocks++;
+   }
+
+   buf[5] = htonl(nacks | (nblocks << 16));
+
+   send_datagram(netplay, connection, buf, used * sizeof(uint32_t));
+   netplay->stats.udp_sent++;
+}
+
+/**
+ * netplay_udp_send
+ *
+ * Send the latest frames of input to every peer with a UDP channel.
+ */
+void netplay_udp_send(netplay_t *netplay)
+{
+   retro_time_t now;
+   size_t i;
+
+   if (netplay->udp_fd < 0)
+      return;
+
+   /* Once per frame, and now and then while stalled to keep acks flowing */
+   now = cpu_features_get_time_usec();
+   if (netplay->self_frame_count == netplay->udp_send_frame &&
+         now - netplay->udp_send_time < NETPLAY_UDP_RESEND_TIME_USEC)
+      return;
+   netplay->udp_send_frame = netplay->self_frame_count;
+   netplay->udp_send_time  = now;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (connection->active && connection->udp_active &&
+          connection->mode >= NETPLAY_CONNECTION_CONNECTED)
+         send_input_datagram(netplay, connection, (uint32_t)(i + 1));
+   }
+}
+
+/* Read in a block of input, returning true if any of it was new */
+static bool recv_input_block(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t client,
+      uint32_t first, uint32_t count, uint32_t words, uint32_t sync_frame,
+      const uint32_t *data)
+{
+   uint32_t devices = netplay->client_devices[client];
+   bool ret         = false;
+   uint32_t i;
+
+   for (i = 0; i < count; i++)
+   {
+      struct delta_frame *dframe;
+      uint32_t device, frame = first + i;
+      const uint32_t *in     = data + i * words;
+
+      if (frame < netplay->read_frame_count[client])
+         continue;
+      if (frame > netplay->read_frame_count[client] || frame >= sync_frame)
+         break;
+
+      dframe = &netplay->buffer[netplay->read_ptr[client]];
+      if (!netplay_delta_frame_ready(netplay, dframe, frame))
+         break;
+
+      for (device = 0; device < MAX_INPUT_DEVICES; device++)
+      {
+         netplay_input_state_t istate;
+         uint32_t dsize, di;
+         if (!(devices & (1<<device)))
+            continue;
+
+         dsize  = netplay_expected_input_size(netplay, 1 << device);
+         istate = netplay_input_state_for(&dframe->real_input[device],
+               client, dsize, false, false);
+         if (!istate)
+            return ret;
+         for (di = 0; di < dsize; di++)
+            istate->data[di] = ntohl(*in++);
+      }
+      dframe->have_real[client] = true;
+
+      netplay_input_received(netplay, connection, client, dframe);
+      netplay->stats.udp_frames++;
+      ret = true;
+   }
+
+   return ret;
+}
+
+/* Find the connection a datagram belongs to */
+static struct netplay_connection *datagram_connection(netplay_t *netplay,
+      uint32_t token, const struct sockaddr_storage *from, socklen_t from_len)
+{
+   size_t i;
+
+   if (!netplay->is_server)
+   {
+      struct netplay_connection *connection = &netplay->connections[0];
+      if (connection->active && connection->udp_active &&
+            connection->udp_token == token &&
+            same_addr(&connection->udp_addr, from, true))
+         return connection;
+      return NULL;
+   }
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (!connection->active || !connection->udp_supported ||
+            connection->mode < NETPLAY_CONNECTION_CONNECTED ||
+            !token || connection->udp_token != token)
+         continue;
+
+      /* It has to come from the host we're talking to over TCP, but we learn
+       * the port (and follow it if a NAT changes it) from the datagrams */
+      if (!same_addr(&connection->addr, from, false))
+         return NULL;
+      if (!connection->udp_active ||
+            !same_addr(&connection->udp_addr, from, true))
+      {
+         connection->udp_addr     = *from;
+         connection->udp_addr_len = from_len;
+         connection->udp_active   = true;
+      }
+      return connection;
+   }
+
+   return NULL;
+}
+
+/* Handle one datagram, returning true if it had new input */
+static bool handle_datagram(netplay_t *netplay, const uint32_t *buf, size_t words,
+      const struct sockaddr_storage *from, socklen_t from_len)
+{
+   struct netplay_connection *connection;
+   uint32_t seq, sync_cmds, sync_frame, nacks, nblocks, i;
+   uint32_t from_client;
+   size_t used = UDP_HEADER_WORDS;
+   bool ret    = false;
+
+   if (words < UDP_HEADER_WORDS || ntohl(buf[0]) != NETPLAY_UDP_MAGIC)
+      return false;
+
+   connection = datagram_connection(netplay, ntohl(buf[1]), from, from_len);
+   if (!connection)
+      return false;
+
+   /* Anything older than what we've seen is covered by what we've seen */
+   netplay->stats.udp_received++;
+   seq = ntohl(buf[2]);
+   if (seq <= connection->udp_recv_seq)
+      return false;
+   netplay->stats.udp_lost += seq - connection->udp_recv_seq - 1;
+   connection->udp_recv_seq = seq;
+
+   sync_cmds  = ntohl(buf[3]);
+   sync_frame = ntohl(buf[4]);
+   nacks      = ntohl(buf[5]) & 0xFFFF;
+   nblocks    = ntohl(buf[5]) >> 16;
+
+   if (used + 2 * nacks > words)
+      return false;
+   for (i = 0; i < nacks; i++)
+   {
+      uint32_t client = ntohl(buf[used++]);
+      uint32_t frame  = ntohl(buf[used++]);
+      if (client >= MAX_CLIENTS)
+         continue;
+      connection->udp_acks[client] = frame;
+      connection->udp_acked       |= (1<<client);
+   }
+
+   /* Input that may have overtaken a command has to wait for TCP */
+   if (sync_cmds != connection->sync_cmds_recvd ||
+         connection->mode != NETPLAY_CONNECTION_PLAYING)
+      return false;
+
+   from_client = (uint32_t)(connection - netplay->connections + 1);
+   for (i = 0; i < nblocks; i++)
+   {
+      uint32_t client, words_per, first, count;
+
+      if (used + 3 > words)
+         break;
+      client    = ntohl(buf[used]) & 0xFFFF;
+      words_per = ntohl(buf[used]) >> 16;
+      first     = ntohl(buf[used + 1]);
+      count     = ntohl(buf[used + 2]);
+      used     += 3;
+      if (count > NETPLAY_UDP_MAX_FRAMES ||
+            used + count * words_per > words)
+         break;
+
+      /* Same rules as TCP: the server takes a client's own input, a client
+       * takes everyone's but its own */
+      if (client < MAX_CLIENTS &&
+            (netplay->connected_players & (1<<client)) &&
+            !(netplay->connected_slaves & (1<<client)) &&
+            (netplay->is_server ? client == from_client :
+             client != netplay->self_client_num) &&
+            words_per == netplay_expected_input_size(netplay,
+               netplay->client_devices[client]) &&
+            recv_input_block(netplay, connection, client, first, count,
+               words_per, sync_frame, buf + used))
+         ret = true;
+
+      used += count * words_per;
+   }
+
+   return ret;
+}
+
+/**
+ * netplay_udp_poll
+ *
+ * Read any pending datagrams.
+ *
+ * Returns true if any new input was read.
+ */
+bool netplay_udp_poll(netplay_t *netplay)
+{
+   uint32_t buf[UDP_MAX_WORDS];
+   bool ret = false;
+   unsigned i;
+
+   if (netplay->udp_fd < 0)
+      return false;
+
+#ifdef DEBUG_NETPLAY_NETSIM
+   netsim_flush();
+#endif
+
+   /* A few frames' worth from each peer at most. The socket is
+    * non-blocking, so running dry just ends the loop. */
+   for (i = 0; i < 64; i++)
+   {
+      struct sockaddr_storage from;
+      socklen_t from_len    = sizeof(from);
+      ssize_t len;
+
+      memset(&from, 0, sizeof(from));
+      len = recvfrom(netplay->udp_fd, (char *) buf, sizeof(buf), 0,
+            (struct sockaddr *) &from, &from_len);
+      if (len <= 0)
+         break;
+
+      if (handle_datagram(netplay, buf, (size_t) len / sizeof(uint32_t), &from,
+               from_len))
+         ret = true;
+   }
+
+   return ret;
+}
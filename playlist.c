@@ -39,14 +39,65 @@
 #define PLAYLIST_ENTRIES 6
 #endif
 
+#define PLAYLIST_ARENA_BLOCK_MIN  (4 * 1024)
+#define PLAYLIST_ARENA_BLOCK_MAX  (64 * 1024)
+#define PLAYLIST_INDEX_BUCKETS    64
+#define PLAYLIST_INDEX_NONE       0xffffffff
+
+/* Entries are stored oldest first, so that pushing to the top
+ * of the playlist is an append. Converts a playlist index to
+ * a position in the entries array and back. */
+#define PLAYLIST_SLOT(playlist, idx) ((playlist)->size - 1 - (idx))
+
+enum playlist_index_type
+{
+   PLAYLIST_INDEX_PATH = 0,
+   /* Archive part of '[archive_path]#[rom_file]' paths,
+    * for fuzzy archive matching */
+   PLAYLIST_INDEX_ARCHIVE,
+   PLAYLIST_INDEX_CRC32,
+   PLAYLIST_INDEX_LABEL,
+   PLAYLIST_INDEX_LAST
+};
+
+/* Hash chains link entries by slot. A zero hash means the
+ * entry has no key for that index. */
+struct playlist_index_node
+{
+   uint32_t hash[PLAYLIST_INDEX_LAST];
+   uint32_t next[PLAYLIST_INDEX_LAST];
+};
+
+/* Entry strings are never freed one by one. Strings that are
+ * replaced or whose entry goes away are only counted, and the
+ * arena is compacted when the playlist is written out. */
+struct playlist_arena_block
+{
+   struct playlist_arena_block *next;
+   size_t used;
+   size_t size;
+   char data[1];
+};
+
 struct content_playlist
 {
    bool modified;
+   /* The index is built on the first lookup, so that
+    * playlists that are only displayed don't pay for
+    * resolving the path of every entry. */
+   bool indexed;
    size_t size;
    size_t cap;
+   size_t alloc;
+   size_t buckets_count;
+   /* Bytes of the arena no entry points to anymore */
+   size_t arena_freed;
 
    char *conf_path;
    struct playlist_entry *entries;
+   struct playlist_index_node *nodes;
+   uint32_t *buckets;
+   struct playlist_arena_block *arena;
 };
 
 typedef struct
@@ -70,10 +121,536 @@ typedef struct
 
 static playlist_t *playlist_cached = NULL;
 
+static const struct playlist_entry playlist_entry_empty = {0};
+
 typedef int (playlist_sort_fun_t)(
       const struct playlist_entry *a,
       const struct playlist_entry *b);
 
+typedef bool (playlist_match_fun_t)(
+      const struct playlist_entry *entry,
+      const void *userdata);
+
+/**
+ * playlist_strdup:
+ * @playlist            : Playlist handle.
+ * @str                 : String to copy.
+ *
+ * Copies @str into the string arena of @playlist.
+ *
+ * Returns: the copy, valid until the playlist is cleared
+ * or freed, or NULL on allocation failure.
+ **/
+static char *playlist_strdup(playlist_t *playlist, const char *str)
+{
+   char *copy                         = NULL;
+   size_t len                         = strlen(str) + 1;
+   struct playlist_arena_block *block = playlist->arena;
+
+   if (!block || block->size - block->used < len)
+   {
+      size_t size = block ? block->size * 2 : PLAYLIST_ARENA_BLOCK_MIN;
+
+      if (size > PLAYLIST_ARENA_BLOCK_MAX)
+         size = PLAYLIST_ARENA_BLOCK_MAX;
+      if (size < len)
+         size = len;
+
+      block = (struct playlist_arena_block*)
+         malloc(sizeof(*block) + size);
+
+      if (!block)
+         return NULL;
+
+      block->used = 0;
+      block->size = size;
+
+      /* An oversized string gets a block of its own, keep
+       * filling the current one afterwards */
+      if (playlist->arena && size == len)
+      {
+         block->next          = playlist->arena->next;
+         playlist->arena->next = block;
+      }
+      else
+      {
+         block->next          = playlist->arena;
+         playlist->arena      = block;
+      }
+   }
+
+   copy         = block->data + block->used;
+   memcpy(copy, str, len);
+   block->used += len;
+
+   return copy;
+}
+
+/* Accounts for @str, a string of the arena that is about to
+ * be dropped by its entry. */
+static void playlist_strfree(playlist_t *playlist, const char *str)
+{
+   if (str)
+      playlist->arena_freed += strlen(str) + 1;
+}
+
+static void playlist_arena_free(playlist_t *playlist)
+{
+   struct playlist_arena_block *block = playlist->arena;
+
+   while (block)
+   {
+      struct playlist_arena_block *next = block->next;
+      free(block);
+      block = next;
+   }
+
+   playlist->arena       = NULL;
+   playlist->arena_freed = 0;
+}
+
+static void playlist_arena_move(char **str, char *data, size_t *used)
+{
+   size_t len;
+
+   if (!*str)
+      return;
+
+   len    = strlen(*str) + 1;
+   memcpy(data + *used, *str, len);
+   *str   = data + *used;
+   *used += len;
+}
+
+/**
+ * playlist_arena_compact:
+ * @playlist            : Playlist handle.
+ *
+ * Copies the strings still in use into a single new block
+ * once at least half of the arena is unused, so that updating
+ * entries doesn't grow it without bound. The strings of all
+ * entries move.
+ **/
+static void playlist_arena_compact(playlist_t *playlist)
+{
+   size_t i;
+   size_t used                        = 0;
+   struct playlist_arena_block *block = NULL;
+
+   for (block = playlist->arena; block; block = block->next)
+      used += block->used;
+
+   if (!playlist->arena_freed || playlist->arena_freed * 2 < used)
+      return;
+
+   used -= playlist->arena_freed;
+
+   /* Keep the old arena if there is no memory for the new one */
+   block = (struct playlist_arena_block*)malloc(sizeof(*block) + used);
+   if (!block)
+      return;
+
+   block->next = NULL;
+   block->used = 0;
+   block->size = used;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      struct playlist_entry *entry = &playlist->entries[i];
+
+      playlist_arena_move(&entry->path,            block->data, &block->used);
+      playlist_arena_move(&entry->label,           block->data, &block->used);
+      playlist_arena_move(&entry->core_path,       block->data, &block->used);
+      playlist_arena_move(&entry->core_name,       block->data, &block->used);
+      playlist_arena_move(&entry->db_name,         block->data, &block->used);
+      playlist_arena_move(&entry->crc32,           block->data, &block->used);
+      playlist_arena_move(&entry->subsystem_ident, block->data, &block->used);
+      playlist_arena_move(&entry->subsystem_name,  block->data, &block->used);
+   }
+
+   playlist_arena_free(playlist);
+   playlist->arena = block;
+}
+
+/**
+ * playlist_reserve:
+ * @playlist            : Playlist handle.
+ * @count               : Amount of entries needed.
+ *
+ * Grows the entries array, up to the capacity of the playlist.
+ *
+ * Returns: true if there's room for @count entries.
+ **/
+static bool playlist_reserve(playlist_t *playlist, size_t count)
+{
+   size_t alloc                   = playlist->alloc ? playlist->alloc : 16;
+   struct playlist_entry *entries = NULL;
+
+   if (count <= playlist->alloc)
+      return true;
+
+   if (count > playlist->cap)
+      return false;
+
+   while (alloc < count)
+      alloc *= 2;
+
+   if (alloc > playlist->cap)
+      alloc = playlist->cap;
+
+   entries = (struct playlist_entry*)realloc(playlist->entries,
+         alloc * sizeof(*entries));
+
+   if (!entries)
+      return false;
+
+   memset(entries + playlist->alloc, 0,
+         (alloc - playlist->alloc) * sizeof(*entries));
+   playlist->entries = entries;
+
+   if (playlist->indexed)
+   {
+      struct playlist_index_node *nodes = (struct playlist_index_node*)
+         realloc(playlist->nodes, alloc * sizeof(*nodes));
+
+      if (!nodes)
+         return false;
+
+      playlist->nodes = nodes;
+   }
+
+   playlist->alloc = alloc;
+
+   return true;
+}
+
+static uint32_t playlist_hash_string(const char *str, size_t len,
+      bool case_sensitive)
+{
+   size_t i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < len; i++)
+   {
+      unsigned char c = (unsigned char)str[i];
+
+      if (!case_sensitive && c >= 'A' && c <= 'Z')
+         c = c - 'A' + 'a';
+
+      hash = (hash << 5) + hash + c;
+   }
+
+   /* Zero means 'no key' */
+   return hash ? hash : 1;
+}
+
+/* Paths are compared the same way as in playlist_path_equal() */
+static uint32_t playlist_hash_path(const char *path, size_t len)
+{
+#ifdef _WIN32
+   return playlist_hash_string(path, len, false);
+#else
+   return playlist_hash_string(path, len, true);
+#endif
+}
+
+static void playlist_index_hash_path(playlist_t *playlist,
+      size_t slot, const char *real_path)
+{
+   struct playlist_index_node *node = &playlist->nodes[slot];
+   const char *delim                = NULL;
+   char tmp[PATH_MAX_LENGTH];
+
+   if (!real_path)
+   {
+      const char *path = playlist->entries[slot].path;
+
+      tmp[0] = '\0';
+
+      if (!string_is_empty(path))
+      {
+         strlcpy(tmp, path, sizeof(tmp));
+         path_resolve_realpath(tmp, sizeof(tmp));
+      }
+
+      real_path = tmp;
+   }
+
+   node->hash[PLAYLIST_INDEX_PATH]    = playlist_hash_path(real_path,
+         strlen(real_path));
+   node->hash[PLAYLIST_INDEX_ARCHIVE] = 0;
+
+   if (!string_is_empty(real_path) &&
+         (delim = path_get_archive_delim(real_path)))
+      node->hash[PLAYLIST_INDEX_ARCHIVE] = playlist_hash_path(real_path,
+            delim - real_path);
+}
+
+static void playlist_index_hash_keys(playlist_t *playlist, size_t slot)
+{
+   const struct playlist_entry *entry = &playlist->entries[slot];
+   struct playlist_index_node *node   = &playlist->nodes[slot];
+
+   node->hash[PLAYLIST_INDEX_CRC32] = string_is_empty(entry->crc32)
+      ? 0 : playlist_hash_string(entry->crc32, strlen(entry->crc32), false);
+   node->hash[PLAYLIST_INDEX_LABEL] = string_is_empty(entry->label)
+      ? 0 : playlist_hash_string(entry->label, strlen(entry->label), true);
+}
+
+static uint32_t *playlist_index_bucket(playlist_t *playlist,
+      unsigned type, uint32_t hash)
+{
+   return &playlist->buckets[type * playlist->buckets_count
+      + (hash & (playlist->buckets_count - 1))];
+}
+
+/* Chains are sorted by descending slot, so that the
+ * first match is the most recent entry. */
+static void playlist_index_link(playlist_t *playlist, size_t slot)
+{
+   unsigned type;
+   struct playlist_index_node *node = &playlist->nodes[slot];
+
+   for (type = 0; type < PLAYLIST_INDEX_LAST; type++)
+   {
+      uint32_t *prev = NULL;
+
+      node->next[type] = PLAYLIST_INDEX_NONE;
+
+      if (!node->hash[type])
+         continue;
+
+      prev = playlist_index_bucket(playlist, type, node->hash[type]);
+
+      while (*prev != PLAYLIST_INDEX_NONE && *prev > slot)
+         prev = &playlist->nodes[*prev].next[type];
+
+      node->next[type] = *prev;
+      *prev            = (uint32_t)slot;
+   }
+}
+
+static void playlist_index_unlink(playlist_t *playlist, size_t slot)
+{
+   unsigned type;
+   struct playlist_index_node *node = &playlist->nodes[slot];
+
+   for (type = 0; type < PLAYLIST_INDEX_LAST; type++)
+   {
+      uint32_t *prev = NULL;
+
+      if (!node->hash[type])
+         continue;
+
+      prev = playlist_index_bucket(playlist, type, node->hash[type]);
+
+      while (*prev != PLAYLIST_INDEX_NONE && *prev != slot)
+         prev = &playlist->nodes[*prev].next[type];
+
+      if (*prev == slot)
+         *prev = node->next[type];
+   }
+}
+
+/* Rebuilds the hash chains from the hashes of the entries,
+ * after entries were moved around. */
+static bool playlist_index_relink(playlist_t *playlist)
+{
+   size_t slot;
+   size_t count = PLAYLIST_INDEX_BUCKETS;
+
+   while (count < playlist->size)
+      count *= 2;
+
+   if (count != playlist->buckets_count)
+   {
+      uint32_t *buckets = (uint32_t*)realloc(playlist->buckets,
+            PLAYLIST_INDEX_LAST * count * sizeof(*buckets));
+
+      if (!buckets)
+         return false;
+
+      playlist->buckets       = buckets;
+      playlist->buckets_count = count;
+   }
+
+   memset(playlist->buckets, 0xff,
+         PLAYLIST_INDEX_LAST * count * sizeof(*playlist->buckets));
+
+   for (slot = 0; slot < playlist->size; slot++)
+      playlist_index_link(playlist, slot);
+
+   return true;
+}
+
+static void playlist_index_free(playlist_t *playlist)
+{
+   free(playlist->nodes);
+   free(playlist->buckets);
+
+   playlist->nodes         = NULL;
+   playlist->buckets       = NULL;
+   playlist->buckets_count = 0;
+   playlist->indexed       = false;
+}
+
+static bool playlist_index_build(playlist_t *playlist)
+{
+   size_t slot;
+
+   if (playlist->indexed)
+      return true;
+
+   if (!playlist->alloc)
+      playlist_reserve(playlist, 1);
+
+   if (!(playlist->nodes = (struct playlist_index_node*)
+            malloc(playlist->alloc * sizeof(*playlist->nodes))))
+      return false;
+
+   for (slot = 0; slot < playlist->size; slot++)
+   {
+      playlist_index_hash_path(playlist, slot, NULL);
+      playlist_index_hash_keys(playlist, slot);
+   }
+
+   playlist->indexed = true;
+
+   if (!playlist_index_relink(playlist))
+   {
+      playlist_index_free(playlist);
+      return false;
+   }
+
+   return true;
+}
+
+/* Adds the entry that was just appended at the top */
+static void playlist_index_push(playlist_t *playlist, const char *real_path)
+{
+   size_t slot = playlist->size - 1;
+
+   if (!playlist->indexed)
+      return;
+
+   playlist_index_hash_path(playlist, slot, real_path);
+   playlist_index_hash_keys(playlist, slot);
+
+   if (playlist->size > playlist->buckets_count)
+   {
+      if (!playlist_index_relink(playlist))
+         playlist_index_free(playlist);
+   }
+   else
+      playlist_index_link(playlist, slot);
+}
+
+/* Call after changing the path, label or CRC of an entry */
+static void playlist_index_update(playlist_t *playlist, size_t slot,
+      bool path_changed)
+{
+   if (!playlist->indexed)
+      return;
+
+   playlist_index_unlink(playlist, slot);
+   if (path_changed)
+      playlist_index_hash_path(playlist, slot, NULL);
+   playlist_index_hash_keys(playlist, slot);
+   playlist_index_link(playlist, slot);
+}
+
+/**
+ * playlist_free_entry:
+ * @playlist            : Playlist handle.
+ * @entry               : Playlist entry handle.
+ *
+ * Frees playlist entry.
+ **/
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
+{
+   if (!entry)
+      return;
+
+   /* Strings belong to the arena of the playlist */
+   playlist_strfree(playlist, entry->path);
+   playlist_strfree(playlist, entry->label);
+   playlist_strfree(playlist, entry->core_path);
+   playlist_strfree(playlist, entry->core_name);
+   playlist_strfree(playlist, entry->db_name);
+   playlist_strfree(playlist, entry->crc32);
+   playlist_strfree(playlist, entry->subsystem_ident);
+   playlist_strfree(playlist, entry->subsystem_name);
+
+   if (entry->subsystem_roms != NULL)
+      string_list_free(entry->subsystem_roms);
+
+   entry->path      = NULL;
+   entry->label     = NULL;
+   entry->core_path = NULL;
+   entry->core_name = NULL;
+   entry->db_name   = NULL;
+   entry->crc32     = NULL;
+   entry->subsystem_ident = NULL;
+   entry->subsystem_name = NULL;
+   entry->subsystem_roms = NULL;
+   entry->runtime_hours = 0;
+   entry->runtime_minutes = 0;
+   entry->runtime_seconds = 0;
+   entry->last_played_year = 0;
+   entry->last_played_month = 0;
+   entry->last_played_day = 0;
+   entry->last_played_hour = 0;
+   entry->last_played_minute = 0;
+   entry->last_played_second = 0;
+}
+
+/**
+ * playlist_remove_slot:
+ * @playlist            : Playlist handle.
+ * @slot                : Position in the entries array.
+ *
+ * Removes an entry from the entries array, without
+ * freeing it.
+ **/
+static void playlist_remove_slot(playlist_t *playlist, size_t slot)
+{
+   size_t count = playlist->size - slot - 1;
+
+   memmove(playlist->entries + slot, playlist->entries + slot + 1,
+         count * sizeof(*playlist->entries));
+
+   if (playlist->indexed)
+      memmove(playlist->nodes + slot, playlist->nodes + slot + 1,
+            count * sizeof(*playlist->nodes));
+
+   playlist->size--;
+
+   if (playlist->indexed && !playlist_index_relink(playlist))
+      playlist_index_free(playlist);
+}
+
+/* Moves an entry to the top of the playlist */
+static void playlist_move_to_top(playlist_t *playlist, size_t slot)
+{
+   struct playlist_entry tmp        = playlist->entries[slot];
+   struct playlist_index_node node;
+
+   if (playlist->indexed)
+      node = playlist->nodes[slot];
+
+   playlist_remove_slot(playlist, slot);
+
+   playlist->entries[playlist->size] = tmp;
+   if (playlist->indexed)
+      playlist->nodes[playlist->size] = node;
+
+   playlist->size++;
+
+   if (playlist->indexed)
+      playlist_index_link(playlist, playlist->size - 1);
+}
+
 /**
  * playlist_path_equal:
  * @real_path           : 'Real' search path, generated by path_resolve_realpath()
@@ -174,31 +751,138 @@ static bool playlist_path_equal(const char *real_path, const char *entry_path)
  **/
 static bool playlist_core_path_equal(const char *real_core_path, const char *entry_core_path)
 {
-   char entry_real_core_path[PATH_MAX_LENGTH];
+   char entry_real_core_path[PATH_MAX_LENGTH];
+
+   entry_real_core_path[0] = '\0';
+
+   /* Sanity check */
+   if (string_is_empty(real_core_path) || string_is_empty(entry_core_path))
+      return false;
+
+   /* Get entry 'real' core path */
+   strlcpy(entry_real_core_path, entry_core_path, sizeof(entry_real_core_path));
+   path_resolve_realpath(entry_real_core_path, sizeof(entry_real_core_path));
+
+   if (string_is_empty(entry_real_core_path))
+      return false;
+
+#ifdef _WIN32
+   /* Handle case-insensitive operating systems*/
+   if (string_is_equal_noncase(real_core_path, entry_real_core_path))
+      return true;
+#else
+   if (string_is_equal(real_core_path, entry_real_core_path))
+      return true;
+#endif
+
+   return false;
+}
+
+static uint32_t playlist_find_path_chain(playlist_t *playlist,
+      unsigned type, uint32_t hash, const char *real_path,
+      playlist_match_fun_t *match, const void *userdata)
+{
+   uint32_t slot = *playlist_index_bucket(playlist, type, hash);
+
+   for (; slot != PLAYLIST_INDEX_NONE;
+         slot = playlist->nodes[slot].next[type])
+   {
+      const struct playlist_entry *entry = &playlist->entries[slot];
+
+      if (playlist->nodes[slot].hash[type] != hash)
+         continue;
+
+      if (!(string_is_empty(real_path) && string_is_empty(entry->path)) &&
+            !playlist_path_equal(real_path, entry->path))
+         continue;
+
+      if (!match || match(entry, userdata))
+         return slot;
+   }
+
+   return PLAYLIST_INDEX_NONE;
+}
+
+/**
+ * playlist_find_path:
+ * @playlist            : Playlist handle.
+ * @real_path           : 'Real' search path, generated by path_resolve_realpath()
+ * @match               : Additional condition, may be NULL.
+ * @userdata            : Passed to @match.
+ *
+ * Finds the most recent entry matching @real_path, same as
+ * comparing each entry with playlist_path_equal().
+ *
+ * Returns: position of the entry in the entries array,
+ * or PLAYLIST_INDEX_NONE.
+ **/
+static uint32_t playlist_find_path(playlist_t *playlist,
+      const char *real_path,
+      playlist_match_fun_t *match, const void *userdata)
+{
+   settings_t *settings = config_get_ptr();
+   uint32_t slot        = PLAYLIST_INDEX_NONE;
+
+   if (!playlist_index_build(playlist))
+      return PLAYLIST_INDEX_NONE;
+
+   slot = playlist_find_path_chain(playlist, PLAYLIST_INDEX_PATH,
+         playlist_hash_path(real_path, strlen(real_path)),
+         real_path, match, userdata);
+
+   /* Archive paths with and without the [delimiter][rom_file]
+    * part, see playlist_path_equal() */
+   if (!string_is_empty(real_path) &&
+         settings && settings->bools.playlist_fuzzy_archive_match)
+   {
+      uint32_t fuzzy_slot = PLAYLIST_INDEX_NONE;
+      const char *delim   = path_get_archive_delim(real_path);
+
+      if (delim)
+         fuzzy_slot = playlist_find_path_chain(playlist, PLAYLIST_INDEX_PATH,
+               playlist_hash_path(real_path, delim - real_path),
+               real_path, match, userdata);
+      else if (path_is_compressed_file(real_path))
+         fuzzy_slot = playlist_find_path_chain(playlist, PLAYLIST_INDEX_ARCHIVE,
+               playlist_hash_path(real_path, strlen(real_path)),
+               real_path, match, userdata);
+
+      if (fuzzy_slot != PLAYLIST_INDEX_NONE &&
+            (slot == PLAYLIST_INDEX_NONE || fuzzy_slot > slot))
+         slot = fuzzy_slot;
+   }
+
+   return slot;
+}
+
+static const struct playlist_entry *playlist_find_key(playlist_t *playlist,
+      unsigned type, const char *key)
+{
+   uint32_t slot;
+   uint32_t hash;
 
-   entry_real_core_path[0] = '\0';
+   if (!playlist || string_is_empty(key) || !playlist_index_build(playlist))
+      return NULL;
 
-   /* Sanity check */
-   if (string_is_empty(real_core_path) || string_is_empty(entry_core_path))
-      return false;
+   hash = playlist_hash_string(key, strlen(key),
+         type != PLAYLIST_INDEX_CRC32);
 
-   /* Get entry 'real' core path */
-   strlcpy(entry_real_core_path, entry_core_path, sizeof(entry_real_core_path));
-   path_resolve_realpath(entry_real_core_path, sizeof(entry_real_core_path));
+   for (slot = *playlist_index_bucket(playlist, type, hash);
+         slot != PLAYLIST_INDEX_NONE;
+         slot = playlist->nodes[slot].next[type])
+   {
+      const struct playlist_entry *entry = &playlist->entries[slot];
 
-   if (string_is_empty(entry_real_core_path))
-      return false;
+      if (playlist->nodes[slot].hash[type] != hash)
+         continue;
 
-#ifdef _WIN32
-   /* Handle case-insensitive operating systems*/
-   if (string_is_equal_noncase(real_core_path, entry_real_core_path))
-      return true;
-#else
-   if (string_is_equal(real_core_path, entry_real_core_path))
-      return true;
-#endif
+      if (type == PLAYLIST_INDEX_CRC32
+            ? string_is_equal_noncase(entry->crc32, key)
+            : string_is_equal(entry->label, key))
+         return entry;
+   }
 
-   return false;
+   return NULL;
 }
 
 uint32_t playlist_get_size(playlist_t *playlist)
@@ -232,7 +916,13 @@ void playlist_get_index(playlist_t *playlist,
    if (!playlist || !entry)
       return;
 
-   *entry = &playlist->entries[idx];
+   if (idx >= playlist->size)
+   {
+      *entry = &playlist_entry_empty;
+      return;
+   }
+
+   *entry = &playlist->entries[PLAYLIST_SLOT(playlist, idx)];
 }
 
 void playlist_get_runtime_index(playlist_t *playlist,
@@ -242,31 +932,35 @@ void playlist_get_runtime_index(playlist_t *playlist,
       unsigned *last_played_year, unsigned *last_played_month, unsigned *last_played_day,
       unsigned *last_played_hour, unsigned *last_played_minute, unsigned *last_played_second)
 {
-   if (!playlist)
+   const struct playlist_entry *entry = NULL;
+
+   if (!playlist || idx >= playlist->size)
       return;
 
+   entry = &playlist->entries[PLAYLIST_SLOT(playlist, idx)];
+
    if (path)
-      *path      = playlist->entries[idx].path;
+      *path      = entry->path;
    if (core_path)
-      *core_path = playlist->entries[idx].core_path;
+      *core_path = entry->core_path;
    if (runtime_hours)
-      *runtime_hours = playlist->entries[idx].runtime_hours;
+      *runtime_hours = entry->runtime_hours;
    if (runtime_minutes)
-      *runtime_minutes = playlist->entries[idx].runtime_minutes;
+      *runtime_minutes = entry->runtime_minutes;
    if (runtime_seconds)
-      *runtime_seconds = playlist->entries[idx].runtime_seconds;
+      *runtime_seconds = entry->runtime_seconds;
    if (last_played_year)
-      *last_played_year = playlist->entries[idx].last_played_year;
+      *last_played_year = entry->last_played_year;
    if (last_played_month)
-      *last_played_month = playlist->entries[idx].last_played_month;
+      *last_played_month = entry->last_played_month;
    if (last_played_day)
-      *last_played_day = playlist->entries[idx].last_played_day;
+      *last_played_day = entry->last_played_day;
    if (last_played_hour)
-      *last_played_hour = playlist->entries[idx].last_played_hour;
+      *last_played_hour = entry->last_played_hour;
    if (last_played_minute)
-      *last_played_minute = playlist->entries[idx].last_played_minute;
+      *last_played_minute = entry->last_played_minute;
    if (last_played_second)
-      *last_played_second = playlist->entries[idx].last_played_second;
+      *last_played_second = entry->last_played_second;
 }
 
 /**
@@ -279,13 +973,15 @@ void playlist_get_runtime_index(playlist_t *playlist,
 void playlist_delete_index(playlist_t *playlist,
       size_t idx)
 {
-   if (!playlist)
+   size_t slot;
+
+   if (!playlist || idx >= playlist->size)
       return;
 
-   playlist->size     = playlist->size - 1;
+   slot = PLAYLIST_SLOT(playlist, idx);
 
-   memmove(playlist->entries + idx, playlist->entries + idx + 1,
-         (playlist->size - idx) * sizeof(struct playlist_entry));
+   playlist_free_entry(playlist, &playlist->entries[slot]);
+   playlist_remove_slot(playlist, slot);
 
    playlist->modified = true;
 }
@@ -294,7 +990,7 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const char *search_path,
       const struct playlist_entry **entry)
 {
-   size_t i;
+   uint32_t slot;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -306,22 +1002,38 @@ void playlist_get_index_by_path(playlist_t *playlist,
    strlcpy(real_search_path, search_path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path));
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (!playlist_path_equal(real_search_path, playlist->entries[i].path))
-         continue;
+   slot = playlist_find_path(playlist, real_search_path, NULL, NULL);
+
+   if (slot != PLAYLIST_INDEX_NONE)
+      *entry = &playlist->entries[slot];
+}
 
-      *entry = &playlist->entries[i];
+void playlist_get_index_by_crc32(playlist_t *playlist,
+      const char *crc32,
+      const struct playlist_entry **entry)
+{
+   const struct playlist_entry *found = playlist_find_key(playlist,
+         PLAYLIST_INDEX_CRC32, crc32);
 
-      break;
-   }
+   if (found && entry)
+      *entry = found;
+}
+
+void playlist_get_index_by_label(playlist_t *playlist,
+      const char *label,
+      const struct playlist_entry **entry)
+{
+   const struct playlist_entry *found = playlist_find_key(playlist,
+         PLAYLIST_INDEX_LABEL, label);
+
+   if (found && entry)
+      *entry = found;
 }
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32)
 {
-   size_t i;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -333,121 +1045,71 @@ bool playlist_entry_exists(playlist_t *playlist,
    strlcpy(real_search_path, path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path));
 
-   for (i = 0; i < playlist->size; i++)
-      if (playlist_path_equal(real_search_path, playlist->entries[i].path))
-         return true;
-
-   return false;
-}
-
-/**
- * playlist_free_entry:
- * @entry               : Playlist entry handle.
- *
- * Frees playlist entry.
- **/
-static void playlist_free_entry(struct playlist_entry *entry)
-{
-   if (!entry)
-      return;
-
-   if (entry->path != NULL)
-      free(entry->path);
-   if (entry->label != NULL)
-      free(entry->label);
-   if (entry->core_path != NULL)
-      free(entry->core_path);
-   if (entry->core_name != NULL)
-      free(entry->core_name);
-   if (entry->db_name != NULL)
-      free(entry->db_name);
-   if (entry->crc32 != NULL)
-      free(entry->crc32);
-   if (entry->subsystem_ident != NULL)
-      free(entry->subsystem_ident);
-   if (entry->subsystem_name != NULL)
-      free(entry->subsystem_name);
-   if (entry->subsystem_roms != NULL)
-      string_list_free(entry->subsystem_roms);
-
-   entry->path      = NULL;
-   entry->label     = NULL;
-   entry->core_path = NULL;
-   entry->core_name = NULL;
-   entry->db_name   = NULL;
-   entry->crc32     = NULL;
-   entry->subsystem_ident = NULL;
-   entry->subsystem_name = NULL;
-   entry->subsystem_roms = NULL;
-   entry->runtime_hours = 0;
-   entry->runtime_minutes = 0;
-   entry->runtime_seconds = 0;
-   entry->last_played_year = 0;
-   entry->last_played_month = 0;
-   entry->last_played_day = 0;
-   entry->last_played_hour = 0;
-   entry->last_played_minute = 0;
-   entry->last_played_second = 0;
+   return playlist_find_path(playlist, real_search_path,
+         NULL, NULL) != PLAYLIST_INDEX_NONE;
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
       const struct playlist_entry *update_entry)
 {
+   size_t slot;
    struct playlist_entry *entry = NULL;
+   bool path_changed            = false;
+   bool keys_changed            = false;
 
-   if (!playlist || idx > playlist->size)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   entry            = &playlist->entries[idx];
+   slot             = PLAYLIST_SLOT(playlist, idx);
+   entry            = &playlist->entries[slot];
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path != NULL)
-         free(entry->path);
-      entry->path        = strdup(update_entry->path);
+      playlist_strfree(playlist, entry->path);
+      entry->path        = playlist_strdup(playlist, update_entry->path);
+      path_changed       = true;
       playlist->modified = true;
    }
 
    if (update_entry->label && (update_entry->label != entry->label))
    {
-      if (entry->label != NULL)
-         free(entry->label);
-      entry->label       = strdup(update_entry->label);
+      playlist_strfree(playlist, entry->label);
+      entry->label       = playlist_strdup(playlist, update_entry->label);
+      keys_changed       = true;
       playlist->modified = true;
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path != NULL)
-         free(entry->core_path);
-      entry->core_path   = NULL;
-      entry->core_path   = strdup(update_entry->core_path);
+      playlist_strfree(playlist, entry->core_path);
+      entry->core_path   = playlist_strdup(playlist, update_entry->core_path);
       playlist->modified = true;
    }
 
    if (update_entry->core_name && (update_entry->core_name != entry->core_name))
    {
-      if (entry->core_name != NULL)
-         free(entry->core_name);
-      entry->core_name   = strdup(update_entry->core_name);
+      playlist_strfree(playlist, entry->core_name);
+      entry->core_name   = playlist_strdup(playlist, update_entry->core_name);
       playlist->modified = true;
    }
 
    if (update_entry->db_name && (update_entry->db_name != entry->db_name))
    {
-      if (entry->db_name != NULL)
-         free(entry->db_name);
-      entry->db_name     = strdup(update_entry->db_name);
+      playlist_strfree(playlist, entry->db_name);
+      entry->db_name     = playlist_strdup(playlist, update_entry->db_name);
       playlist->modified = true;
    }
 
    if (update_entry->crc32 && (update_entry->crc32 != entry->crc32))
    {
-      if (entry->crc32 != NULL)
-         free(entry->crc32);
-      entry->crc32       = strdup(update_entry->crc32);
+      playlist_strfree(playlist, entry->crc32);
+      entry->crc32       = playlist_strdup(playlist, update_entry->crc32);
+      keys_changed       = true;
       playlist->modified = true;
    }
+
+   if (path_changed || keys_changed)
+      playlist_index_update(playlist, slot, path_changed);
 }
 
 void playlist_update_runtime(playlist_t *playlist, size_t idx,
@@ -457,27 +1119,27 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
       unsigned last_played_hour, unsigned last_played_minute, unsigned last_played_second,
       bool register_update)
 {
+   size_t slot;
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx > playlist->size)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   entry            = &playlist->entries[idx];
+   slot             = PLAYLIST_SLOT(playlist, idx);
+   entry            = &playlist->entries[slot];
 
    if (path && (path != entry->path))
    {
-      if (entry->path != NULL)
-         free(entry->path);
-      entry->path        = strdup(path);
+      playlist_strfree(playlist, entry->path);
+      entry->path        = playlist_strdup(playlist, path);
       playlist->modified = playlist->modified || register_update;
+      playlist_index_update(playlist, slot, true);
    }
 
    if (core_path && (core_path != entry->core_path))
    {
-      if (entry->core_path != NULL)
-         free(entry->core_path);
-      entry->core_path   = NULL;
-      entry->core_path   = strdup(core_path);
+      playlist_strfree(playlist, entry->core_path);
+      entry->core_path   = playlist_strdup(playlist, core_path);
       playlist->modified = playlist->modified || register_update;
    }
 
@@ -536,13 +1198,53 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
    }
 }
 
+static bool playlist_push_runtime_match(
+      const struct playlist_entry *entry, const void *userdata)
+{
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only. */
+   return playlist_core_path_equal((const char*)userdata, entry->core_path);
+}
+
+/**
+ * playlist_push_slot:
+ * @playlist            : Playlist handle.
+ *
+ * Makes room for a new entry at the top of the playlist,
+ * dropping the oldest entry if the playlist is full.
+ *
+ * Returns: the new, zeroed entry, or NULL on allocation failure.
+ **/
+static struct playlist_entry *playlist_push_slot(playlist_t *playlist)
+{
+   struct playlist_entry *entry = NULL;
+
+   if (!playlist->cap)
+      return NULL;
+
+   if (playlist->size == playlist->cap)
+   {
+      playlist_free_entry(playlist, &playlist->entries[0]);
+      playlist_remove_slot(playlist, 0);
+   }
+
+   if (!playlist_reserve(playlist, playlist->size + 1))
+      return NULL;
+
+   entry = &playlist->entries[playlist->size];
+   memset(entry, 0, sizeof(*entry));
+
+   return entry;
+}
+
 bool playlist_push_runtime(playlist_t *playlist,
       const char *path, const char *core_path,
       unsigned runtime_hours, unsigned runtime_minutes, unsigned runtime_seconds,
       unsigned last_played_year, unsigned last_played_month, unsigned last_played_day,
       unsigned last_played_hour, unsigned last_played_minute, unsigned last_played_second)
 {
-   size_t i;
+   uint32_t slot;
+   struct playlist_entry *entry = NULL;
    char real_path[PATH_MAX_LENGTH];
    char real_core_path[PATH_MAX_LENGTH];
 
@@ -575,73 +1277,117 @@ bool playlist_push_runtime(playlist_t *playlist,
       return false;
    }
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      struct playlist_entry tmp;
-      const char *entry_path = playlist->entries[i].path;
-      bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path);
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (!playlist_core_path_equal(real_core_path, playlist->entries[i].core_path))
-         continue;
+   slot = playlist_find_path(playlist, real_path,
+         playlist_push_runtime_match, real_core_path);
 
+   if (slot != PLAYLIST_INDEX_NONE)
+   {
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
-      if (i == 0)
+      if (slot == playlist->size - 1)
          return false;
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      playlist_move_to_top(playlist, slot);
 
       goto success;
    }
 
-   if (playlist->size == playlist->cap)
-   {
-      struct playlist_entry *entry = &playlist->entries[playlist->cap - 1];
+   if (!(entry = playlist_push_slot(playlist)))
+      return false;
 
-      if (entry)
-         playlist_free_entry(entry);
-      playlist->size--;
-   }
+   if (!string_is_empty(real_path))
+      entry->path      = playlist_strdup(playlist, real_path);
+   if (!string_is_empty(real_core_path))
+      entry->core_path = playlist_strdup(playlist, real_core_path);
+
+   entry->runtime_hours      = runtime_hours;
+   entry->runtime_minutes    = runtime_minutes;
+   entry->runtime_seconds    = runtime_seconds;
+   entry->last_played_year   = last_played_year;
+   entry->last_played_month  = last_played_month;
+   entry->last_played_day    = last_played_day;
+   entry->last_played_hour   = last_played_hour;
+   entry->last_played_minute = last_played_minute;
+   entry->last_played_second = last_played_second;
 
-   if (playlist->entries)
+   playlist->size++;
+   playlist_index_push(playlist, real_path);
+
+success:
+   playlist->modified = true;
+
+   return true;
+}
+
+struct playlist_push_state
+{
+   const struct playlist_entry *entry;
+   const char *real_core_path;
+};
+
+static bool playlist_push_match(
+      const struct playlist_entry *playlist_entry, const void *userdata)
+{
+   const struct playlist_push_state *state =
+      (const struct playlist_push_state*)userdata;
+   const struct playlist_entry *entry      = state->entry;
+
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only. */
+   if (!playlist_core_path_equal(state->real_core_path, playlist_entry->core_path))
+      return false;
+
+   if (     !string_is_empty(entry->subsystem_ident) 
+         && !string_is_empty(playlist_entry->subsystem_ident) 
+         && !string_is_equal(playlist_entry->subsystem_ident, entry->subsystem_ident))
+      return false;
+
+   if (      string_is_empty(entry->subsystem_ident) 
+         && !string_is_empty(playlist_entry->subsystem_ident))
+      return false;
+
+   if (    !string_is_empty(entry->subsystem_ident) 
+         && string_is_empty(playlist_entry->subsystem_ident))
+      return false;
+
+   if (     !string_is_empty(entry->subsystem_name) 
+         && !string_is_empty(playlist_entry->subsystem_name) 
+         && !string_is_equal(playlist_entry->subsystem_name, entry->subsystem_name))
+      return false;
+
+   if (      string_is_empty(entry->subsystem_name) 
+         && !string_is_empty(playlist_entry->subsystem_name))
+      return false;
+
+   if (     !string_is_empty(entry->subsystem_name) 
+         &&  string_is_empty(playlist_entry->subsystem_name))
+      return false;
+
+   if (entry->subsystem_roms)
    {
-      memmove(playlist->entries + 1, playlist->entries,
-            (playlist->cap - 1) * sizeof(struct playlist_entry));
+      unsigned j;
+      const struct string_list *roms = playlist_entry->subsystem_roms;
 
-      playlist->entries[0].path            = NULL;
-      playlist->entries[0].core_path       = NULL;
+      if (!roms || entry->subsystem_roms->size != roms->size)
+         return false;
 
-      if (!string_is_empty(real_path))
-         playlist->entries[0].path      = strdup(real_path);
-      if (!string_is_empty(real_core_path))
-         playlist->entries[0].core_path = strdup(real_core_path);
+      for (j = 0; j < entry->subsystem_roms->size; j++)
+      {
+         char real_rom_path[PATH_MAX_LENGTH];
 
-      playlist->entries[0].runtime_hours = runtime_hours;
-      playlist->entries[0].runtime_minutes = runtime_minutes;
-      playlist->entries[0].runtime_seconds = runtime_seconds;
-      playlist->entries[0].last_played_year = last_played_year;
-      playlist->entries[0].last_played_month = last_played_month;
-      playlist->entries[0].last_played_day = last_played_day;
-      playlist->entries[0].last_played_hour = last_played_hour;
-      playlist->entries[0].last_played_minute = last_played_minute;
-      playlist->entries[0].last_played_second = last_played_second;
-   }
+         real_rom_path[0] = '\0';
 
-   playlist->size++;
+         if (!string_is_empty(entry->subsystem_roms->elems[j].data))
+         {
+            strlcpy(real_rom_path, entry->subsystem_roms->elems[j].data, sizeof(real_rom_path));
+            path_resolve_realpath(real_rom_path, sizeof(real_rom_path));
+         }
 
-success:
-   playlist->modified = true;
+         if (!playlist_path_equal(real_rom_path, roms->elems[j].data))
+            return false;
+      }
+   }
 
    return true;
 }
@@ -656,10 +1402,12 @@ bool playlist_push(playlist_t *playlist,
       const struct playlist_entry *entry)
 {
    size_t i;
+   uint32_t slot;
+   struct playlist_push_state state;
+   struct playlist_entry *new_entry = NULL;
    char real_path[PATH_MAX_LENGTH];
    char real_core_path[PATH_MAX_LENGTH];
-   const char *core_name = entry->core_name;
-   bool entry_updated    = false;
+   const char *core_name = NULL;
 
    real_path[0] = '\0';
    real_core_path[0] = '\0';
@@ -667,6 +1415,8 @@ bool playlist_push(playlist_t *playlist,
    if (!playlist || !entry)
       return false;
 
+   core_name = entry->core_name;
+
    if (string_is_empty(entry->core_path))
    {
       RARCH_ERR("cannot push NULL or empty core path into the playlist.\n");
@@ -703,103 +1453,43 @@ bool playlist_push(playlist_t *playlist,
       }
    }
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      struct playlist_entry tmp;
-      const char *entry_path = playlist->entries[i].path;
-      bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path);
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (!playlist_core_path_equal(real_core_path, playlist->entries[i].core_path))
-         continue;
-
-      if (     !string_is_empty(entry->subsystem_ident) 
-            && !string_is_empty(playlist->entries[i].subsystem_ident) 
-            && !string_is_equal(playlist->entries[i].subsystem_ident, entry->subsystem_ident))
-         continue;
-
-      if (      string_is_empty(entry->subsystem_ident) 
-            && !string_is_empty(playlist->entries[i].subsystem_ident))
-         continue;
-
-      if (    !string_is_empty(entry->subsystem_ident) 
-            && string_is_empty(playlist->entries[i].subsystem_ident))
-         continue;
-
-      if (     !string_is_empty(entry->subsystem_name) 
-            && !string_is_empty(playlist->entries[i].subsystem_name) 
-            && !string_is_equal(playlist->entries[i].subsystem_name, entry->subsystem_name))
-         continue;
-
-      if (      string_is_empty(entry->subsystem_name) 
-            && !string_is_empty(playlist->entries[i].subsystem_name))
-         continue;
-
-      if (     !string_is_empty(entry->subsystem_name) 
-            &&  string_is_empty(playlist->entries[i].subsystem_name))
-         continue;
-
-      if (entry->subsystem_roms)
-      {
-         unsigned j;
-         const struct string_list *roms = playlist->entries[i].subsystem_roms;
-         bool                   unequal = false;
-
-         if (entry->subsystem_roms->size != roms->size)
-            continue;
-
-         for (j = 0; j < entry->subsystem_roms->size; j++)
-         {
-            char real_rom_path[PATH_MAX_LENGTH];
-
-            real_rom_path[0] = '\0';
-
-            if (!string_is_empty(entry->subsystem_roms->elems[j].data))
-            {
-               strlcpy(real_rom_path, entry->subsystem_roms->elems[j].data, sizeof(real_rom_path));
-               path_resolve_realpath(real_rom_path, sizeof(real_rom_path));
-            }
+   state.entry          = entry;
+   state.real_core_path = real_core_path;
 
-            if (!playlist_path_equal(real_rom_path, roms->elems[j].data))
-            {
-               unequal = true;
-               break;
-            }
-         }
+   slot = playlist_find_path(playlist, real_path,
+         playlist_push_match, &state);
 
-         if (unequal)
-            continue;
-      }
+   if (slot != PLAYLIST_INDEX_NONE)
+   {
+      struct playlist_entry *found = &playlist->entries[slot];
+      bool entry_updated           = false;
 
       /* If content was previously loaded via file browser
        * or command line, certain entry values will be missing.
        * If we are now loading the same content from a playlist,
        * fill in any blanks */
-      if ((playlist->entries[i].label == NULL) && !string_is_empty(entry->label))
+      if ((found->label == NULL) && !string_is_empty(entry->label))
       {
-         playlist->entries[i].label   = strdup(entry->label);
-         entry_updated                = true;
+         found->label   = playlist_strdup(playlist, entry->label);
+         entry_updated  = true;
       }
-      if ((playlist->entries[i].crc32 == NULL) && !string_is_empty(entry->crc32))
+      if ((found->crc32 == NULL) && !string_is_empty(entry->crc32))
       {
-         playlist->entries[i].crc32   = strdup(entry->crc32);
-         entry_updated                = true;
+         found->crc32   = playlist_strdup(playlist, entry->crc32);
+         entry_updated  = true;
       }
-      if ((playlist->entries[i].db_name == NULL) && !string_is_empty(entry->db_name))
+      if ((found->db_name == NULL) && !string_is_empty(entry->db_name))
       {
-         playlist->entries[i].db_name = strdup(entry->db_name);
-         entry_updated                = true;
+         found->db_name = playlist_strdup(playlist, entry->db_name);
+         entry_updated  = true;
       }
 
+      if (entry_updated)
+         playlist_index_update(playlist, slot, false);
+
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
-      if (i == 0)
+      if (slot == playlist->size - 1)
       {
          if (entry_updated)
             goto success;
@@ -808,75 +1498,43 @@ bool playlist_push(playlist_t *playlist,
       }
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      playlist_move_to_top(playlist, slot);
 
       goto success;
    }
 
-   if (playlist->size == playlist->cap)
-   {
-      struct playlist_entry *entry = &playlist->entries[playlist->cap - 1];
+   if (!(new_entry = playlist_push_slot(playlist)))
+      return false;
 
-      if (entry)
-         playlist_free_entry(entry);
-      playlist->size--;
-   }
-
-   if (playlist->entries)
-   {
-      memmove(playlist->entries + 1, playlist->entries,
-            (playlist->cap - 1) * sizeof(struct playlist_entry));
-
-      playlist->entries[0].path               = NULL;
-      playlist->entries[0].label              = NULL;
-      playlist->entries[0].core_path          = NULL;
-      playlist->entries[0].core_name          = NULL;
-      playlist->entries[0].db_name            = NULL;
-      playlist->entries[0].crc32              = NULL;
-      playlist->entries[0].subsystem_ident    = NULL;
-      playlist->entries[0].subsystem_name     = NULL;
-      playlist->entries[0].subsystem_roms     = NULL;
-      playlist->entries[0].runtime_hours      = 0;
-      playlist->entries[0].runtime_minutes    = 0;
-      playlist->entries[0].runtime_seconds    = 0;
-      playlist->entries[0].last_played_year   = 0;
-      playlist->entries[0].last_played_month  = 0;
-      playlist->entries[0].last_played_day    = 0;
-      playlist->entries[0].last_played_hour   = 0;
-      playlist->entries[0].last_played_minute = 0;
-      playlist->entries[0].last_played_second = 0;
-      if (!string_is_empty(real_path))
-         playlist->entries[0].path            = strdup(real_path);
-      if (!string_is_empty(entry->label))
-         playlist->entries[0].label           = strdup(entry->label);
-      if (!string_is_empty(real_core_path))
-         playlist->entries[0].core_path       = strdup(real_core_path);
-      if (!string_is_empty(core_name))
-         playlist->entries[0].core_name       = strdup(core_name);
-      if (!string_is_empty(entry->db_name))
-         playlist->entries[0].db_name         = strdup(entry->db_name);
-      if (!string_is_empty(entry->crc32))
-         playlist->entries[0].crc32           = strdup(entry->crc32);
-      if (!string_is_empty(entry->subsystem_ident))
-         playlist->entries[0].subsystem_ident = strdup(entry->subsystem_ident);
-      if (!string_is_empty(entry->subsystem_name))
-         playlist->entries[0].subsystem_name  = strdup(entry->subsystem_name);
-
-      if (entry->subsystem_roms)
-      {
-         union string_list_elem_attr attributes = {0};
+   if (!string_is_empty(real_path))
+      new_entry->path            = playlist_strdup(playlist, real_path);
+   if (!string_is_empty(entry->label))
+      new_entry->label           = playlist_strdup(playlist, entry->label);
+   if (!string_is_empty(real_core_path))
+      new_entry->core_path       = playlist_strdup(playlist, real_core_path);
+   if (!string_is_empty(core_name))
+      new_entry->core_name       = playlist_strdup(playlist, core_name);
+   if (!string_is_empty(entry->db_name))
+      new_entry->db_name         = playlist_strdup(playlist, entry->db_name);
+   if (!string_is_empty(entry->crc32))
+      new_entry->crc32           = playlist_strdup(playlist, entry->crc32);
+   if (!string_is_empty(entry->subsystem_ident))
+      new_entry->subsystem_ident = playlist_strdup(playlist, entry->subsystem_ident);
+   if (!string_is_empty(entry->subsystem_name))
+      new_entry->subsystem_name  = playlist_strdup(playlist, entry->subsystem_name);
+
+   if (entry->subsystem_roms)
+   {
+      union string_list_elem_attr attributes = {0};
 
-         playlist->entries[0].subsystem_roms    = string_list_new();
+      new_entry->subsystem_roms    = string_list_new();
 
-         for (i = 0; i < entry->subsystem_roms->size; i++)
-            string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
-      }
+      for (i = 0; i < entry->subsystem_roms->size; i++)
+         string_list_append(new_entry->subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
    }
 
    playlist->size++;
+   playlist_index_push(playlist, real_path);
 
 success:
    playlist->modified = true;
@@ -921,6 +1579,8 @@ void playlist_write_runtime_file(playlist_t *playlist)
    if (!playlist || !playlist->modified)
       return;
 
+   playlist_arena_compact(playlist);
+
    file = filestream_open(playlist->conf_path,
          RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
@@ -964,6 +1624,9 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
    for (i = 0; i < playlist->size; i++)
    {
+      const struct playlist_entry *entry =
+         &playlist->entries[PLAYLIST_SLOT(playlist, i)];
+
       JSON_Writer_WriteSpace(context.writer, 4);
       JSON_Writer_WriteStartObject(context.writer);
 
@@ -974,11 +1637,11 @@ void playlist_write_runtime_file(playlist_t *playlist)
       JSON_Writer_WriteColon(context.writer);
       JSON_Writer_WriteSpace(context.writer, 1);
       JSON_Writer_WriteString(context.writer,
-            playlist->entries[i].path 
-            ? playlist->entries[i].path 
+            entry->path 
+            ? entry->path 
             : "",
-            playlist->entries[i].path 
-            ? strlen(playlist->entries[i].path) 
+            entry->path 
+            ? strlen(entry->path) 
             : 0,
             JSON_UTF8);
       JSON_Writer_WriteComma(context.writer);
@@ -989,15 +1652,15 @@ void playlist_write_runtime_file(playlist_t *playlist)
             STRLEN_CONST("core_path"), JSON_UTF8);
       JSON_Writer_WriteColon(context.writer);
       JSON_Writer_WriteSpace(context.writer, 1);
-      JSON_Writer_WriteString(context.writer, playlist->entries[i].core_path,
-            strlen(playlist->entries[i].core_path), JSON_UTF8);
+      JSON_Writer_WriteString(context.writer, entry->core_path,
+            strlen(entry->core_path), JSON_UTF8);
       JSON_Writer_WriteComma(context.writer);
       JSON_Writer_WriteNewLine(context.writer);
 
       {
          char tmp[32] = {0};
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].runtime_hours);
+         snprintf(tmp, sizeof(tmp), "%u", entry->runtime_hours);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "runtime_hours",
@@ -1010,7 +1673,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].runtime_minutes);
+         snprintf(tmp, sizeof(tmp), "%u", entry->runtime_minutes);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "runtime_minutes",
@@ -1023,7 +1686,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].runtime_seconds);
+         snprintf(tmp, sizeof(tmp), "%u", entry->runtime_seconds);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "runtime_seconds",
@@ -1036,7 +1699,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].last_played_year);
+         snprintf(tmp, sizeof(tmp), "%u", entry->last_played_year);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "last_played_year",
@@ -1049,7 +1712,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].last_played_month);
+         snprintf(tmp, sizeof(tmp), "%u", entry->last_played_month);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "last_played_month",
@@ -1062,7 +1725,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].last_played_day);
+         snprintf(tmp, sizeof(tmp), "%u", entry->last_played_day);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "last_played_day",
@@ -1076,7 +1739,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].last_played_hour);
+         snprintf(tmp, sizeof(tmp), "%u", entry->last_played_hour);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "last_played_hour",
@@ -1089,7 +1752,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].last_played_minute);
+         snprintf(tmp, sizeof(tmp), "%u", entry->last_played_minute);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "last_played_minute",
@@ -1102,7 +1765,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
 
          memset(tmp, 0, sizeof(tmp));
 
-         snprintf(tmp, sizeof(tmp), "%u", playlist->entries[i].last_played_second);
+         snprintf(tmp, sizeof(tmp), "%u", entry->last_played_second);
 
          JSON_Writer_WriteSpace(context.writer, 6);
          JSON_Writer_WriteString(context.writer, "last_played_second",
@@ -1146,6 +1809,8 @@ void playlist_write_file(playlist_t *playlist)
    if (!playlist || !playlist->modified)
       return;
 
+   playlist_arena_compact(playlist);
+
    file = filestream_open(playlist->conf_path,
          RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
@@ -1158,14 +1823,19 @@ void playlist_write_file(playlist_t *playlist)
    if (settings->bools.playlist_use_old_format)
    {
       for (i = 0; i < playlist->size; i++)
+      {
+         const struct playlist_entry *entry =
+            &playlist->entries[PLAYLIST_SLOT(playlist, i)];
+
          filestream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
-               playlist->entries[i].path    ? playlist->entries[i].path    : "",
-               playlist->entries[i].label   ? playlist->entries[i].label   : "",
-               playlist->entries[i].core_path,
-               playlist->entries[i].core_name,
-               playlist->entries[i].crc32   ? playlist->entries[i].crc32   : "",
-               playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
+               entry->path    ? entry->path    : "",
+               entry->label   ? entry->label   : "",
+               entry->core_path,
+               entry->core_name,
+               entry->crc32   ? entry->crc32   : "",
+               entry->db_name ? entry->db_name : ""
                );
+      }
    }
    else
    {
@@ -1204,6 +1874,9 @@ void playlist_write_file(playlist_t *playlist)
 
       for (i = 0; i < playlist->size; i++)
       {
+         const struct playlist_entry *entry =
+            &playlist->entries[PLAYLIST_SLOT(playlist, i)];
+
          JSON_Writer_WriteSpace(context.writer, 4);
          JSON_Writer_WriteStartObject(context.writer);
 
@@ -1214,11 +1887,11 @@ void playlist_write_file(playlist_t *playlist)
          JSON_Writer_WriteColon(context.writer);
          JSON_Writer_WriteSpace(context.writer, 1);
          JSON_Writer_WriteString(context.writer,
-               playlist->entries[i].path 
-               ? playlist->entries[i].path 
+               entry->path 
+               ? entry->path 
                : "",
-               playlist->entries[i].path 
-               ? strlen(playlist->entries[i].path) 
+               entry->path 
+               ? strlen(entry->path) 
                : 0,
                JSON_UTF8);
          JSON_Writer_WriteComma(context.writer);
@@ -1230,11 +1903,11 @@ void playlist_write_file(playlist_t *playlist)
          JSON_Writer_WriteColon(context.writer);
          JSON_Writer_WriteSpace(context.writer, 1);
          JSON_Writer_WriteString(context.writer,
-               playlist->entries[i].label 
-               ? playlist->entries[i].label 
+               entry->label 
+               ? entry->label 
                : "",
-               playlist->entries[i].label 
-               ? strlen(playlist->entries[i].label) 
+               entry->label 
+               ? strlen(entry->label) 
                : 0,
                JSON_UTF8);
          JSON_Writer_WriteComma(context.writer);
@@ -1246,8 +1919,8 @@ void playlist_write_file(playlist_t *playlist)
          JSON_Writer_WriteColon(context.writer);
          JSON_Writer_WriteSpace(context.writer, 1);
          JSON_Writer_WriteString(context.writer,
-               playlist->entries[i].core_path,
-               strlen(playlist->entries[i].core_path), JSON_UTF8);
+               entry->core_path,
+               strlen(entry->core_path), JSON_UTF8);
          JSON_Writer_WriteComma(context.writer);
 
          JSON_Writer_WriteNewLine(context.writer);
@@ -1257,8 +1930,8 @@ void playlist_write_file(playlist_t *playlist)
          JSON_Writer_WriteColon(context.writer);
          JSON_Writer_WriteSpace(context.writer, 1);
          JSON_Writer_WriteString(context.writer,
-               playlist->entries[i].core_name,
-               strlen(playlist->entries[i].core_name), JSON_UTF8);
+               entry->core_name,
+               strlen(entry->core_name), JSON_UTF8);
          JSON_Writer_WriteComma(context.writer);
 
          JSON_Writer_WriteNewLine(context.writer);
@@ -1267,9 +1940,9 @@ void playlist_write_file(playlist_t *playlist)
                STRLEN_CONST("crc32"), JSON_UTF8);
          JSON_Writer_WriteColon(context.writer);
          JSON_Writer_WriteSpace(context.writer, 1);
-         JSON_Writer_WriteString(context.writer, playlist->entries[i].crc32 ? playlist->entries[i].crc32 : "",
-               playlist->entries[i].crc32 
-               ? strlen(playlist->entries[i].crc32) 
+         JSON_Writer_WriteString(context.writer, entry->crc32 ? entry->crc32 : "",
+               entry->crc32 
+               ? strlen(entry->crc32) 
                : 0,
                JSON_UTF8);
          JSON_Writer_WriteComma(context.writer);
@@ -1280,13 +1953,13 @@ void playlist_write_file(playlist_t *playlist)
                STRLEN_CONST("db_name"), JSON_UTF8);
          JSON_Writer_WriteColon(context.writer);
          JSON_Writer_WriteSpace(context.writer, 1);
-         JSON_Writer_WriteString(context.writer, playlist->entries[i].db_name ? playlist->entries[i].db_name : "",
-               playlist->entries[i].db_name 
-               ? strlen(playlist->entries[i].db_name) 
+         JSON_Writer_WriteString(context.writer, entry->db_name ? entry->db_name : "",
+               entry->db_name 
+               ? strlen(entry->db_name) 
                : 0,
                JSON_UTF8);
 
-         if (!string_is_empty(playlist->entries[i].subsystem_ident))
+         if (!string_is_empty(entry->subsystem_ident))
          {
             JSON_Writer_WriteComma(context.writer);
             JSON_Writer_WriteNewLine(context.writer);
@@ -1295,14 +1968,14 @@ void playlist_write_file(playlist_t *playlist)
                   STRLEN_CONST("subsystem_ident"), JSON_UTF8);
             JSON_Writer_WriteColon(context.writer);
             JSON_Writer_WriteSpace(context.writer, 1);
-            JSON_Writer_WriteString(context.writer, playlist->entries[i].subsystem_ident ? playlist->entries[i].subsystem_ident : "",
-                  playlist->entries[i].subsystem_ident 
-                  ? strlen(playlist->entries[i].subsystem_ident) 
+            JSON_Writer_WriteString(context.writer, entry->subsystem_ident ? entry->subsystem_ident : "",
+                  entry->subsystem_ident 
+                  ? strlen(entry->subsystem_ident) 
                   : 0,
                   JSON_UTF8);
          }
 
-         if (!string_is_empty(playlist->entries[i].subsystem_name))
+         if (!string_is_empty(entry->subsystem_name))
          {
             JSON_Writer_WriteComma(context.writer);
             JSON_Writer_WriteNewLine(context.writer);
@@ -1312,16 +1985,16 @@ void playlist_write_file(playlist_t *playlist)
             JSON_Writer_WriteColon(context.writer);
             JSON_Writer_WriteSpace(context.writer, 1);
             JSON_Writer_WriteString(context.writer,
-                  playlist->entries[i].subsystem_name 
-                  ? playlist->entries[i].subsystem_name 
+                  entry->subsystem_name 
+                  ? entry->subsystem_name 
                   : "",
-                  playlist->entries[i].subsystem_name 
-                  ? strlen(playlist->entries[i].subsystem_name) 
+                  entry->subsystem_name 
+                  ? strlen(entry->subsystem_name) 
                   : 0, JSON_UTF8);
          }
 
-         if (  playlist->entries[i].subsystem_roms && 
-               playlist->entries[i].subsystem_roms->size > 0)
+         if (  entry->subsystem_roms && 
+               entry->subsystem_roms->size > 0)
          {
             unsigned j;
 
@@ -1335,9 +2008,9 @@ void playlist_write_file(playlist_t *playlist)
             JSON_Writer_WriteStartArray(context.writer);
             JSON_Writer_WriteNewLine(context.writer);
 
-            for (j = 0; j < playlist->entries[i].subsystem_roms->size; j++)
+            for (j = 0; j < entry->subsystem_roms->size; j++)
             {
-               const struct string_list *roms = playlist->entries[i].subsystem_roms;
+               const struct string_list *roms = entry->subsystem_roms;
                JSON_Writer_WriteSpace(context.writer, 8);
                JSON_Writer_WriteString(context.writer,
                      !string_is_empty(roms->elems[j].data) 
@@ -1348,7 +2021,7 @@ void playlist_write_file(playlist_t *playlist)
                      : 0,
                      JSON_UTF8);
 
-               if (j < playlist->entries[i].subsystem_roms->size - 1)
+               if (j < entry->subsystem_roms->size - 1)
                {
                   JSON_Writer_WriteComma(context.writer);
                   JSON_Writer_WriteNewLine(context.writer);
@@ -1409,12 +2082,15 @@ void playlist_free(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
 
    free(playlist->entries);
    playlist->entries = NULL;
 
+   playlist_index_free(playlist);
+   playlist_arena_free(playlist);
+
    free(playlist);
 }
 
@@ -1435,9 +2111,12 @@ void playlist_clear(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
    playlist->size = 0;
+
+   playlist_index_free(playlist);
+   playlist_arena_free(playlist);
 }
 
 /**
@@ -1519,8 +2198,11 @@ static JSON_Parser_HandlerResult JSONStartObjectHandler(JSON_Parser parser)
    {
       if (pCtx->array_depth == 1)
       {
-         if (pCtx->playlist->size < pCtx->playlist->cap)
+         if (playlist_reserve(pCtx->playlist, pCtx->playlist->size + 1))
+         {
             pCtx->current_entry = &pCtx->playlist->entries[pCtx->playlist->size];
+            memset(pCtx->current_entry, 0, sizeof(*pCtx->current_entry));
+         }
          else
             /* hit max item limit */
             return JSON_Parser_Abort;
@@ -1569,12 +2251,7 @@ static JSON_Parser_HandlerResult JSONStringHandler(JSON_Parser parser, char *pVa
       if (pCtx->array_depth == 1)
       {
          if (pCtx->current_entry_val && length && !string_is_empty(pValue))
-         {
-            if (*pCtx->current_entry_val)
-               free(*pCtx->current_entry_val);
-
-            *pCtx->current_entry_val = strdup(pValue);
-         }
+            *pCtx->current_entry_val = playlist_strdup(pCtx->playlist, pValue);
          else
          {
             /* must be a value for an unknown member we aren't tracking, skip it */
@@ -1726,6 +2403,20 @@ static JSON_Parser_HandlerResult JSONObjectMemberHandler(JSON_Parser parser, cha
    return JSON_Parser_Continue;
 }
 
+static void playlist_reverse(playlist_t *playlist)
+{
+   size_t i;
+
+   for (i = 0; i < playlist->size / 2; i++)
+   {
+      size_t j                  = playlist->size - 1 - i;
+      struct playlist_entry tmp = playlist->entries[i];
+
+      playlist->entries[i]      = playlist->entries[j];
+      playlist->entries[j]      = tmp;
+   }
+}
+
 static bool playlist_read_file(
       playlist_t *playlist, const char *path)
 {
@@ -1880,28 +2571,36 @@ static bool playlist_read_file(
                *last = '\0';
          }
 
-         entry = &playlist->entries[playlist->size];
-
          if (!*buf[2] || !*buf[3])
             continue;
 
+         if (!playlist_reserve(playlist, playlist->size + 1))
+            goto end;
+
+         entry = &playlist->entries[playlist->size];
+         memset(entry, 0, sizeof(*entry));
+
          if (*buf[0])
-            entry->path      = strdup(buf[0]);
+            entry->path      = playlist_strdup(playlist, buf[0]);
          if (*buf[1])
-            entry->label     = strdup(buf[1]);
+            entry->label     = playlist_strdup(playlist, buf[1]);
 
-         entry->core_path    = strdup(buf[2]);
-         entry->core_name    = strdup(buf[3]);
+         entry->core_path    = playlist_strdup(playlist, buf[2]);
+         entry->core_name    = playlist_strdup(playlist, buf[3]);
          if (*buf[4])
-            entry->crc32     = strdup(buf[4]);
+            entry->crc32     = playlist_strdup(playlist, buf[4]);
          if (*buf[5])
-            entry->db_name   = strdup(buf[5]);
+            entry->db_name   = playlist_strdup(playlist, buf[5]);
          playlist->size++;
       }
    }
 
 end:
    filestream_close(file);
+
+   /* Files list the most recent entry first */
+   playlist_reverse(playlist);
+
    return true;
 }
 
@@ -1939,23 +2638,14 @@ bool playlist_init_cached(const char *path, size_t size)
  **/
 playlist_t *playlist_init(const char *path, size_t size)
 {
-   struct playlist_entry *entries = NULL;
-   playlist_t           *playlist = (playlist_t*)malloc(sizeof(*playlist));
+   playlist_t *playlist = (playlist_t*)calloc(1, sizeof(*playlist));
    if (!playlist)
       return NULL;
 
-   entries = (struct playlist_entry*)calloc(size, sizeof(*entries));
-   if (!entries)
-   {
-      free(playlist);
-      return NULL;
-   }
-
    playlist->modified  = false;
    playlist->size      = 0;
    playlist->cap       = size;
    playlist->conf_path = strdup(path);
-   playlist->entries   = entries;
 
    playlist_read_file(playlist, path);
 
@@ -2041,9 +2731,17 @@ end:
 
 void playlist_qsort(playlist_t *playlist)
 {
+   if (!playlist)
+      return;
+
    qsort(playlist->entries, playlist->size,
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+
+   playlist_reverse(playlist);
+
+   /* Rebuilt on the next lookup */
+   playlist_index_free(playlist);
 }
 
 void command_playlist_push_write(
@@ -2087,6 +2785,8 @@ bool playlist_index_is_valid(playlist_t *playlist, size_t idx,
    if (idx >= playlist->size)
       return false;
 
+   idx = PLAYLIST_SLOT(playlist, idx);
+
    return string_is_equal(playlist->entries[idx].path, path) &&
           string_is_equal(path_basename(playlist->entries[idx].core_path), path_basename(core_path));
 }
@@ -2094,23 +2794,26 @@ bool playlist_index_is_valid(playlist_t *playlist, size_t idx,
 void playlist_get_crc32(playlist_t *playlist, size_t idx,
       const char **crc32)
 {
-   if (!playlist)
+   if (!playlist || idx >= playlist->size)
       return;
 
    if (crc32)
-      *crc32 = playlist->entries[idx].crc32;
+      *crc32 = playlist->entries[PLAYLIST_SLOT(playlist, idx)].crc32;
 }
 
 void playlist_get_db_name(playlist_t *playlist, size_t idx,
       const char **db_name)
 {
-   if (!playlist)
+   if (!playlist || idx >= playlist->size)
       return;
 
    if (db_name)
    {
-      if (!string_is_empty(playlist->entries[idx].db_name))
-         *db_name = playlist->entries[idx].db_name;
+      const struct playlist_entry *entry =
+         &playlist->entries[PLAYLIST_SLOT(playlist, idx)];
+
+      if (!string_is_empty(entry->db_name))
+         *db_name = entry->db_name;
       else
       {
          const char *conf_path_basename = path_basename(playlist->conf_path);
@@ -154,6 +154,19 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const char *search_path,
       const struct playlist_entry **entry);
 
+/* Finds the most recent entry with a matching CRC32 string
+ * (e.g. "DEADBEEF|crc", case insensitive). Leaves @entry
+ * untouched if there is none. */
+void playlist_get_index_by_crc32(playlist_t *playlist,
+      const char *crc32,
+      const struct playlist_entry **entry);
+
+/* Finds the most recent entry with a matching label.
+ * Leaves @entry untouched if there is none. */
+void playlist_get_index_by_label(playlist_t *playlist,
+      const char *label,
+      const struct playlist_entry **entry);
+
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32);
@@ -162,6 +175,9 @@ char *playlist_get_conf_path(playlist_t *playlist);
 
 uint32_t playlist_get_size(playlist_t *playlist);
 
+/* Writes out a modified playlist. As with playlist_write_runtime_file,
+ * strings previously returned for its entries may move, they have to
+ * be fetched again. */
 void playlist_write_file(playlist_t *playlist);
 
 void playlist_write_runtime_file(playlist_t *playlist);
@@ -4512,9 +4512,15 @@ int runloop_iterate(unsigned *sleep_ms)
             && !netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_ENABLED, NULL)
 #endif
          )
-         run_ahead(run_ahead_num_frames, settings->bools.run_ahead_secondary_instance);
+         run_ahead(run_ahead_num_frames,
+               settings->bools.run_ahead_secondary_instance,
+               settings->bools.run_ahead_skip_reload);
       else
+      {
+         /* The skip reload mode may have left the core ahead */
+         runahead_ring_restore();
          core_run();
+      }
    }
 #else
    {
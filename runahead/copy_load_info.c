@@ -5,6 +5,7 @@
 #include <lists/string_list.h>
 
 #include "../core.h"
+#include "../configuration.h"
 #include "mem_util.h"
 #include "copy_load_info.h"
 
@@ -27,7 +28,7 @@ static void free_retro_game_info(struct retro_game_info *dest)
 }
 
 static struct retro_game_info* clone_retro_game_info(const
-      struct retro_game_info *src)
+      struct retro_game_info *src, bool copy_data)
 {
    void *data                   = NULL;
    struct retro_game_info *dest = NULL;
@@ -43,7 +44,12 @@ static struct retro_game_info* clone_retro_game_info(const
    dest->data    = NULL;
    dest->path    = strcpy_alloc(src->path);
 
-   if (src->size && src->data)
+   /* Always a copy, even of mapped content: the secondary core
+    * may load it at any time in the session, and a mapping kept
+    * that long would see the file change under it. Without
+    * @copy_data, only the size is kept, so the secondary core
+    * can tell that the data is missing. */
+   if (copy_data && src->size && src->data)
    {
       data = malloc(src->size);
 
@@ -257,7 +263,7 @@ static void free_retro_ctx_load_content_info(struct
 
 static struct retro_ctx_load_content_info
 *clone_retro_ctx_load_content_info(
-      const struct retro_ctx_load_content_info *src)
+      const struct retro_ctx_load_content_info *src, bool copy_data)
 {
    struct retro_ctx_load_content_info *dest = NULL;
    if (!src || src->special != NULL)
@@ -269,7 +275,7 @@ static struct retro_ctx_load_content_info
    if (!dest)
       return NULL;
 
-   dest->info       = clone_retro_game_info(src->info);
+   dest->info       = clone_retro_game_info(src->info, copy_data);
    dest->content    = NULL;
    dest->special    = NULL;
 
@@ -283,9 +289,15 @@ static struct retro_ctx_load_content_info
 
 void set_load_content_info(const retro_ctx_load_content_info_t *ctx)
 {
+   settings_t *settings = config_get_ptr();
+   /* Only the secondary instance needs its own copy of the content,
+    * and making it reads every page of mapped content. */
+   bool copy_data       = settings->bools.run_ahead_enabled
+      && settings->bools.run_ahead_secondary_instance;
+
    free_retro_ctx_load_content_info(load_content_info);
    free(load_content_info);
-   load_content_info = clone_retro_ctx_load_content_info(ctx);
+   load_content_info = clone_retro_ctx_load_content_info(ctx, copy_data);
 }
 
 void set_last_core_type(enum rarch_core_type type)
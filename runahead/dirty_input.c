@@ -19,6 +19,9 @@ typedef struct InputListElement_t
    unsigned device;
    unsigned index;
    int16_t *state;
+   /* Non-zero for every id the core has read, on a real frame
+    * or while running ahead. */
+   uint8_t *polled;
    unsigned int state_size;
 } InputListElement;
 
@@ -42,6 +45,7 @@ static void* InputListElementConstructor(void)
    InputListElement *element = (InputListElement*)ptr;
    element->state_size = initial_state_array_size;
    element->state = (int16_t*)calloc(element->state_size, sizeof(int16_t));
+   element->polled = (uint8_t*)calloc(element->state_size, sizeof(uint8_t));
    return ptr;
 }
 
@@ -51,6 +55,8 @@ static void InputListElementRealloc(InputListElement *element, unsigned int newS
    {
       element->state = (int16_t*)realloc(element->state, newSize * sizeof(int16_t));
       memset(&element->state[element->state_size], 0, (newSize - element->state_size) * sizeof(int16_t));
+      element->polled = (uint8_t*)realloc(element->polled, newSize * sizeof(uint8_t));
+      memset(&element->polled[element->state_size], 0, (newSize - element->state_size) * sizeof(uint8_t));
       element->state_size = newSize;
    }
 }
@@ -70,6 +76,7 @@ static void InputListElementDestructor(void* element_ptr)
 {
    InputListElement *element = (InputListElement*)element_ptr;
    free(element->state);
+   free(element->polled);
    free(element_ptr);
 }
 
@@ -100,7 +107,8 @@ static void input_state_set_last(unsigned port, unsigned device,
       {
          if (id >= element->state_size)
             InputListElementExpand(element, id);
-         element->state[id] = value;
+         element->state[id]  = value;
+         element->polled[id] = 1;
          return;
       }
    }
@@ -114,10 +122,11 @@ static void input_state_set_last(unsigned port, unsigned device,
    {
       InputListElementExpand(element, id);
    }
-   element->state[id] = value;
+   element->state[id]  = value;
+   element->polled[id] = 1;
 }
 
-int16_t input_state_get_last(unsigned port,
+static int16_t input_state_lookup_last(unsigned port,
       unsigned device, unsigned index, unsigned id)
 {
    unsigned i;
@@ -143,6 +152,42 @@ int16_t input_state_get_last(unsigned port,
    return 0;
 }
 
+/* Frames run ahead read their input here. Those reads are recorded
+ * as well, or a misprediction on an input the core only started to
+ * read while running ahead would go unnoticed. */
+int16_t input_state_get_last(unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   int16_t value = input_state_lookup_last(port, device, index, id);
+   input_state_set_last(port, device, index, id, value);
+   return value;
+}
+
+bool input_state_matches_last(void)
+{
+   unsigned i, id;
+
+   if (!input_state_callback_original || !input_state_list)
+      return false;
+
+   for (i = 0; i < (unsigned)input_state_list->size; i++)
+   {
+      InputListElement *element =
+         (InputListElement*)input_state_list->data[i];
+
+      for (id = 0; id < element->state_size; id++)
+      {
+         if (!element->polled[id])
+            continue;
+         if (input_state_callback_original(element->port,
+                  element->device, element->index, id) != element->state[id])
+            return false;
+      }
+   }
+
+   return true;
+}
+
 static int16_t input_state_with_logging(unsigned port,
       unsigned device, unsigned index, unsigned id)
 {
@@ -150,7 +195,7 @@ static int16_t input_state_with_logging(unsigned port,
    {
       int16_t result     = input_state_callback_original(
             port, device, index, id);
-      int16_t last_input = input_state_get_last(port, device, index, id);
+      int16_t last_input = input_state_lookup_last(port, device, index, id);
       if (result != last_input)
          input_is_dirty = true;
       input_state_set_last(port, device, index, id, result);
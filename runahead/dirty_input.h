@@ -12,6 +12,11 @@ void remove_input_state_hook(void);
 int16_t input_state_get_last(unsigned port,
    unsigned device, unsigned index, unsigned id);
 
+/* Returns true if the input currently reported by the frontend is
+ * the same as the last input read by the core, for every input the
+ * core has read so far. Input must have been polled first. */
+bool input_state_matches_last(void);
+
 RETRO_END_DECLS
 
 #endif
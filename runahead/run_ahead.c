@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include <boolean.h>
+#include <memalign.h>
 
 #include "dirty_input.h"
 #include "mylist.h"
@@ -15,6 +16,8 @@
 #include "../gfx/video_driver.h"
 #include "../configuration.h"
 #include "../retroarch.h"
+#include "../performance_counters.h"
+#include "../input/input_driver.h"
 
 static size_t runahead_save_state_size     = 0;
 
@@ -25,6 +28,18 @@ static bool hard_disable_audio             = false;
 /* Save State List for Run Ahead */
 static MyList *runahead_save_state_list    = NULL;
 
+/* Savestate ring for the skip reload mode. Slot runahead_ring_real
+ * holds the state after the last real frame, the following slots the
+ * states of the frames run ahead with the predicted input. */
+#define RUNAHEAD_RING_ALIGNMENT 4096
+static uint8_t **runahead_ring             = NULL;
+static unsigned runahead_ring_size         = 0;
+static unsigned runahead_ring_real         = 0;
+static bool runahead_ring_valid            = false;
+
+static struct retro_perf_counter runahead_serialize_perf   = {0};
+static struct retro_perf_counter runahead_unserialize_perf = {0};
+
 static void *runahead_save_state_alloc(void)
 {
    retro_ctx_serialize_info_t *savestate = (retro_ctx_serialize_info_t*)
@@ -69,6 +84,46 @@ static void runahead_save_state_list_destroy(void)
    mylist_destroy(&runahead_save_state_list);
 }
 
+static void runahead_ring_destroy(void)
+{
+   unsigned i;
+
+   for (i = 0; i < runahead_ring_size; i++)
+      memalign_free(runahead_ring[i]);
+   free(runahead_ring);
+
+   runahead_ring       = NULL;
+   runahead_ring_size  = 0;
+   runahead_ring_real  = 0;
+   runahead_ring_valid = false;
+}
+
+static bool runahead_ring_create(unsigned size)
+{
+   unsigned i;
+
+   runahead_ring_destroy();
+
+   runahead_ring = (uint8_t**)calloc(size, sizeof(*runahead_ring));
+   if (!runahead_ring)
+      return false;
+
+   runahead_ring_size = size;
+
+   for (i = 0; i < size; i++)
+   {
+      runahead_ring[i] = (uint8_t*)memalign_alloc(RUNAHEAD_RING_ALIGNMENT,
+            runahead_save_state_size);
+      if (!runahead_ring[i])
+      {
+         runahead_ring_destroy();
+         return false;
+      }
+   }
+
+   return true;
+}
+
 #if 0
 static void runahead_save_state_list_rotate(void)
 {
@@ -184,6 +239,7 @@ static void runahead_error(void)
 {
    runahead_available = false;
    runahead_save_state_list_destroy();
+   runahead_ring_destroy();
    runahead_remove_hooks();
    runahead_save_state_size = 0;
    runahead_save_state_size_known = true;
@@ -216,14 +272,18 @@ static bool runahead_create(void)
 static bool runahead_save_state(void)
 {
    bool okay                                  = false;
+   bool is_perfcnt_enable                     = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
    retro_ctx_serialize_info_t *serialize_info;
    if (!runahead_save_state_list)
       return false;
    serialize_info =
       (retro_ctx_serialize_info_t*)runahead_save_state_list->data[0];
+   performance_counter_init(runahead_serialize_perf, "runahead_serialize");
+   performance_counter_start_plus(is_perfcnt_enable, runahead_serialize_perf);
    request_fast_savestate = true;
    okay                   = core_serialize(serialize_info);
    request_fast_savestate = false;
+   performance_counter_stop_plus(is_perfcnt_enable, runahead_serialize_perf);
 
    if (okay)
       return true;
@@ -238,7 +298,10 @@ static bool runahead_load_state(void)
    retro_ctx_serialize_info_t *serialize_info = (retro_ctx_serialize_info_t*)
       runahead_save_state_list->data[0];
    bool last_dirty                            = input_is_dirty;
+   bool is_perfcnt_enable                     = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
 
+   performance_counter_init(runahead_unserialize_perf, "runahead_unserialize");
+   performance_counter_start_plus(is_perfcnt_enable, runahead_unserialize_perf);
    request_fast_savestate                     = true;
    /* calling core_unserialize has side effects with
     * netplay (it triggers transmitting your save state)
@@ -248,6 +311,51 @@ static bool runahead_load_state(void)
 
    request_fast_savestate = false;
    input_is_dirty         = last_dirty;
+   performance_counter_stop_plus(is_perfcnt_enable, runahead_unserialize_perf);
+
+   if (!okay)
+      runahead_error();
+
+   return okay;
+}
+
+static bool runahead_ring_save_state(unsigned slot)
+{
+   bool okay              = false;
+   bool is_perfcnt_enable = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
+   retro_ctx_serialize_info_t serialize_info;
+
+   serialize_info.data       = runahead_ring[slot];
+   serialize_info.data_const = runahead_ring[slot];
+   serialize_info.size       = runahead_save_state_size;
+
+   performance_counter_init(runahead_serialize_perf, "runahead_serialize");
+   performance_counter_start_plus(is_perfcnt_enable, runahead_serialize_perf);
+   request_fast_savestate = true;
+   okay                   = core_serialize(&serialize_info);
+   request_fast_savestate = false;
+   performance_counter_stop_plus(is_perfcnt_enable, runahead_serialize_perf);
+
+   if (!okay)
+      runahead_error();
+
+   return okay;
+}
+
+static bool runahead_ring_load_state(unsigned slot)
+{
+   bool okay              = false;
+   bool last_dirty        = input_is_dirty;
+   bool is_perfcnt_enable = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
+
+   performance_counter_init(runahead_unserialize_perf, "runahead_unserialize");
+   performance_counter_start_plus(is_perfcnt_enable, runahead_unserialize_perf);
+   request_fast_savestate = true;
+   okay = current_core.retro_unserialize(runahead_ring[slot],
+         runahead_save_state_size);
+   request_fast_savestate = false;
+   input_is_dirty         = last_dirty;
+   performance_counter_stop_plus(is_perfcnt_enable, runahead_unserialize_perf);
 
    if (!okay)
       runahead_error();
@@ -256,16 +364,51 @@ static bool runahead_load_state(void)
 }
 
 #if HAVE_DYNAMIC
+/* Serializes the primary core straight into the buffer shared with
+ * the secondary core, which then unserializes from the same memory. */
+static bool runahead_save_state_secondary(void)
+{
+   bool okay              = false;
+   bool is_perfcnt_enable = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
+   retro_ctx_serialize_info_t serialize_info;
+
+   serialize_info.data       = secondary_core_get_state_buffer(
+         runahead_save_state_size);
+   serialize_info.data_const = serialize_info.data;
+   serialize_info.size       = runahead_save_state_size;
+
+   if (!serialize_info.data)
+   {
+      runahead_error();
+      return false;
+   }
+
+   performance_counter_init(runahead_serialize_perf, "runahead_serialize");
+   performance_counter_start_plus(is_perfcnt_enable, runahead_serialize_perf);
+   request_fast_savestate = true;
+   okay                   = core_serialize(&serialize_info);
+   request_fast_savestate = false;
+   performance_counter_stop_plus(is_perfcnt_enable, runahead_serialize_perf);
+
+   if (!okay)
+      runahead_error();
+
+   return okay;
+}
+
 static bool runahead_load_state_secondary(void)
 {
-   bool okay                                  = false;
-   retro_ctx_serialize_info_t *serialize_info =
-      (retro_ctx_serialize_info_t*)runahead_save_state_list->data[0];
+   bool okay              = false;
+   bool is_perfcnt_enable = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
 
-   request_fast_savestate                     = true;
-   okay                                       = secondary_core_deserialize(
-         serialize_info->data_const, (int)serialize_info->size);
+   performance_counter_init(runahead_unserialize_perf, "runahead_unserialize");
+   performance_counter_start_plus(is_perfcnt_enable, runahead_unserialize_perf);
+   request_fast_savestate = true;
+   okay                   = secondary_core_deserialize(
+         secondary_core_get_state_buffer(runahead_save_state_size),
+         (int)runahead_save_state_size);
    request_fast_savestate = false;
+   performance_counter_stop_plus(is_perfcnt_enable, runahead_unserialize_perf);
 
    if (!okay)
    {
@@ -340,7 +483,129 @@ static bool runahead_core_run_use_last_input(void)
    return true;
 }
 
-void run_ahead(int runahead_count, bool useSecondary)
+/* Runs the real frame on the input the ring already polled, so that
+ * it isn't polled twice. */
+static void runahead_core_run_polled(void)
+{
+   extern struct retro_callbacks retro_ctx;
+   extern struct retro_core_t current_core;
+
+   retro_input_poll_t old_poll_function = retro_ctx.poll_cb;
+
+   retro_ctx.poll_cb         = runahead_input_poll_null;
+   current_core.retro_set_input_poll(retro_ctx.poll_cb);
+   /* Late polling cores poll on their first input read otherwise */
+   current_core.input_polled = true;
+
+   core_run_no_input_polling();
+
+   retro_ctx.poll_cb         = old_poll_function;
+   current_core.retro_set_input_poll(retro_ctx.poll_cb);
+}
+
+/* Runs the real frame, then the frames ahead with the predicted input,
+ * saving a state after each of them. Input has been polled already. */
+static bool runahead_ring_fill(int runahead_count)
+{
+   int frame_number;
+
+   for (frame_number = 0; frame_number <= runahead_count; frame_number++)
+   {
+      bool last_frame = frame_number == runahead_count;
+
+      if (!last_frame)
+      {
+         runahead_suspend_audio();
+         runahead_suspend_video();
+      }
+
+      if (frame_number == 0)
+         runahead_core_run_polled();
+      else
+         runahead_core_run_use_last_input();
+
+      if (!last_frame)
+      {
+         runahead_resume_video();
+         runahead_resume_audio();
+      }
+
+      if (!runahead_ring_save_state(frame_number))
+         return false;
+   }
+
+   runahead_ring_real  = 0;
+   runahead_ring_valid = true;
+   return true;
+}
+
+/* Brings the core back from the frames run ahead to the last real
+ * frame, and drops the ring. */
+bool runahead_ring_restore(void)
+{
+   if (!runahead_ring_valid)
+      return true;
+
+   runahead_ring_valid = false;
+   return runahead_ring_load_state(runahead_ring_real);
+}
+
+/* The ring leaves the core ahead of the real frame. Rewind and the
+ * achievements look at the core after every frame, so they need the
+ * default mode. Netplay doesn't run ahead at all. */
+static bool runahead_ring_allowed(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (settings->bools.rewind_enable)
+      return false;
+#ifdef HAVE_CHEEVOS
+   if (settings->bools.cheevos_enable)
+      return false;
+#endif
+
+   return true;
+}
+
+/* Unlike the default mode, the core is left at the last frame run
+ * ahead. As long as the input matches the prediction, the real frame
+ * is already in the ring, so only one more frame has to be run and
+ * saved, and no state has to be loaded. */
+static bool runahead_run_ring(int runahead_count)
+{
+   unsigned next_slot;
+
+   if (runahead_ring_size != (unsigned)runahead_count + 1)
+      if (!runahead_ring_create(runahead_count + 1))
+         return false;
+
+   /* A reset, a state loaded outside of run-ahead or frames run
+    * without it, the current state becomes the real one. */
+   if (input_is_dirty || runahead_force_input_dirty)
+      runahead_ring_valid = false;
+
+   input_poll();
+
+   if (!runahead_ring_valid)
+      return runahead_ring_fill(runahead_count);
+
+   if (!input_state_matches_last())
+   {
+      if (!runahead_ring_load_state(runahead_ring_real))
+         return false;
+      return runahead_ring_fill(runahead_count);
+   }
+
+   runahead_ring_real = (runahead_ring_real + 1) % runahead_ring_size;
+   next_slot          = (runahead_ring_real + runahead_count)
+      % runahead_ring_size;
+
+   runahead_core_run_use_last_input();
+
+   return runahead_ring_save_state(next_slot);
+}
+
+void run_ahead(int runahead_count, bool useSecondary, bool skip_reload)
 {
    int frame_number        = 0;
    bool last_frame         = false;
@@ -353,6 +618,7 @@ void run_ahead(int runahead_count, bool useSecondary)
 
    if (runahead_count <= 0 || !runahead_available)
    {
+      runahead_ring_restore();
       core_run();
       runahead_force_input_dirty = true;
       return;
@@ -375,8 +641,25 @@ void run_ahead(int runahead_count, bool useSecondary)
 
    runahead_check_for_gui();
 
-   if (!useSecondary || !have_dynamic || !runahead_secondary_core_available)
+   if (skip_reload && runahead_ring_allowed() &&
+         (!useSecondary || !have_dynamic ||
+            !runahead_secondary_core_available))
+   {
+      if (!runahead_run_ring(runahead_count))
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         return;
+      }
+      input_is_dirty = false;
+   }
+   else if (!useSecondary || !have_dynamic || !runahead_secondary_core_available)
    {
+      if (!runahead_ring_restore())
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         return;
+      }
+
       /* TODO: multiple savestates for higher performance
        * when not using secondary core */
       for (frame_number = 0; frame_number <= runahead_count; frame_number++)
@@ -422,6 +705,11 @@ void run_ahead(int runahead_count, bool useSecondary)
    }
    else
    {
+      if (!runahead_ring_restore())
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         return;
+      }
 #if HAVE_DYNAMIC
       if (!secondary_core_ensure_exists())
       {
@@ -441,7 +729,7 @@ void run_ahead(int runahead_count, bool useSecondary)
       {
          input_is_dirty       = false;
 
-         if (!runahead_save_state())
+         if (!runahead_save_state_secondary())
          {
             runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
             return;
@@ -477,6 +765,7 @@ void run_ahead(int runahead_count, bool useSecondary)
 void runahead_destroy(void)
 {
    runahead_save_state_list_destroy();
+   runahead_ring_destroy();
    runahead_remove_hooks();
    runahead_clear_variables();
 }
@@ -10,7 +10,12 @@ RETRO_BEGIN_DECLS
 
 void runahead_destroy(void);
 
-void run_ahead(int runAheadCount, bool useSecondary);
+void run_ahead(int runAheadCount, bool useSecondary, bool skipReload);
+
+/* Loads the state of the last real frame back into the core if the
+ * skip reload mode left it at a frame run ahead. Anything that saves
+ * the core's state or memory for later calls this first. */
+bool runahead_ring_restore(void);
 
 bool want_fast_savestate(void);
 bool get_hard_disable_audio(void);
@@ -10,6 +10,7 @@
 #endif
 
 #include <boolean.h>
+#include <memalign.h>
 #include <encodings/utf.h>
 #include <dynamic/dylib.h>
 #include <file/file_path.h>
@@ -22,14 +23,22 @@
 #include "../dynamic.h"
 #include "../paths.h"
 #include "../content.h"
+#include "../verbosity.h"
 
 #include "secondary_core.h"
 #include "dirty_input.h"
 
 static int port_map[16];
 
+/* Page-aligned buffer the primary core serializes into
+ * and the secondary core unserializes from */
+#define SECONDARY_STATE_ALIGNMENT 4096
+
 static char *secondary_library_path;
+static bool secondary_library_is_temp;
 static dylib_t secondary_module;
+static void *secondary_state_buffer;
+static size_t secondary_state_size;
 static struct retro_core_t secondary_core;
 static struct retro_callbacks secondary_callbacks;
 
@@ -235,104 +244,154 @@ static bool rarch_environment_secondary_core_hook(unsigned cmd, void *data)
    return result;
 }
 
-static bool secondary_core_create(void)
+/* Loads a second instance of the core into its own namespace if
+ * @isolated, otherwise from a temporary copy of the library file,
+ * which is needed on platforms where the same file can't be loaded
+ * twice. */
+static bool secondary_core_load_library(bool isolated)
 {
-   long port, device;
-   bool contentless       = false;
-   bool is_inited         = false;
+   if (isolated)
+   {
+      secondary_module = dylib_load_isolated(path_get(RARCH_PATH_CORE));
 
-   if (  last_core_type != CORE_TYPE_PLAIN ||
-         !load_content_info                ||
-         load_content_info->special)
-      return false;
+      if (!secondary_module)
+         return false;
 
-   if (secondary_library_path)
-      free(secondary_library_path);
-   secondary_library_path = NULL;
-   secondary_library_path = copy_core_to_temp_file();
+      secondary_library_path = strcpy_alloc_force(
+            path_get(RARCH_PATH_CORE));
+   }
+   else
+   {
+      secondary_library_path    = copy_core_to_temp_file();
+      secondary_library_is_temp = true;
 
-   if (!secondary_library_path)
-      return false;
+      if (!secondary_library_path)
+         return false;
+   }
 
-   /* Load Core */
-   if (init_libretro_sym_custom(
+   if (!init_libretro_sym_custom(
             CORE_TYPE_PLAIN, &secondary_core,
             secondary_library_path, &secondary_module))
-   {
-      secondary_core.symbols_inited = true;
-      secondary_core.retro_set_environment(
-            rarch_environment_secondary_core_hook);
-      secondary_core_set_variable_update();
+      return false;
 
-      secondary_core.retro_init();
+   secondary_core.symbols_inited = true;
 
-      content_get_status(&contentless, &is_inited);
-      secondary_core.inited = is_inited;
+   if (isolated)
+      RARCH_LOG("[Run-Ahead]: Loaded secondary core in a separate namespace.\n");
+   else
+      RARCH_LOG("[Run-Ahead]: Loaded secondary core from temporary copy \"%s\".\n",
+            secondary_library_path);
+   return true;
+}
 
-      /* Load Content */
-      if (!load_content_info || load_content_info->special)
-      {
-         /* disabled due to crashes */
-         return false;
-#if 0
-         secondary_core.game_loaded = secondary_core.retro_load_game_special(
-               loadContentInfo.special->id, loadContentInfo.info, loadContentInfo.content->size);
-         if (!secondary_core.game_loaded)
-         {
-            secondary_core_destroy();
-            return false;
-         }
-#endif
-      }
-      else if (load_content_info->content->size > 0 && load_content_info->content->elems[0].data)
-      {
-         secondary_core.game_loaded = secondary_core.retro_load_game(load_content_info->info);
-         if (!secondary_core.game_loaded)
-         {
-            secondary_core_destroy();
-            return false;
-         }
-      }
-      else if (contentless)
-      {
-         secondary_core.game_loaded = secondary_core.retro_load_game(NULL);
-         if (!secondary_core.game_loaded)
-         {
-            secondary_core_destroy();
-            return false;
-         }
-      }
-      else
-         secondary_core.game_loaded = false;
+/* Initializes the loaded secondary core and loads the content
+ * into it. */
+static bool secondary_core_start(void)
+{
+   long port, device;
+   bool contentless       = false;
+   bool is_inited         = false;
 
-      if (!secondary_core.inited)
-      {
-         secondary_core_destroy();
-         return false;
-      }
+   secondary_core.retro_set_environment(
+         rarch_environment_secondary_core_hook);
+   secondary_core_set_variable_update();
 
-      core_set_default_callbacks(&secondary_callbacks);
-      secondary_core.retro_set_video_refresh(secondary_callbacks.frame_cb);
-      secondary_core.retro_set_audio_sample(secondary_callbacks.sample_cb);
-      secondary_core.retro_set_audio_sample_batch(secondary_callbacks.sample_batch_cb);
-      secondary_core.retro_set_input_state(secondary_callbacks.state_cb);
-      secondary_core.retro_set_input_poll(secondary_callbacks.poll_cb);
+   secondary_core.retro_init();
 
-      for (port = 0; port < 16; port++)
-      {
-         device = port_map[port];
-         if (device >= 0)
-            secondary_core.retro_set_controller_port_device(
-                  (unsigned)port, (unsigned)device);
-      }
-      clear_controller_port_map();
+   content_get_status(&contentless, &is_inited);
+   secondary_core.inited = is_inited;
+
+   /* Load Content */
+   if (!load_content_info || load_content_info->special)
+   {
+      /* disabled due to crashes */
+      return false;
+#if 0
+      secondary_core.game_loaded = secondary_core.retro_load_game_special(
+            loadContentInfo.special->id, loadContentInfo.info, loadContentInfo.content->size);
+      if (!secondary_core.game_loaded)
+         return false;
+#endif
+   }
+   else if (load_content_info->content->size > 0 && load_content_info->content->elems[0].data)
+   {
+      secondary_core.game_loaded = secondary_core.retro_load_game(load_content_info->info);
+      if (!secondary_core.game_loaded)
+         return false;
+   }
+   else if (contentless)
+   {
+      secondary_core.game_loaded = secondary_core.retro_load_game(NULL);
+      if (!secondary_core.game_loaded)
+         return false;
    }
    else
+      secondary_core.game_loaded = false;
+
+   if (!secondary_core.inited)
       return false;
 
+   core_set_default_callbacks(&secondary_callbacks);
+   secondary_core.retro_set_video_refresh(secondary_callbacks.frame_cb);
+   secondary_core.retro_set_audio_sample(secondary_callbacks.sample_cb);
+   secondary_core.retro_set_audio_sample_batch(secondary_callbacks.sample_batch_cb);
+   secondary_core.retro_set_input_state(secondary_callbacks.state_cb);
+   secondary_core.retro_set_input_poll(secondary_callbacks.poll_cb);
+
+   for (port = 0; port < 16; port++)
+   {
+      device = port_map[port];
+      if (device >= 0)
+         secondary_core.retro_set_controller_port_device(
+               (unsigned)port, (unsigned)device);
+   }
+   clear_controller_port_map();
+
    return true;
 }
 
+static bool secondary_core_create(void)
+{
+   if (  last_core_type != CORE_TYPE_PLAIN ||
+         !load_content_info                ||
+         load_content_info->special)
+      return false;
+
+   /* The content buffer is only copied if the second instance
+    * was enabled when the content was loaded */
+   if (     load_content_info->info
+         && load_content_info->info->size
+         && !load_content_info->info->data)
+   {
+      RARCH_WARN("[Run-Ahead]: Content was loaded without a copy for the second instance, reload it to use one.\n");
+      return false;
+   }
+
+   if (secondary_library_path)
+      free(secondary_library_path);
+   secondary_library_path    = NULL;
+   secondary_library_is_temp = false;
+
+   /* Some cores only misbehave once they share the process with
+    * their first instance, when loading the game for instance. */
+   if (secondary_core_load_library(true))
+   {
+      if (secondary_core_start())
+         return true;
+
+      RARCH_WARN("[Run-Ahead]: Secondary core failed to start in a separate namespace, trying a temporary copy.\n");
+   }
+
+   secondary_core_destroy();
+
+   if (     secondary_core_load_library(false)
+         && secondary_core_start())
+      return true;
+
+   secondary_core_destroy();
+   return false;
+}
+
 void secondary_core_set_variable_update(void)
 {
    has_variable_update = true;
@@ -375,6 +434,23 @@ bool secondary_core_deserialize(const void *buffer, int size)
    return false;
 }
 
+void *secondary_core_get_state_buffer(size_t size)
+{
+   if (secondary_state_buffer && secondary_state_size == size)
+      return secondary_state_buffer;
+
+   if (secondary_state_buffer)
+      memalign_free(secondary_state_buffer);
+
+   secondary_state_size   = 0;
+   secondary_state_buffer = memalign_alloc(SECONDARY_STATE_ALIGNMENT, size);
+
+   if (secondary_state_buffer)
+      secondary_state_size = size;
+
+   return secondary_state_buffer;
+}
+
 bool secondary_core_ensure_exists(void)
 {
    if (!secondary_module)
@@ -390,23 +466,32 @@ bool secondary_core_ensure_exists(void)
 
 void secondary_core_destroy(void)
 {
-   if (!secondary_module)
-      return;
-
-   /* unload game from core */
-   if (secondary_core.retro_unload_game)
-      secondary_core.retro_unload_game();
-   /* deinit */
-   if (secondary_core.retro_deinit)
-      secondary_core.retro_deinit();
+   if (secondary_state_buffer)
+      memalign_free(secondary_state_buffer);
+   secondary_state_buffer = NULL;
+   secondary_state_size   = 0;
+
+   /* Also called on a core which failed to load or to start */
+   if (secondary_module)
+   {
+      /* unload game from core */
+      if (secondary_core.game_loaded && secondary_core.retro_unload_game)
+         secondary_core.retro_unload_game();
+      /* deinit */
+      if (secondary_core.symbols_inited && secondary_core.retro_deinit)
+         secondary_core.retro_deinit();
+
+      dylib_close(secondary_module);
+      secondary_module = NULL;
+   }
    memset(&secondary_core, 0, sizeof(struct retro_core_t));
 
-   dylib_close(secondary_module);
-   secondary_module = NULL;
-   filestream_delete(secondary_library_path);
+   if (secondary_library_is_temp && secondary_library_path)
+      filestream_delete(secondary_library_path);
    if (secondary_library_path)
       free(secondary_library_path);
-   secondary_library_path = NULL;
+   secondary_library_path    = NULL;
+   secondary_library_is_temp = false;
 }
 
 void remember_controller_port_device(long port, long device)
@@ -439,6 +524,11 @@ bool secondary_core_deserialize(const void *buffer, int size)
    return false;
 }
 
+void *secondary_core_get_state_buffer(size_t size)
+{
+   return NULL;
+}
+
 void secondary_core_destroy(void) { }
 void remember_controller_port_device(long port, long device) { }
 void secondary_core_set_variable_update(void) { }
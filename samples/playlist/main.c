@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <features/features_cpu.h>
+#include <retro_miscellaneous.h>
+#include <string/stdstring.h>
+
+#include "../../configuration.h"
+#include "../../file_path_special.h"
+#include "../../playlist.h"
+
+#define BENCH_ENTRIES 50000
+
+static settings_t bench_settings;
+
+/* Stand-ins for the parts of the frontend playlist.c uses */
+settings_t *config_get_ptr(void)
+{
+   return &bench_settings;
+}
+
+const char *file_path_str(enum file_path_enum enum_idx)
+{
+   return "";
+}
+
+void frontend_driver_attach_console(void) { }
+void frontend_driver_detach_console(void) { }
+
+static void bench_entry_path(char *s, size_t len,
+      const char *dir, unsigned i)
+{
+   /* Mix plain files and archive members like a scan would */
+   if (i & 1)
+      snprintf(s, len, "%s/game%06u.zip#game%06u.sfc", dir, i, i);
+   else
+      snprintf(s, len, "%s/game%06u.sfc", dir, i);
+}
+
+static double bench_elapsed(retro_time_t start)
+{
+   return (cpu_features_get_time_usec() - start) / 1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   retro_time_t start;
+   double t;
+   char lpl_path[PATH_MAX_LENGTH];
+   char dir[PATH_MAX_LENGTH];
+   char path[PATH_MAX_LENGTH];
+   char label[64];
+   char crc[32];
+   unsigned found                      = 0;
+   int failed                          = 0;
+   unsigned count                      = BENCH_ENTRIES;
+   const struct playlist_entry *entry  = NULL;
+   playlist_t *playlist                = NULL;
+
+   if (argc > 1)
+      count = (unsigned)strtoul(argv[1], NULL, 10);
+
+   bench_settings.bools.playlist_fuzzy_archive_match = true;
+
+   snprintf(dir, sizeof(dir), "/tmp/playlist_bench");
+   path_mkdir(dir);
+   snprintf(lpl_path, sizeof(lpl_path), "%s/bench.lpl", dir);
+   remove(lpl_path);
+
+   playlist = playlist_init(lpl_path, 99999);
+
+   /* Same pattern as the content scanner */
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < count; i++)
+   {
+      struct playlist_entry e = {0};
+
+      bench_entry_path(path, sizeof(path), dir, i);
+      snprintf(label, sizeof(label), "Game %u", i);
+      snprintf(crc, sizeof(crc), "%08X|crc", i * 2654435761u);
+
+      if (playlist_entry_exists(playlist, path, crc))
+         continue;
+
+      e.path      = path;
+      e.label     = label;
+      e.core_path = (char*)"DETECT";
+      e.core_name = (char*)"DETECT";
+      e.db_name   = (char*)"bench.lpl";
+      e.crc32     = crc;
+
+      playlist_push(playlist, &e);
+   }
+   t = bench_elapsed(start);
+   printf("push:   %u entries in %.3f s (%.0f entries/s)\n",
+         count, t, count / (t > 0 ? t : 1e-9));
+
+   if (playlist_size(playlist) != count)
+   {
+      printf("FAIL: size %u, expected %u\n",
+            (unsigned)playlist_size(playlist), count);
+      failed++;
+   }
+
+   /* Pushing the top entry again must be a no-op */
+   {
+      struct playlist_entry e = {0};
+      bench_entry_path(path, sizeof(path), dir, count - 1);
+      e.path      = path;
+      e.core_path = (char*)"DETECT";
+      if (playlist_push(playlist, &e) || playlist_size(playlist) != count)
+      {
+         printf("FAIL: duplicate top entry was pushed\n");
+         failed++;
+      }
+   }
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < count; i++)
+   {
+      bench_entry_path(path, sizeof(path), dir, (i * 7919) % count);
+      if (playlist_entry_exists(playlist, path, NULL))
+         found++;
+      bench_entry_path(path, sizeof(path), dir, count + i);
+      if (playlist_entry_exists(playlist, path, NULL))
+         found += count;
+   }
+   t = bench_elapsed(start);
+   printf("lookup: %u paths in %.3f s (%.0f lookups/s)\n",
+         count * 2, t, count * 2 / (t > 0 ? t : 1e-9));
+
+   if (found != count)
+   {
+      printf("FAIL: found %u paths, expected %u\n", found, count);
+      failed++;
+   }
+
+   /* Fuzzy archive match: the archive alone finds its member */
+   entry = NULL;
+   snprintf(path, sizeof(path), "%s/game%06u.zip", dir, 1);
+   playlist_get_index_by_path(playlist, path, &entry);
+   if (!entry || !strstr(entry->path, "game000001.sfc"))
+   {
+      printf("FAIL: fuzzy archive lookup\n");
+      failed++;
+   }
+
+   start = cpu_features_get_time_usec();
+   for (i = 0, found = 0; i < count; i++)
+   {
+      entry = NULL;
+      snprintf(crc, sizeof(crc), "%08x|crc", i * 2654435761u);
+      playlist_get_index_by_crc32(playlist, crc, &entry);
+      if (entry)
+         found++;
+      entry = NULL;
+      snprintf(label, sizeof(label), "Game %u", i);
+      playlist_get_index_by_label(playlist, label, &entry);
+      if (entry)
+         found++;
+   }
+   t = bench_elapsed(start);
+   printf("keys:   %u crc/label lookups in %.3f s\n", count * 2, t);
+
+   if (found != count * 2)
+   {
+      printf("FAIL: found %u keys, expected %u\n", found, count * 2);
+      failed++;
+   }
+
+   /* Deleting shifts entries, the index must follow */
+   playlist_delete_index(playlist, 0);
+   bench_entry_path(path, sizeof(path), dir, count - 1);
+   if (playlist_entry_exists(playlist, path, NULL))
+   {
+      printf("FAIL: deleted entry still found\n");
+      failed++;
+   }
+   bench_entry_path(path, sizeof(path), dir, 0);
+   if (!playlist_entry_exists(playlist, path, NULL))
+   {
+      printf("FAIL: oldest entry lost after delete\n");
+      failed++;
+   }
+
+   start = cpu_features_get_time_usec();
+   playlist_write_file(playlist);
+   t = bench_elapsed(start);
+   printf("write:  %u entries in %.3f s\n", count - 1, t);
+
+   playlist_free(playlist);
+
+   start    = cpu_features_get_time_usec();
+   playlist = playlist_init(lpl_path, 99999);
+   t        = bench_elapsed(start);
+   printf("read:   %u entries in %.3f s\n",
+         (unsigned)playlist_size(playlist), t);
+
+   entry = NULL;
+   playlist_get_index(playlist, 0, &entry);
+   bench_entry_path(path, sizeof(path), dir, count - 2);
+   if (playlist_size(playlist) != count - 1 || !entry
+         || !string_is_equal(entry->path, path))
+   {
+      printf("FAIL: read back playlist differs\n");
+      failed++;
+   }
+
+   playlist_free(playlist);
+   remove(lpl_path);
+
+   /* History style playlist: full playlists drop the oldest
+    * entry, pushing a known entry moves it to the top */
+   playlist = playlist_init(lpl_path, 100);
+   for (i = 0; i < 250; i++)
+   {
+      struct playlist_entry e = {0};
+
+      bench_entry_path(path, sizeof(path), dir, i % 200);
+      e.path      = path;
+      e.core_path = (char*)"DETECT";
+      playlist_push(playlist, &e);
+   }
+
+   entry = NULL;
+   playlist_get_index(playlist, 0, &entry);
+   bench_entry_path(path, sizeof(path), dir, 49);
+   if (playlist_size(playlist) != 100 || !entry
+         || !string_is_equal(entry->path, path))
+   {
+      printf("FAIL: history playlist order\n");
+      failed++;
+   }
+
+   bench_entry_path(path, sizeof(path), dir, 149);
+   if (playlist_entry_exists(playlist, path, NULL))
+   {
+      printf("FAIL: dropped entry still found\n");
+      failed++;
+   }
+
+   /* Updating entries over and over, writing out in between,
+    * compacts the strings of the playlist */
+   for (i = 0; i < 5000; i++)
+   {
+      struct playlist_entry e = {0};
+
+      snprintf(label, sizeof(label), "Label %u", i);
+      e.label = label;
+      playlist_update(playlist, i % 100, &e);
+      if (i % 100 == 99)
+         playlist_write_file(playlist);
+   }
+
+   for (i = 0; i < 100; i++)
+   {
+      entry = NULL;
+      playlist_get_index(playlist, i, &entry);
+      snprintf(label, sizeof(label), "Label %u", 4900 + i);
+      bench_entry_path(path, sizeof(path), dir, (249 - i) % 200);
+      if (!entry || !string_is_equal(entry->label, label)
+            || !string_is_equal(entry->path, path))
+      {
+         printf("FAIL: entry %u differs after updates\n", i);
+         failed++;
+         break;
+      }
+   }
+
+   playlist_free(playlist);
+
+   printf("%s\n", failed ? "FAILED" : "PASSED");
+
+   return failed ? 1 : 0;
+}
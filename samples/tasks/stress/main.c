@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <queues/task_queue.h>
+#include <features/features_cpu.h>
+
+#define STRESS_TASKS 5000
+
+typedef struct
+{
+   unsigned steps;
+   unsigned work;
+} stress_state_t;
+
+static unsigned stress_done[TASK_PRIORITY_LAST];
+static retro_time_t stress_latency[TASK_PRIORITY_LAST];
+static retro_time_t stress_start;
+
+static void main_msg_queue_push(retro_task_t *task,
+      const char *msg,
+      unsigned prio, unsigned duration,
+      bool flush)
+{
+}
+
+static void stress_handler(retro_task_t *task)
+{
+   stress_state_t *state   = (stress_state_t*)task->state;
+   volatile unsigned accum = 0;
+   unsigned i;
+
+   /* Pretend to do some work each step */
+   for (i = 0; i < state->work; i++)
+      accum += i * i;
+
+   if (--state->steps == 0)
+      task_set_finished(task, true);
+}
+
+static void stress_cb(retro_task_t *task,
+      void *task_data, void *user_data, const char *err)
+{
+   enum task_priority priority = task->priority;
+
+   stress_done[priority]++;
+   stress_latency[priority] += cpu_features_get_time_usec() - stress_start;
+
+   free(task->state);
+}
+
+static void stress_push(unsigned i)
+{
+   retro_task_t   *task  = task_init();
+   stress_state_t *state = (stress_state_t*)calloc(1, sizeof(*state));
+
+   /* Mix of short interactive tasks, medium I/O ones
+    * and long running background ones, a few of them
+    * serial ones on the first worker. */
+   switch (i % 10)
+   {
+      case 0:
+      case 1:
+      case 2:
+         task->priority = TASK_PRIORITY_INTERACTIVE;
+         state->steps   = 1;
+         state->work    = 20000;
+         break;
+      case 9:
+         task->priority = TASK_PRIORITY_BACKGROUND;
+         state->steps   = 50;
+         state->work    = 20000;
+         break;
+      default:
+         task->priority = TASK_PRIORITY_IO;
+         state->steps   = 4;
+         state->work    = 20000;
+         break;
+   }
+
+   task->concurrent = (i % 50) != 7;
+   task->state      = state;
+   task->handler    = stress_handler;
+   task->callback   = stress_cb;
+
+   task_queue_push(task);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   retro_time_t elapsed;
+   unsigned workers = 0;
+   unsigned count   = STRESS_TASKS;
+   static const char *names[TASK_PRIORITY_LAST] = {
+      "I/O", "interactive", "background"
+   };
+
+   if (argc > 1)
+      workers = (unsigned)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      count   = (unsigned)strtoul(argv[2], NULL, 10);
+
+   task_queue_set_worker_count(workers);
+   task_queue_set_threaded();
+   task_queue_init(true, main_msg_queue_push);
+
+   stress_start = cpu_features_get_time_usec();
+
+   for (i = 0; i < count; i++)
+      stress_push(i);
+
+   task_queue_wait(NULL, NULL);
+   /* Run the callbacks of the last tasks to finish */
+   task_queue_check();
+
+   elapsed = cpu_features_get_time_usec() - stress_start;
+
+   printf("%u tasks in %.1f ms\n", count, elapsed / 1000.0);
+
+   for (i = 0; i < TASK_PRIORITY_LAST; i++)
+   {
+      if (!stress_done[i])
+         continue;
+      printf("  %-12s: %5u tasks, average completion after %.1f ms\n",
+            names[i], stress_done[i],
+            stress_latency[i] / (1000.0 * stress_done[i]));
+   }
+
+   task_queue_deinit();
+
+   return 0;
+}
@@ -47,9 +47,22 @@
 #include "../config.h"
 #endif
 
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <memmap.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+#include <sys/resource.h>
+#define HAVE_CONTENT_PEAK_RSS
+#endif
+
 #include <boolean.h>
 
 #include <encodings/crc32.h>
+#include <hash/hash_stream.h>
 #include <compat/strl.h>
 #include <compat/posix_string.h>
 #include <file/file_path.h>
@@ -59,6 +72,7 @@
 #include <retro_miscellaneous.h>
 #include <streams/file_stream.h>
 #include <retro_assert.h>
+#include <features/features_cpu.h>
 
 #include <lists/string_list.h>
 #include <string/stdstring.h>
@@ -143,6 +157,7 @@ struct content_information_ctx
    bool patch_is_blocked;
    bool bios_is_missing;
    bool check_firmware_before_loading;
+   bool load_mmap;
 
    struct string_list *temporary_content;
 };
@@ -176,6 +191,97 @@ static int64_t content_file_read(const char *path, void **buf, int64_t *length)
    return filestream_read_file(path, buf, length);
 }
 
+#if defined(HAVE_MMAP) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Maps the content file @path privately (copy-on-write), so a
+ * core can be handed the data without reading it into a buffer.
+ * The mapping is followed by at least one zeroed byte, which
+ * keeps the data NUL-terminated like filestream_read_file.
+ * Returns: length of the mapping, to be passed to
+ * content_file_unmap, or 0 if the file could not be mapped. */
+static size_t content_file_map(const char *path, void **buf, int64_t *length)
+{
+   size_t map_len = 0;
+#ifdef HAVE_MMAP
+   struct stat st;
+   int fd;
+
+#ifdef HAVE_COMPRESSION
+   if (path_contains_compressed_file(path))
+      return 0;
+#endif
+
+   fd = open(path, O_RDONLY);
+
+   if (fd < 0)
+      return 0;
+
+   if (     fstat(fd, &st) == 0
+         && S_ISREG(st.st_mode)
+         && st.st_size > 0
+         && (uint64_t)st.st_size < (uint64_t)SIZE_MAX / 2)
+   {
+      size_t page = (size_t)sysconf(_SC_PAGESIZE);
+      size_t size = (size_t)st.st_size;
+      size_t len  = (size + page) & ~(page - 1);
+      void  *base = mmap(NULL, len, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+      if (base != MAP_FAILED)
+      {
+         /* Place the file over the start of the anonymous
+          * reservation; the remaining pages stay zeroed. */
+         if (mmap(base, size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_FIXED, fd, 0) == base)
+         {
+            *buf    = base;
+            *length = (int64_t)size;
+            map_len = len;
+         }
+         else
+            munmap(base, len);
+      }
+   }
+
+   close(fd);
+#endif
+   return map_len;
+}
+
+static void content_file_unmap(void *buf, size_t map_len)
+{
+#ifdef HAVE_MMAP
+   munmap(buf, map_len);
+#endif
+}
+
+static void content_file_release(void *buf, size_t map_len)
+{
+   if (map_len)
+      content_file_unmap(buf, map_len);
+   else
+      free(buf);
+}
+
+/* Returns: peak resident set size of the process in KB,
+ * or 0 if the platform doesn't report it. */
+static uint64_t content_peak_rss(void)
+{
+#ifdef HAVE_CONTENT_PEAK_RSS
+   struct rusage usage;
+
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef __APPLE__
+      return (uint64_t)usage.ru_maxrss / 1024;
+#else
+      return (uint64_t)usage.ru_maxrss;
+#endif
+#endif
+   return 0;
+}
+
 /**
  * content_load_init_wrap:
  * @args                 : Input arguments.
@@ -320,6 +426,8 @@ end:
  * @path         : buffer of the content file.
  * @buf          : size   of the content file.
  * @length       : size of the content file that has been read from.
+ * @map_len      : set to the length of the mapping if @buf was
+ *                 memory-mapped rather than allocated, 0 otherwise.
  *
  * Read the content file. If read into memory, also performs soft patching
  * (see patch_content function) in case soft patching has not been
@@ -330,14 +438,19 @@ end:
 static bool load_content_into_memory(
       content_information_ctx_t *content_ctx,
       unsigned i, const char *path, void **buf,
-      int64_t *length)
+      int64_t *length, size_t *map_len)
 {
    uint8_t *ret_buf          = NULL;
 
    RARCH_LOG("%s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
 
-   if (!content_file_read(path, (void**) &ret_buf, length))
+   *map_len = 0;
+
+   if (content_ctx->load_mmap)
+      *map_len = content_file_map(path, (void**)&ret_buf, length);
+
+   if (!*map_len && !content_file_read(path, (void**) &ret_buf, length))
       return false;
 
    if (*length < 0)
@@ -355,6 +468,9 @@ static bool load_content_into_memory(
 
          /* Attempt to apply a patch. */
          if (!content_ctx->patch_is_blocked)
+         {
+            uint8_t *unpatched = ret_buf;
+
             patch_content(
                   content_ctx->is_ips_pref,
                   content_ctx->is_bps_pref,
@@ -365,7 +481,15 @@ static bool load_content_into_memory(
                   (uint8_t**)&ret_buf,
                   (void*)length);
 
-         content_rom_crc = encoding_crc32(0, ret_buf, (size_t)*length);
+            /* A patch was applied into a new buffer. */
+            if (ret_buf != unpatched)
+            {
+               content_file_release(unpatched, *map_len);
+               *map_len = 0;
+            }
+         }
+
+         content_rom_crc = hash_crc32(0, ret_buf, (size_t)*length);
 
          RARCH_LOG("CRC32: 0x%x .\n", (unsigned)content_rom_crc);
       }
@@ -556,11 +680,14 @@ static bool content_file_load(
       content_information_ctx_t *content_ctx,
       char **error_string,
       const struct retro_subsystem_info *special,
-      struct string_list *additional_path_allocs
+      struct string_list *additional_path_allocs,
+      size_t *map_lens
       )
 {
    unsigned i;
    retro_ctx_load_content_info_t load_info;
+   retro_time_t load_start     = cpu_features_get_time_usec();
+   unsigned mapped             = 0;
    size_t msg_size             = 1024 * sizeof(char);
    char *msg                   = (char*)malloc(msg_size);
    bool used_vfs_fallback_copy = false;
@@ -600,7 +727,7 @@ static bool content_file_load(
 
          if (!load_content_into_memory(
                   content_ctx,
-                  i, path, (void**)&info[i].data, &len))
+                  i, path, (void**)&info[i].data, &len, &map_lens[i]))
          {
             snprintf(msg,
                   msg_size,
@@ -612,6 +739,9 @@ static bool content_file_load(
          }
 
          info[i].size = len;
+
+         if (map_lens[i])
+            mapped++;
       }
       else
       {
@@ -732,6 +862,12 @@ static bool content_file_load(
       goto error;
    }
 
+   RARCH_LOG("[Content]: Loaded in %u ms (%u of %u file(s) mapped), "
+         "peak RSS %u KB.\n",
+         (unsigned)((cpu_features_get_time_usec() - load_start) / 1000),
+         mapped, (unsigned)content->size,
+         (unsigned)content_peak_rss());
+
 #ifdef HAVE_CHEEVOS
    if (!special)
    {
@@ -905,14 +1041,23 @@ static bool content_file_init(
    {
       unsigned i;
       struct string_list *additional_path_allocs = string_list_new();
+      size_t *map_lens                           = (size_t*)
+         calloc(content->size, sizeof(*map_lens));
 
-      ret = content_file_load(info, content, content_ctx, error_string,
-            special, additional_path_allocs);
-      string_list_free(additional_path_allocs);
+      if (map_lens)
+      {
+         ret = content_file_load(info, content, content_ctx, error_string,
+               special, additional_path_allocs, map_lens);
 
-      for (i = 0; i < content->size; i++)
-         free((void*)info[i].data);
+         for (i = 0; i < content->size; i++)
+            if (info[i].data)
+               content_file_release((void*)info[i].data, map_lens[i]);
+      }
+      else
+         ret = false;
 
+      string_list_free(additional_path_allocs);
+      free(map_lens);
       free(info);
    }
    else if (!special)
@@ -1221,6 +1366,7 @@ bool task_push_start_dummy_core(content_ctx_info_t *content_info)
       return false;
 
    content_ctx.check_firmware_before_loading  = settings->bools.check_firmware_before_loading;
+   content_ctx.load_mmap                      = settings->bools.content_load_mmap;
    content_ctx.is_ips_pref                    = rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    content_ctx.is_bps_pref                    = rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
    content_ctx.is_ups_pref                    = rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL);
@@ -1312,6 +1458,7 @@ bool task_push_load_content_from_playlist_from_menu(
    rarch_system_info_t *sys_info              = runloop_get_system_info();
 
    content_ctx.check_firmware_before_loading  = settings->bools.check_firmware_before_loading;
+   content_ctx.load_mmap                      = settings->bools.content_load_mmap;
    content_ctx.is_ips_pref                    = rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    content_ctx.is_bps_pref                    = rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
    content_ctx.is_ups_pref                    = rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL);
@@ -1412,6 +1559,7 @@ bool task_push_start_current_core(content_ctx_info_t *content_info)
       return false;
 
    content_ctx.check_firmware_before_loading  = settings->bools.check_firmware_before_loading;
+   content_ctx.load_mmap                      = settings->bools.content_load_mmap;
    content_ctx.is_ips_pref                    = rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    content_ctx.is_bps_pref                    = rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
    content_ctx.is_ups_pref                    = rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL);
@@ -1536,6 +1684,7 @@ bool task_push_load_content_with_new_core_from_menu(
    settings_t *settings                       = config_get_ptr();
 
    content_ctx.check_firmware_before_loading  = settings->bools.check_firmware_before_loading;
+   content_ctx.load_mmap                      = settings->bools.content_load_mmap;
    content_ctx.is_ips_pref                    = rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    content_ctx.is_bps_pref                    = rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
    content_ctx.is_ups_pref                    = rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL);
@@ -1639,6 +1788,7 @@ static bool task_load_content_callback(content_ctx_info_t *content_info,
    rarch_system_info_t *sys_info              = runloop_get_system_info();
 
    content_ctx.check_firmware_before_loading  = settings->bools.check_firmware_before_loading;
+   content_ctx.load_mmap                      = settings->bools.content_load_mmap;
    content_ctx.is_ips_pref                    = rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    content_ctx.is_bps_pref                    = rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
    content_ctx.is_ups_pref                    = rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL);
@@ -2106,6 +2256,7 @@ bool content_init(void)
    temporary_content                          = string_list_new();
 
    content_ctx.check_firmware_before_loading  = settings->bools.check_firmware_before_loading;
+   content_ctx.load_mmap                      = settings->bools.content_load_mmap;
    content_ctx.patch_is_blocked               = rarch_ctl(RARCH_CTL_IS_PATCH_BLOCKED, NULL);
    content_ctx.is_ips_pref                    = rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    content_ctx.is_bps_pref                    = rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
@@ -2159,6 +2310,9 @@ bool content_init(void)
    _content_is_inited = true;
    content            = string_list_new();
 
+   /* Subsystem content may come from the same solid block */
+   file_archive_cache_hold();
+
    if (     !temporary_content
          || !content_file_init(&content_ctx, content, &error_string))
    {
@@ -2167,6 +2321,10 @@ bool content_init(void)
       ret                = false;
    }
 
+   file_archive_cache_release();
+   /* Keep no archive around for the whole session */
+   file_archive_cache_flush();
+
    string_list_free(content);
 
    if (content_ctx.name_ips)
@@ -23,15 +23,22 @@
 #include <string/stdstring.h>
 #include <lists/dir_list.h>
 #include <file/file_path.h>
-#include <encodings/crc32.h>
+#include <file/archive_file.h>
+#include <hash/hash_stream.h>
+#include <features/features_cpu.h>
 #include <streams/file_stream.h>
 #include <streams/chd_stream.h>
 #include <streams/interface_stream.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 #include "tasks_internal.h"
 
 #include "../core_info.h"
 #include "../database_info.h"
+#include "../database_index.h"
 
+#include "../configuration.h"
 #include "../file_path_special.h"
 #include "../msg_hash.h"
 #include "../playlist.h"
@@ -44,6 +51,79 @@
 #define COLLECTION_SIZE                99999
 #endif
 
+#define DATABASE_SCAN_READ_SIZE        (1024 * 1024)
+#define DATABASE_SCAN_THREADS_MAX      4
+
+#define DATABASE_SCAN_CACHE_MAGIC      0x43534452 /* "RDSC" */
+#define DATABASE_SCAN_CACHE_VERSION    1
+#define DATABASE_SCAN_CACHE_BUCKETS    4096
+
+/* Items a lookup sorts on the stack, more are allocated */
+#define DATABASE_INDEX_MATCHES_STACK   16
+
+enum database_scan_cache_flags
+{
+   DATABASE_SCAN_CACHE_CRC    = (1 << 0),
+   DATABASE_SCAN_CACHE_SERIAL = (1 << 1)
+};
+
+typedef struct database_scan_cache_entry
+{
+   char *path;
+   char *serial;
+   uint64_t size;
+   int64_t mtime;
+   uint32_t crc;
+   uint32_t flags;
+   /* Looked up by the current scan */
+   bool visited;
+   struct database_scan_cache_entry *next;
+} database_scan_cache_entry_t;
+
+/* Persistent (path, size, mtime) -> CRC/serial cache,
+ * so that rescans only need to read the changed files. */
+typedef struct database_scan_cache
+{
+   database_scan_cache_entry_t *buckets[DATABASE_SCAN_CACHE_BUCKETS];
+   bool dirty;
+} database_scan_cache_t;
+
+#ifdef HAVE_THREADS
+enum database_scan_job_state
+{
+   DATABASE_SCAN_JOB_NONE = 0,
+   DATABASE_SCAN_JOB_PENDING,
+   DATABASE_SCAN_JOB_RUNNING,
+   DATABASE_SCAN_JOB_DONE,
+   DATABASE_SCAN_JOB_FAILED
+};
+
+typedef struct database_scan_job
+{
+   char *path;
+   uint64_t size;
+   int64_t mtime;
+   uint32_t crc;
+   unsigned state;
+} database_scan_job_t;
+
+/* Hashes the plain files and archives of the scan list
+ * on a few worker threads, ahead of the database lookups.
+ * The jobs are indexed like the scan list. */
+typedef struct database_scan
+{
+   sthread_t *threads[DATABASE_SCAN_THREADS_MAX];
+   slock_t *lock;
+   scond_t *cond;
+   database_scan_job_t *jobs;
+   size_t jobs_count;
+   size_t jobs_next;
+   uint64_t bytes;
+   unsigned threads_count;
+   bool alive;
+} database_scan_t;
+#endif
+
 typedef struct database_state_handle
 {
    uint32_t crc;
@@ -66,6 +146,19 @@ typedef struct db_handle
    char *playlist_directory;
    char *content_database_path;
    char *fullpath;
+   char *cache_path;
+   database_scan_cache_t *cache;
+   database_index_t *index;
+#ifdef HAVE_THREADS
+   database_scan_t *scan;
+#endif
+   unsigned chd_cache_hunks;
+   unsigned chd_prefetch_hunks;
+   retro_time_t scan_start;
+   uint64_t scan_bytes;
+   /* Playlists that received matches, written when the scan ends */
+   playlist_t **playlists;
+   size_t playlists_count;
    database_info_handle_t *handle;
    database_state_handle_t state;
 } db_handle_t;
@@ -132,22 +225,428 @@ static const char *database_info_get_current_element_name(
    return handle->list->elems[handle->list_ptr].data;
 }
 
+static bool task_database_file_stat(const char *path,
+      uint64_t *size, int64_t *mtime)
+{
+   int64_t len = 0;
+
+   if (!path_get_size_mtime(path, &len, mtime))
+      return false;
+
+   *size = (uint64_t)len;
+
+   return true;
+}
+
+static bool task_database_file_crc(const char *path,
+      uint8_t *buf, size_t len, uint32_t *crc, uint64_t *bytes)
+{
+   int64_t read = 0;
+   uint32_t acc = 0;
+   RFILE *file  = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   while ((read = filestream_read(file, buf, len)) > 0)
+   {
+      acc     = hash_crc32(acc, buf, (size_t)read);
+      *bytes += (uint64_t)read;
+   }
+
+   filestream_close(file);
+
+   if (read < 0)
+      return false;
+
+   *crc = acc;
+
+   return true;
+}
+
+static database_scan_cache_entry_t *task_database_cache_find(
+      database_scan_cache_t *cache, const char *path)
+{
+   database_scan_cache_entry_t *entry = cache->buckets[
+      msg_hash_calculate(path) & (DATABASE_SCAN_CACHE_BUCKETS - 1)];
+
+   for (; entry; entry = entry->next)
+   {
+      if (string_is_equal(entry->path, path))
+         return entry;
+   }
+
+   return NULL;
+}
+
+/* Returns the cache entry of @path, reset if the
+ * file changed since it was last cached. */
+static database_scan_cache_entry_t *task_database_cache_set(
+      database_scan_cache_t *cache, const char *path,
+      uint64_t size, int64_t mtime)
+{
+   database_scan_cache_entry_t *entry = task_database_cache_find(cache, path);
+
+   if (!entry)
+   {
+      database_scan_cache_entry_t **bucket = &cache->buckets[
+         msg_hash_calculate(path) & (DATABASE_SCAN_CACHE_BUCKETS - 1)];
+
+      entry = (database_scan_cache_entry_t*)calloc(1, sizeof(*entry));
+
+      if (!entry)
+         return NULL;
+
+      entry->path = strdup(path);
+      entry->next = *bucket;
+      *bucket     = entry;
+   }
+   else if (entry->size != size || entry->mtime != mtime)
+   {
+      if (entry->serial)
+         free(entry->serial);
+      entry->serial = NULL;
+      entry->flags  = 0;
+   }
+
+   entry->size  = size;
+   entry->mtime = mtime;
+   cache->dirty = true;
+
+   return entry;
+}
+
+static bool task_database_cache_read(const uint8_t **pos,
+      const uint8_t *end, void *data, size_t len)
+{
+   if ((size_t)(end - *pos) < len)
+      return false;
+
+   memcpy(data, *pos, len);
+   *pos += len;
+
+   return true;
+}
+
+static database_scan_cache_t *task_database_cache_load(const char *path)
+{
+   uint32_t header[3];
+   void *buf                    = NULL;
+   int64_t len                  = 0;
+   const uint8_t *pos           = NULL;
+   const uint8_t *end           = NULL;
+   database_scan_cache_t *cache = (database_scan_cache_t*)
+      calloc(1, sizeof(*cache));
+
+   if (!cache || string_is_empty(path) || !path_is_valid(path))
+      return cache;
+
+   if (!filestream_read_file(path, &buf, &len) || !buf)
+      return cache;
+
+   pos = (const uint8_t*)buf;
+   end = pos + len;
+
+   if (     !task_database_cache_read(&pos, end, header, sizeof(header))
+         || swap_if_big32(header[0]) != DATABASE_SCAN_CACHE_MAGIC
+         || swap_if_big32(header[1]) != DATABASE_SCAN_CACHE_VERSION)
+   {
+      RARCH_WARN("[Scanner]: Ignoring invalid scan cache \"%s\".\n", path);
+      free(buf);
+      return cache;
+   }
+
+   header[2] = swap_if_big32(header[2]);
+
+   while (header[2]--)
+   {
+      char name[PATH_MAX_LENGTH];
+      char serial[4096];
+      uint32_t path_len, serial_len, crc, flags;
+      uint64_t size, mtime;
+      database_scan_cache_entry_t *entry = NULL;
+
+      if (!task_database_cache_read(&pos, end, &path_len, sizeof(path_len)))
+         break;
+      path_len = swap_if_big32(path_len);
+      if (path_len >= sizeof(name)
+            || !task_database_cache_read(&pos, end, name, path_len))
+         break;
+      name[path_len] = '\0';
+
+      if (     !task_database_cache_read(&pos, end, &size,       sizeof(size))
+            || !task_database_cache_read(&pos, end, &mtime,      sizeof(mtime))
+            || !task_database_cache_read(&pos, end, &crc,        sizeof(crc))
+            || !task_database_cache_read(&pos, end, &flags,      sizeof(flags))
+            || !task_database_cache_read(&pos, end, &serial_len, sizeof(serial_len)))
+         break;
+
+      serial_len = swap_if_big32(serial_len);
+      if (serial_len >= sizeof(serial)
+            || !task_database_cache_read(&pos, end, serial, serial_len))
+         break;
+      serial[serial_len] = '\0';
+
+      if (!(entry = task_database_cache_set(cache, name,
+                  swap_if_big64(size), (int64_t)swap_if_big64(mtime))))
+         break;
+
+      entry->crc   = swap_if_big32(crc);
+      entry->flags = swap_if_big32(flags);
+      if (entry->flags & DATABASE_SCAN_CACHE_SERIAL)
+         entry->serial = strdup(serial);
+   }
+
+   cache->dirty = false;
+
+   free(buf);
+
+   return cache;
+}
+
+static void task_database_cache_write_u32(RFILE *file, uint32_t val)
+{
+   val = swap_if_big32(val);
+   filestream_write(file, &val, sizeof(val));
+}
+
+static void task_database_cache_write_u64(RFILE *file, uint64_t val)
+{
+   val = swap_if_big64(val);
+   filestream_write(file, &val, sizeof(val));
+}
+
+static void task_database_cache_write(database_scan_cache_t *cache,
+      const char *path)
+{
+   size_t i;
+   uint32_t count = 0;
+   RFILE *file    = NULL;
+
+   if (!cache->dirty || string_is_empty(path))
+      return;
+
+   for (i = 0; i < DATABASE_SCAN_CACHE_BUCKETS; i++)
+   {
+      database_scan_cache_entry_t *entry = cache->buckets[i];
+      for (; entry; entry = entry->next)
+         count++;
+   }
+
+   file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+   {
+      RARCH_WARN("[Scanner]: Failed to write scan cache \"%s\".\n", path);
+      return;
+   }
+
+   task_database_cache_write_u32(file, DATABASE_SCAN_CACHE_MAGIC);
+   task_database_cache_write_u32(file, DATABASE_SCAN_CACHE_VERSION);
+   task_database_cache_write_u32(file, count);
+
+   for (i = 0; i < DATABASE_SCAN_CACHE_BUCKETS; i++)
+   {
+      database_scan_cache_entry_t *entry = cache->buckets[i];
+
+      for (; entry; entry = entry->next)
+      {
+         uint32_t path_len   = (uint32_t)strlen(entry->path);
+         uint32_t serial_len = entry->serial
+            ? (uint32_t)strlen(entry->serial) : 0;
+
+         task_database_cache_write_u32(file, path_len);
+         filestream_write(file, entry->path, path_len);
+         task_database_cache_write_u64(file, entry->size);
+         task_database_cache_write_u64(file, (uint64_t)entry->mtime);
+         task_database_cache_write_u32(file, entry->crc);
+         task_database_cache_write_u32(file, entry->flags);
+         task_database_cache_write_u32(file, serial_len);
+         if (serial_len)
+            filestream_write(file, entry->serial, serial_len);
+      }
+   }
+
+   filestream_close(file);
+
+   RARCH_LOG("[Scanner]: Wrote %u entries to scan cache \"%s\".\n",
+         count, path);
+}
+
+static void task_database_cache_free(database_scan_cache_t *cache)
+{
+   size_t i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < DATABASE_SCAN_CACHE_BUCKETS; i++)
+   {
+      database_scan_cache_entry_t *entry = cache->buckets[i];
+
+      while (entry)
+      {
+         database_scan_cache_entry_t *next = entry->next;
+
+         free(entry->path);
+         if (entry->serial)
+            free(entry->serial);
+         free(entry);
+
+         entry = next;
+      }
+   }
+
+   free(cache);
+}
+
+/* Returns false if @name can't be cached, otherwise
+ * @entry is set to its cache entry if it is unchanged. */
+static bool task_database_cache_lookup(db_handle_t *_db,
+      const char *name, uint64_t *size, int64_t *mtime,
+      database_scan_cache_entry_t **entry)
+{
+   database_scan_cache_entry_t *found = NULL;
+
+   *entry = NULL;
+
+   if (     !_db->cache
+         || path_contains_compressed_file(name)
+         || !task_database_file_stat(name, size, mtime))
+      return false;
+
+   found = task_database_cache_find(_db->cache, name);
+
+   if (!found)
+      return true;
+
+   found->visited = true;
+
+   if (found->size == *size && found->mtime == *mtime)
+      *entry = found;
+
+   return true;
+}
+
+static void task_database_cache_store(db_handle_t *_db,
+      const char *name, uint64_t size, int64_t mtime,
+      uint32_t flags, uint32_t crc, const char *serial)
+{
+   database_scan_cache_entry_t *entry = task_database_cache_set(
+         _db->cache, name, size, mtime);
+
+   if (!entry)
+      return;
+
+   entry->visited = true;
+
+   if (flags & DATABASE_SCAN_CACHE_CRC)
+      entry->crc = crc;
+
+   if (flags & DATABASE_SCAN_CACHE_SERIAL)
+   {
+      if (entry->serial)
+         free(entry->serial);
+      entry->serial = strdup(serial);
+   }
+
+   entry->flags |= flags;
+}
+
+/* Drops the entries under @root that the finished scan didn't
+ * come across, as their files were removed or moved away. */
+static void task_database_cache_prune(database_scan_cache_t *cache,
+      const char *root)
+{
+   size_t i;
+   unsigned pruned = 0;
+   size_t root_len = strlen(root);
+   bool root_slash = root_len && path_char_is_slash(root[root_len - 1]);
+
+   for (i = 0; i < DATABASE_SCAN_CACHE_BUCKETS; i++)
+   {
+      database_scan_cache_entry_t **entry = &cache->buckets[i];
+
+      while (*entry)
+      {
+         database_scan_cache_entry_t *cur = *entry;
+
+         if (     cur->visited
+               || strncmp(cur->path, root, root_len)
+               || (     !root_slash
+                     && cur->path[root_len] != '\0'
+                     && !path_char_is_slash(cur->path[root_len])))
+         {
+            entry = &cur->next;
+            continue;
+         }
+
+         *entry = cur->next;
+         free(cur->path);
+         if (cur->serial)
+            free(cur->serial);
+         free(cur);
+         pruned++;
+      }
+   }
+
+   if (pruned)
+   {
+      cache->dirty = true;
+      RARCH_LOG("[Scanner]: Dropped %u stale scan cache entries.\n",
+            pruned);
+   }
+}
+
+static uint64_t task_database_scan_bytes(db_handle_t *_db)
+{
+   uint64_t bytes = _db->scan_bytes;
+
+#ifdef HAVE_THREADS
+   if (_db->scan)
+   {
+      slock_lock(_db->scan->lock);
+      bytes += _db->scan->bytes;
+      slock_unlock(_db->scan->lock);
+   }
+#endif
+
+   return bytes;
+}
+
 static int task_database_iterate_start(retro_task_t *task,
+      db_handle_t *_db,
       database_info_handle_t *db,
       const char *name)
 {
    char msg[256];
+   char stats[64];
    const char *basename_path = !string_is_empty(name) ? 
       path_basename(name) : "";
+   retro_time_t elapsed      = cpu_features_get_time_usec() - _db->scan_start;
+
+   msg[0]   = '\0';
+   stats[0] = '\0';
 
-   msg[0] = '\0';
+   /* Wait a second for the rates to settle */
+   if (elapsed >= 1000000)
+   {
+      double seconds = elapsed / 1000000.0;
+
+      snprintf(stats, sizeof(stats), " (%u files/s, %.1f MB/s)",
+            (unsigned)(db->list_ptr / seconds),
+            task_database_scan_bytes(_db) / (seconds * 1024.0 * 1024.0));
+   }
 
    snprintf(msg, sizeof(msg),
-         STRING_REP_USIZE "/" STRING_REP_USIZE ": %s %s...\n",
+         STRING_REP_USIZE "/" STRING_REP_USIZE ": %s %s...%s\n",
          (size_t)db->list_ptr,
          (size_t)db->list->size,
          msg_hash_to_str(MSG_SCANNING),
-         basename_path);
+         basename_path,
+         stats);
 
    if (!string_is_empty(msg))
    {
@@ -328,36 +827,65 @@ static int task_database_gdi_get_serial(const char *name, char* serial)
    return ret;
 }
 
-static int task_database_chd_get_serial(const char *name, char* serial)
+static void task_database_chd_options(db_handle_t *_db,
+      chdstream_options_t *options, unsigned decode_threads,
+      chdstream_stats_t *stats)
+{
+   options->cache_hunks    = _db->chd_cache_hunks;
+   options->prefetch_hunks = _db->chd_prefetch_hunks;
+   options->decode_threads = decode_threads;
+   options->stats          = stats;
+
+   memset(stats, 0, sizeof(*stats));
+}
+
+static void task_database_chd_log_stats(const char *name,
+      const chdstream_stats_t *stats)
+{
+   RARCH_LOG("CHD '%s' hunks: %llu hits, %llu misses, "
+         "%llu prefetched, %llu waits, %llu batched\n", name,
+         (unsigned long long)stats->hits,
+         (unsigned long long)stats->misses,
+         (unsigned long long)stats->prefetched,
+         (unsigned long long)stats->waits,
+         (unsigned long long)stats->batched);
+}
+
+static int task_database_chd_get_serial(db_handle_t *_db,
+      const char *name, char* serial)
 {
    int result;
-   intfstream_t *fd = intfstream_open_chd_track(
+   chdstream_stats_t stats;
+   chdstream_options_t options;
+   intfstream_t *fd = NULL;
+
+   task_database_chd_options(_db, &options, 1, &stats);
+
+   fd = intfstream_open_chd_track(
          name,
          RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE,
-         CHDSTREAM_TRACK_FIRST_DATA);
+         CHDSTREAM_TRACK_FIRST_DATA, &options);
    if (!fd)
       return 0;
 
    result = intfstream_get_serial(fd, serial);
    intfstream_close(fd);
    free(fd);
+   task_database_chd_log_stats(name, &stats);
    return result;
 }
 
 static int intfstream_get_crc(intfstream_t *fd, uint32_t *crc)
 {
-   int64_t read = 0;
-   uint32_t acc = 0;
-   uint8_t buffer[4096];
+   hash_stream_t hash;
 
-   while ((read = intfstream_read(fd, buffer, sizeof(buffer))) > 0)
-      acc = encoding_crc32(acc, buffer, (size_t)read);
+   hash_stream_init(&hash, HASH_STREAM_CRC32);
 
-   if (read < 0)
+   if (hash_stream_intfstream(&hash, fd) < 0)
       return 0;
 
-   *crc = acc;
+   *crc = hash.ctx.crc32;
 
    return 1;
 }
@@ -485,14 +1013,25 @@ static int task_database_gdi_get_crc(const char *name, uint32_t *crc)
    return rv;
 }
 
-static bool task_database_chd_get_crc(const char *name, uint32_t *crc)
+static bool task_database_chd_get_crc(db_handle_t *_db,
+      const char *name, uint32_t *crc)
 {
    int rv;
-   intfstream_t *fd = intfstream_open_chd_track(
+   chdstream_stats_t stats;
+   chdstream_options_t options;
+   intfstream_t *fd = NULL;
+
+   /* The whole track gets hashed, spread the decompression
+    * over every core */
+   task_database_chd_options(_db, &options,
+         cpu_features_get_core_amount(), &stats);
+
+   fd = intfstream_open_chd_track(
          name,
          RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE,
-         CHDSTREAM_TRACK_PRIMARY);
+         CHDSTREAM_TRACK_PRIMARY, &options);
+
    if (!fd)
       return 0;
 
@@ -501,11 +1040,9 @@ static bool task_database_chd_get_crc(const char *name, uint32_t *crc)
    {
       RARCH_LOG("CHD '%s' crc: %x\n", name, *crc);
    }
-   if (fd)
-   {
-      intfstream_close(fd);
-      free(fd);
-   }
+   intfstream_close(fd);
+   free(fd);
+   task_database_chd_log_stats(name, &stats);
    return rv;
 }
 
@@ -616,18 +1153,322 @@ static enum msg_file_type extension_to_file_type(const char *ext)
    return FILE_TYPE_NONE;
 }
 
+#ifdef HAVE_THREADS
+static void task_database_scan_thread(void *data)
+{
+   database_scan_t *scan = (database_scan_t*)data;
+   uint8_t *buf          = (uint8_t*)malloc(DATABASE_SCAN_READ_SIZE);
+
+   for (;;)
+   {
+      database_scan_job_t *job = NULL;
+      uint64_t bytes           = 0;
+      uint32_t crc             = 0;
+      bool ok                  = false;
+
+      slock_lock(scan->lock);
+      while (scan->jobs_next < scan->jobs_count &&
+            scan->jobs[scan->jobs_next].state != DATABASE_SCAN_JOB_PENDING)
+         scan->jobs_next++;
+
+      if (scan->alive && scan->jobs_next < scan->jobs_count)
+      {
+         job        = &scan->jobs[scan->jobs_next++];
+         job->state = DATABASE_SCAN_JOB_RUNNING;
+      }
+      slock_unlock(scan->lock);
+
+      if (!job)
+         break;
+
+      if (buf)
+         ok = task_database_file_crc(job->path,
+               buf, DATABASE_SCAN_READ_SIZE, &crc, &bytes);
+
+      slock_lock(scan->lock);
+      job->crc     = crc;
+      job->state   = ok ? DATABASE_SCAN_JOB_DONE : DATABASE_SCAN_JOB_FAILED;
+      scan->bytes += bytes;
+      scond_broadcast(scan->cond);
+      slock_unlock(scan->lock);
+   }
+
+   free(buf);
+}
+
+static void task_database_scan_free(database_scan_t *scan)
+{
+   unsigned i;
+
+   if (!scan)
+      return;
+
+   if (scan->lock)
+   {
+      slock_lock(scan->lock);
+      scan->alive = false;
+      slock_unlock(scan->lock);
+   }
+
+   for (i = 0; i < scan->threads_count; i++)
+      sthread_join(scan->threads[i]);
+
+   if (scan->jobs)
+   {
+      size_t j;
+      for (j = 0; j < scan->jobs_count; j++)
+      {
+         if (scan->jobs[j].path)
+            free(scan->jobs[j].path);
+      }
+      free(scan->jobs);
+   }
+
+   if (scan->lock)
+      slock_free(scan->lock);
+   if (scan->cond)
+      scond_free(scan->cond);
+
+   free(scan);
+}
+
+/* Queues the files which are identified by the CRC of the
+ * whole file and aren't in the cache yet, then starts the
+ * threads hashing them. */
+static database_scan_t *task_database_scan_new(db_handle_t *_db,
+      struct string_list *list)
+{
+   size_t i;
+   unsigned threads      = cpu_features_get_core_amount();
+   size_t pending        = 0;
+   database_scan_t *scan = (database_scan_t*)calloc(1, sizeof(*scan));
+
+   if (!scan)
+      return NULL;
+
+   scan->jobs_count = list->size;
+   scan->jobs       = (database_scan_job_t*)calloc(
+         list->size, sizeof(*scan->jobs));
+   scan->lock       = slock_new();
+   scan->cond       = scond_new();
+   scan->alive      = true;
+
+   if (!scan->jobs || !scan->lock || !scan->cond)
+      goto error;
+
+   for (i = 0; i < list->size; i++)
+   {
+      uint64_t size                      = 0;
+      int64_t mtime                      = 0;
+      database_scan_cache_entry_t *entry = NULL;
+      database_scan_job_t *job           = &scan->jobs[i];
+      const char *name                   = list->elems[i].data;
+
+      if (!name)
+         continue;
+
+      switch (extension_to_file_type(path_get_extension(name)))
+      {
+#ifdef HAVE_COMPRESSION
+         case FILE_TYPE_COMPRESSED:
+#endif
+         case FILE_TYPE_NONE:
+            break;
+         default:
+            continue;
+      }
+
+      if (!task_database_cache_lookup(_db, name, &size, &mtime, &entry))
+         continue;
+
+      if (entry && (entry->flags & DATABASE_SCAN_CACHE_CRC))
+         continue;
+
+      job->path  = strdup(name);
+      job->size  = size;
+      job->mtime = mtime;
+      job->state = DATABASE_SCAN_JOB_PENDING;
+      pending++;
+   }
+
+   if (!pending)
+      goto error;
+
+   if (threads > DATABASE_SCAN_THREADS_MAX)
+      threads = DATABASE_SCAN_THREADS_MAX;
+   if (threads > pending)
+      threads = (unsigned)pending;
+
+   for (i = 0; i < threads; i++)
+   {
+      sthread_t *thread = sthread_create(task_database_scan_thread, scan);
+
+      if (!thread)
+         break;
+
+      scan->threads[scan->threads_count++] = thread;
+   }
+
+   if (!scan->threads_count)
+      goto error;
+
+   RARCH_LOG("[Scanner]: Hashing " STRING_REP_USIZE
+         " files on %u threads.\n", pending, scan->threads_count);
+
+   return scan;
+
+error:
+   task_database_scan_free(scan);
+   return NULL;
+}
+#endif
+
+/* Gets the CRC of the whole file, from the hashing threads
+ * or the scan cache if possible. */
+static int task_database_get_file_crc(db_handle_t *_db,
+      database_info_handle_t *db, const char *name, uint32_t *crc)
+{
+   uint64_t size                      = 0;
+   int64_t mtime                      = 0;
+   uint64_t bytes                     = 0;
+   uint8_t *buf                       = NULL;
+   bool cacheable                     = false;
+   bool ret                           = false;
+   database_scan_cache_entry_t *entry = NULL;
+#ifdef HAVE_THREADS
+   database_scan_t *scan              = _db->scan;
+
+   if (scan && db->list_ptr < scan->jobs_count
+         && scan->jobs[db->list_ptr].path
+         && string_is_equal(scan->jobs[db->list_ptr].path, name))
+   {
+      database_scan_job_t *job = &scan->jobs[db->list_ptr];
+
+      slock_lock(scan->lock);
+      while (     job->state == DATABASE_SCAN_JOB_PENDING
+               || job->state == DATABASE_SCAN_JOB_RUNNING)
+         scond_wait(scan->cond, scan->lock);
+      slock_unlock(scan->lock);
+
+      if (job->state != DATABASE_SCAN_JOB_DONE)
+         return 0;
+
+      task_database_cache_store(_db, name, job->size, job->mtime,
+            DATABASE_SCAN_CACHE_CRC, job->crc, NULL);
+
+      *crc = job->crc;
+      return 1;
+   }
+#endif
+
+   cacheable = task_database_cache_lookup(_db, name, &size, &mtime, &entry);
+
+   if (entry && (entry->flags & DATABASE_SCAN_CACHE_CRC))
+   {
+      *crc = entry->crc;
+      return 1;
+   }
+
+   if (!(buf = (uint8_t*)malloc(DATABASE_SCAN_READ_SIZE)))
+      return 0;
+
+   ret              = task_database_file_crc(name,
+         buf, DATABASE_SCAN_READ_SIZE, crc, &bytes);
+   _db->scan_bytes += bytes;
+
+   free(buf);
+
+   if (!ret)
+      return 0;
+
+   if (cacheable)
+      task_database_cache_store(_db, name, size, mtime,
+            DATABASE_SCAN_CACHE_CRC, *crc, NULL);
+
+   return 1;
+}
+
+static void task_database_scan_begin(db_handle_t *_db,
+      database_info_handle_t *db)
+{
+   size_t i;
+   char *index_path = NULL;
+
+   _db->scan_start = cpu_features_get_time_usec();
+
+   /* Prune the files referenced by cue and gdi sheets
+    * up front, so they don't get hashed ahead of time. */
+   for (i = 0; i < db->list->size; i++)
+   {
+      const char *name = db->list->elems[i].data;
+
+      if (!name)
+         continue;
+
+      db->list_ptr = i;
+
+      switch (extension_to_file_type(path_get_extension(name)))
+      {
+         case FILE_TYPE_CUE:
+            task_database_cue_prune(db, name);
+            break;
+         case FILE_TYPE_GDI:
+            gdi_prune(db, name);
+            break;
+         default:
+            break;
+      }
+   }
+
+   db->list_ptr = 0;
+
+   if (!string_is_empty(_db->playlist_directory))
+   {
+      _db->cache_path = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+      fill_pathname_join(_db->cache_path, _db->playlist_directory,
+            file_path_str(FILE_PATH_CONTENT_SCAN_CACHE),
+            PATH_MAX_LENGTH * sizeof(char));
+   }
+
+   _db->cache = task_database_cache_load(_db->cache_path);
+
+   /* Lets the lookups skip the queries over every database */
+   if (!string_is_empty(_db->playlist_directory))
+   {
+      index_path = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+      fill_pathname_join(index_path, _db->playlist_directory,
+            file_path_str(FILE_PATH_CONTENT_DATABASE_INDEX),
+            PATH_MAX_LENGTH * sizeof(char));
+   }
+
+   _db->index = database_index_init(index_path,
+         _db->content_database_path, _db->show_hidden_files);
+
+   free(index_path);
+
+#ifdef HAVE_THREADS
+   _db->scan  = task_database_scan_new(_db, db->list);
+#endif
+}
+
 static int task_database_iterate_playlist(
+      db_handle_t *_db,
       database_state_handle_t *db_state,
       database_info_handle_t *db, const char *name)
 {
+   uint64_t size                      = 0;
+   int64_t mtime                      = 0;
+   bool cacheable                     = false;
+   database_scan_cache_entry_t *entry = NULL;
+
    switch (extension_to_file_type(path_get_extension(name)))
    {
       case FILE_TYPE_COMPRESSED:
 #ifdef HAVE_COMPRESSION
          database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
          /* first check crc of archive itself */
-         return intfstream_file_get_crc(name,
-               0, SIZE_MAX, &db_state->archive_crc);
+         return task_database_get_file_crc(_db, db,
+               name, &db_state->archive_crc);
 #else
          break;
 #endif
@@ -659,17 +1500,51 @@ static int task_database_iterate_playlist(
       case FILE_TYPE_WBFS:
       case FILE_TYPE_ISO:
          db_state->serial[0] = '\0';
-         intfstream_file_get_serial(name, 0, SIZE_MAX, db_state->serial);
+         cacheable = task_database_cache_lookup(_db, name,
+               &size, &mtime, &entry);
+         if (entry && (entry->flags & DATABASE_SCAN_CACHE_SERIAL))
+            strlcpy(db_state->serial, entry->serial,
+                  sizeof(db_state->serial));
+         else
+         {
+            intfstream_file_get_serial(name, 0, SIZE_MAX, db_state->serial);
+            if (cacheable)
+               task_database_cache_store(_db, name, size, mtime,
+                     DATABASE_SCAN_CACHE_SERIAL, 0, db_state->serial);
+         }
          database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
          break;
       case FILE_TYPE_CHD:
          db_state->serial[0] = '\0';
-         if (task_database_chd_get_serial(name, db_state->serial))
+         cacheable = task_database_cache_lookup(_db, name,
+               &size, &mtime, &entry);
+         if (entry && (entry->flags & DATABASE_SCAN_CACHE_SERIAL))
+         {
+            strlcpy(db_state->serial, entry->serial,
+                  sizeof(db_state->serial));
+            database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
+         }
+         else if (entry && (entry->flags & DATABASE_SCAN_CACHE_CRC))
+         {
+            db_state->crc = entry->crc;
+            database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
+         }
+         else if (task_database_chd_get_serial(_db, name, db_state->serial))
+         {
+            if (cacheable)
+               task_database_cache_store(_db, name, size, mtime,
+                     DATABASE_SCAN_CACHE_SERIAL, 0, db_state->serial);
             database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
+         }
          else
          {
             database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
-            return task_database_chd_get_crc(name, &db_state->crc);
+            if (!task_database_chd_get_crc(_db, name, &db_state->crc))
+               return 0;
+            if (cacheable)
+               task_database_cache_store(_db, name, size, mtime,
+                     DATABASE_SCAN_CACHE_CRC, db_state->crc, NULL);
+            return 1;
          }
          break;
       case FILE_TYPE_LUTRO:
@@ -677,7 +1552,7 @@ static int task_database_iterate_playlist(
          break;
       default:
          database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
-         return intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+         return task_database_get_file_crc(_db, db, name, &db_state->crc);
    }
 
    return 1;
@@ -772,6 +1647,154 @@ static int database_info_list_iterate_new(database_state_handle_t *db_state,
    return 0;
 }
 
+/**
+ * task_database_index_lookup:
+ * @_db                 : Scan handle.
+ * @db_state            : Lookup state.
+ * @matches             : Index entries of the looked up keys.
+ * @counts              : Amount of entries in each of @matches.
+ * @num                 : Amount of keys.
+ *
+ * Skips the databases in which the index has no entry for
+ * the keys, and reads the matching items of the next one
+ * into the info list, in the order a query would return them.
+ *
+ * Returns: false if the current database isn't part of the
+ * index, so it has to be queried instead.
+ **/
+static bool task_database_index_lookup(db_handle_t *_db,
+      database_state_handle_t *db_state,
+      const database_index_entry_t **matches, const size_t *counts,
+      unsigned num)
+{
+   unsigned i;
+   uint64_t offsets_stack[DATABASE_INDEX_MATCHES_STACK];
+   uint64_t *offsets = offsets_stack;
+   size_t total      = 0;
+   bool ret          = true;
+
+   for (i = 0; i < num; i++)
+      total += counts[i];
+
+   if (total > DATABASE_INDEX_MATCHES_STACK)
+   {
+      if (!(offsets = (uint64_t*)malloc(total * sizeof(*offsets))))
+         return false;
+   }
+
+   while (db_state->list_index < db_state->list->size)
+   {
+      size_t offsets_count = 0;
+      const char *path     = database_info_get_current_name(db_state);
+      int id               = database_index_get_db(_db->index, path);
+
+      if (id < 0)
+      {
+         ret = false;
+         break;
+      }
+
+      for (i = 0; i < num; i++)
+      {
+         size_t j;
+
+         for (j = 0; j < counts[i]; j++)
+         {
+            size_t k;
+            uint64_t offset = matches[i][j].offset;
+
+            if (matches[i][j].db != (uint32_t)id)
+               continue;
+
+            /* Insertion sort, there are usually only a few */
+            for (k = offsets_count; k > 0 && offsets[k - 1] > offset; k--)
+               offsets[k] = offsets[k - 1];
+            offsets[k] = offset;
+            offsets_count++;
+         }
+      }
+
+      if (offsets_count)
+      {
+         database_info_list_t *info = database_info_list_new_offsets(
+               path, offsets, offsets_count);
+
+         if (!info)
+         {
+            ret = false;
+            break;
+         }
+
+         if (db_state->info)
+         {
+            database_info_list_free(db_state->info);
+            free(db_state->info);
+         }
+         db_state->info = info;
+         break;
+      }
+
+      db_state->list_index++;
+   }
+
+   if (offsets != offsets_stack)
+      free(offsets);
+   return ret;
+}
+
+/**
+ * task_database_get_playlist:
+ * @_db                 : Scan handle.
+ * @path                : Path of the playlist.
+ *
+ * Keeps the playlists open for the whole scan, so that each
+ * match doesn't read and write the whole playlist again.
+ *
+ * Returns: the playlist, or NULL on allocation failure.
+ **/
+static playlist_t *task_database_get_playlist(db_handle_t *_db,
+      const char *path)
+{
+   size_t i;
+   playlist_t *playlist   = NULL;
+   playlist_t **playlists = NULL;
+
+   for (i = 0; i < _db->playlists_count; i++)
+      if (string_is_equal(playlist_get_conf_path(_db->playlists[i]), path))
+         return _db->playlists[i];
+
+   playlists = (playlist_t**)realloc(_db->playlists,
+         (_db->playlists_count + 1) * sizeof(*playlists));
+
+   if (!playlists)
+      return NULL;
+
+   _db->playlists = playlists;
+
+   if (!(playlist = playlist_init(path, COLLECTION_SIZE)))
+      return NULL;
+
+   _db->playlists[_db->playlists_count++] = playlist;
+
+   return playlist;
+}
+
+static void task_database_write_playlists(db_handle_t *_db)
+{
+   size_t i;
+
+   for (i = 0; i < _db->playlists_count; i++)
+   {
+      playlist_write_file(_db->playlists[i]);
+      playlist_free(_db->playlists[i]);
+   }
+
+   free(_db->playlists);
+
+   _db->playlists       = NULL;
+   _db->playlists_count = 0;
+}
+
 static int database_info_list_iterate_found_match(
       db_handle_t *_db,
       database_state_handle_t *db_state,
@@ -808,7 +1831,7 @@ static int database_info_list_iterate_found_match(
       fill_pathname_join(db_playlist_path, _db->playlist_directory,
             db_playlist_base_str, PATH_MAX_LENGTH * sizeof(char));
 
-   playlist = playlist_init(db_playlist_path, COLLECTION_SIZE);
+   playlist = task_database_get_playlist(_db, db_playlist_path);
 
    snprintf(db_crc, PATH_MAX_LENGTH * sizeof(char),
          "%08X|crc", db_info_entry->crc32);
@@ -877,9 +1900,6 @@ static int database_info_list_iterate_found_match(
       playlist_push(playlist, &entry);
    }
 
-   playlist_write_file(playlist);
-   playlist_free(playlist);
-
    database_info_list_free(db_state->info);
    free(db_state->info);
 
@@ -937,9 +1957,34 @@ static int task_database_iterate_crc_lookup(
    if (db_state->entry_index == 0)
    {
       char query[50];
+      bool indexed = false;
 
       query[0] = '\0';
 
+      if (_db->index)
+      {
+         const database_index_entry_t *matches[2];
+         size_t counts[2];
+         unsigned num = 1;
+
+         matches[0]   = database_index_find_crc(_db->index,
+               db_state->crc, &counts[0]);
+
+         /* The same item would be read twice otherwise */
+         if (db_state->archive_crc != db_state->crc)
+         {
+            matches[1] = database_index_find_crc(_db->index,
+                  db_state->archive_crc, &counts[1]);
+            num++;
+         }
+
+         indexed = task_database_index_lookup(_db, db_state,
+               matches, counts, num);
+
+         if (db_state->list_index == db_state->list->size)
+            return database_info_list_iterate_end_no_match(db, db_state, name);
+      }
+
       /* don't scan files that can't be in this database */
       if (!(path_contains_compressed_file(name) &&
          core_info_database_match_archive_member(
@@ -948,11 +1993,14 @@ static int task_database_iterate_crc_lookup(
          db_state->list->elems[db_state->list_index].data, name))
          return database_info_list_iterate_next(db_state);
 
-      snprintf(query, sizeof(query),
-            "{crc:or(b\"%08X\",b\"%08X\")}",
-            db_state->crc, db_state->archive_crc);
+      if (!indexed)
+      {
+         snprintf(query, sizeof(query),
+               "{crc:or(b\"%08X\",b\"%08X\")}",
+               db_state->crc, db_state->archive_crc);
 
-      database_info_list_iterate_new(db_state, query);
+         database_info_list_iterate_new(db_state, query);
+      }
    }
 
    if (db_state->info)
@@ -1031,7 +2079,7 @@ static int task_database_iterate_playlist_lutro(
             file_path_str(FILE_PATH_LUTRO_PLAYLIST),
             PATH_MAX_LENGTH * sizeof(char));
 
-   playlist = playlist_init(db_playlist_path, COLLECTION_SIZE);
+   playlist = task_database_get_playlist(_db, db_playlist_path);
 
    free(db_playlist_path);
 
@@ -1071,9 +2119,6 @@ static int task_database_iterate_playlist_lutro(
       free(game_title);
    }
 
-   playlist_write_file(playlist);
-   playlist_free(playlist);
-
    return 0;
 }
 
@@ -1088,19 +2133,37 @@ static int task_database_iterate_serial_lookup(
 
    if (db_state->entry_index == 0)
    {
-      char query[50];
-      char *serial_buf =
-         bin_to_hex_alloc((uint8_t*)db_state->serial, strlen(db_state->serial) * sizeof(uint8_t));
+      bool indexed = false;
 
-      if (!serial_buf)
-         return 1;
+      if (_db->index)
+      {
+         size_t count                          = 0;
+         const database_index_entry_t *matches =
+            database_index_find_serial(_db->index, db_state->serial, &count);
 
-      query[0] = '\0';
+         indexed = task_database_index_lookup(_db, db_state,
+               &matches, &count, 1);
 
-      snprintf(query, sizeof(query), "{'serial': b'%s'}", serial_buf);
-      database_info_list_iterate_new(db_state, query);
+         if (db_state->list_index == db_state->list->size)
+            return database_info_list_iterate_end_no_match(db, db_state, name);
+      }
+
+      if (!indexed)
+      {
+         char query[50];
+         char *serial_buf =
+            bin_to_hex_alloc((uint8_t*)db_state->serial, strlen(db_state->serial) * sizeof(uint8_t));
 
-      free(serial_buf);
+         if (!serial_buf)
+            return 1;
+
+         query[0] = '\0';
+
+         snprintf(query, sizeof(query), "{'serial': b'%s'}", serial_buf);
+         database_info_list_iterate_new(db_state, query);
+
+         free(serial_buf);
+      }
    }
 
    if (db_state->info)
@@ -1156,7 +2219,7 @@ static int task_database_iterate(
    switch (database_info_get_type(db))
    {
       case DATABASE_TYPE_ITERATE:
-         return task_database_iterate_playlist(db_state, db, name);
+         return task_database_iterate_playlist(_db, db_state, db, name);
       case DATABASE_TYPE_ITERATE_ARCHIVE:
          return task_database_iterate_playlist_archive(_db, db_state, db, name);
       case DATABASE_TYPE_ITERATE_LUTRO:
@@ -1273,6 +2336,7 @@ static void task_database_handler(retro_task_t *task)
                }
             }
          }
+         task_database_scan_begin(db, dbinfo);
          dbinfo->status = DATABASE_STATUS_ITERATE_START;
          break;
       case DATABASE_STATUS_ITERATE_START:
@@ -1280,7 +2344,7 @@ static void task_database_handler(retro_task_t *task)
          task_database_cleanup_state(dbstate);
          dbstate->list_index  = 0;
          dbstate->entry_index = 0;
-         task_database_iterate_start(task, dbinfo, name);
+         task_database_iterate_start(task, db, dbinfo, name);
          break;
       case DATABASE_STATUS_ITERATE:
          if (task_database_iterate(db, dbstate, dbinfo) == 0)
@@ -1302,6 +2366,14 @@ static void task_database_handler(retro_task_t *task)
                msg = msg_hash_to_str(MSG_SCANNING_OF_DIRECTORY_FINISHED);
             else
                msg = msg_hash_to_str(MSG_SCANNING_OF_FILE_FINISHED);
+
+            RARCH_LOG("[Scanner]: Scanned " STRING_REP_USIZE " files, %.1f MB"
+                  " read in %.1f seconds.\n",
+                  (size_t)dbinfo->list->size,
+                  task_database_scan_bytes(db) / (1024.0 * 1024.0),
+                  (cpu_features_get_time_usec() - db->scan_start) / 1000000.0);
+            if (db->cache && !string_is_empty(db->fullpath))
+               task_database_cache_prune(db->cache, db->fullpath);
 #ifdef RARCH_INTERNAL
             task_free_title(task);
             task_set_title(task, strdup(msg));
@@ -1309,6 +2381,7 @@ static void task_database_handler(retro_task_t *task)
 #else
             fprintf(stderr, "msg: %s\n", msg);
 #endif
+            task_database_write_playlists(db);
             ui_companion_driver_notify_refresh();
             goto task_finished;
          }
@@ -1340,6 +2413,22 @@ task_finished:
          free(db->fullpath);
       if (db->state.buf)
          free(db->state.buf);
+#ifdef HAVE_THREADS
+      task_database_scan_free(db->scan);
+#endif
+      if (db->cache)
+      {
+         task_database_cache_write(db->cache, db->cache_path);
+         task_database_cache_free(db->cache);
+      }
+      if (db->cache_path)
+         free(db->cache_path);
+      database_index_free(db->index);
+
+      task_database_write_playlists(db);
+
+      /* The archives of the last scanned files aren't needed anymore */
+      file_archive_cache_flush();
 
       if (db->handle)
          database_info_free(db->handle);
@@ -1360,11 +2449,14 @@ bool task_push_dbscan(
 {
    retro_task_t *t      = task_init();
    db_handle_t *db      = (db_handle_t*)calloc(1, sizeof(db_handle_t));
+   settings_t *settings = config_get_ptr();
 
    if (!t || !db)
       goto error;
 
    t->handler                = task_database_handler;
+   t->priority               = TASK_PRIORITY_BACKGROUND;
+   t->concurrent             = true;
    t->state                  = db;
    t->callback               = cb;
    t->title                  = strdup(msg_hash_to_str(MSG_PREPARING_FOR_CONTENT_SCAN));
@@ -1377,6 +2469,12 @@ bool task_push_dbscan(
    db->playlist_directory    = strdup(playlist_directory);
    db->content_database_path = strdup(content_database);
 
+   if (settings)
+   {
+      db->chd_cache_hunks    = settings->uints.scan_chd_cache_hunks;
+      db->chd_prefetch_hunks = settings->uints.scan_chd_prefetch_hunks;
+   }
+
    task_queue_push(t);
 
    return true;
@@ -18,6 +18,7 @@
 #include <string/stdstring.h>
 #include <file/file_path.h>
 #include <file/archive_file.h>
+#include <features/features_cpu.h>
 #include <retro_miscellaneous.h>
 #include <compat/strl.h>
 
@@ -238,12 +239,34 @@ static void task_decompress_handler_subdir(retro_task_t *task)
    }
 }
 
+/* Backends that can extract a whole archive at once, such as
+ * solid 7z archives decoding their blocks on several threads,
+ * do it in one step. Cancelling only takes effect after it, so
+ * this is only done off the main thread. */
+static void task_decompress_handler_all(retro_task_t *task)
+{
+   decompress_state_t *dec = (decompress_state_t*)task->state;
+
+   if (!file_archive_extract_all(dec->source_file, dec->target_dir,
+            cpu_features_get_core_amount()))
+   {
+      dec->callback_error = (char*)malloc(CALLBACK_ERROR_SIZE);
+      snprintf(dec->callback_error, CALLBACK_ERROR_SIZE,
+            "Failed to deflate %s.\n", dec->source_file);
+      task_set_error(task, dec->callback_error);
+   }
+
+   task_set_progress(task, 100);
+   task_decompress_handler_finished(task, dec);
+}
+
 static bool task_decompress_finder(
       retro_task_t *task, void *user_data)
 {
    decompress_state_t *dec = (decompress_state_t*)task->state;
 
-   if (task->handler != task_decompress_handler)
+   if (     task->handler != task_decompress_handler
+         && task->handler != task_decompress_handler_all)
       return false;
 
    return string_is_equal(dec->source_file, (const char*)user_data);
@@ -274,6 +297,7 @@ bool task_push_decompress(
    char tmp[PATH_MAX_LENGTH];
    const char *ext            = NULL;
    decompress_state_t *s      = NULL;
+   const struct file_archive_file_backend *backend = NULL;
    retro_task_t *t            = NULL;
 
    tmp[0] = '\0';
@@ -352,6 +376,10 @@ bool task_push_decompress(
       s->target_file   = strdup(target_file);
       t->handler       = task_decompress_handler_target_file;
    }
+   else if (!valid_ext && task_queue_is_threaded()
+         && (backend = file_archive_get_file_backend(source_file))
+         && backend->archive_extract_all)
+      t->handler       = task_decompress_handler_all;
 
    t->callback    = cb;
    t->user_data   = user_data;
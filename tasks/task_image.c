@@ -360,6 +360,7 @@ bool task_push_image_load(const char *fullpath, retro_task_callback_t cb, void *
 
    t->state           = nbio;
    t->handler         = task_file_load_handler;
+   t->priority        = TASK_PRIORITY_INTERACTIVE;
    t->cleanup         = task_image_load_free;
    t->callback        = cb;
    t->user_data       = user_data;
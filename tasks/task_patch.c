@@ -527,16 +527,18 @@ static bool apply_patch_content(uint8_t **buf,
 
    if (err == PATCH_SUCCESS)
    {
-      free(ret_buf);
       *buf  = patched_content;
       *size = target_size;
    }
    else
+   {
+      free(patched_content);
       RARCH_ERR("%s %s: %s #%u\n",
             msg_hash_to_str(MSG_FAILED_TO_PATCH),
             patch_desc,
             msg_hash_to_str(MSG_ERROR),
             (unsigned)err);
+   }
 
    return true;
 }
@@ -629,6 +631,10 @@ static bool try_ips_patch(bool allow_ips,
  *
  * Apply patch to the content file in-memory.
  *
+ * The patched content is written to a newly allocated buffer
+ * which replaces @buf; the original buffer is left untouched and
+ * still belongs to the caller, who may have memory-mapped it.
+ *
  **/
 static void patch_content(
       bool is_ips_pref,
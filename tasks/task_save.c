@@ -44,6 +44,10 @@
 #include "../network/netplay/netplay.h"
 #endif
 
+#ifdef HAVE_RUNAHEAD
+#include "../runahead/run_ahead.h"
+#endif
+
 #include "../content.h"
 #include "../core.h"
 #include "../file_path_special.h"
@@ -1230,6 +1234,11 @@ bool content_save_state(const char *path, bool save_to_disk, bool autosave)
    if (info.size == 0)
       return false;
 
+#ifdef HAVE_RUNAHEAD
+   /* Save the real frame, not one run ahead */
+   runahead_ring_restore();
+#endif
+
    if (!save_state_in_background)
    {
       RARCH_LOG("%s: \"%s\".\n",
@@ -1568,6 +1577,10 @@ bool event_save_files(void)
          !rarch_ctl(RARCH_CTL_IS_SRAM_USED, NULL))
       return false;
 
+#ifdef HAVE_RUNAHEAD
+   runahead_ring_restore();
+#endif
+
    for (i = 0; i < task_save_files->size; i++)
       content_save_ram_file(i);
 
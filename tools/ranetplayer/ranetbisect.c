@@ -0,0 +1,976 @@
+/*
+ * Copyright (c) 2019 The RetroArch team
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Replays desync recordings (see network/netplay/netplay_record.c) against a
+ * core, without a frontend, display or network.
+ *
+ * Given the recordings of two peers, finds the first frame at which their
+ * states went apart, replays both up to it and shows how the states differ.
+ * Given one recording, checks that the core replays it exactly, and that
+ * running a frame again after loading the state from its start (which is what
+ * netplay does on every rollback) gives the same result.
+ *
+ * Exits with 0 if everything agreed, 1 if something diverged and 2 on
+ * errors, so that it can be used to qualify cores in CI. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compat/getopt.h"
+#include "dynamic/dylib.h"
+#include "encodings/crc32.h"
+
+/* Only for #defines, and the keyboard mapping */
+#include "../../network/netplay/netplay_private.h"
+
+#define MAX_INPUT_WORDS (MAX_INPUT_DEVICES * 5)
+
+/* How many differing frames of input to show */
+#define MAX_INPUT_REPORTS 8
+
+/* How many bytes of each differing range of the states to show */
+#define DIFF_SHOW_BYTES 32
+
+/* Differences closer than this are shown as one range */
+#define DIFF_MERGE_BYTES 16
+
+#define ERROR(...) do { \
+   fprintf(stderr, __VA_ARGS__); \
+   exit(2); \
+} while (0)
+
+/* One frame of a recording */
+struct rec_frame
+{
+   uint32_t frame;
+
+   /* The CRC of the state at the start of the frame, if recorded */
+   bool have_crc;
+   uint32_t crc;
+
+   /* The state at the start of the frame, if it was loaded rather than run
+    * into */
+   uint8_t *state;
+
+   /* The input during the frame */
+   uint32_t input[MAX_INPUT_WORDS];
+};
+
+struct recording
+{
+   const char *file_name;
+   char core_name[NETPLAY_NICK_LEN];
+   char core_version[NETPLAY_NICK_LEN];
+   uint32_t content_crc;
+   uint32_t devices[MAX_INPUT_DEVICES];
+   size_t state_size;
+
+   /* Frames in order. A load into the past replaces what came after it. */
+   struct rec_frame *frames;
+   size_t frames_size, frames_cap;
+};
+
+enum replay_result
+{
+   REPLAY_OK = 0,
+   REPLAY_CRC,      /* The state didn't match the recorded CRC */
+   REPLAY_ROLLBACK  /* Running the frame again gave another state */
+};
+
+enum replay_checks
+{
+   CHECK_CRC      = 1,
+   CHECK_ROLLBACK = 2
+};
+
+/* The core's entry points */
+static dylib_t core_lib;
+static void (*lr_set_environment)(retro_environment_t);
+static void (*lr_set_video_refresh)(retro_video_refresh_t);
+static void (*lr_set_audio_sample)(retro_audio_sample_t);
+static void (*lr_set_audio_sample_batch)(retro_audio_sample_batch_t);
+static void (*lr_set_input_poll)(retro_input_poll_t);
+static void (*lr_set_input_state)(retro_input_state_t);
+static void (*lr_init)(void);
+static void (*lr_deinit)(void);
+static void (*lr_get_system_info)(struct retro_system_info*);
+static bool (*lr_load_game)(const struct retro_game_info*);
+static void (*lr_unload_game)(void);
+static void (*lr_set_controller_port_device)(unsigned, unsigned);
+static void (*lr_run)(void);
+static size_t (*lr_serialize_size)(void);
+static bool (*lr_serialize)(void*, size_t);
+static bool (*lr_unserialize)(const void*, size_t);
+
+/* Options */
+static const char *system_dir = ".";
+static bool verbose = false;
+
+/* What the core sees of the input: the devices, where each port's input is
+ * in a recorded frame, and the frame being run */
+static uint32_t devices[MAX_INPUT_DEVICES];
+static size_t port_offset[MAX_INPUT_DEVICES], port_size[MAX_INPUT_DEVICES];
+static const uint32_t *cur_input;
+
+/* Scratch states */
+static size_t state_size;
+static uint8_t *state_run, *state_rerun;
+
+/* Usage statement */
+void usage()
+{
+   fprintf(stderr,
+      "Use: ranetbisect [options] <core> <ranp file> [ranp file]\n"
+      "With the recordings of two peers, finds where they desynced and how\n"
+      "their states differ. With one, checks that the core replays it\n"
+      "deterministically, rollbacks included.\n"
+      "Options:\n"
+      "    -c|--content <file>:  Content to load.\n"
+      "    -s|--system <dir>:    System directory for the core.\n"
+      "    -o|--output <prefix>: Save the differing states as <prefix>.a and\n"
+      "                          <prefix>.b.\n"
+      "    -v|--verbose:         Show the core's log.\n"
+      "\n");
+}
+
+/* Size in words of each device's input, as in netplay_expected_input_size */
+static size_t device_input_size(uint32_t device)
+{
+   switch (device&RETRO_DEVICE_MASK)
+   {
+      case RETRO_DEVICE_JOYPAD:      return 1;
+      case RETRO_DEVICE_MOUSE:       return 2;
+      case RETRO_DEVICE_KEYBOARD:    return 5;
+      case RETRO_DEVICE_LIGHTGUN:    return 2;
+      case RETRO_DEVICE_ANALOG:      return 3;
+      default:                       return 0;
+   }
+}
+
+static size_t input_words(const uint32_t *devs)
+{
+   size_t i, ret = 0;
+   for (i = 0; i < MAX_INPUT_DEVICES; i++)
+      ret += device_input_size(devs[i]);
+   return ret;
+}
+
+static struct rec_frame *add_frame(struct recording *rec, uint32_t frame)
+{
+   struct rec_frame *ret;
+
+   if (rec->frames_size == rec->frames_cap)
+   {
+      rec->frames_cap = rec->frames_cap ? rec->frames_cap * 2 : 1024;
+      rec->frames = realloc(rec->frames,
+            rec->frames_cap * sizeof(struct rec_frame));
+      if (!rec->frames)
+      {
+         perror("realloc");
+         exit(2);
+      }
+   }
+
+   ret = &rec->frames[rec->frames_size++];
+   memset(ret, 0, sizeof(*ret));
+   ret->frame = frame;
+   return ret;
+}
+
+/* Read a whole recording */
+static void read_recording(struct recording *rec, const char *file_name)
+{
+   FILE *file;
+   uint32_t header[2], cmd, cmd_size;
+   uint32_t *payload     = NULL;
+   size_t payload_size   = 0;
+   uint8_t *load_state   = NULL;
+   uint32_t load_frame   = 0;
+   uint32_t crc_frame    = 0, crc = 0;
+   bool have_crc         = false;
+
+   memset(rec, 0, sizeof(*rec));
+   rec->file_name = file_name;
+
+   file = fopen(file_name, "rb");
+   if (!file)
+   {
+      perror(file_name);
+      exit(2);
+   }
+
+   while (fread(header, sizeof(uint32_t), 2, file) == 2)
+   {
+      cmd      = ntohl(header[0]);
+      cmd_size = ntohl(header[1]);
+
+      if (cmd_size > payload_size)
+      {
+         payload_size = cmd_size;
+         payload = realloc(payload, payload_size);
+         if (!payload)
+         {
+            perror("realloc");
+            exit(2);
+         }
+      }
+      if (fread(payload, 1, cmd_size, file) != cmd_size)
+         break;
+
+      switch (cmd)
+      {
+         case NETPLAY_CMD_INFO:
+            if (cmd_size < 2*NETPLAY_NICK_LEN + sizeof(uint32_t))
+               break;
+            memcpy(rec->core_name, payload, NETPLAY_NICK_LEN);
+            rec->core_name[NETPLAY_NICK_LEN-1] = '\0';
+            memcpy(rec->core_version, (char*)payload + NETPLAY_NICK_LEN,
+                  NETPLAY_NICK_LEN);
+            rec->core_version[NETPLAY_NICK_LEN-1] = '\0';
+            rec->content_crc =
+               ntohl(payload[2*NETPLAY_NICK_LEN/sizeof(uint32_t)]);
+            break;
+
+         case NETPLAY_CMD_RECORD_DEVICES:
+         {
+            size_t i;
+            for (i = 0; i < MAX_INPUT_DEVICES &&
+                  i < cmd_size/sizeof(uint32_t); i++)
+               rec->devices[i] = ntohl(payload[i]);
+            break;
+         }
+
+         case NETPLAY_CMD_LOAD_SAVESTATE:
+         {
+            uint32_t size;
+
+            if (cmd_size < 2*sizeof(uint32_t))
+               break;
+            size = ntohl(payload[1]);
+            if (size != cmd_size - 2*sizeof(uint32_t) ||
+                  (rec->state_size && size != rec->state_size))
+               ERROR("%s: Savestates of varying size.\n", file_name);
+            rec->state_size = size;
+
+            free(load_state);
+            load_state = malloc(size);
+            if (!load_state)
+            {
+               perror("malloc");
+               exit(2);
+            }
+            memcpy(load_state, payload + 2, size);
+            load_frame = ntohl(payload[0]);
+
+            /* Loading into the past replaces what we had from there */
+            while (rec->frames_size &&
+                  rec->frames[rec->frames_size-1].frame >= load_frame)
+               free(rec->frames[--rec->frames_size].state);
+            break;
+         }
+
+         case NETPLAY_CMD_CRC:
+            if (cmd_size < 2*sizeof(uint32_t))
+               break;
+            have_crc  = true;
+            crc_frame = ntohl(payload[0]);
+            crc       = ntohl(payload[1]);
+            break;
+
+         case NETPLAY_CMD_INPUT:
+         {
+            struct rec_frame *frame;
+            size_t i, words;
+
+            if (cmd_size < 2*sizeof(uint32_t))
+               break;
+            frame = add_frame(rec, ntohl(payload[0]));
+
+            words = cmd_size/sizeof(uint32_t) - 2;
+            if (words > MAX_INPUT_WORDS)
+               words = MAX_INPUT_WORDS;
+            for (i = 0; i < words; i++)
+               frame->input[i] = ntohl(payload[2 + i]);
+
+            if (have_crc && crc_frame == frame->frame)
+            {
+               frame->have_crc = true;
+               frame->crc      = crc;
+            }
+            if (load_state && load_frame == frame->frame)
+            {
+               frame->state = load_state;
+               load_state   = NULL;
+            }
+            have_crc = false;
+            break;
+         }
+
+         default:
+            break;
+      }
+   }
+
+   free(load_state);
+   free(payload);
+   fclose(file);
+
+   if (!rec->frames_size)
+      ERROR("%s: No frames recorded.\n", file_name);
+   if (!rec->state_size)
+      ERROR("%s: No savestates recorded, so it can't be replayed.\n",
+            file_name);
+}
+
+/* The last frame replaying from frames[start] (which must have a state) can
+ * reach, before another load or a frame that wasn't recorded */
+static size_t segment_end(const struct recording *rec, size_t start)
+{
+   size_t i;
+   for (i = start + 1; i < rec->frames_size; i++)
+   {
+      if (rec->frames[i].state ||
+            rec->frames[i].frame != rec->frames[i-1].frame + 1)
+         break;
+   }
+   return i - 1;
+}
+
+/* Where replaying up to frames[idx] has to start */
+static size_t segment_start(const struct recording *rec, size_t idx)
+{
+   while (idx && !rec->frames[idx].state &&
+         rec->frames[idx].frame == rec->frames[idx-1].frame + 1)
+      idx--;
+   return idx;
+}
+
+static void RETRO_CALLCONV core_log(enum retro_log_level level,
+      const char *fmt, ...)
+{
+   va_list ap;
+   if (!verbose && level < RETRO_LOG_WARN)
+      return;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+static bool RETRO_CALLCONV core_environment(unsigned cmd, void *data)
+{
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+         *(bool*)data = true;
+         return true;
+
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+      case RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME:
+      case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+         return true;
+
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+         *(const char**)data = system_dir;
+         return true;
+
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+         ((struct retro_log_callback*)data)->log = core_log;
+         return true;
+
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool*)data = false;
+         return true;
+
+      default:
+         return false;
+   }
+}
+
+static void RETRO_CALLCONV core_video_refresh(const void *data,
+      unsigned width, unsigned height, size_t pitch) {}
+static void RETRO_CALLCONV core_audio_sample(int16_t left, int16_t right) {}
+static size_t RETRO_CALLCONV core_audio_sample_batch(const int16_t *data,
+      size_t frames) { return frames; }
+static void RETRO_CALLCONV core_input_poll(void) {}
+
+/* The recorded input, as netplay_input_state presents it */
+static int16_t RETRO_CALLCONV core_input_state(unsigned port,
+      unsigned device, unsigned idx, unsigned id)
+{
+   const uint32_t *input;
+
+   if (port >= MAX_INPUT_DEVICES || !cur_input)
+      return 0;
+
+   /* Correct the port as netplay does */
+   if (device != RETRO_DEVICE_JOYPAD &&
+       (devices[port]&RETRO_DEVICE_MASK) != device)
+   {
+      for (port = 0; port < MAX_INPUT_DEVICES; port++)
+      {
+         if ((devices[port]&RETRO_DEVICE_MASK) == device)
+            break;
+      }
+      if (port == MAX_INPUT_DEVICES)
+         return 0;
+   }
+
+   if (!port_size[port])
+      return 0;
+   input = cur_input + port_offset[port];
+
+   switch (device)
+   {
+      case RETRO_DEVICE_JOYPAD:
+         return ((1 << id) & input[0]) ? 1 : 0;
+
+      case RETRO_DEVICE_ANALOG:
+         if (port_size[port] != 3)
+            return 0;
+         return (int16_t)(uint16_t)(input[1 + idx] >> (id * 16));
+
+      case RETRO_DEVICE_MOUSE:
+      case RETRO_DEVICE_LIGHTGUN:
+         if (port_size[port] != 2)
+            return 0;
+         if (id <= RETRO_DEVICE_ID_MOUSE_Y)
+            return (int16_t)(uint16_t)(input[1] >> (id * 16));
+         return ((1 << id) & input[0]) ? 1 : 0;
+
+      case RETRO_DEVICE_KEYBOARD:
+      {
+         unsigned key = netplay_key_hton(id);
+         if (key == NETPLAY_KEY_UNKNOWN || key/32 >= port_size[port])
+            return 0;
+         return ((1U<<(key%32)) & input[key/32]) ? 1 : 0;
+      }
+
+      default:
+         return 0;
+   }
+}
+
+#define CORE_SYMBOL(name, x) do { \
+   function_t func = dylib_proc(core_lib, "retro_" #x); \
+   memcpy(&name, &func, sizeof(func)); \
+   if (!name) \
+      ERROR("%s: No retro_%s.\n", core_path, #x); \
+} while (0)
+
+static void load_core(const char *core_path, const char *content_path,
+      const struct recording *rec)
+{
+   struct retro_system_info info;
+   struct retro_game_info game;
+   void *content = NULL;
+   unsigned port;
+
+   core_lib = dylib_load(core_path);
+   if (!core_lib)
+      ERROR("%s: %s\n", core_path, dylib_error());
+
+   CORE_SYMBOL(lr_set_environment, set_environment);
+   CORE_SYMBOL(lr_set_video_refresh, set_video_refresh);
+   CORE_SYMBOL(lr_set_audio_sample, set_audio_sample);
+   CORE_SYMBOL(lr_set_audio_sample_batch, set_audio_sample_batch);
+   CORE_SYMBOL(lr_set_input_poll, set_input_poll);
+   CORE_SYMBOL(lr_set_input_state, set_input_state);
+   CORE_SYMBOL(lr_init, init);
+   CORE_SYMBOL(lr_deinit, deinit);
+   CORE_SYMBOL(lr_get_system_info, get_system_info);
+   CORE_SYMBOL(lr_load_game, load_game);
+   CORE_SYMBOL(lr_unload_game, unload_game);
+   CORE_SYMBOL(lr_set_controller_port_device, set_controller_port_device);
+   CORE_SYMBOL(lr_run, run);
+   CORE_SYMBOL(lr_serialize_size, serialize_size);
+   CORE_SYMBOL(lr_serialize, serialize);
+   CORE_SYMBOL(lr_unserialize, unserialize);
+
+   lr_set_environment(core_environment);
+   lr_set_video_refresh(core_video_refresh);
+   lr_set_audio_sample(core_audio_sample);
+   lr_set_audio_sample_batch(core_audio_sample_batch);
+   lr_set_input_poll(core_input_poll);
+   lr_set_input_state(core_input_state);
+   lr_init();
+
+   memset(&info, 0, sizeof(info));
+   lr_get_system_info(&info);
+   if (strcmp(info.library_name ? info.library_name : "", rec->core_name) ||
+         strcmp(info.library_version ? info.library_version : "",
+            rec->core_version))
+      fprintf(stderr, "Warning: Recorded with %s %s, replaying with %s %s.\n",
+            rec->core_name, rec->core_version,
+            info.library_name, info.library_version);
+
+   memset(&game, 0, sizeof(game));
+   if (content_path)
+   {
+      game.path = content_path;
+      if (!info.need_fullpath)
+      {
+         FILE *file = fopen(content_path, "rb");
+         long size;
+
+         if (!file || fseek(file, 0, SEEK_END) || (size = ftell(file)) < 0)
+         {
+            perror(content_path);
+            exit(2);
+         }
+         rewind(file);
+         content = malloc(size ? size : 1);
+         if (!content || fread(content, 1, size, file) != (size_t)size)
+         {
+            perror(content_path);
+            exit(2);
+         }
+         fclose(file);
+         game.data = content;
+         game.size = size;
+
+         if (encoding_crc32(0, content, size) != rec->content_crc)
+            fprintf(stderr, "Warning: %s isn't the recorded content.\n",
+                  content_path);
+      }
+   }
+
+   if (!lr_load_game(content_path ? &game : NULL))
+      ERROR("%s: Failed to load content.\n", core_path);
+
+   for (port = 0; port < MAX_INPUT_DEVICES; port++)
+   {
+      if ((devices[port]&RETRO_DEVICE_MASK) != RETRO_DEVICE_NONE)
+         lr_set_controller_port_device(port, devices[port]);
+   }
+
+   state_size = lr_serialize_size();
+   if (!state_size)
+      ERROR("%s: The core can't serialize.\n", core_path);
+   if (state_size != rec->state_size)
+      ERROR("%s: Savestates are %lu bytes, but %lu were recorded.\n",
+            core_path, (unsigned long)state_size,
+            (unsigned long)rec->state_size);
+
+   state_run   = malloc(state_size);
+   state_rerun = malloc(state_size);
+   if (!state_run || !state_rerun)
+   {
+      perror("malloc");
+      exit(2);
+   }
+
+   free(content);
+}
+
+static void set_devices(const uint32_t *devs)
+{
+   size_t port, offset = 0;
+   memcpy(devices, devs, sizeof(devices));
+   for (port = 0; port < MAX_INPUT_DEVICES; port++)
+   {
+      port_offset[port] = offset;
+      port_size[port]   = device_input_size(devices[port]);
+      offset           += port_size[port];
+   }
+}
+
+/**
+ * replay
+ *
+ * Replay from frames[from], which must have a state, to the start of
+ * frames[to], serializing at the start of every frame as netplay does. The
+ * state reached ends up in state_run.
+ *
+ * With CHECK_CRC, stops at the first frame whose state doesn't match its
+ * recorded CRC. With CHECK_ROLLBACK, runs every frame twice from its state
+ * and stops at the first that doesn't agree with itself, with the two
+ * results in state_run and state_rerun.
+ *
+ * Returns the result, and where it stopped in *at.
+ */
+static enum replay_result replay(const struct recording *rec,
+      size_t from, size_t to, unsigned checks, size_t *at)
+{
+   size_t i;
+
+   if (!lr_unserialize(rec->frames[from].state, state_size))
+      ERROR("Failed to load the state of frame %u.\n",
+            rec->frames[from].frame);
+
+   for (i = from; ; i++)
+   {
+      const struct rec_frame *frame = &rec->frames[i];
+
+      *at = i;
+      if (!lr_serialize(state_run, state_size))
+         ERROR("Failed to save the state of frame %u.\n", frame->frame);
+      if ((checks & CHECK_CRC) && frame->have_crc &&
+            encoding_crc32(0, state_run, state_size) != frame->crc)
+         return REPLAY_CRC;
+      if (i == to)
+         return REPLAY_OK;
+
+      cur_input = frame->input;
+      lr_run();
+
+      if (checks & CHECK_ROLLBACK)
+      {
+         if (!lr_serialize(state_rerun, state_size) ||
+               !lr_unserialize(state_run, state_size))
+            ERROR("Failed to roll back frame %u.\n", frame->frame);
+         lr_run();
+         if (!lr_serialize(state_run, state_size))
+            ERROR("Failed to save the state of frame %u.\n", frame->frame);
+         if (memcmp(state_run, state_rerun, state_size))
+            return REPLAY_ROLLBACK;
+      }
+   }
+}
+
+/* Show where two states differ */
+static void show_diff(const uint8_t *a, const char *a_name,
+      const uint8_t *b, const char *b_name)
+{
+   size_t i = 0, bytes = 0, ranges = 0;
+
+   while (i < state_size)
+   {
+      size_t start, end, j;
+
+      if (a[i] == b[i])
+      {
+         i++;
+         continue;
+      }
+
+      /* Find the end of this range */
+      start = end = i;
+      for (j = i + 1; j < state_size && j <= end + DIFF_MERGE_BYTES; j++)
+      {
+         if (a[j] != b[j])
+         {
+            end = j;
+            bytes++;
+         }
+      }
+      bytes++;
+      ranges++;
+      i = end + 1;
+
+      printf("  0x%08lx-0x%08lx:\n", (unsigned long)start,
+            (unsigned long)end);
+      printf("    %-8s", a_name);
+      for (j = start; j <= end && j < start + DIFF_SHOW_BYTES; j++)
+         printf(" %02x", a[j]);
+      printf(j <= end ? " ...\n" : "\n");
+      printf("    %-8s", b_name);
+      for (j = start; j <= end && j < start + DIFF_SHOW_BYTES; j++)
+         printf(" %02x", b[j]);
+      printf(j <= end ? " ...\n" : "\n");
+   }
+
+   if (bytes)
+      printf("%lu bytes differ in %lu ranges, of %lu.\n",
+            (unsigned long)bytes, (unsigned long)ranges,
+            (unsigned long)state_size);
+   else
+      printf("  They're identical.\n");
+}
+
+static void save_state(const char *prefix, const char *suffix,
+      const uint8_t *state)
+{
+   char file_name[PATH_MAX_LENGTH];
+   FILE *file;
+
+   if (!prefix)
+      return;
+   snprintf(file_name, sizeof(file_name), "%s.%s", prefix, suffix);
+   file = fopen(file_name, "wb");
+   if (!file || fwrite(state, 1, state_size, file) != state_size)
+      perror(file_name);
+   if (file)
+      fclose(file);
+}
+
+/* Replay one recording, checking the core against itself */
+static int check_one(const struct recording *rec, const char *output)
+{
+   size_t start = 0, checked = 0;
+
+   while (start < rec->frames_size)
+   {
+      size_t end = segment_end(rec, start), at;
+      enum replay_result result;
+
+      if (!rec->frames[start].state)
+      {
+         start = end + 1;
+         continue;
+      }
+
+      result = replay(rec, start, end, CHECK_CRC|CHECK_ROLLBACK, &at);
+      switch (result)
+      {
+         case REPLAY_CRC:
+            printf("Frame %u: Replayed state doesn't match the recording "
+                  "(%08x, recorded %08x).\n", rec->frames[at].frame,
+                  encoding_crc32(0, state_run, state_size),
+                  rec->frames[at].crc);
+            return 1;
+
+         case REPLAY_ROLLBACK:
+            printf("Frame %u: Running it again after loading its state "
+                  "gives another state:\n", rec->frames[at].frame);
+            show_diff(state_rerun, "first", state_run, "again");
+            save_state(output, "a", state_rerun);
+            save_state(output, "b", state_run);
+            return 1;
+
+         default:
+            break;
+      }
+
+      checked += end - start + 1;
+      start    = end + 1;
+   }
+
+   printf("%lu frames replayed and rolled back deterministically.\n",
+         (unsigned long)checked);
+   return 0;
+}
+
+/* Find where two recordings went apart and show how */
+static int check_two(const struct recording *a, const struct recording *b,
+      const char *output)
+{
+   size_t *pairs, pairs_size = 0;
+   size_t ia = 0, ib = 0, i;
+   size_t first = (size_t)-1, seg = 0, first_seg = 0;
+   size_t fa, fb, at;
+   unsigned reports = 0;
+
+   if (memcmp(a->devices, b->devices, sizeof(a->devices)))
+      ERROR("The recordings have different devices.\n");
+   if (a->state_size != b->state_size)
+      ERROR("The recordings have savestates of different sizes.\n");
+
+   /* Pair up the frames both checked */
+   pairs = malloc(2 * sizeof(size_t) *
+         (a->frames_size < b->frames_size ? a->frames_size : b->frames_size));
+   if (!pairs)
+   {
+      perror("malloc");
+      exit(2);
+   }
+   while (ia < a->frames_size && ib < b->frames_size)
+   {
+      if (a->frames[ia].frame < b->frames[ib].frame)
+         ia++;
+      else if (a->frames[ia].frame > b->frames[ib].frame)
+         ib++;
+      else
+      {
+         if (a->frames[ia].have_crc && b->frames[ib].have_crc)
+         {
+            pairs[2*pairs_size]   = ia;
+            pairs[2*pairs_size+1] = ib;
+            pairs_size++;
+         }
+         ia++;
+         ib++;
+      }
+   }
+   if (!pairs_size)
+      ERROR("The recordings have no checked frames in common.\n");
+
+   /* Between loads, states that went apart stay apart, so bisect each
+    * stretch for where that happened */
+   while (seg < pairs_size && first == (size_t)-1)
+   {
+      size_t sa  = segment_start(a, pairs[2*seg]);
+      size_t sb  = segment_start(b, pairs[2*seg+1]);
+      size_t end = seg, lo, hi;
+
+      while (end + 1 < pairs_size &&
+            segment_start(a, pairs[2*(end+1)]) == sa &&
+            segment_start(b, pairs[2*(end+1)+1]) == sb)
+         end++;
+
+#define PAIR_DIFFERS(p) \
+      (a->frames[pairs[2*(p)]].crc != b->frames[pairs[2*(p)+1]].crc)
+      if (PAIR_DIFFERS(end))
+      {
+         lo = seg;
+         hi = end;
+         while (lo < hi)
+         {
+            size_t mid = lo + (hi - lo) / 2;
+            if (PAIR_DIFFERS(mid))
+               hi = mid;
+            else
+               lo = mid + 1;
+         }
+         first     = lo;
+         first_seg = seg;
+      }
+#undef PAIR_DIFFERS
+
+      seg = end + 1;
+   }
+
+   if (first == (size_t)-1)
+   {
+      printf("%lu frames checked by both, and they agree.\n",
+            (unsigned long)pairs_size);
+      free(pairs);
+      return 0;
+   }
+
+   fa = pairs[2*first];
+   fb = pairs[2*first+1];
+   printf("Frame %u: States went apart (%s %08x, %s %08x).\n",
+         a->frames[fa].frame, a->file_name, a->frames[fa].crc,
+         b->file_name, b->frames[fb].crc);
+
+   /* Different input means netplay went wrong rather than the core */
+   for (i = first_seg; i < first; i++)
+   {
+      const struct rec_frame *af = &a->frames[pairs[2*i]];
+      const struct rec_frame *bf = &b->frames[pairs[2*i+1]];
+      size_t words = input_words(a->devices), w;
+
+      if (!memcmp(af->input, bf->input, words * sizeof(uint32_t)))
+         continue;
+      if (reports++ == MAX_INPUT_REPORTS)
+      {
+         printf("  ...\n");
+         break;
+      }
+      printf("Frame %u: Input differs:\n    a       ", af->frame);
+      for (w = 0; w < words; w++)
+         printf(" %08x", af->input[w]);
+      printf("\n    b       ");
+      for (w = 0; w < words; w++)
+         printf(" %08x", bf->input[w]);
+      printf("\n");
+   }
+
+   /* Now replay both up to there and compare */
+   if (replay(a, segment_start(a, fa), fa, CHECK_CRC, &at) != REPLAY_OK)
+   {
+      printf("Frame %u: Replaying %s doesn't reproduce it, so the core "
+            "isn't deterministic here.\n", a->frames[at].frame, a->file_name);
+      replay(a, segment_start(a, fa), fa, 0, &at);
+   }
+   memcpy(state_rerun, state_run, state_size);
+   if (replay(b, segment_start(b, fb), fb, CHECK_CRC, &at) != REPLAY_OK)
+   {
+      printf("Frame %u: Replaying %s doesn't reproduce it, so the core "
+            "isn't deterministic here.\n", b->frames[at].frame, b->file_name);
+      replay(b, segment_start(b, fb), fb, 0, &at);
+   }
+
+   printf("Replayed states at frame %u:\n", a->frames[fa].frame);
+   show_diff(state_rerun, "a", state_run, "b");
+   save_state(output, "a", state_rerun);
+   save_state(output, "b", state_run);
+
+   free(pairs);
+   return 1;
+}
+
+int main(int argc, char **argv)
+{
+   struct recording rec_a, rec_b;
+   const char *content_path = NULL, *output = NULL, *core_path;
+   int ret;
+
+   const struct option opt[] = {
+      {"content",    1, NULL, 'c'},
+      {"system",     1, NULL, 's'},
+      {"output",     1, NULL, 'o'},
+      {"verbose",    0, NULL, 'v'},
+      {NULL,         0, NULL, 0}
+   };
+
+   while (1)
+   {
+      int c;
+
+      c = getopt_long(argc, argv, "c:s:o:v", opt, NULL);
+      if (c == -1)
+         break;
+
+      switch (c)
+      {
+         case 'c':
+            content_path = optarg;
+            break;
+
+         case 's':
+            system_dir = optarg;
+            break;
+
+         case 'o':
+            output = optarg;
+            break;
+
+         case 'v':
+            verbose = true;
+            break;
+
+         default:
+            usage();
+            return 2;
+      }
+   }
+
+   if (argc - optind < 2 || argc - optind > 3)
+   {
+      usage();
+      return 2;
+   }
+   core_path = argv[optind++];
+
+   netplay_key_hton_init();
+
+   read_recording(&rec_a, argv[optind++]);
+   if (optind < argc)
+   {
+      read_recording(&rec_b, argv[optind++]);
+      if (rec_a.content_crc != rec_b.content_crc)
+         fprintf(stderr, "Warning: The recordings are of different content.\n");
+   }
+   else
+      rec_b.frames_size = 0;
+
+   set_devices(rec_a.devices);
+   load_core(core_path, content_path, &rec_a);
+
+   if (rec_b.frames_size)
+      ret = check_two(&rec_a, &rec_b, output);
+   else
+      ret = check_one(&rec_a, output);
+
+   lr_unload_game();
+   lr_deinit();
+   dylib_close(core_lib);
+   return ret;
+}
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+#
+# Connects a number of spectators to a netplay host and reads from all of
+# them, to see how the host copes with many connections.
+#
+# Each spectator does the handshake, then reads and sends an ACK every so
+# often, so that the host has many readable connections at once. At the
+# end, the number of spectators still connected and the bytes they got are
+# printed, as is the longest time in which none of them got anything. A
+# host that stops serving its connections shows up as a long stall.
+#
+# The core name and version must be the ones the host runs, as it refuses
+# anything else. The content CRC is sent as 0, which the host accepts.
+#
+# With a host command after --, the host is started first, and the time it
+# spent in netplay per frame is read from its log once it quits. That is CPU
+# time of the main thread where the host can measure it. The host should be
+# given -v and --max-frames, so that it logs and quits by itself after the
+# run; one still running --host-timeout seconds later is terminated.
+#
+# Exits with 0 if every spectator stayed connected and the longest stall
+# was under --max-stall seconds, and with 1 otherwise.
+
+import argparse
+import re
+import select
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+NETPLAY_MAGIC            = 0x52414E50 # "RANP"
+NETPLAY_NICK_LEN         = 32
+NETPLAY_CMD_ACK          = 0x0000
+NETPLAY_CMD_NICK         = 0x0020
+NETPLAY_CMD_INFO         = 0x0022
+NETPLAY_COMPRESSION_ZLIB = 1
+
+def recv_exactly(sock, size):
+    data = b''
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise EOFError('host closed the connection')
+        data += chunk
+    return data
+
+def recv_cmd(sock):
+    cmd, size = struct.unpack('>II', recv_exactly(sock, 8))
+    return cmd, recv_exactly(sock, size)
+
+def send_cmd(sock, cmd, payload):
+    sock.sendall(struct.pack('>II', cmd, len(payload)) + payload)
+
+def connect_spectator(args, index):
+    sock = socket.create_connection((args.host, args.port))
+    header = struct.unpack('>6I', recv_exactly(sock, 24))
+    if header[0] != NETPLAY_MAGIC:
+        raise ValueError('not a netplay host')
+
+    # Same platform, protocol and implementation as the host, no salt
+    sock.sendall(struct.pack('>6I', NETPLAY_MAGIC, header[1],
+        NETPLAY_COMPRESSION_ZLIB, 0, header[4], header[5]))
+    send_cmd(sock, NETPLAY_CMD_NICK,
+        (b'load%d' % index).ljust(NETPLAY_NICK_LEN, b'\0'))
+
+    seen = set()
+    while not {NETPLAY_CMD_NICK, NETPLAY_CMD_INFO} <= seen:
+        cmd, _ = recv_cmd(sock)
+        seen.add(cmd)
+
+    send_cmd(sock, NETPLAY_CMD_INFO,
+        args.core_name.encode().ljust(NETPLAY_NICK_LEN, b'\0') +
+        args.core_version.encode().ljust(NETPLAY_NICK_LEN, b'\0') +
+        struct.pack('>I', 0))
+
+    sock.setblocking(False)
+    return sock
+
+FRAME_TIME_RE = re.compile(r'\[netplay\] (\d+) frames, (\d+) us '
+    r'((?:of CPU time )?)per frame in netplay on average \((\d+) us at most\)')
+
+def start_host(args):
+    log = tempfile.TemporaryFile(mode='w+')
+    host = subprocess.Popen(args.host_cmd, stdout=log,
+        stderr=subprocess.STDOUT)
+    deadline = time.time() + args.host_timeout
+    while time.time() < deadline and host.poll() is None:
+        try:
+            socket.create_connection((args.host, args.port), 1).close()
+            return host, log
+        except OSError:
+            time.sleep(0.2)
+    host.kill()
+    host.wait()
+    raise RuntimeError('host did not start listening')
+
+def stop_host(args, host, log):
+    try:
+        host.wait(args.host_timeout)
+    except subprocess.TimeoutExpired:
+        host.send_signal(signal.SIGTERM)
+        try:
+            host.wait(5)
+        except subprocess.TimeoutExpired:
+            host.kill()
+            host.wait()
+    log.seek(0)
+    for line in log:
+        match = FRAME_TIME_RE.search(line)
+        if match:
+            frames, average, cpu, most = match.groups()
+            print('host: %s frames, %s us %sper frame in netplay on average, '
+                  '%s us at most' % (frames, average, cpu, most))
+            return
+    print('host: no netplay frame time in its log')
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Load a netplay host with spectators.',
+        usage='%(prog)s [options] core_name core_version [-- host command]')
+    parser.add_argument('core_name')
+    parser.add_argument('core_version')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=55435)
+    parser.add_argument('--spectators', type=int, default=64)
+    parser.add_argument('--seconds', type=float, default=20)
+    parser.add_argument('--max-stall', type=float, default=2)
+    parser.add_argument('--acks-per-second', type=float, default=20)
+    parser.add_argument('--host-timeout', type=float, default=30)
+    argv = sys.argv[1:]
+    host_cmd = []
+    if '--' in argv:
+        host_cmd = argv[argv.index('--') + 1:]
+        argv     = argv[:argv.index('--')]
+    args = parser.parse_args(argv)
+    args.host_cmd = host_cmd
+
+    host = log = None
+    if args.host_cmd:
+        host, log = start_host(args)
+
+    try:
+        ok = run_spectators(args)
+    finally:
+        if host:
+            stop_host(args, host, log)
+
+    return 0 if ok else 1
+
+def run_spectators(args):
+    socks = [connect_spectator(args, i) for i in range(args.spectators)]
+    print('%d spectators connected' % len(socks))
+
+    total     = 0
+    start     = time.time()
+    last_data = start
+    stall     = 0.0
+    next_ack  = start
+    while time.time() - start < args.seconds and socks:
+        readable, _, _ = select.select(socks, [], [], 0.05)
+        now = time.time()
+        if args.acks_per_second > 0 and now >= next_ack:
+            for sock in socks:
+                try:
+                    send_cmd(sock, NETPLAY_CMD_ACK, b'')
+                except (BlockingIOError, OSError):
+                    pass
+            next_ack = now + 1 / args.acks_per_second
+        for sock in readable:
+            try:
+                data = sock.recv(65536)
+            except BlockingIOError:
+                continue
+            except OSError:
+                data = b''
+            if not data:
+                socks.remove(sock)
+                continue
+            total    += len(data)
+            last_data = now
+        stall = max(stall, now - last_data)
+
+    print('%d of %d spectators still connected, %d bytes, '
+          'longest stall %.2f s' % (len(socks), args.spectators, total, stall))
+
+    return len(socks) == args.spectators and stall < args.max_stall
+
+if __name__ == '__main__':
+    sys.exit(main())
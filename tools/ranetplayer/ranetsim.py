@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+#
+# Runs a netplay host and a client over loopback, once with input over TCP
+# only and once with UDP input, and prints the stall, rollback and UDP
+# counts both peers log when their session ends.
+#
+# RetroArch has to be built with the network simulator
+# (make DEBUG_NETPLAY_NETSIM=1), which drops and delays what the peers send
+# each other and makes up their joypad input, so that the counts mean
+# something over loopback. Any core with savestates will do.
+#
+# Exits with 0 if both peers of every run logged their counts, and with 1
+# otherwise.
+
+import argparse
+import os
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+STALLS_RE = re.compile(r'\[netplay\] (\d+) stalls \((\d+) frames\), '
+    r'(\d+) rollbacks \((\d+) frames replayed\)')
+UDP_RE    = re.compile(r'\[netplay\] UDP input: (\d+) datagrams sent, '
+    r'(\d+) received, (\d+) lost, (\d+) frames ahead of TCP')
+
+CONFIG = '''config_save_on_exit = "false"
+video_driver = "null"
+audio_driver = "null"
+input_driver = "null"
+menu_driver = "null"
+vrr_runloop_enable = "true"
+netplay_public_announce = "false"
+netplay_nat_traversal = "false"
+netplay_udp_input = "%s"
+netplay_udp_input_frames = "%d"
+'''
+
+def wait_listening(args, host):
+    deadline = time.time() + 30
+    while time.time() < deadline and host.poll() is None:
+        try:
+            socket.create_connection(('127.0.0.1', args.port), 1).close()
+            return True
+        except OSError:
+            time.sleep(0.2)
+    return False
+
+def read_counts(log):
+    counts = {}
+    log.seek(0)
+    for line in log:
+        match = STALLS_RE.search(line)
+        if match:
+            counts['stalls'] = tuple(int(x) for x in match.groups())
+        match = UDP_RE.search(line)
+        if match:
+            counts['udp'] = tuple(int(x) for x in match.groups())
+    return counts
+
+def run(args, udp):
+    tmp = tempfile.mkdtemp(prefix='ranetsim')
+    try:
+        return run_peers(args, udp, tmp)
+    finally:
+        shutil.rmtree(tmp)
+
+def run_peers(args, udp, tmp):
+    cfg = os.path.join(tmp, 'retroarch.cfg')
+    with open(cfg, 'w') as f:
+        f.write(CONFIG % ('true' if udp else 'false', args.udp_frames))
+
+    # RetroArch doesn't start without a locale
+    env = dict(os.environ)
+    env.setdefault('LANG', 'C')
+
+    common = [args.retroarch, '-c', cfg, '-L', args.core, '-v',
+              '--port', str(args.port), '--max-frames=%d' % args.frames]
+    host_log   = tempfile.TemporaryFile(mode='w+')
+    client_log = tempfile.TemporaryFile(mode='w+')
+
+    host = subprocess.Popen(common + ['--host', args.content],
+        stdout=host_log, stderr=subprocess.STDOUT, env=env)
+    if not wait_listening(args, host):
+        host.kill()
+        host.wait()
+        return None, None
+    client = subprocess.Popen(common + ['--connect', '127.0.0.1',
+        args.content], stdout=client_log, stderr=subprocess.STDOUT, env=env)
+
+    for proc in (host, client):
+        try:
+            proc.wait(args.frames / 60 * 4 + 30)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+
+    return read_counts(host_log), read_counts(client_log)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare netplay over TCP only and with UDP input.')
+    parser.add_argument('retroarch', help='RetroArch built with '
+        'DEBUG_NETPLAY_NETSIM=1')
+    parser.add_argument('core')
+    parser.add_argument('content')
+    parser.add_argument('--frames', type=int, default=2400)
+    parser.add_argument('--port', type=int, default=55435)
+    parser.add_argument('--udp-frames', type=int, default=4)
+    args = parser.parse_args()
+
+    ok = True
+    for udp in (False, True):
+        mode = 'udp' if udp else 'tcp'
+        for peer, counts in zip(('host', 'client'), run(args, udp)):
+            if not counts or 'stalls' not in counts:
+                print('%s %-6s: no counts logged' % (mode, peer))
+                ok = False
+                continue
+            line = ('%s %-6s: %d stalls (%d frames), %d rollbacks '
+                '(%d frames replayed)' % ((mode, peer) + counts['stalls']))
+            if 'udp' in counts:
+                line += (', %d datagrams sent, %d received, %d lost, '
+                    '%d frames ahead of TCP' % counts['udp'])
+            print(line)
+
+    return 0 if ok else 1
+
+if __name__ == '__main__':
+    sys.exit(main())